@@ -0,0 +1,126 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// decodes a trace log written with --log-trace
+
+#include "base/TraceLogReader.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+static
+void
+usage(const char* exename)
+{
+    fprintf(stderr,
+        "Usage: %s [--debug <level>] <file>\n"
+        "\n"
+        "Print the messages in a trace log written with --log-trace,\n"
+        "oldest first.\n"
+        "\n"
+        "  -d, --debug <level>      only print messages up to level.\n",
+        exename);
+}
+
+static
+void
+printMessage(const TraceLogReader::Message& message)
+{
+    time_t second = (time_t)(message.m_time / 1000000);
+    struct tm tm;
+#if SYSAPI_WIN32
+    localtime_s(&tm, &second);
+#else
+    localtime_r(&second, &tm);
+#endif
+
+    printf("[%04i-%02i-%02iT%02i:%02i:%02i.%06i] %s (thread %u): %s",
+        tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+        tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(message.m_time % 1000000),
+        CLOG->getFilterName(message.m_level), message.m_thread,
+        message.m_text.c_str());
+    if (!message.m_file.empty()) {
+        printf("\n\t%s,%d", message.m_file.c_str(), message.m_line);
+    }
+    printf("\n");
+}
+
+int
+main(int argc, char** argv)
+{
+    Arch arch;
+    arch.init();
+
+    Log log;
+    log.setFilter(kDEBUG5);
+
+    const char* filename = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if ((strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "--debug") == 0) &&
+            i + 1 < argc) {
+            if (!log.setFilter(argv[++i])) {
+                fprintf(stderr, "%s: unrecognized log level `%s'\n",
+                    argv[0], argv[i]);
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        }
+        else if (filename == NULL && argv[i][0] != '-') {
+            filename = argv[i];
+        }
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (filename == NULL) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        fprintf(stderr, "%s: cannot open `%s'\n", argv[0], filename);
+        return 1;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+
+    TraceLogReader reader(data.data(), data.size());
+    if (!reader.isValid()) {
+        fprintf(stderr, "%s: `%s' is not a trace log\n", argv[0], filename);
+        return 1;
+    }
+
+    TraceLogReader::MessageList messages;
+    reader.read(messages);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        if (messages[i].m_level <= log.getFilter()) {
+            printMessage(messages[i]);
+        }
+    }
+    return 0;
+}
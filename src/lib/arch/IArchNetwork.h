@@ -53,6 +53,20 @@ An opaque type representing a network address.
 */
 typedef ArchNetAddressImpl* ArchNetAddress;
 
+/*!
+\class ArchPollSetImpl
+\brief Internal poll set data.
+An architecture dependent type holding the necessary data for a
+persistent set of sockets to poll.
+*/
+class ArchPollSetImpl;
+/*!
+\var ArchPollSet
+\brief Opaque poll set type.
+An opaque type representing a persistent poll set.
+*/
+typedef ArchPollSetImpl* ArchPollSet;
+
 //! Interface for architecture dependent networking
 /*!
 This interface defines the networking operations required by
@@ -102,6 +116,16 @@ public:
         unsigned short    m_revents;
     };
 
+    //! A poll set result for \c pollSocketSet()
+    class PollSetEntry {
+    public:
+        //! The key the socket was added to the poll set with
+        void*            m_key;
+
+        //! The result events
+        unsigned short    m_revents;
+    };
+
     //! @name manipulators
     //@{
 
@@ -197,6 +221,54 @@ public:
     */
     virtual void        unblockPollSocket(ArchThread thread) = 0;
 
+    //! Create a persistent poll set
+    /*!
+    Creates a poll set that keeps its sockets registered with the
+    operating system between calls to \c pollSocketSet(), so the cost
+    of a poll depends on the number of ready sockets rather than the
+    number of sockets in the set.  Returns NULL if the platform has no
+    such facility, in which case callers must use \c pollSocket().
+    */
+    virtual ArchPollSet    newPollSet() = 0;
+
+    //! Destroy a poll set
+    /*!
+    Destroys a poll set created with \c newPollSet().  The sockets in
+    the set are not closed.
+    */
+    virtual void        closePollSet(ArchPollSet) = 0;
+
+    //! Add or modify a socket in a poll set
+    /*!
+    Adds socket \c s to poll set \c set, or changes the events queried
+    for if it's already in the set.  \c events can be any combination
+    of kPOLLIN and kPOLLOUT;  kPOLLERR is always reported.  \c key must
+    not be NULL and is returned in \c PollSetEntry::m_key when the
+    socket is ready.
+    */
+    virtual void        setPollSetSocket(ArchPollSet set, ArchSocket s,
+                            unsigned short events, void* key) = 0;
+
+    //! Remove a socket from a poll set
+    /*!
+    Removes socket \c s from poll set \c set.  This must be called
+    before the last reference to \c s is closed.  Does nothing if
+    \c s is not in the set.
+    */
+    virtual void        removePollSetSocket(ArchPollSet set,
+                            ArchSocket s) = 0;
+
+    //! Check state of sockets in a poll set
+    /*!
+    Like \c pollSocket() but for the sockets in poll set \c set.  Fills
+    in at most \c num entries in \c pe, one for each ready socket, and
+    returns the number filled in.  Sockets that aren't ready are not
+    reported.  \c unblockPollSocket() causes this to return 0.
+    (Cancellation point)
+    */
+    virtual int            pollSocketSet(ArchPollSet set,
+                            PollSetEntry pe[], int num, double timeout) = 0;
+
     //! Read data from socket
     /*!
     Read up to \c len bytes from socket \c s in \c buf and return the
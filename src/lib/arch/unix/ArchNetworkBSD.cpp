@@ -46,6 +46,11 @@
 #    endif
 #endif
 
+#if HAVE_SYS_EPOLL_H
+#    include <sys/epoll.h>
+#    include <vector>
+#endif
+
 #if !HAVE_INET_ATON
 #    include <stdio.h>
 #endif
@@ -60,6 +65,17 @@ static const int s_type[] = {
     SOCK_STREAM
 };
 
+#if HAVE_SYS_EPOLL_H
+// a poll set is an epoll instance plus space for its results.  the
+// unblock pipe of the polling thread is registered with a NULL key.
+class ArchPollSetImpl {
+public:
+    int                    m_fd;
+    int                    m_unblockFd;
+    std::vector<struct epoll_event>    m_events;
+};
+#endif
+
 #if !HAVE_INET_ATON
 // parse dotted quad addresses.  we don't bother with the weird BSD'ism
 // of handling octal and hex and partial forms.
@@ -207,8 +223,9 @@ ArchNetworkBSD::listenOnSocket(ArchSocket s)
 {
     assert(s != NULL);
 
-    // hardcoding backlog
-    if (listen(s->m_fd, 3) == -1) {
+    // a short backlog drops connections when many clients connect at
+    // once, the secure listen socket limits pending handshakes instead
+    if (listen(s->m_fd, SOMAXCONN) == -1) {
         throwError(errno);
     }
 }
@@ -514,6 +531,189 @@ ArchNetworkBSD::unblockPollSocket(ArchThread thread)
     }
 }
 
+#if HAVE_SYS_EPOLL_H
+
+ArchPollSet
+ArchNetworkBSD::newPollSet()
+{
+    int fd = epoll_create1(EPOLL_CLOEXEC);
+    if (fd == -1) {
+        throwError(errno);
+    }
+
+    ArchPollSetImpl* newSet = new ArchPollSetImpl;
+    newSet->m_fd        = fd;
+    newSet->m_unblockFd = -1;
+    return newSet;
+}
+
+void
+ArchNetworkBSD::closePollSet(ArchPollSet set)
+{
+    assert(set != NULL);
+
+    close(set->m_fd);
+    delete set;
+}
+
+void
+ArchNetworkBSD::setPollSetSocket(ArchPollSet set, ArchSocket s,
+                unsigned short events, void* key)
+{
+    assert(set != NULL);
+    assert(s   != NULL);
+    assert(key != NULL);
+
+    struct epoll_event ev;
+    ev.events   = 0;
+    ev.data.ptr = key;
+    if ((events & kPOLLIN) != 0) {
+        ev.events |= EPOLLIN;
+    }
+    if ((events & kPOLLOUT) != 0) {
+        ev.events |= EPOLLOUT;
+    }
+
+    // modifying is the common case so try that first
+    if (epoll_ctl(set->m_fd, EPOLL_CTL_MOD, s->m_fd, &ev) == -1) {
+        if (errno != ENOENT) {
+            throwError(errno);
+        }
+        if (epoll_ctl(set->m_fd, EPOLL_CTL_ADD, s->m_fd, &ev) == -1) {
+            throwError(errno);
+        }
+    }
+}
+
+void
+ArchNetworkBSD::removePollSetSocket(ArchPollSet set, ArchSocket s)
+{
+    assert(set != NULL);
+    assert(s   != NULL);
+
+    // old kernels require a non-NULL event even though it's ignored
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    if (epoll_ctl(set->m_fd, EPOLL_CTL_DEL, s->m_fd, &ev) == -1) {
+        if (errno != ENOENT) {
+            throwError(errno);
+        }
+    }
+}
+
+int
+ArchNetworkBSD::pollSocketSet(ArchPollSet set,
+                PollSetEntry pe[], int num, double timeout)
+{
+    assert(set != NULL);
+    assert(pe  != NULL || num == 0);
+
+    // register the calling thread's unblock pipe.  a poll set is
+    // normally only ever polled by one thread so this happens once.
+    const int* unblockPipe = getUnblockPipe();
+    if (unblockPipe != NULL && unblockPipe[0] != set->m_unblockFd) {
+        struct epoll_event ev;
+        ev.events   = EPOLLIN;
+        ev.data.ptr = NULL;
+        if (epoll_ctl(set->m_fd, EPOLL_CTL_ADD, unblockPipe[0], &ev) == -1) {
+            throwError(errno);
+        }
+        if (set->m_unblockFd != -1) {
+            epoll_ctl(set->m_fd, EPOLL_CTL_DEL, set->m_unblockFd, &ev);
+        }
+        set->m_unblockFd = unblockPipe[0];
+    }
+
+    // leave room for the unblock pipe
+    if (set->m_events.size() < static_cast<size_t>(num) + 1) {
+        set->m_events.resize(num + 1);
+    }
+
+    // prepare timeout
+    int t = (timeout < 0.0) ? -1 : static_cast<int>(1000.0 * timeout);
+
+    // do the poll
+    int n = epoll_wait(set->m_fd, &set->m_events[0], num + 1, t);
+
+    // handle results
+    if (n == -1) {
+        if (errno == EINTR) {
+            // interrupted system call
+            ARCH->testCancelThread();
+            return 0;
+        }
+        throwError(errno);
+    }
+
+    // translate back.  if every slot was used by a socket then the
+    // last one is dropped but, since the set is level triggered, it
+    // will be reported again by the next poll.
+    int m = 0;
+    for (int i = 0; i < n; ++i) {
+        const struct epoll_event& ev = set->m_events[i];
+        if (ev.data.ptr == NULL) {
+            // the unblock event was signalled.  flush the pipe.
+            char dummy[100];
+            while (read(set->m_unblockFd, dummy, sizeof(dummy)) > 0) {
+                // discard
+            }
+            continue;
+        }
+        if (m == num) {
+            continue;
+        }
+        pe[m].m_key     = ev.data.ptr;
+        pe[m].m_revents = 0;
+        if ((ev.events & EPOLLIN) != 0) {
+            pe[m].m_revents |= kPOLLIN;
+        }
+        if ((ev.events & EPOLLOUT) != 0) {
+            pe[m].m_revents |= kPOLLOUT;
+        }
+        if ((ev.events & EPOLLERR) != 0) {
+            pe[m].m_revents |= kPOLLERR;
+        }
+        ++m;
+    }
+    return m;
+}
+
+#else
+
+ArchPollSet
+ArchNetworkBSD::newPollSet()
+{
+    // no persistent poll facility;  callers fall back to pollSocket()
+    return NULL;
+}
+
+void
+ArchNetworkBSD::closePollSet(ArchPollSet)
+{
+    assert(0 && "poll sets are not supported");
+}
+
+void
+ArchNetworkBSD::setPollSetSocket(ArchPollSet, ArchSocket, unsigned short, void*)
+{
+    assert(0 && "poll sets are not supported");
+}
+
+void
+ArchNetworkBSD::removePollSetSocket(ArchPollSet, ArchSocket)
+{
+    assert(0 && "poll sets are not supported");
+}
+
+int
+ArchNetworkBSD::pollSocketSet(ArchPollSet, PollSetEntry[], int, double)
+{
+    assert(0 && "poll sets are not supported");
+    return 0;
+}
+
+#endif
+
 size_t
 ArchNetworkBSD::readSocket(ArchSocket s, void* buf, size_t len)
 {
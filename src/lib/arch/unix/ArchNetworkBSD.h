@@ -74,6 +74,13 @@ public:
     virtual bool        connectSocket(ArchSocket s, ArchNetAddress name);
     virtual int            pollSocket(PollEntry[], int num, double timeout);
     virtual void        unblockPollSocket(ArchThread thread);
+    virtual ArchPollSet    newPollSet();
+    virtual void        closePollSet(ArchPollSet);
+    virtual void        setPollSetSocket(ArchPollSet, ArchSocket,
+                            unsigned short events, void* key);
+    virtual void        removePollSetSocket(ArchPollSet, ArchSocket);
+    virtual int            pollSocketSet(ArchPollSet,
+                            PollSetEntry[], int num, double timeout);
     virtual size_t        readSocket(ArchSocket s, void* buf, size_t len);
     virtual size_t        writeSocket(ArchSocket s,
                             const void* buf, size_t len);
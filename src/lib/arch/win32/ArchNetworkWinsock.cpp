@@ -310,8 +310,9 @@ ArchNetworkWinsock::listenOnSocket(ArchSocket s)
 {
     assert(s != NULL);
 
-    // hardcoding backlog
-    if (listen_winsock(s->m_socket, 3) == SOCKET_ERROR) {
+    // a short backlog drops connections when many clients connect at
+    // once, the secure listen socket limits pending handshakes instead
+    if (listen_winsock(s->m_socket, SOMAXCONN) == SOCKET_ERROR) {
         throwError(getsockerror_winsock());
     }
 }
@@ -550,6 +551,39 @@ ArchNetworkWinsock::unblockPollSocket(ArchThread thread)
     }
 }
 
+ArchPollSet
+ArchNetworkWinsock::newPollSet()
+{
+    // no persistent poll facility;  callers fall back to pollSocket()
+    return NULL;
+}
+
+void
+ArchNetworkWinsock::closePollSet(ArchPollSet)
+{
+    assert(0 && "poll sets are not supported");
+}
+
+void
+ArchNetworkWinsock::setPollSetSocket(ArchPollSet, ArchSocket,
+                unsigned short, void*)
+{
+    assert(0 && "poll sets are not supported");
+}
+
+void
+ArchNetworkWinsock::removePollSetSocket(ArchPollSet, ArchSocket)
+{
+    assert(0 && "poll sets are not supported");
+}
+
+int
+ArchNetworkWinsock::pollSocketSet(ArchPollSet, PollSetEntry[], int, double)
+{
+    assert(0 && "poll sets are not supported");
+    return 0;
+}
+
 size_t
 ArchNetworkWinsock::readSocket(ArchSocket s, void* buf, size_t len)
 {
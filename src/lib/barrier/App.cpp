@@ -23,6 +23,7 @@
 #include "barrier/protocol_types.h"
 #include "base/XBase.h"
 #include "base/log_outputters.h"
+#include "base/TraceLog.h"
 #include "barrier/XBarrier.h"
 #include "barrier/ArgsBase.h"
 #include "ipc/IpcServerProxy.h"
@@ -39,6 +40,7 @@
 
 #include <iostream>
 #include <stdio.h>
+#include <stdlib.h>
 
 #if WINAPI_CARBON
 #include <ApplicationServices/ApplicationServices.h>
@@ -72,6 +74,11 @@ App::App(IEventQueue* events, CreateTaskBarReceiverFunc createTaskBarReceiver, A
 
 App::~App()
 {
+    // report messages the file log could not keep up with
+    if (m_fileLog != nullptr && m_fileLog->getDropped() > 0) {
+        LOG((CLOG_WARN "%u messages were dropped from the log file", m_fileLog->getDropped()));
+    }
+
     s_instance = nullptr;
     delete m_args;
 }
@@ -137,14 +144,79 @@ App::daemonMainLoop(int, const char**)
     return mainLoop();
 }
 
+// parses a whole number of at most \c max
+static
+bool
+parseLogCount(const char* arg, UInt32 max, UInt32& value)
+{
+    char* end;
+    unsigned long n = strtoul(arg, &end, 10);
+    if (end == arg || *end != '\0' || arg[0] == '-' || n > max) {
+        return false;
+    }
+    value = (UInt32)n;
+    return true;
+}
+
+static
+bool
+parseLogSeconds(const char* arg, double& value)
+{
+    char* end;
+    double n = strtod(arg, &end);
+    if (end == arg || *end != '\0' || !(n >= 0.0)) {
+        return false;
+    }
+    value = n;
+    return true;
+}
+
 void
 App::setupFileLogging()
 {
+    UInt32 maxSize   = FileLogOutputter::kDefaultMaxSize;
+    UInt32 keepFiles = FileLogOutputter::kDefaultKeepFiles;
+    double interval  = -1.0;
+    if (argsBase().m_logMaxSize != NULL) {
+        UInt32 kb;
+        if (!parseLogCount(argsBase().m_logMaxSize, 0xffffffffu / 1024, kb) ||
+            kb == 0) {
+            LOG((CLOG_PRINT "%s: invalid log file size `%s'" BYE,
+                argsBase().m_exename.c_str(), argsBase().m_logMaxSize, argsBase().m_exename.c_str()));
+            m_bye(kExitArgs);
+            return;
+        }
+        maxSize = kb * 1024;
+    }
+    if (argsBase().m_logKeep != NULL &&
+        !parseLogCount(argsBase().m_logKeep, 1000, keepFiles)) {
+        LOG((CLOG_PRINT "%s: invalid number of log files `%s'" BYE,
+            argsBase().m_exename.c_str(), argsBase().m_logKeep, argsBase().m_exename.c_str()));
+        m_bye(kExitArgs);
+        return;
+    }
+    if (argsBase().m_logSync != NULL &&
+        !parseLogSeconds(argsBase().m_logSync, interval)) {
+        LOG((CLOG_PRINT "%s: invalid log sync interval `%s'" BYE,
+            argsBase().m_exename.c_str(), argsBase().m_logSync, argsBase().m_exename.c_str()));
+        m_bye(kExitArgs);
+        return;
+    }
+
     if (argsBase().m_logFile != NULL) {
         m_fileLog = new FileLogOutputter(argsBase().m_logFile);
-        CLOG->insert(m_fileLog);
+        m_fileLog->setRotation(maxSize, keepFiles);
+        m_fileLog->setSyncInterval(interval);
+
+        // at the head so a daemon's SystemLogger, which stops the
+        // console, doesn't stop the file too
+        CLOG->insert(m_fileLog, true);
         LOG((CLOG_DEBUG1 "logging to file (%s) enabled", argsBase().m_logFile));
     }
+    if (argsBase().m_logTrace != NULL) {
+        m_traceLog.reset(new TraceLog(argsBase().m_logTrace));
+        LOG((CLOG_DEBUG1 "trace log (%s) enabled", argsBase().m_logTrace));
+    }
 }
 
 void
@@ -174,6 +246,12 @@ App::initApp(int argc, const char** argv)
     }
     loggingFilterWarning();
 
+    if (!CLOG->setTimestampPrecision(argsBase().m_logTimestamps)) {
+        LOG((CLOG_PRINT "%s: unrecognized timestamp precision `%s'" BYE,
+            argsBase().m_exename.c_str(), argsBase().m_logTimestamps, argsBase().m_exename.c_str()));
+        m_bye(kExitArgs);
+    }
+
     if (argsBase().m_enableDragDrop) {
         LOG((CLOG_INFO "drag and drop enabled"));
         if (!argsBase().m_dropTarget.empty()) {
@@ -37,6 +37,7 @@ class IArchTaskBarReceiver;
 class BufferedLogOutputter;
 class ILogOutputter;
 class FileLogOutputter;
+class TraceLog;
 namespace barrier { class Screen; }
 class IEventQueue;
 class SocketMultiplexer;
@@ -76,7 +77,9 @@ public:
 
     static App& instance() { assert(s_instance != nullptr); return *s_instance; }
 
-    // If --log was specified in args, then add a file logger.
+    // If --log was specified in args, then add a file logger, rotated
+    // and synced as --log-max-size, --log-keep and --log-sync say.  If
+    // --log-trace was specified, then open the trace log.
     void setupFileLogging();
 
     // If messages will be hidden (to improve performance), warn user.
@@ -118,6 +121,7 @@ private:
     ArgsBase* m_args;
     static App* s_instance;
     FileLogOutputter* m_fileLog;
+    std::unique_ptr<TraceLog> m_traceLog;
     CreateTaskBarReceiverFunc m_createTaskBarReceiver;
     ARCH_APP_UTIL m_appUtil;
     IpcClient*            m_ipcClient;
@@ -164,6 +168,17 @@ private:
     "  -1, --no-restart         do not try to restart on failure.\n" \
     "      --restart            restart the server automatically if it fails. (*)\n" \
     "  -l  --log <file>         write log messages to file.\n" \
+    "      --log-timestamps <precision>\n" \
+    "                             timestamp log messages to the second (s),\n" \
+    "                             millisecond (ms) or microsecond (us).\n" \
+    "      --log-trace <file>   record protocol tracing in binary to file, for\n" \
+    "                             reading with barrier-logdump.\n" \
+    "      --log-max-size <kb>  start a new log file when it grows past this\n" \
+    "                             many kilobytes (default 1024).\n" \
+    "      --log-keep <count>   keep this many old log files, named file.1\n" \
+    "                             (newest) to file.<count> (default 1).\n" \
+    "      --log-sync <seconds> write log messages to the disk at most this\n" \
+    "                             many seconds after logging them.\n" \
     "      --no-tray            disable the system tray icon.\n" \
     "      --enable-drag-drop   enable file drag & drop.\n" \
     "      --enable-crypto      enable the crypto (ssl) plugin.\n" \
@@ -185,6 +185,21 @@ ArgParser::parseGenericArgs(int argc, const char* const* argv, int& i)
     else if (isArg(i, argc, argv, "-l", "--log", 1)) {
         argsBase().m_logFile = argv[++i];
     }
+    else if (isArg(i, argc, argv, NULL, "--log-timestamps", 1)) {
+        argsBase().m_logTimestamps = argv[++i];
+    }
+    else if (isArg(i, argc, argv, NULL, "--log-trace", 1)) {
+        argsBase().m_logTrace = argv[++i];
+    }
+    else if (isArg(i, argc, argv, NULL, "--log-max-size", 1)) {
+        argsBase().m_logMaxSize = argv[++i];
+    }
+    else if (isArg(i, argc, argv, NULL, "--log-keep", 1)) {
+        argsBase().m_logKeep = argv[++i];
+    }
+    else if (isArg(i, argc, argv, NULL, "--log-sync", 1)) {
+        argsBase().m_logSync = argv[++i];
+    }
     else if (isArg(i, argc, argv, "-f", "--no-daemon")) {
         // not a daemon
         argsBase().m_daemon = false;
@@ -35,6 +35,11 @@ m_restartable(true),
 m_noHooks(false),
 m_logFilter(NULL),
 m_logFile(NULL),
+m_logTimestamps(NULL),
+m_logTrace(NULL),
+m_logMaxSize(NULL),
+m_logKeep(NULL),
+m_logSync(NULL),
 m_display(NULL),
 m_disableTray(false),
 m_enableIpc(false),
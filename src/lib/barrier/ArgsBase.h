@@ -33,6 +33,11 @@ public:
     std::string            m_exename;
     const char*            m_logFilter;
     const char*            m_logFile;
+    const char*            m_logTimestamps;
+    const char*            m_logTrace;
+    const char*            m_logMaxSize;
+    const char*            m_logKeep;
+    const char*            m_logSync;
     const char*            m_display;
     String                m_name;
     bool                m_disableTray;
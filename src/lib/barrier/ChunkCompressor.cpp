@@ -0,0 +1,295 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/ChunkCompressor.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// the LZ4 block format
+const int                kHashBits      = 12;
+const size_t            kMinMatch      = 4;
+const size_t            kLastLiterals  = 5;
+const size_t            kMatchLimit    = 12;
+const size_t            kMaxOffset     = 65535;
+
+// level adaptation
+const UInt32            kMaxAcceleration = 32;
+const UInt32            kSkipChunks      = 16;
+
+inline
+UInt32
+read32(const UInt8* p)
+{
+    UInt32 v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+inline
+UInt32
+hash4(UInt32 v)
+{
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+// lengths of 15 and over continue in bytes of 255 and a last byte
+// that's less
+inline
+void
+writeLength(UInt8*& op, size_t length)
+{
+    for (; length >= 255; length -= 255) {
+        *op++ = 255;
+    }
+    *op++ = static_cast<UInt8>(length);
+}
+
+inline
+bool
+readLength(const UInt8*& ip, const UInt8* end, size_t& length)
+{
+    UInt8 byte;
+    do {
+        if (ip == end) {
+            return false;
+        }
+        byte    = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+inline
+void
+writeSequence(UInt8*& op, const UInt8* literals, size_t numLiterals,
+                size_t offset, size_t matchLength)
+{
+    UInt8* token = op++;
+    *token = static_cast<UInt8>(std::min(numLiterals, (size_t)15) << 4);
+    if (numLiterals >= 15) {
+        writeLength(op, numLiterals - 15);
+    }
+    memcpy(op, literals, numLiterals);
+    op += numLiterals;
+
+    // the last sequence has no match
+    if (offset == 0) {
+        return;
+    }
+    matchLength -= kMinMatch;
+    *token |= static_cast<UInt8>(std::min(matchLength, (size_t)15));
+    *op++   = static_cast<UInt8>(offset & 0xff);
+    *op++   = static_cast<UInt8>(offset >> 8);
+    if (matchLength >= 15) {
+        writeLength(op, matchLength - 15);
+    }
+}
+
+// returns the size of the block written to dst, which has room for
+// size + size / 255 + 16 bytes
+size_t
+compressBlock(const UInt8* src, size_t size, UInt8* dst,
+                UInt32* table, UInt32 acceleration)
+{
+    UInt8* op              = dst;
+    const UInt8* anchor    = src;
+    const UInt8* end       = src + size;
+
+    if (size > kMatchLimit) {
+        const UInt8* limit    = end - kMatchLimit;
+        const UInt8* matchEnd = end - kLastLiterals;
+        std::fill(table, table + (1 << kHashBits), 0);
+
+        const UInt8* ip = src + 1;
+        UInt32 misses   = 0;
+        while (ip < limit) {
+            UInt32 h           = hash4(read32(ip));
+            const UInt8* match = src + table[h];
+            table[h]           = static_cast<UInt32>(ip - src);
+
+            // search less often the longer nothing matches
+            if ((size_t)(ip - match) > kMaxOffset || read32(match) != read32(ip)) {
+                ip += acceleration + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            // extend the match both ways
+            while (ip > anchor && match > src && ip[-1] == match[-1]) {
+                --ip;
+                --match;
+            }
+            const UInt8* next = ip + kMinMatch;
+            match += kMinMatch;
+            while (next < matchEnd && *next == *match) {
+                ++next;
+                ++match;
+            }
+
+            writeSequence(op, anchor, ip - anchor,
+                            next - match, next - ip);
+            ip     = next;
+            anchor = next;
+        }
+    }
+
+    writeSequence(op, anchor, end - anchor, 0, 0);
+    return op - dst;
+}
+
+bool
+decompressBlock(const UInt8* ip, const UInt8* end, UInt8* dst, UInt8* dstEnd)
+{
+    UInt8* op = dst;
+    while (ip != end) {
+        UInt8 token = *ip++;
+
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && !readLength(ip, end, numLiterals)) {
+            return false;
+        }
+        if ((size_t)(end - ip) < numLiterals || (size_t)(dstEnd - op) < numLiterals) {
+            return false;
+        }
+        memcpy(op, ip, numLiterals);
+        op += numLiterals;
+        ip += numLiterals;
+
+        // the last sequence has no match
+        if (ip == end) {
+            break;
+        }
+        if (end - ip < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) {
+            return false;
+        }
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(ip, end, matchLength)) {
+            return false;
+        }
+        matchLength += kMinMatch;
+        if ((size_t)(dstEnd - op) < matchLength) {
+            return false;
+        }
+
+        // a match may overlap what it's copying
+        const UInt8* match = op - offset;
+        if (offset >= matchLength) {
+            memcpy(op, match, matchLength);
+            op += matchLength;
+        }
+        else {
+            for (; matchLength != 0; --matchLength) {
+                *op++ = *match++;
+            }
+        }
+    }
+    return (op == dstEnd);
+}
+
+}
+
+//
+// ChunkCompressor
+//
+
+const size_t            ChunkCompressor::kThreshold = 1024;
+const size_t            ChunkCompressor::kMaxSize   = 1024 * 1024;
+
+ChunkCompressor::ChunkCompressor() :
+    m_table(1 << kHashBits),
+    m_acceleration(1),
+    m_skip(0)
+{
+    // do nothing
+}
+
+void
+ChunkCompressor::start()
+{
+    m_acceleration = 1;
+    m_skip         = 0;
+}
+
+bool
+ChunkCompressor::compress(const void* data, size_t size, String& compressed)
+{
+    if (size < kThreshold || size > kMaxSize) {
+        return false;
+    }
+    if (m_skip != 0) {
+        --m_skip;
+        return false;
+    }
+
+    compressed.resize(4 + size + size / 255 + 16);
+    UInt8* out = reinterpret_cast<UInt8*>(&compressed[0]);
+    out[0] = static_cast<UInt8>((size >> 24) & 0xff);
+    out[1] = static_cast<UInt8>((size >> 16) & 0xff);
+    out[2] = static_cast<UInt8>((size >>  8) & 0xff);
+    out[3] = static_cast<UInt8>( size        & 0xff);
+    size_t n = compressBlock(static_cast<const UInt8*>(data), size,
+                            out + 4, &m_table[0], m_acceleration);
+    compressed.resize(4 + n);
+
+    // search less for data that barely compresses and then stop trying
+    // for a while.  search more again for data that compresses well.
+    if (compressed.size() > size - size / 8) {
+        if (m_acceleration < kMaxAcceleration) {
+            m_acceleration *= 2;
+        }
+        else {
+            m_skip = kSkipChunks;
+        }
+        return false;
+    }
+    if (compressed.size() < size / 2 && m_acceleration > 1) {
+        m_acceleration /= 2;
+    }
+    return true;
+}
+
+bool
+ChunkCompressor::decompress(const void* data, size_t size, String& decompressed)
+{
+    const UInt8* in = static_cast<const UInt8*>(data);
+    if (size < 4) {
+        return false;
+    }
+    size_t length = ((size_t)in[0] << 24) | ((size_t)in[1] << 16) |
+                    ((size_t)in[2] <<  8) |  (size_t)in[3];
+    if (length > kMaxSize) {
+        return false;
+    }
+
+    size_t offset = decompressed.size();
+    decompressed.resize(offset + length);
+    UInt8* out = reinterpret_cast<UInt8*>(&decompressed[0]) + offset;
+    if (!decompressBlock(in + 4, in + size, out, out + length)) {
+        decompressed.resize(offset);
+        return false;
+    }
+    return true;
+}
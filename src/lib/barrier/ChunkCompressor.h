@@ -0,0 +1,89 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/String.h"
+#include "common/basic_types.h"
+#include "common/stdvector.h"
+
+//! Compressor for clipboard and file chunks
+/*!
+Compresses the chunks of a transfer one at a time, each on its own, so
+the receiver can decompress a chunk as soon as it arrives.  A compressed
+chunk is the size of the data as 4 bytes, most significant first, then
+the data as an LZ4 block.
+
+Chunks smaller than kThreshold aren't compressed and neither are chunks
+that compression barely shrinks.  The level adapts as a transfer goes:
+data that compresses poorly is searched less thoroughly and, once that
+doesn't pay off either, left alone for a while.  Call start() before
+each transfer.
+*/
+class ChunkCompressor {
+public:
+    ChunkCompressor();
+
+    //! @name manipulators
+    //@{
+
+    //! Start a transfer
+    /*!
+    Goes back to compressing each chunk as thoroughly as possible.
+    */
+    void                start();
+
+    //! Compress a chunk
+    /*!
+    Compresses \c size bytes at \c data into \c compressed and returns
+    true.  Returns false if the chunk should be sent as it is instead.
+    */
+    bool                compress(const void* data, size_t size,
+                            String& compressed);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Decompress a chunk
+    /*!
+    Appends the data in the compressed chunk of \c size bytes at \c data
+    to \c decompressed.  Returns false if the chunk is malformed or its
+    data is larger than kMaxSize.
+    */
+    static bool            decompress(const void* data, size_t size,
+                            String& decompressed);
+
+    //@}
+
+    //! Smallest chunk that's compressed
+    static const size_t    kThreshold;
+
+    //! Largest data a compressed chunk may have
+    static const size_t    kMaxSize;
+
+private:
+    // positions in the chunk being compressed, by hash of the 4 bytes
+    // there
+    std::vector<UInt32>    m_table;
+
+    // each position tried skips this many more when nothing matches
+    UInt32                m_acceleration;
+
+    // chunks left to send without trying to compress them
+    UInt32                m_skip;
+};
@@ -66,6 +66,26 @@ Clipboard::add(EFormat format, const String& data)
     m_added[format] = true;
 }
 
+void
+Clipboard::adopt(EFormat format, String& data)
+{
+    assert(m_open);
+    assert(m_owner);
+
+    m_data[format].swap(data);
+    m_added[format] = true;
+    data.clear();
+}
+
+void
+Clipboard::take(EFormat format, String& data)
+{
+    assert(m_open);
+
+    data.clear();
+    data.swap(m_data[format]);
+}
+
 bool
 Clipboard::open(Time time) const
 {
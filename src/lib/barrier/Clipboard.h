@@ -39,6 +39,20 @@ public:
     */
     void                unmarshall(const String& data, Time time);
 
+    //! Adopt format data
+    /*!
+    Like add() but moves \c data into the clipboard instead of copying
+    it.  \c data is left empty.
+    */
+    void                adopt(EFormat, String& data);
+
+    //! Take format data
+    /*!
+    Moves the data of a format into \c data instead of copying it.  The
+    clipboard still has the format but its data is left empty.
+    */
+    void                take(EFormat, String& data);
+
     //@}
     //! @name accessors
     //@{
@@ -0,0 +1,213 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/ClipboardCache.h"
+
+namespace {
+
+const std::uint64_t        kPrime1 = 0x9e3779b185ebca87ULL;
+const std::uint64_t        kPrime2 = 0xc2b2ae3d27d4eb4fULL;
+const std::uint64_t        kPrime3 = 0x165667b19e3779f9ULL;
+const std::uint64_t        kPrime4 = 0x85ebca77c2b2ae63ULL;
+const std::uint64_t        kPrime5 = 0x27d4eb2f165667c5ULL;
+
+inline
+std::uint64_t
+rotate(std::uint64_t x, int bits)
+{
+    return (x << bits) | (x >> (64 - bits));
+}
+
+// the hash reads little endian whatever the host byte order
+inline
+std::uint64_t
+read64(const UInt8* p)
+{
+    return  (std::uint64_t)p[0]        | ((std::uint64_t)p[1] <<  8) |
+           ((std::uint64_t)p[2] << 16) | ((std::uint64_t)p[3] << 24) |
+           ((std::uint64_t)p[4] << 32) | ((std::uint64_t)p[5] << 40) |
+           ((std::uint64_t)p[6] << 48) | ((std::uint64_t)p[7] << 56);
+}
+
+inline
+std::uint64_t
+read32(const UInt8* p)
+{
+    return  (std::uint64_t)p[0]        | ((std::uint64_t)p[1] <<  8) |
+           ((std::uint64_t)p[2] << 16) | ((std::uint64_t)p[3] << 24);
+}
+
+inline
+std::uint64_t
+mix(std::uint64_t acc, std::uint64_t input)
+{
+    acc += input * kPrime2;
+    acc  = rotate(acc, 31);
+    return acc * kPrime1;
+}
+
+inline
+std::uint64_t
+merge(std::uint64_t acc, std::uint64_t value)
+{
+    acc ^= mix(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+}
+
+//
+// ClipboardCache
+//
+
+const size_t            ClipboardCache::kDefaultMaxSize = 64 * 1024 * 1024;
+
+ClipboardCache::ClipboardCache(size_t maxSize) :
+    m_maxSize(maxSize),
+    m_size(0)
+{
+    // do nothing
+}
+
+void
+ClipboardCache::add(std::uint64_t hash, const String& data)
+{
+    if (data.size() > m_maxSize || has(hash, (UInt32)data.size())) {
+        return;
+    }
+
+    Item item;
+    item.m_hash = hash;
+    item.m_data = data;
+    m_items.push_front(item);
+    m_size += data.size();
+
+    // drop the least recently used
+    while (m_size > m_maxSize) {
+        m_size -= m_items.back().m_data.size();
+        m_items.pop_back();
+    }
+}
+
+bool
+ClipboardCache::find(std::uint64_t hash, UInt32 size, String& data)
+{
+    ItemList::const_iterator i = findItem(hash, size);
+    if (i == m_items.end()) {
+        return false;
+    }
+    m_items.splice(m_items.begin(), m_items, i);
+    data = m_items.front().m_data;
+    return true;
+}
+
+void
+ClipboardCache::clear()
+{
+    m_items.clear();
+    m_size = 0;
+}
+
+bool
+ClipboardCache::has(std::uint64_t hash, UInt32 size) const
+{
+    return (findItem(hash, size) != m_items.end());
+}
+
+std::uint64_t
+ClipboardCache::hash(const void* data, size_t size)
+{
+    const UInt8* p   = static_cast<const UInt8*>(data);
+    const UInt8* end = p + size;
+
+    std::uint64_t h;
+    if (size >= 32) {
+        std::uint64_t v1 = kPrime1 + kPrime2;
+        std::uint64_t v2 = kPrime2;
+        std::uint64_t v3 = 0;
+        std::uint64_t v4 = 0 - kPrime1;
+        for (const UInt8* limit = end - 32; p <= limit; p += 32) {
+            v1 = mix(v1, read64(p));
+            v2 = mix(v2, read64(p + 8));
+            v3 = mix(v3, read64(p + 16));
+            v4 = mix(v4, read64(p + 24));
+        }
+        h = rotate(v1, 1) + rotate(v2, 7) + rotate(v3, 12) + rotate(v4, 18);
+        h = merge(h, v1);
+        h = merge(h, v2);
+        h = merge(h, v3);
+        h = merge(h, v4);
+    }
+    else {
+        h = kPrime5;
+    }
+    h += (std::uint64_t)size;
+
+    for (; end - p >= 8; p += 8) {
+        h ^= mix(0, read64(p));
+        h  = rotate(h, 27) * kPrime1 + kPrime4;
+    }
+    if (end - p >= 4) {
+        h ^= read32(p) * kPrime1;
+        h  = rotate(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p != end; ++p) {
+        h ^= *p * kPrime5;
+        h  = rotate(h, 11) * kPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+void
+ClipboardCache::summarize(const IClipboard* clipboard, Summary& summary)
+{
+    summary.clear();
+    if (!clipboard->open(0)) {
+        return;
+    }
+    for (UInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+        IClipboard::EFormat eFormat = static_cast<IClipboard::EFormat>(format);
+        if (clipboard->has(eFormat)) {
+            String data = clipboard->get(eFormat);
+
+            Entry entry;
+            entry.m_format = eFormat;
+            entry.m_size   = (UInt32)data.size();
+            entry.m_hash   = hash(data.data(), data.size());
+            summary.push_back(entry);
+        }
+    }
+    clipboard->close();
+}
+
+ClipboardCache::ItemList::const_iterator
+ClipboardCache::findItem(std::uint64_t hash, UInt32 size) const
+{
+    for (ItemList::const_iterator i = m_items.begin(); i != m_items.end(); ++i) {
+        if (i->m_hash == hash && i->m_data.size() == size) {
+            return i;
+        }
+    }
+    return m_items.end();
+}
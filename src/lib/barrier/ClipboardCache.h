@@ -0,0 +1,120 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "barrier/IClipboard.h"
+#include "base/String.h"
+#include "common/stdlist.h"
+#include "common/stdvector.h"
+
+#include <cstdint>
+
+//! Recently received clipboard data
+/*!
+Keeps the data of recently received clipboard formats, looked up by a
+hash of the data, so a clipboard with formats that were sent before can
+be rebuilt without sending them again.  The least recently used data is
+dropped once the cache holds more than its size limit.
+
+Data is hashed with XXH64 and a seed of zero.  Both ends of a
+connection compute the hash so it must not change between versions.
+*/
+class ClipboardCache {
+public:
+    //! Hash and size of the data in one clipboard format
+    class Entry {
+    public:
+        IClipboard::EFormat    m_format;
+        UInt32                m_size;
+        std::uint64_t        m_hash;
+    };
+
+    //! The formats in a clipboard, in format order
+    typedef std::vector<Entry> Summary;
+
+    //! Default size limit in bytes
+    static const size_t    kDefaultMaxSize;
+
+    ClipboardCache(size_t maxSize = kDefaultMaxSize);
+
+    //! @name manipulators
+    //@{
+
+    //! Add data
+    /*!
+    Saves \c data, whose hash is \c hash, as the most recently used.
+    Data larger than the size limit isn't saved.
+    */
+    void                add(std::uint64_t hash, const String& data);
+
+    //! Find data
+    /*!
+    Copies the data with hash \c hash and size \c size to \c data, marks
+    it as the most recently used and returns true.  Returns false if the
+    cache doesn't have it.
+    */
+    bool                find(std::uint64_t hash, UInt32 size, String& data);
+
+    //! Discard all data
+    void                clear();
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Test for data
+    /*!
+    Returns true if the cache has the data with hash \c hash and size
+    \c size.
+    */
+    bool                has(std::uint64_t hash, UInt32 size) const;
+
+    //! Get the number of bytes of data saved
+    size_t                getSize() const { return m_size; }
+
+    //! Hash data
+    static std::uint64_t    hash(const void* data, size_t size);
+
+    //! Summarize a clipboard
+    /*!
+    Fills \c summary with the hash and size of each format in
+    \c clipboard.
+    */
+    static void            summarize(const IClipboard* clipboard,
+                            Summary& summary);
+
+    //@}
+
+private:
+    class Item {
+    public:
+        std::uint64_t    m_hash;
+        String            m_data;
+    };
+    typedef std::list<Item> ItemList;
+
+    ItemList::const_iterator
+                        findItem(std::uint64_t hash, UInt32 size) const;
+
+private:
+    size_t                m_maxSize;
+    size_t                m_size;
+
+    // most recently used first
+    ItemList            m_items;
+};
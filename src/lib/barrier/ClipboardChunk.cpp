@@ -23,8 +23,6 @@
 #include "base/Log.h"
 #include <cstring>
 
-size_t ClipboardChunk::s_expectedSize = 0;
-
 ClipboardChunk::ClipboardChunk(size_t size) :
     Chunk(size)
 {
@@ -85,7 +83,7 @@ ClipboardChunk::end(ClipboardID id, UInt32 sequence)
 
 int
 ClipboardChunk::assemble(barrier::IStream* stream,
-                    String& dataCached,
+                    ClipboardTransfer* transfers,
                     ClipboardID& id,
                     UInt32& sequence)
 {
@@ -96,25 +94,41 @@ ClipboardChunk::assemble(barrier::IStream* stream,
         return kError;
     }
 
+    // validate
+    if (id >= kClipboardEnd) {
+        return kError;
+    }
+    ClipboardUnmarshaller& clipboard = transfers[id].m_data;
+    TransferProgress& progress       = transfers[id].m_progress;
+
     if (mark == kDataStart) {
-        s_expectedSize = barrier::string::stringToSizeType(data);
-        LOG((CLOG_DEBUG "start receiving clipboard data"));
-        dataCached.clear();
+        size_t size = barrier::string::stringToSizeType(data);
+        LOG((CLOG_DEBUG "start receiving clipboard %d data", id));
+        clipboard.reset(size);
+        progress.start(size);
         return kStart;
     }
-    else if (mark == kDataChunk) {
-        dataCached.append(data);
+    else if (mark == kDataChunk || mark == kDataCompressed) {
+        // unmarshall as it arrives.  a bad chunk is reported at the end.
+        if (mark == kDataChunk) {
+            clipboard.add(data.data(), data.size());
+        }
+        else {
+            clipboard.addCompressed(data.data(), data.size());
+        }
+        if (progress.add(data.size())) {
+            LOG((CLOG_DEBUG2 "recv clipboard %d average speed=%f kb/s", id, progress.getRate() / 1000));
+        }
         return kNotFinish;
     }
     else if (mark == kDataEnd) {
-        // validate
-        if (id >= kClipboardEnd) {
-            return kError;
-        }
-        else if (s_expectedSize != dataCached.size()) {
-            LOG((CLOG_ERR "corrupted clipboard data, expected size=%d actual size=%d", s_expectedSize, dataCached.size()));
+        progress.finish();
+        if (!clipboard.isComplete()) {
+            LOG((CLOG_ERR "corrupted clipboard data, expected size=%d actual size=%d", clipboard.getExpectedSize(), clipboard.getSize()));
             return kError;
         }
+        LOG((CLOG_DEBUG2 "clipboard %d transfer finished: %d bytes received in %f s, average speed=%f kb/s",
+                id, progress.getReceived(), progress.getTime(), progress.getRate() / 1000));
         return kFinish;
     }
 
@@ -18,6 +18,8 @@
 #pragma once
 
 #include "barrier/Chunk.h"
+#include "barrier/ClipboardUnmarshaller.h"
+#include "barrier/TransferProgress.h"
 #include "barrier/clipboard_types.h"
 #include "base/String.h"
 #include "common/basic_types.h"
@@ -28,6 +30,18 @@ namespace barrier {
 class IStream;
 };
 
+//! A clipboard being received
+/*!
+Each connection has one for each clipboard so clipboards can be
+received from several clients, and different clipboards from one
+client, at once.
+*/
+class ClipboardTransfer {
+public:
+    ClipboardUnmarshaller    m_data;
+    TransferProgress    m_progress;
+};
+
 class ClipboardChunk : public Chunk {
 public:
     ClipboardChunk(size_t size);
@@ -45,16 +59,16 @@ public:
     static ClipboardChunk*
                         end(ClipboardID id, UInt32 sequence);
 
+    //! Assemble a chunk
+    /*!
+    Reads a kMsgDClipboard chunk into the transfer for its clipboard,
+    one of the kClipboardEnd \c transfers.
+    */
     static int            assemble(
                             barrier::IStream* stream,
-                            String& dataCached,
+                            ClipboardTransfer* transfers,
                             ClipboardID& id,
                             UInt32& sequence);
 
     static void            send(barrier::IStream* stream, void* data);
-
-    static size_t        getExpectedSize() { return s_expectedSize; }
-
-private:
-    static size_t        s_expectedSize;
 };
@@ -0,0 +1,212 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/ClipboardStreamer.h"
+
+#include "barrier/ProtocolUtil.h"
+#include "barrier/protocol_types.h"
+#include "io/IStream.h"
+#include "base/Log.h"
+
+#include <algorithm>
+
+static
+void
+writeUInt32(String& buf, UInt32 v)
+{
+    buf += static_cast<char>((v >> 24) & 0xff);
+    buf += static_cast<char>((v >> 16) & 0xff);
+    buf += static_cast<char>((v >>  8) & 0xff);
+    buf += static_cast<char>( v        & 0xff);
+}
+
+//
+// ClipboardStreamer
+//
+
+const size_t            ClipboardStreamer::kChunkSize    = 32 * 1024;
+const size_t            ClipboardStreamer::kWindowChunks = 4;
+
+ClipboardStreamer::ClipboardStreamer(barrier::IStream* stream) :
+    m_stream(stream),
+    m_compression(false)
+{
+    // do nothing
+}
+
+ClipboardStreamer::~ClipboardStreamer()
+{
+    // do nothing
+}
+
+void
+ClipboardStreamer::send(ClipboardID id, UInt32 sequence, Clipboard& clipboard)
+{
+    // a newer clipboard replaces one not done yet
+    for (TransferList::iterator i = m_transfers.begin(); i != m_transfers.end(); ) {
+        if (i->m_id == id) {
+            LOG((CLOG_DEBUG "dropped clipboard %d seqnum=%d, replaced", id, i->m_sequence));
+            i = m_transfers.erase(i);
+        }
+        else {
+            ++i;
+        }
+    }
+    bool idle = m_transfers.empty();
+
+    // the pieces point into the transfer so it's filled in place
+    m_transfers.push_back(Transfer());
+    Transfer& transfer  = m_transfers.back();
+    transfer.m_id       = id;
+    transfer.m_sequence = sequence;
+
+    // take the data instead of copying it
+    bool added[IClipboard::kNumFormats];
+    UInt32 numFormats = 0;
+    if (clipboard.open(0)) {
+        for (UInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+            IClipboard::EFormat eFormat = static_cast<IClipboard::EFormat>(format);
+            added[format] = clipboard.has(eFormat);
+            if (added[format]) {
+                clipboard.take(eFormat, transfer.m_data[format]);
+                ++numFormats;
+            }
+        }
+        clipboard.close();
+    }
+    else {
+        std::fill(added, added + IClipboard::kNumFormats, false);
+    }
+
+    // the headers are complete before any piece points into them
+    String& headers = transfer.m_headers;
+    writeUInt32(headers, numFormats);
+    for (UInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+        if (added[format]) {
+            writeUInt32(headers, format);
+            writeUInt32(headers, (UInt32)transfer.m_data[format].size());
+        }
+    }
+
+    // lay out the pieces in marshalled order
+    const char* header = headers.data();
+    transfer.m_pieces.push_back(std::make_pair(header, (size_t)4));
+    header += 4;
+    for (UInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+        if (added[format]) {
+            const String& data = transfer.m_data[format];
+            transfer.m_pieces.push_back(std::make_pair(header, (size_t)8));
+            transfer.m_pieces.push_back(std::make_pair(data.data(), data.size()));
+            header += 8;
+        }
+    }
+    for (size_t i = 0; i < transfer.m_pieces.size(); ++i) {
+        transfer.m_size += transfer.m_pieces[i].second;
+    }
+
+    // otherwise the transfer in flight calls flush() when it drains
+    if (idle) {
+        flush();
+    }
+}
+
+void
+ClipboardStreamer::setCompression(bool compression)
+{
+    m_compression = compression;
+}
+
+void
+ClipboardStreamer::flush()
+{
+    for (size_t i = 0; i < kWindowChunks && !m_transfers.empty(); ++i) {
+        if (!writeChunk(m_transfers.front())) {
+            m_transfers.pop_front();
+        }
+    }
+}
+
+bool
+ClipboardStreamer::writeChunk(Transfer& transfer)
+{
+    // first the size
+    if (!transfer.m_started) {
+        transfer.m_started = true;
+        m_compressor.start();
+        m_chunk = barrier::string::sizeTypeToString(transfer.m_size);
+        LOG((CLOG_DEBUG2 "sending clipboard chunk start: size=%s", m_chunk.c_str()));
+        ProtocolUtil::writef(m_stream, kMsgDClipboard,
+                            transfer.m_id, transfer.m_sequence, kDataStart, &m_chunk);
+        return true;
+    }
+
+    // then the marshalled data, a chunk at a time
+    if (transfer.m_piece < transfer.m_pieces.size()) {
+        m_chunk.clear();
+        while (m_chunk.size() < kChunkSize &&
+                transfer.m_piece < transfer.m_pieces.size()) {
+            const std::pair<const char*, size_t>& piece =
+                transfer.m_pieces[transfer.m_piece];
+            size_t n = std::min(piece.second - transfer.m_offset,
+                                kChunkSize - m_chunk.size());
+            m_chunk.append(piece.first + transfer.m_offset, n);
+            transfer.m_offset += n;
+            if (transfer.m_offset == piece.second) {
+                ++transfer.m_piece;
+                transfer.m_offset = 0;
+            }
+        }
+        if (m_compression &&
+                m_compressor.compress(m_chunk.data(), m_chunk.size(), m_compressed)) {
+            LOG((CLOG_DEBUG2 "sending clipboard chunk data: size=%i compressed=%i", m_chunk.size(), m_compressed.size()));
+            transfer.m_sent += m_compressed.size();
+            ProtocolUtil::writef(m_stream, kMsgDClipboard,
+                            transfer.m_id, transfer.m_sequence, kDataCompressed, &m_compressed);
+        }
+        else {
+            LOG((CLOG_DEBUG2 "sending clipboard chunk data: size=%i", m_chunk.size()));
+            transfer.m_sent += m_chunk.size();
+            ProtocolUtil::writef(m_stream, kMsgDClipboard,
+                            transfer.m_id, transfer.m_sequence, kDataChunk, &m_chunk);
+        }
+        return true;
+    }
+
+    // and the end
+    m_chunk.clear();
+    LOG((CLOG_DEBUG2 "sending clipboard finished"));
+    ProtocolUtil::writef(m_stream, kMsgDClipboard,
+                        transfer.m_id, transfer.m_sequence, kDataEnd, &m_chunk);
+    LOG((CLOG_DEBUG "sent clipboard size=%d written=%d", transfer.m_size, transfer.m_sent));
+    return false;
+}
+
+//
+// ClipboardStreamer::Transfer
+//
+
+ClipboardStreamer::Transfer::Transfer() :
+    m_id(0),
+    m_sequence(0),
+    m_started(false),
+    m_piece(0),
+    m_offset(0),
+    m_size(0),
+    m_sent(0)
+{
+    // do nothing
+}
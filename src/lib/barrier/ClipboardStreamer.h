@@ -0,0 +1,130 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "barrier/ChunkCompressor.h"
+#include "barrier/Clipboard.h"
+#include "barrier/clipboard_types.h"
+#include "base/String.h"
+#include "common/stdlist.h"
+#include "common/stdvector.h"
+
+namespace barrier { class IStream; }
+
+//! Clipboard sender
+/*!
+Sends clipboards as kMsgDClipboard chunks of their marshalled form (see
+IClipboard::marshall()), read straight from each format's data rather
+than marshalling the whole clipboard first.  Only a window of chunks is
+written at a time so the stream's output buffer stays small.  The owner
+calls flush() each time the stream's output has drained to write the
+next window.
+
+With compression on, each chunk that ChunkCompressor shrinks is sent
+compressed with a kDataCompressed mark instead.  Only peers using
+protocol 1.9 or later understand that.
+*/
+class ClipboardStreamer {
+public:
+    ClipboardStreamer(barrier::IStream* stream);
+    ~ClipboardStreamer();
+
+    //! @name manipulators
+    //@{
+
+    //! Send a clipboard
+    /*!
+    Sends \c clipboard as clipboard \c id with sequence number
+    \c sequence after anything already being sent.  Its data is taken
+    from \c clipboard, which is left with empty formats.  A clipboard
+    with the same \c id that isn't done is dropped;  the receiver
+    starts over when it sees the new one begin.
+    */
+    void                send(ClipboardID id, UInt32 sequence,
+                            Clipboard& clipboard);
+
+    //! Set compression
+    /*!
+    Compresses the chunks of clipboards sent from now on if
+    \c compression is true.  It's off by default.
+    */
+    void                setCompression(bool compression);
+
+    //! Write the next window
+    /*!
+    Writes up to kWindowChunks chunks.  Call when the stream's output
+    has drained.
+    */
+    void                flush();
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Test if sending
+    /*!
+    Returns true if any clipboard isn't completely written.
+    */
+    bool                isSending() const { return !m_transfers.empty(); }
+
+    //@}
+
+    //! Largest chunk of data in one message
+    static const size_t    kChunkSize;
+
+    //! Chunks written each flush()
+    static const size_t    kWindowChunks;
+
+private:
+    class Transfer {
+    public:
+        Transfer();
+
+    public:
+        ClipboardID        m_id;
+        UInt32            m_sequence;
+        bool            m_started;
+
+        // the format count and headers and each format's data
+        String            m_headers;
+        String            m_data[IClipboard::kNumFormats];
+
+        // the marshalled clipboard as pieces of the above, in order,
+        // and where the next chunk starts
+        std::vector<std::pair<const char*, size_t> >    m_pieces;
+        size_t            m_piece;
+        size_t            m_offset;
+        size_t            m_size;
+
+        // bytes of data written, after compression
+        size_t            m_sent;
+    };
+    typedef std::list<Transfer> TransferList;
+
+    // write the next message of the front transfer.  returns false
+    // once it's done.
+    bool                writeChunk(Transfer&);
+
+private:
+    barrier::IStream*    m_stream;
+    TransferList        m_transfers;
+    String                m_chunk;
+    bool                m_compression;
+    ChunkCompressor        m_compressor;
+    String                m_compressed;
+};
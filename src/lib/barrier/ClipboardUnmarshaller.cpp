@@ -0,0 +1,208 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/ClipboardUnmarshaller.h"
+
+#include "barrier/ChunkCompressor.h"
+
+#include <algorithm>
+#include <cstring>
+
+static
+UInt32
+readUInt32(const UInt8* buf)
+{
+    return  (static_cast<UInt32>(buf[0]) << 24) |
+            (static_cast<UInt32>(buf[1]) << 16) |
+            (static_cast<UInt32>(buf[2]) <<  8) |
+             static_cast<UInt32>(buf[3]);
+}
+
+//
+// ClipboardUnmarshaller
+//
+
+ClipboardUnmarshaller::ClipboardUnmarshaller()
+{
+    reset(0);
+}
+
+void
+ClipboardUnmarshaller::reset(size_t size)
+{
+    m_state        = kCount;
+    m_size         = 0;
+    m_expectedSize = size;
+    m_headerSize   = 0;
+    m_formatsLeft  = 0;
+    m_format       = 0;
+    m_dataLeft     = 0;
+    for (UInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+        m_added[format] = false;
+        String().swap(m_data[format]);
+    }
+}
+
+bool
+ClipboardUnmarshaller::add(const void* vdata, size_t size)
+{
+    if (m_state == kFailed) {
+        return false;
+    }
+    if (size > m_expectedSize - m_size) {
+        m_state = kFailed;
+        return false;
+    }
+    m_size += size;
+
+    const UInt8* data = static_cast<const UInt8*>(vdata);
+    while (size > 0) {
+        switch (m_state) {
+        case kCount:
+        case kHeader: {
+            // gather the 4 byte count or 8 byte format header
+            size_t headerSize = (m_state == kCount) ? 4 : 8;
+            size_t n = std::min(headerSize - m_headerSize, size);
+            memcpy(m_header + m_headerSize, data, n);
+            m_headerSize += n;
+            data         += n;
+            size         -= n;
+            if (m_headerSize < headerSize) {
+                break;
+            }
+            m_headerSize = 0;
+
+            if (m_state == kCount) {
+                m_formatsLeft = readUInt32(m_header);
+                nextFormat();
+                break;
+            }
+
+            // a size larger than what's left to come is corrupt and
+            // mustn't be reserved
+            m_format   = readUInt32(m_header);
+            m_dataLeft = readUInt32(m_header + 4);
+            if (m_dataLeft > m_expectedSize - m_size + size) {
+                m_state = kFailed;
+                return false;
+            }
+
+            // formats newer than ours are skipped, as unmarshall() does
+            if (m_format < IClipboard::kNumFormats) {
+                m_added[m_format] = true;
+                m_data[m_format].clear();
+                m_data[m_format].reserve(m_dataLeft);
+            }
+            m_state = kData;
+            if (m_dataLeft == 0) {
+                nextFormat();
+            }
+            break;
+        }
+
+        case kData: {
+            size_t n = std::min((size_t)m_dataLeft, size);
+            if (m_format < IClipboard::kNumFormats) {
+                m_data[m_format].append(reinterpret_cast<const char*>(data), n);
+            }
+            m_dataLeft -= (UInt32)n;
+            data       += n;
+            size       -= n;
+            if (m_dataLeft == 0) {
+                nextFormat();
+            }
+            break;
+        }
+
+        case kDone:
+        case kFailed:
+            // more data than the formats need
+            m_state = kFailed;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+ClipboardUnmarshaller::addCompressed(const void* data, size_t size)
+{
+    if (m_state == kFailed) {
+        return false;
+    }
+    m_decompressed.clear();
+    if (!ChunkCompressor::decompress(data, size, m_decompressed)) {
+        m_state = kFailed;
+        return false;
+    }
+    return add(m_decompressed.data(), m_decompressed.size());
+}
+
+bool
+ClipboardUnmarshaller::unmarshall(Clipboard& clipboard, IClipboard::Time time)
+{
+    if (!isComplete() || !clipboard.open(time)) {
+        return false;
+    }
+    clipboard.empty();
+    store(clipboard);
+    clipboard.close();
+    return true;
+}
+
+bool
+ClipboardUnmarshaller::merge(Clipboard& clipboard)
+{
+    if (!isComplete() || !clipboard.open(clipboard.getTime())) {
+        return false;
+    }
+    store(clipboard);
+    clipboard.close();
+    return true;
+}
+
+bool
+ClipboardUnmarshaller::isComplete() const
+{
+    // nothing at all is an empty clipboard
+    return (m_size == m_expectedSize &&
+            (m_state == kDone || (m_state == kCount && m_size == 0)));
+}
+
+void
+ClipboardUnmarshaller::store(Clipboard& clipboard)
+{
+    for (UInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+        if (m_added[format]) {
+            clipboard.adopt(static_cast<IClipboard::EFormat>(format),
+                            m_data[format]);
+            m_added[format] = false;
+        }
+    }
+}
+
+void
+ClipboardUnmarshaller::nextFormat()
+{
+    if (m_formatsLeft == 0) {
+        m_state = kDone;
+    }
+    else {
+        --m_formatsLeft;
+        m_state = kHeader;
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "barrier/Clipboard.h"
+#include "base/String.h"
+
+//! Incremental clipboard unmarshaller
+/*!
+Rebuilds a clipboard from its marshalled form (see IClipboard::marshall())
+given a piece at a time, as the chunks of a transfer arrive, so the
+marshalled clipboard is never held whole.  Each format's data is
+reserved once from the size that precedes it and moved into the
+clipboard when done.
+*/
+class ClipboardUnmarshaller {
+public:
+    ClipboardUnmarshaller();
+
+    //! @name manipulators
+    //@{
+
+    //! Start over
+    /*!
+    Discards anything added so far and expects \c size bytes.
+    */
+    void                reset(size_t size);
+
+    //! Add data
+    /*!
+    Unmarshalls the next \c size bytes.  Returns false if they don't
+    follow the marshalled format or go past the expected size, after
+    which the data can't be completed.
+    */
+    bool                add(const void* data, size_t size);
+
+    //! Add compressed data
+    /*!
+    Like add() except the \c size bytes at \c data are a chunk
+    compressed by ChunkCompressor.  Returns false if it can't be
+    decompressed either.
+    */
+    bool                addCompressed(const void* data, size_t size);
+
+    //! Store the clipboard
+    /*!
+    Moves the unmarshalled formats into \c clipboard, replacing what it
+    had, and sets its time to \c time.  Returns false and leaves
+    \c clipboard alone if the data isn't complete.
+    */
+    bool                unmarshall(Clipboard& clipboard, IClipboard::Time time);
+
+    //! Merge the clipboard
+    /*!
+    Like unmarshall() except the formats \c clipboard has and the data
+    doesn't are kept.
+    */
+    bool                merge(Clipboard& clipboard);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Test if complete
+    /*!
+    Returns true if the expected number of bytes were added and they
+    hold a whole clipboard.
+    */
+    bool                isComplete() const;
+
+    //! Get the number of bytes added
+    size_t                getSize() const { return m_size; }
+
+    //! Get the number of bytes expected
+    size_t                getExpectedSize() const { return m_expectedSize; }
+
+    //@}
+
+private:
+    enum EState {
+        kCount,
+        kHeader,
+        kData,
+        kDone,
+        kFailed
+    };
+
+    void                store(Clipboard& clipboard);
+    void                nextFormat();
+
+private:
+    EState                m_state;
+    size_t                m_size;
+    size_t                m_expectedSize;
+
+    // the format count or format header being read
+    UInt8                m_header[8];
+    size_t                m_headerSize;
+
+    // formats left after the one being read, which it is and how much
+    // of its data is still to come
+    UInt32                m_formatsLeft;
+    UInt32                m_format;
+    UInt32                m_dataLeft;
+
+    bool                m_added[IClipboard::kNumFormats];
+    String                m_data[IClipboard::kNumFormats];
+
+    // the last compressed chunk, decompressed
+    String                m_decompressed;
+};
@@ -17,14 +17,12 @@
 
 #include "barrier/FileChunk.h"
 
+#include "barrier/ChunkCompressor.h"
 #include "barrier/ProtocolUtil.h"
 #include "barrier/protocol_types.h"
 #include "io/IStream.h"
-#include "base/Stopwatch.h"
 #include "base/Log.h"
 
-static const UInt16 kIntervalThreshold = 1;
-
 FileChunk::FileChunk(size_t size) :
     Chunk(size)
 {
@@ -68,14 +66,13 @@ FileChunk::end()
 }
 
 int
-FileChunk::assemble(barrier::IStream* stream, String& dataReceived, size_t& expectedSize)
+FileChunk::assemble(barrier::IStream* stream, FileTransfer& transfer)
 {
     // parse
     UInt8 mark = 0;
     String content;
-    static size_t receivedDataSize;
-    static double elapsedTime;
-    static Stopwatch stopwatch;
+    String& dataReceived       = transfer.m_data;
+    TransferProgress& progress = transfer.m_progress;
 
     if (!ProtocolUtil::readf(stream, kMsgDFileTransfer + 4, &mark, &content)) {
         return kError;
@@ -84,49 +81,35 @@ FileChunk::assemble(barrier::IStream* stream, String& dataReceived, size_t& expe
     switch (mark) {
     case kDataStart:
         dataReceived.clear();
-        expectedSize = barrier::string::stringToSizeType(content);
-        receivedDataSize = 0;
-        elapsedTime = 0;
-        stopwatch.reset();
-
-        if (CLOG->getFilter() >= kDEBUG2) {
-            LOG((CLOG_DEBUG2 "recv file size=%s", content.c_str()));
-            stopwatch.start();
-        }
+        progress.start(barrier::string::stringToSizeType(content));
+        LOG((CLOG_DEBUG2 "recv file size=%s", content.c_str()));
         return kStart;
 
     case kDataChunk:
-        dataReceived.append(content);
-        if (CLOG->getFilter() >= kDEBUG2) {
-                LOG((CLOG_DEBUG2 "recv file chunck size=%i", content.size()));
-                double interval = stopwatch.getTime();
-                receivedDataSize += content.size();
-                LOG((CLOG_DEBUG2 "recv file interval=%f s", interval));
-                if (interval >= kIntervalThreshold) {
-                    double averageSpeed = receivedDataSize / interval / 1000;
-                    LOG((CLOG_DEBUG2 "recv file average speed=%f kb/s", averageSpeed));
-
-                    receivedDataSize = 0;
-                    elapsedTime += interval;
-                    stopwatch.reset();
-                }
-            }
+    case kDataCompressed:
+        if (mark == kDataChunk) {
+            dataReceived.append(content);
+        }
+        else if (!ChunkCompressor::decompress(content.data(), content.size(), dataReceived)) {
+            LOG((CLOG_ERR "corrupted compressed file chunk"));
+            return kError;
+        }
+        LOG((CLOG_DEBUG2 "recv file chunck size=%i", content.size()));
+        if (progress.add(content.size())) {
+            LOG((CLOG_DEBUG2 "recv file average speed=%f kb/s", progress.getRate() / 1000));
+        }
         return kNotFinish;
 
     case kDataEnd:
-        if (expectedSize != dataReceived.size()) {
-            LOG((CLOG_ERR "corrupted clipboard data, expected size=%d actual size=%d", expectedSize, dataReceived.size()));
+        progress.finish();
+        if (progress.getSize() != dataReceived.size()) {
+            LOG((CLOG_ERR "corrupted file data, expected size=%d actual size=%d", progress.getSize(), dataReceived.size()));
             return kError;
         }
 
-        if (CLOG->getFilter() >= kDEBUG2) {
-            LOG((CLOG_DEBUG2 "file transfer finished"));
-            elapsedTime += stopwatch.getTime();
-            double averageSpeed = expectedSize / elapsedTime / 1000;
-            LOG((CLOG_DEBUG2 "file transfer finished: total time consumed=%f s", elapsedTime));
-            LOG((CLOG_DEBUG2 "file transfer finished: total data received=%i kb", expectedSize / 1000));
-            LOG((CLOG_DEBUG2 "file transfer finished: total average speed=%f kb/s", averageSpeed));
-        }
+        LOG((CLOG_DEBUG2 "file transfer finished: total time consumed=%f s", progress.getTime()));
+        LOG((CLOG_DEBUG2 "file transfer finished: total data received=%i kb", progress.getReceived() / 1000));
+        LOG((CLOG_DEBUG2 "file transfer finished: total average speed=%f kb/s", progress.getRate() / 1000));
         return kFinish;
     }
 
@@ -147,6 +130,10 @@ FileChunk::send(barrier::IStream* stream, UInt8 mark, char* data, size_t dataSiz
         LOG((CLOG_DEBUG2 "sending file chunk: size=%i", chunk.size()));
         break;
 
+    case kDataCompressed:
+        LOG((CLOG_DEBUG2 "sending compressed file chunk: size=%i", chunk.size()));
+        break;
+
     case kDataEnd:
         LOG((CLOG_DEBUG2 "sending file finished"));
         break;
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "barrier/Chunk.h"
+#include "barrier/TransferProgress.h"
 #include "base/String.h"
 #include "common/basic_types.h"
 
@@ -27,6 +28,17 @@ namespace barrier {
 class IStream;
 };
 
+//! A file being received
+/*!
+Each connection has its own so files can be received from several
+clients at once.
+*/
+class FileTransfer {
+public:
+    String                m_data;
+    TransferProgress    m_progress;
+};
+
 class FileChunk : public Chunk {
 public:
     FileChunk(size_t size);
@@ -36,8 +48,7 @@ public:
     static FileChunk*    end();
     static int            assemble(
                             barrier::IStream* stream,
-                            String& dataCached,
-                            size_t& expectedSize);
+                            FileTransfer& transfer);
     static void            send(
                             barrier::IStream* stream,
                             UInt8 mark,
@@ -148,6 +148,23 @@ IClipboard::copy(IClipboard* dst, const IClipboard* src, Time time)
     return success;
 }
 
+UInt32
+IClipboard::getFormats(const IClipboard* clipboard)
+{
+    assert(clipboard != NULL);
+
+    UInt32 formats = 0;
+    if (clipboard->open(0)) {
+        for (SInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+            if (clipboard->has(static_cast<IClipboard::EFormat>(format))) {
+                formats |= (1u << format);
+            }
+        }
+        clipboard->close();
+    }
+    return formats;
+}
+
 UInt32
 IClipboard::readUInt32(const char* buf)
 {
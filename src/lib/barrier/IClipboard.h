@@ -161,6 +161,13 @@ public:
     */
     static bool            copy(IClipboard* dst, const IClipboard* src, Time);
 
+    //! Get clipboard formats
+    /*!
+    Returns a mask with bit (1 << format) set for each EFormat that
+    \p clipboard has data for.
+    */
+    static UInt32        getFormats(const IClipboard* clipboard);
+
     //@}
 
 private:
@@ -20,14 +20,13 @@
 
 #include "barrier/DragInformation.h"
 #include "barrier/clipboard_types.h"
+#include "barrier/IClipboard.h"
 #include "barrier/IScreen.h"
 #include "barrier/IPrimaryScreen.h"
 #include "barrier/ISecondaryScreen.h"
 #include "barrier/IKeyState.h"
 #include "barrier/option_types.h"
 
-class IClipboard;
-
 //! Screen interface
 /*!
 This interface defines the methods common to all platform dependent
@@ -79,6 +78,26 @@ public:
     */
     virtual bool        setClipboard(ClipboardID id, const IClipboard*) = 0;
 
+    //! Promise clipboard
+    /*!
+    Take ownership of the system clipboard indicated by \c id and
+    advertise \c formats, a mask with bit (1 << format) set for each
+    IClipboard::EFormat, without having their data.  When an application
+    asks for a format that hasn't been given yet the screen sends a
+    clipboardRequested event and fulfilClipboard() supplies the data.
+    Returns false if the platform can't do this, in which case the caller
+    must use setClipboard().
+    */
+    virtual bool        promiseClipboard(ClipboardID id, UInt32 formats) = 0;
+
+    //! Fulfil clipboard promise
+    /*!
+    Give the promised clipboard indicated by \c id the data in
+    \c clipboard and answer the applications waiting for it.  Does
+    nothing if the clipboard has changed since promiseClipboard().
+    */
+    virtual void        fulfilClipboard(ClipboardID id, const IClipboard*) = 0;
+
     //! Check clipboard owner
     /*!
     Check ownership of all clipboards and post grab events for any that
@@ -143,6 +162,18 @@ public:
     */
     virtual bool        isPrimary() const = 0;
 
+    //! Get clipboard formats
+    /*!
+    Save the formats of the clipboard indicated by \c id in \c formats,
+    a mask with bit (1 << format) set for each IClipboard::EFormat, and
+    the time it last changed in \c time, without getting the clipboard
+    data.  Returns false if there's no such clipboard or if the platform
+    can't list the formats without getting the data.  Use getClipboard()
+    in that case.
+    */
+    virtual bool        getClipboardFormats(ClipboardID id, UInt32& formats,
+                            IClipboard::Time& time) const = 0;
+
     //@}
 
     // IScreen overrides
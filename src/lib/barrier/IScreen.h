@@ -37,6 +37,13 @@ public:
         UInt32            m_sequenceNumber;
     };
 
+    //! Promised clipboard data requested
+    struct ClipboardRequestInfo {
+    public:
+        ClipboardID        m_id;
+        UInt32            m_formats;    //!< bit (1 << format) per EFormat
+    };
+
     //! @name accessors
     //@{
 
@@ -0,0 +1,151 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/LatencyTrace.h"
+
+#include "arch/Arch.h"
+#include "base/Log.h"
+
+#include <cmath>
+#include <cstring>
+
+static const char*        s_stageNames[] = {
+    "server",
+    "network",
+    "client",
+    "total"
+};
+
+//
+// LatencyTrace
+//
+
+LatencyTrace::LatencyTrace()
+{
+    reset();
+}
+
+void
+LatencyTrace::record(EStage stage, double seconds)
+{
+    ++m_buckets[stage][getBucket(seconds)];
+    ++m_counts[stage];
+}
+
+void
+LatencyTrace::reset()
+{
+    memset(m_buckets, 0, sizeof(m_buckets));
+    memset(m_counts, 0, sizeof(m_counts));
+}
+
+UInt32
+LatencyTrace::getCount(EStage stage) const
+{
+    return m_counts[stage];
+}
+
+double
+LatencyTrace::getPercentile(EStage stage, double fraction) const
+{
+    if (m_counts[stage] == 0) {
+        return 0.0;
+    }
+
+    // find the bucket holding the sample at the fraction
+    UInt32 rank = static_cast<UInt32>(std::ceil(fraction * m_counts[stage]));
+    if (rank == 0) {
+        rank = 1;
+    }
+    UInt32 seen = 0;
+    for (UInt32 i = 0; i < kBuckets; ++i) {
+        seen += m_buckets[stage][i];
+        if (seen >= rank) {
+            return getBucketLimit(i);
+        }
+    }
+    return getBucketLimit(kBuckets - 1);
+}
+
+void
+LatencyTrace::report() const
+{
+    for (int i = 0; i < kNumStages; ++i) {
+        EStage stage = static_cast<EStage>(i);
+        LOG((CLOG_INFO "latency %s: n=%u p50=%.0fus p99=%.0fus p999=%.0fus",
+            getStageName(stage), getCount(stage),
+            1.0e+6 * getPercentile(stage, 0.5),
+            1.0e+6 * getPercentile(stage, 0.99),
+            1.0e+6 * getPercentile(stage, 0.999)));
+    }
+}
+
+UInt32
+LatencyTrace::getTimestamp()
+{
+    return toTimestamp(ARCH->time());
+}
+
+UInt32
+LatencyTrace::toTimestamp(double time)
+{
+    // keep the low 32 bits.  differences survive wrapping.
+    return static_cast<UInt32>(std::fmod(time * 1.0e+6, 4294967296.0));
+}
+
+double
+LatencyTrace::getInterval(UInt32 from, UInt32 to)
+{
+    return 1.0e-6 * static_cast<double>(static_cast<SInt32>(to - from));
+}
+
+const char*
+LatencyTrace::getStageName(EStage stage)
+{
+    return s_stageNames[stage];
+}
+
+UInt32
+LatencyTrace::getBucket(double seconds)
+{
+    double us = 1.0e+6 * seconds;
+    if (!(us >= 1.0)) {
+        return 0;
+    }
+
+    // us = mantissa * 2^exponent with mantissa in [0.5, 1)
+    int exponent;
+    double mantissa = std::frexp(us, &exponent);
+    UInt32 octave   = static_cast<UInt32>(exponent - 1);
+    if (octave >= kOctaves) {
+        return kBuckets - 1;
+    }
+    UInt32 step = static_cast<UInt32>((2.0 * mantissa - 1.0) * kBucketsPerOctave);
+    return 1 + octave * kBucketsPerOctave + step;
+}
+
+double
+LatencyTrace::getBucketLimit(UInt32 bucket)
+{
+    if (bucket == 0) {
+        return 1.0e-6;
+    }
+    UInt32 octave = (bucket - 1) / kBucketsPerOctave;
+    UInt32 step   = (bucket - 1) % kBucketsPerOctave;
+    return 1.0e-6 * std::ldexp(1.0 + (step + 1.0) / kBucketsPerOctave,
+                            static_cast<int>(octave));
+}
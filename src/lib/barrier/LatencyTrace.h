@@ -0,0 +1,108 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+
+//! Input latency histograms
+/*!
+Collects the time input takes through each stage from the server to
+the client when the latencyTracing option is enabled.  Timestamps cross
+the network as the low 32 bits of ARCH->time() in microseconds, so the
+server and client stages are only meaningful when both share a clock,
+for example on the same host.
+
+Each stage keeps a histogram with eight buckets per power of two
+microseconds, so percentiles are accurate to within about 12%.
+*/
+class LatencyTrace {
+public:
+    enum EStage {
+        kServer,            //!< Server input event until it's written
+        kNetwork,            //!< Written until the client handles it
+        kClient,            //!< Client handles it until injected
+        kTotal,                //!< Server input event until injected
+        kNumStages
+    };
+
+    LatencyTrace();
+
+    //! @name manipulators
+    //@{
+
+    //! Record a sample
+    /*!
+    Adds \c seconds to the histogram of \c stage.  Negative times,
+    from a clock being adjusted, count as zero.
+    */
+    void                record(EStage stage, double seconds);
+
+    //! Discard all samples
+    void                reset();
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get number of samples
+    UInt32                getCount(EStage stage) const;
+
+    //! Get percentile
+    /*!
+    Returns the time, in seconds, that \c fraction of the samples of
+    \c stage did not exceed.  Returns 0 if there are no samples.
+    */
+    double                getPercentile(EStage stage, double fraction) const;
+
+    //! Log the histograms
+    /*!
+    Logs p50, p99 and p999 of each stage at the INFO level.
+    */
+    void                report() const;
+
+    //! Get the current timestamp
+    /*!
+    Returns the current time for sending in a kMsgDLatencyTrace.
+    */
+    static UInt32        getTimestamp();
+
+    //! Convert a time to a timestamp
+    static UInt32        toTimestamp(double time);
+
+    //! Get the seconds between two timestamps
+    static double        getInterval(UInt32 from, UInt32 to);
+
+    //! Get the name of a stage
+    static const char*    getStageName(EStage stage);
+
+    //@}
+
+private:
+    enum {
+        kBucketsPerOctave = 8,
+        kOctaves = 24,
+        kBuckets = 1 + kOctaves * kBucketsPerOctave
+    };
+
+    static UInt32        getBucket(double seconds);
+    static double        getBucketLimit(UInt32 bucket);
+
+private:
+    UInt32                m_buckets[kNumStages][kBuckets];
+    UInt32                m_counts[kNumStages];
+};
@@ -0,0 +1,148 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+
+#include <cassert>
+
+//! Message dispatch table
+/*!
+Maps the 4 byte code at the start of each protocol message to a
+\c Handler, typically a pointer to a member function of the proxy that
+receives the message.  Codes are compared as a single integer and looked
+up in a small open addressed hash table, so dispatch takes constant time
+however many messages a protocol version has.
+*/
+template <class Handler>
+class MessageTable {
+public:
+    MessageTable();
+
+    //! @name manipulators
+    //@{
+
+    //! Add handler
+    /*!
+    Dispatch messages starting with \c code, a message format from
+    protocol_types.h, to \c handler.  Replaces any existing handler for
+    the code, so a newer protocol version can override an older one.
+    */
+    void                add(const char* code, Handler handler);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Find handler
+    /*!
+    Returns the handler for the 4 byte message code at \c code or NULL
+    if there isn't one.
+    */
+    Handler                find(const UInt8* code) const;
+
+    //! Get message code as an integer
+    static UInt32        toCode(const void* code);
+
+    //@}
+
+private:
+    // twice as many slots as messages in the protocol keeps probes short
+    static const UInt32    kSlots = 128;
+
+    static UInt32        getSlot(UInt32 code);
+
+    struct Entry {
+    public:
+        UInt32            m_code;
+        Handler            m_handler;
+    };
+
+    Entry                m_entries[kSlots];
+    UInt32                m_size;
+};
+
+template <class Handler>
+inline
+MessageTable<Handler>::MessageTable() :
+    m_size(0)
+{
+    // no message has a code of zero so use it to mark empty slots
+    for (UInt32 i = 0; i < kSlots; ++i) {
+        m_entries[i].m_code    = 0;
+        m_entries[i].m_handler = NULL;
+    }
+}
+
+template <class Handler>
+inline
+void
+MessageTable<Handler>::add(const char* format, Handler handler)
+{
+    assert(format != NULL);
+    assert(handler != NULL);
+
+    UInt32 code = toCode(format);
+    UInt32 i    = getSlot(code);
+    while (m_entries[i].m_code != 0 && m_entries[i].m_code != code) {
+        i = (i + 1) & (kSlots - 1);
+    }
+    if (m_entries[i].m_code == 0) {
+        assert(m_size < kSlots / 2);
+        m_entries[i].m_code = code;
+        ++m_size;
+    }
+    m_entries[i].m_handler = handler;
+}
+
+template <class Handler>
+inline
+Handler
+MessageTable<Handler>::find(const UInt8* bytes) const
+{
+    UInt32 code = toCode(bytes);
+    UInt32 i    = getSlot(code);
+    while (m_entries[i].m_code != code) {
+        if (m_entries[i].m_code == 0) {
+            return NULL;
+        }
+        i = (i + 1) & (kSlots - 1);
+    }
+    return m_entries[i].m_handler;
+}
+
+template <class Handler>
+inline
+UInt32
+MessageTable<Handler>::toCode(const void* code)
+{
+    const UInt8* bytes = static_cast<const UInt8*>(code);
+    return (static_cast<UInt32>(bytes[0]) << 24) |
+           (static_cast<UInt32>(bytes[1]) << 16) |
+           (static_cast<UInt32>(bytes[2]) <<  8) |
+            static_cast<UInt32>(bytes[3]);
+}
+
+template <class Handler>
+inline
+UInt32
+MessageTable<Handler>::getSlot(UInt32 code)
+{
+    // fibonacci hashing spreads the ascii codes over the slots
+    return (code * 2654435769u) >> 25;
+}
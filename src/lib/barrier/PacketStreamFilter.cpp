@@ -28,6 +28,8 @@
 // PacketStreamFilter
 //
 
+const UInt32            PacketStreamFilter::kReadSize = 16384;
+
 PacketStreamFilter::PacketStreamFilter(IEventQueue* events, barrier::IStream* stream, bool adoptStream) :
     StreamFilter(events, stream, adoptStream),
     m_size(0),
@@ -47,7 +49,7 @@ PacketStreamFilter::close()
 {
     Lock lock(&m_mutex);
     m_size = 0;
-    m_buffer.pop(m_buffer.getSize());
+    m_buffer.consume(m_buffer.getSize());
     StreamFilter::close();
 }
 
@@ -72,9 +74,9 @@ PacketStreamFilter::read(void* buffer, UInt32 n)
 
     // read it
     if (buffer != NULL) {
-        memcpy(buffer, m_buffer.peek(n), n);
+        memcpy(buffer, m_buffer.data(), n);
     }
-    m_buffer.pop(n);
+    m_buffer.consume(n);
     m_size -= n;
 
     // get next packet's size if we've finished with this packet and
@@ -109,7 +111,7 @@ PacketStreamFilter::shutdownInput()
 {
     Lock lock(&m_mutex);
     m_size = 0;
-    m_buffer.pop(m_buffer.getSize());
+    m_buffer.consume(m_buffer.getSize());
     StreamFilter::shutdownInput();
 }
 
@@ -139,13 +141,12 @@ PacketStreamFilter::readPacketSize()
     // note -- m_mutex must be locked on entry
 
     if (m_size == 0 && m_buffer.getSize() >= 4) {
-        UInt8 buffer[4];
-        memcpy(buffer, m_buffer.peek(sizeof(buffer)), sizeof(buffer));
-        m_buffer.pop(sizeof(buffer));
+        const UInt8* buffer = static_cast<const UInt8*>(m_buffer.data());
         m_size = ((UInt32)buffer[0] << 24) |
                  ((UInt32)buffer[1] << 16) |
                  ((UInt32)buffer[2] <<  8) |
                   (UInt32)buffer[3];
+        m_buffer.consume(4);
     }
 }
 
@@ -155,12 +156,11 @@ PacketStreamFilter::readMore()
     // note if we have whole packet
     bool wasReady = isReadyNoLock();
 
-    // read more data
-    char buffer[4096];
-    UInt32 n = getStream()->read(buffer, sizeof(buffer));
+    // read more data straight into our buffer
+    UInt32 n = getStream()->read(m_buffer.prepare(kReadSize), kReadSize);
     while (n > 0) {
-        m_buffer.write(buffer, n);
-        n = getStream()->read(buffer, sizeof(buffer));
+        m_buffer.commit(n);
+        n = getStream()->read(m_buffer.prepare(kReadSize), kReadSize);
     }
 
     // if we don't yet have the next packet size then get it,
@@ -51,6 +51,8 @@ private:
     bool                readMore();
 
 private:
+    static const UInt32    kReadSize;
+
     Mutex                m_mutex;
     UInt32                m_size;
     StreamBuffer        m_buffer;
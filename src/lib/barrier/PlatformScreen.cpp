@@ -17,6 +17,7 @@
  */
 
 #include "barrier/PlatformScreen.h"
+#include "barrier/Clipboard.h"
 #include "barrier/App.h"
 #include "barrier/ArgsBase.h"
 
@@ -121,3 +122,25 @@ PlatformScreen::isDraggingStarted()
     }
     return false;
 }
+
+bool
+PlatformScreen::promiseClipboard(ClipboardID, UInt32)
+{
+    // platforms can't take a promise unless they say otherwise
+    return false;
+}
+
+void
+PlatformScreen::fulfilClipboard(ClipboardID, const IClipboard*)
+{
+    // do nothing
+}
+
+bool
+PlatformScreen::getClipboardFormats(ClipboardID, UInt32&,
+                IClipboard::Time&) const
+{
+    // platforms can only list the formats by getting the data unless
+    // they say otherwise.  callers get the data just once that way.
+    return false;
+}
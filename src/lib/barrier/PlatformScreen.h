@@ -89,6 +89,8 @@ public:
     virtual void        enter() = 0;
     virtual bool        leave() = 0;
     virtual bool        setClipboard(ClipboardID, const IClipboard*) = 0;
+    virtual bool        promiseClipboard(ClipboardID, UInt32 formats);
+    virtual void        fulfilClipboard(ClipboardID, const IClipboard*);
     virtual void        checkClipboards() = 0;
     virtual void        openScreensaver(bool notify) = 0;
     virtual void        closeScreensaver() = 0;
@@ -97,6 +99,8 @@ public:
     virtual void        setOptions(const OptionsList& options) = 0;
     virtual void        setSequenceNumber(UInt32) = 0;
     virtual bool        isPrimary() const = 0;
+    virtual bool        getClipboardFormats(ClipboardID, UInt32& formats,
+                            IClipboard::Time& time) const;
     
     virtual void        fakeDraggingFiles(DragFileList fileList) { throw std::runtime_error("fakeDraggingFiles not implemented"); }
     virtual const String&
@@ -0,0 +1,199 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "io/IStream.h"
+#include "common/basic_types.h"
+
+#include <type_traits>
+
+namespace barrier {
+namespace protocol {
+
+// total encoded size of a list of fields
+template <typename... Fields>
+struct FieldsSize {
+    static const UInt32 value = 0;
+};
+
+template <typename Field, typename... Fields>
+struct FieldsSize<Field, Fields...> {
+    static const UInt32 value = sizeof(Field) + FieldsSize<Fields...>::value;
+};
+
+// write an integer field in NBO and advance past it
+template <typename Field>
+inline
+void
+encodeField(UInt8*& dst, Field value)
+{
+    typedef typename std::make_unsigned<Field>::type Bits;
+    const Bits bits = static_cast<Bits>(value);
+    for (int i = (int)sizeof(Field) - 1; i >= 0; --i) {
+        *dst++ = static_cast<UInt8>((bits >> (8 * i)) & 0xff);
+    }
+}
+
+// read an integer field in NBO and advance past it
+template <typename Field>
+inline
+void
+decodeField(const UInt8*& src, Field& value)
+{
+    typedef typename std::make_unsigned<Field>::type Bits;
+    Bits bits = 0;
+    for (size_t i = 0; i < sizeof(Field); ++i) {
+        bits = static_cast<Bits>((bits << 8) | *src++);
+    }
+    value = static_cast<Field>(bits);
+}
+
+} // namespace protocol
+} // namespace barrier
+
+//! Fixed layout protocol message
+/*!
+Encodes and decodes a message made of the 4 byte code \c C0..C3 followed
+by one integer per type in \c Fields, each in NBO and as wide as its
+type.  This is equivalent to ProtocolUtil::writef() and readf() with a
+format of \c %1i, \c %2i and \c %4i specifiers, except the layout is
+fixed at compile time and no memory is allocated.
+*/
+template <char C0, char C1, char C2, char C3, typename... Fields>
+class ProtocolMessage {
+public:
+    //! Encoded size of the message, including the code
+    static const UInt32 kSize = 4 + barrier::protocol::FieldsSize<Fields...>::value;
+
+    //! Encoded size of the message after the code
+    static const UInt32 kPayloadSize = kSize - 4;
+
+    //! Encode message
+    /*!
+    Writes the message to \c buffer, which must hold kSize bytes.
+    */
+    static void            encode(UInt8* buffer, Fields... values);
+
+    //! Write message
+    /*!
+    Encodes the message on the stack and writes it to \c stream.
+    */
+    static void            write(barrier::IStream* stream, Fields... values);
+
+    //! Decode message payload
+    /*!
+    Reads the fields from \c buffer, which holds the kPayloadSize bytes
+    that follow the code.
+    */
+    static void            decode(const UInt8* buffer, Fields&... values);
+
+    //! Read message payload
+    /*!
+    Reads the fields that follow the code from \c stream.  Returns false
+    if the stream ends first.
+    */
+    static bool            read(barrier::IStream* stream, Fields&... values);
+};
+
+template <char C0, char C1, char C2, char C3, typename... Fields>
+const UInt32 ProtocolMessage<C0, C1, C2, C3, Fields...>::kSize;
+
+template <char C0, char C1, char C2, char C3, typename... Fields>
+const UInt32 ProtocolMessage<C0, C1, C2, C3, Fields...>::kPayloadSize;
+
+template <char C0, char C1, char C2, char C3, typename... Fields>
+inline
+void
+ProtocolMessage<C0, C1, C2, C3, Fields...>::encode(
+                UInt8* buffer, Fields... values)
+{
+    buffer[0] = C0;
+    buffer[1] = C1;
+    buffer[2] = C2;
+    buffer[3] = C3;
+    buffer += 4;
+
+    // braced initializers are evaluated in order
+    int expand[] = { 0, (barrier::protocol::encodeField(buffer, values), 0)... };
+    (void)expand;
+}
+
+template <char C0, char C1, char C2, char C3, typename... Fields>
+inline
+void
+ProtocolMessage<C0, C1, C2, C3, Fields...>::write(
+                barrier::IStream* stream, Fields... values)
+{
+    UInt8 buffer[kSize];
+    encode(buffer, values...);
+    stream->write(buffer, kSize);
+}
+
+template <char C0, char C1, char C2, char C3, typename... Fields>
+inline
+void
+ProtocolMessage<C0, C1, C2, C3, Fields...>::decode(
+                const UInt8* buffer, Fields&... values)
+{
+    int expand[] = { 0, (barrier::protocol::decodeField(buffer, values), 0)... };
+    (void)expand;
+}
+
+template <char C0, char C1, char C2, char C3, typename... Fields>
+inline
+bool
+ProtocolMessage<C0, C1, C2, C3, Fields...>::read(
+                barrier::IStream* stream, Fields&... values)
+{
+    // one extra byte so a message without fields has a valid buffer
+    UInt8 buffer[kPayloadSize + 1];
+    UInt32 count = 0;
+    while (count < kPayloadSize) {
+        UInt32 n = stream->read(buffer + count, kPayloadSize - count);
+        if (n == 0) {
+            return false;
+        }
+        count += n;
+    }
+    decode(buffer, values...);
+    return true;
+}
+
+//
+// messages with codecs.  these must match the formats in protocol_types.h.
+//
+
+typedef ProtocolMessage<'C','A','L','V'>                    MsgCKeepAlive;
+typedef ProtocolMessage<'D','K','D','N', UInt16, UInt16, UInt16>
+                                                            MsgDKeyDown;
+typedef ProtocolMessage<'D','K','D','N', UInt16, UInt16>    MsgDKeyDown1_0;
+typedef ProtocolMessage<'D','K','R','P', UInt16, UInt16, UInt16, UInt16>
+                                                            MsgDKeyRepeat;
+typedef ProtocolMessage<'D','K','R','P', UInt16, UInt16, UInt16>
+                                                            MsgDKeyRepeat1_0;
+typedef ProtocolMessage<'D','K','U','P', UInt16, UInt16, UInt16>
+                                                            MsgDKeyUp;
+typedef ProtocolMessage<'D','K','U','P', UInt16, UInt16>    MsgDKeyUp1_0;
+typedef ProtocolMessage<'D','M','D','N', UInt8>            MsgDMouseDown;
+typedef ProtocolMessage<'D','M','U','P', UInt8>            MsgDMouseUp;
+typedef ProtocolMessage<'D','M','M','V', SInt16, SInt16>    MsgDMouseMove;
+typedef ProtocolMessage<'D','M','R','M', SInt16, SInt16>    MsgDMouseRelMove;
+typedef ProtocolMessage<'D','M','W','M', SInt16, SInt16>    MsgDMouseWheel;
+typedef ProtocolMessage<'D','B','A','T', UInt16>            MsgDInputBatch;
+typedef ProtocolMessage<'D','T','R','C', UInt32, UInt32, UInt32>
+                                                            MsgDLatencyTrace;
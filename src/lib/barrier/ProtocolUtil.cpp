@@ -19,6 +19,7 @@
 #include "barrier/ProtocolUtil.h"
 #include "io/IStream.h"
 #include "base/Log.h"
+#include "base/TraceLog.h"
 #include "common/stdvector.h"
 #include "base/String.h"
 
@@ -34,7 +35,7 @@ ProtocolUtil::writef(barrier::IStream* stream, const char* fmt, ...)
 {
     assert(stream != NULL);
     assert(fmt != NULL);
-    LOG((CLOG_DEBUG2 "writef(%s)", fmt));
+    LOGT((CLOG_DEBUG2 "writef(%s)", fmt));
 
     va_list args;
     va_start(args, fmt);
@@ -50,7 +51,7 @@ ProtocolUtil::readf(barrier::IStream* stream, const char* fmt, ...)
 {
     assert(stream != NULL);
     assert(fmt != NULL);
-    LOG((CLOG_DEBUG2 "readf(%s)", fmt));
+    LOGT((CLOG_DEBUG2 "readf(%s)", fmt));
 
     bool result;
     va_list args;
@@ -85,7 +86,7 @@ ProtocolUtil::vwritef(barrier::IStream* stream,
     try {
         // write buffer
         stream->write(buffer, size);
-        LOG((CLOG_DEBUG2 "wrote %d bytes", size));
+        LOGT((CLOG_DEBUG2 "wrote %d bytes", size));
 
         delete[] buffer;
     }
@@ -122,7 +123,7 @@ ProtocolUtil::vreadf(barrier::IStream* stream, const char* fmt, va_list args)
                 case 1:
                     // 1 byte integer
                     *static_cast<UInt8*>(v) = buffer[0];
-                    LOG((CLOG_DEBUG2 "readf: read %d byte integer: %d (0x%x)", len, *static_cast<UInt8*>(v), *static_cast<UInt8*>(v)));
+                    LOGT((CLOG_DEBUG2 "readf: read %d byte integer: %d (0x%x)", len, *static_cast<UInt8*>(v), *static_cast<UInt8*>(v)));
                     break;
 
                 case 2:
@@ -131,7 +132,7 @@ ProtocolUtil::vreadf(barrier::IStream* stream, const char* fmt, va_list args)
                         static_cast<UInt16>(
                         (static_cast<UInt16>(buffer[0]) << 8) |
                          static_cast<UInt16>(buffer[1]));
-                    LOG((CLOG_DEBUG2 "readf: read %d byte integer: %d (0x%x)", len, *static_cast<UInt16*>(v), *static_cast<UInt16*>(v)));
+                    LOGT((CLOG_DEBUG2 "readf: read %d byte integer: %d (0x%x)", len, *static_cast<UInt16*>(v), *static_cast<UInt16*>(v)));
                     break;
 
                 case 4:
@@ -141,7 +142,7 @@ ProtocolUtil::vreadf(barrier::IStream* stream, const char* fmt, va_list args)
                         (static_cast<UInt32>(buffer[1]) << 16) |
                         (static_cast<UInt32>(buffer[2]) <<  8) |
                          static_cast<UInt32>(buffer[3]);
-                    LOG((CLOG_DEBUG2 "readf: read %d byte integer: %d (0x%x)", len, *static_cast<UInt32*>(v), *static_cast<UInt32*>(v)));
+                    LOGT((CLOG_DEBUG2 "readf: read %d byte integer: %d (0x%x)", len, *static_cast<UInt32*>(v), *static_cast<UInt32*>(v)));
                     break;
                 }
                 break;
@@ -168,7 +169,7 @@ ProtocolUtil::vreadf(barrier::IStream* stream, const char* fmt, va_list args)
                         read(stream, buffer, 1);
                         static_cast<std::vector<UInt8>*>(v)->push_back(
                             buffer[0]);
-                        LOG((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, static_cast<std::vector<UInt8>*>(v)->back(), static_cast<std::vector<UInt8>*>(v)->back()));
+                        LOGT((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, static_cast<std::vector<UInt8>*>(v)->back(), static_cast<std::vector<UInt8>*>(v)->back()));
                     }
                     break;
 
@@ -180,7 +181,7 @@ ProtocolUtil::vreadf(barrier::IStream* stream, const char* fmt, va_list args)
                             static_cast<UInt16>(
                             (static_cast<UInt16>(buffer[0]) << 8) |
                              static_cast<UInt16>(buffer[1])));
-                        LOG((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, static_cast<std::vector<UInt16>*>(v)->back(), static_cast<std::vector<UInt16>*>(v)->back()));
+                        LOGT((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, static_cast<std::vector<UInt16>*>(v)->back(), static_cast<std::vector<UInt16>*>(v)->back()));
                     }
                     break;
 
@@ -193,7 +194,7 @@ ProtocolUtil::vreadf(barrier::IStream* stream, const char* fmt, va_list args)
                             (static_cast<UInt32>(buffer[1]) << 16) |
                             (static_cast<UInt32>(buffer[2]) <<  8) |
                              static_cast<UInt32>(buffer[3]));
-                        LOG((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, static_cast<std::vector<UInt32>*>(v)->back(), static_cast<std::vector<UInt32>*>(v)->back()));
+                        LOGT((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, static_cast<std::vector<UInt32>*>(v)->back(), static_cast<std::vector<UInt32>*>(v)->back()));
                     }
                     break;
                 }
@@ -231,7 +232,7 @@ ProtocolUtil::vreadf(barrier::IStream* stream, const char* fmt, va_list args)
                     throw;
                 }
 
-                LOG((CLOG_DEBUG2 "readf: read %d byte string", len));
+                LOGT((CLOG_DEBUG2 "readf: read %d byte string", len));
 
                 // save the data
                 String* dst = va_arg(args, String*);
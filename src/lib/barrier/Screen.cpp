@@ -169,6 +169,18 @@ Screen::setClipboard(ClipboardID id, const IClipboard* clipboard)
     m_screen->setClipboard(id, clipboard);
 }
 
+bool
+Screen::promiseClipboard(ClipboardID id, UInt32 formats)
+{
+    return m_screen->promiseClipboard(id, formats);
+}
+
+void
+Screen::fulfilClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+    m_screen->fulfilClipboard(id, clipboard);
+}
+
 void
 Screen::grabClipboard(ClipboardID id)
 {
@@ -484,6 +496,13 @@ Screen::getClipboard(ClipboardID id, IClipboard* clipboard) const
     return m_screen->getClipboard(id, clipboard);
 }
 
+bool
+Screen::getClipboardFormats(ClipboardID id, UInt32& formats,
+                IClipboard::Time& time) const
+{
+    return m_screen->getClipboardFormats(id, formats, time);
+}
+
 void
 Screen::getShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h) const
 {
@@ -20,13 +20,13 @@
 
 #include "barrier/DragInformation.h"
 #include "barrier/clipboard_types.h"
+#include "barrier/IClipboard.h"
 #include "barrier/IScreen.h"
 #include "barrier/key_types.h"
 #include "barrier/mouse_types.h"
 #include "barrier/option_types.h"
 #include "base/String.h"
 
-class IClipboard;
 class IPlatformScreen;
 class IEventQueue;
 
@@ -100,6 +100,20 @@ public:
     */
     void                setClipboard(ClipboardID, const IClipboard*);
 
+    //! Promise clipboard
+    /*!
+    Takes ownership of the system's clipboard with \c formats but not
+    their data.  Returns false if the platform can't do that.
+    \sa IPlatformScreen::promiseClipboard()
+    */
+    virtual bool        promiseClipboard(ClipboardID, UInt32 formats);
+
+    //! Fulfil clipboard promise
+    /*!
+    Gives a promised clipboard the data applications asked for.
+    */
+    virtual void        fulfilClipboard(ClipboardID, const IClipboard*);
+
     //! Grab clipboard
     /*!
     Grabs (i.e. take ownership of) the system clipboard.
@@ -302,6 +316,13 @@ public:
                             SInt32& width, SInt32& height) const;
     virtual void        getCursorPos(SInt32& x, SInt32& y) const;
 
+    //! Get clipboard formats
+    /*!
+    \sa IPlatformScreen::getClipboardFormats()
+    */
+    virtual bool        getClipboardFormats(ClipboardID, UInt32& formats,
+                            IClipboard::Time& time) const;
+
     IPlatformScreen*    getPlatformScreen() { return m_screen; }
 
 protected:
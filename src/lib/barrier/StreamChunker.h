@@ -29,13 +29,6 @@ public:
                             char* filename,
                             IEventQueue* events,
                             void* eventTarget);
-    static void            sendClipboard(
-                            String& data,
-                            size_t size,
-                            ClipboardID id,
-                            UInt32 sequence,
-                            IEventQueue* events,
-                            void* eventTarget);
     static void            interruptFile();
 
 private:
@@ -0,0 +1,69 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/TransferProgress.h"
+
+//
+// TransferProgress
+//
+
+const double            TransferProgress::kReportInterval = 1.0;
+
+TransferProgress::TransferProgress() :
+    m_stopwatch(true),
+    m_size(0),
+    m_received(0),
+    m_reported(0.0)
+{
+    // do nothing
+}
+
+void
+TransferProgress::start(size_t size)
+{
+    m_size     = size;
+    m_received = 0;
+    m_reported = 0.0;
+    m_stopwatch.reset();
+    m_stopwatch.start();
+}
+
+bool
+TransferProgress::add(size_t size)
+{
+    m_received += size;
+
+    double time = m_stopwatch.getTime();
+    if (time - m_reported < kReportInterval) {
+        return false;
+    }
+    m_reported = time;
+    return true;
+}
+
+void
+TransferProgress::finish()
+{
+    m_stopwatch.stop();
+}
+
+double
+TransferProgress::getRate() const
+{
+    double time = getTime();
+    return (time > 0.0) ? m_received / time : 0.0;
+}
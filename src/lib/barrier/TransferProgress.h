@@ -0,0 +1,88 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/Stopwatch.h"
+#include "common/basic_types.h"
+
+//! Progress of a transfer being received
+/*!
+Counts the bytes of one clipboard or file transfer as they arrive and
+times the transfer, so each transfer on each connection has its own
+throughput.
+*/
+class TransferProgress {
+public:
+    TransferProgress();
+
+    //! @name manipulators
+    //@{
+
+    //! Start a transfer
+    /*!
+    Starts over for a transfer of \c size bytes.
+    */
+    void                start(size_t size);
+
+    //! Count received bytes
+    /*!
+    Adds \c size bytes to those received.  Returns true at most once
+    every kReportInterval seconds, when the rate so far is worth
+    reporting.
+    */
+    bool                add(size_t size);
+
+    //! Finish the transfer
+    /*!
+    Stops the clock.
+    */
+    void                finish();
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the number of bytes expected
+    size_t                getSize() const { return m_size; }
+
+    //! Get the number of bytes received
+    size_t                getReceived() const { return m_received; }
+
+    //! Get the time taken
+    /*!
+    Returns the seconds since start(), or until finish().
+    */
+    double                getTime() const { return m_stopwatch.getTime(); }
+
+    //! Get the rate
+    /*!
+    Returns the bytes received per second.
+    */
+    double                getRate() const;
+
+    //@}
+
+    //! Seconds between reports
+    static const double    kReportInterval;
+
+private:
+    Stopwatch            m_stopwatch;
+    size_t                m_size;
+    size_t                m_received;
+    double                m_reported;
+};
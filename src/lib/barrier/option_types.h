@@ -68,6 +68,9 @@ static const OptionID    kOptionScreenPreserveFocus        = OPTION_CODE("SFOC")
 static const OptionID    kOptionRelativeMouseMoves        = OPTION_CODE("MDLT");
 static const OptionID    kOptionWin32KeepForeground        = OPTION_CODE("_KFW");
 static const OptionID    kOptionClipboardSharing            = OPTION_CODE("CLPS");
+static const OptionID    kOptionInputBatching            = OPTION_CODE("INBT");
+static const OptionID    kOptionLatencyTracing            = OPTION_CODE("LTRC");
+static const OptionID    kOptionCompression                = OPTION_CODE("CMPR");
 //@}
 
 //! @name Screen switch corner enumeration
@@ -46,7 +46,12 @@ const char*                kMsgDInfo            = "DINF%2i%2i%2i%2i%2i%2i%2i";
 const char*                kMsgDSetOptions        = "DSOP%4I";
 const char*                kMsgDFileTransfer    = "DFTR%1i%s";
 const char*                kMsgDDragInfo        = "DDRG%2i%s";
+const char*                kMsgDInputBatch        = "DBAT%2i";
+const char*                kMsgDLatencyTrace    = "DTRC%4i%4i%4i";
+const char*                kMsgDClipboardSummary    = "DCLS%1i%4i%4I%4I%4I";
+const char*                kMsgDClipboardOffer    = "DCLO%1i%4i%4I";
 const char*                kMsgQInfo            = "QINF";
+const char*                kMsgQClipboard        = "QCLP%1i%4i%4I";
 const char*                kMsgEIncompatible    = "EICV%2i%2i";
 const char*                kMsgEBusy             = "EBSY";
 const char*                kMsgEUnknown        = "EUNK";
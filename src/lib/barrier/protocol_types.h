@@ -29,9 +29,12 @@
 // 1.4:  adds crypto support
 // 1.5:  adds file transfer and removes home brew crypto
 // 1.6:  adds clipboard streaming
+// 1.7:  adds input batches and latency traces
+// 1.8:  adds clipboard summaries and offers
+// 1.9:  adds compressed clipboard and file chunks
 // NOTE: with new version, barrier minor version should increment
 static const SInt16        kProtocolMajorVersion = 1;
-static const SInt16        kProtocolMinorVersion = 6;
+static const SInt16        kProtocolMinorVersion = 9;
 
 // default contact port number
 static const UInt16        kDefaultPort = 24800;
@@ -74,7 +77,8 @@ enum EDirectionMask {
 enum EDataTransfer {
     kDataStart = 1,
     kDataChunk = 2,
-    kDataEnd = 3
+    kDataEnd = 3,
+    kDataCompressed = 4
 };
 
 // Data received constants
@@ -236,7 +240,9 @@ extern const char*        kMsgDMouseWheel1_0;
 // $2 = sequence number, $3 = mark $4 = clipboard data.  the sequence number
 // is 0 when sent by the primary.  secondary screens should use the
 // sequence number from the most recent kMsgCEnter.  $1 = clipboard
-// identifier.
+// identifier.  since 1.9 a kDataCompressed mark may replace kDataChunk;
+// the data is then compressed as described in ChunkCompressor.  neither
+// side compresses when the compression option is disabled.
 extern const char*        kMsgDClipboard;
 
 // client data:  secondary -> primary
@@ -265,6 +271,8 @@ extern const char*        kMsgDSetOptions;
 // 0 means the content followed is the file size.
 // 1 means the content followed is the chunk data.
 // 2 means the file transfer is finished.
+// since 1.9, 4 means the content is compressed chunk data (see
+// ChunkCompressor), unless the compression option is disabled.
 extern const char*        kMsgDFileTransfer;
 
 // drag infomation:  primary <-> secondary
@@ -273,6 +281,39 @@ extern const char*        kMsgDFileTransfer;
 // of each object's directory.
 extern const char*        kMsgDDragInfo;
 
+// input batch:  primary -> secondary
+// $1 = number of input messages that immediately follow in the same
+// packet.  only key, mouse button, mouse motion and mouse wheel
+// messages may be batched.  the secondary handles them in order as if
+// they'd been sent individually.  the primary only sends batches when
+// the inputBatching option is enabled.
+extern const char*        kMsgDInputBatch;
+
+// latency trace:  primary -> secondary
+// $1 = sequence number, $2 = time the primary began handling the
+// input, $3 = time this message was written.  times are the low 32 bits
+// of the primary's clock in microseconds.  describes the input message
+// that immediately follows it.  the primary only sends traces when the
+// latencyTracing option is enabled.
+extern const char*        kMsgDLatencyTrace;
+
+// clipboard summary:  primary -> secondary
+// $1 = clipboard identifier, $2 = summary sequence number, $3 = formats
+// in the clipboard, $4 = size of each format's data, $5 = XXH64 hash of
+// each format's data as pairs of high and low 32 bits.  sent instead of
+// kMsgDClipboard data.  the secondary replies with a kMsgQClipboard for
+// the formats it doesn't already have, if any.
+extern const char*        kMsgDClipboardSummary;
+
+// clipboard offer:  primary <-> secondary
+// $1 = clipboard identifier, $2 = sequence number, $3 = formats in the
+// clipboard.  sent by the clipboard's owner instead of kMsgDClipboard
+// data.  the receiver asks for the formats it needs, when it needs them,
+// with kMsgQClipboard.  a secondary uses the sequence number from the
+// last kMsgCEnter as for kMsgDClipboard.  the primary numbers offers
+// along with its summaries.
+extern const char*        kMsgDClipboardOffer;
+
 //
 // query codes
 //
@@ -281,6 +322,16 @@ extern const char*        kMsgDDragInfo;
 // client should reply with a kMsgDInfo.
 extern const char*        kMsgQInfo;
 
+// query clipboard formats:  primary <-> secondary
+// $1 = clipboard identifier, $2 = sequence number, $3 = formats to send.
+// the answer is a kMsgDClipboard using $2 as the sequence number.  a
+// secondary asks for formats from a summary or offer using its sequence
+// number and the primary ignores queries for anything but the latest.
+// the primary asks for formats a secondary offered using a sequence
+// number of its own and the secondary sends each format asked for,
+// empty if the clipboard no longer has it.
+extern const char*        kMsgQClipboard;
+
 
 //
 // error codes
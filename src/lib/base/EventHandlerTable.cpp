@@ -0,0 +1,85 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventHandlerTable.h"
+
+#include <cstdint>
+
+//
+// EventHandlerTable
+//
+
+EventHandlerTable::EventHandlerTable(const HandlerTable& handlers) :
+    m_size(0)
+{
+    for (HandlerTable::const_iterator i = handlers.begin();
+                            i != handlers.end(); ++i) {
+        m_size += i->second.size();
+    }
+
+    // keep the table at most half full so probes stay short
+    size_t capacity = 16;
+    while (capacity < 2 * m_size) {
+        capacity <<= 1;
+    }
+    Entry empty = { NULL, Event::kUnknown, NULL };
+    m_entries.assign(capacity, empty);
+    m_mask = capacity - 1;
+
+    for (HandlerTable::const_iterator i = handlers.begin();
+                            i != handlers.end(); ++i) {
+        for (TypeHandlerTable::const_iterator j = i->second.begin();
+                            j != i->second.end(); ++j) {
+            if (j->second == NULL) {
+                continue;
+            }
+            size_t slot = getSlot(j->first, i->first) & m_mask;
+            while (m_entries[slot].m_handler != NULL) {
+                slot = (slot + 1) & m_mask;
+            }
+            m_entries[slot].m_target  = i->first;
+            m_entries[slot].m_type    = j->first;
+            m_entries[slot].m_handler = j->second;
+        }
+    }
+}
+
+IEventJob*
+EventHandlerTable::find(Event::Type type, void* target) const
+{
+    size_t slot = getSlot(type, target) & m_mask;
+    for (;;) {
+        const Entry& entry = m_entries[slot];
+        if (entry.m_handler == NULL) {
+            return NULL;
+        }
+        if (entry.m_target == target && entry.m_type == type) {
+            return entry.m_handler;
+        }
+        slot = (slot + 1) & m_mask;
+    }
+}
+
+size_t
+EventHandlerTable::getSlot(Event::Type type, void* target)
+{
+    // targets are objects so the low bits carry little information
+    std::uintptr_t key = reinterpret_cast<std::uintptr_t>(target) >> 3;
+    key ^= static_cast<std::uintptr_t>(type) * 0x9e3779b9u;
+    key *= static_cast<std::uintptr_t>(0x9e3779b97f4a7c15ull);
+    return static_cast<size_t>(key ^ (key >> 29));
+}
@@ -0,0 +1,69 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/Event.h"
+#include "common/stdmap.h"
+#include "common/stdvector.h"
+
+class IEventJob;
+
+//! Event handler lookup table
+/*!
+An immutable snapshot of the event handlers, stored in a flat open
+addressed hash table keyed on the target and event type.  EventQueue
+builds a new one whenever a handler is added or removed, which is rare
+compared to dispatching events, so lookups never lock or allocate.
+*/
+class EventHandlerTable {
+public:
+    typedef std::map<Event::Type, IEventJob*> TypeHandlerTable;
+    typedef std::map<void*, TypeHandlerTable> HandlerTable;
+
+    //! Build a snapshot of \c handlers
+    explicit EventHandlerTable(const HandlerTable& handlers);
+
+    //! @name accessors
+    //@{
+
+    //! Find handler
+    /*!
+    Returns the handler for events of type \c type sent to \c target or
+    NULL if there isn't one.
+    */
+    IEventJob*            find(Event::Type type, void* target) const;
+
+    //! Get number of handlers
+    size_t                getSize() const { return m_size; }
+
+    //@}
+
+private:
+    static size_t        getSlot(Event::Type type, void* target);
+
+    struct Entry {
+    public:
+        void*            m_target;
+        Event::Type        m_type;
+        IEventJob*        m_handler;
+    };
+
+    std::vector<Entry>    m_entries;
+    size_t                m_mask;
+    size_t                m_size;
+};
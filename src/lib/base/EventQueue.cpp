@@ -29,6 +29,8 @@
 #include "base/XBase.h"
 #include "../gui/src/ShutdownCh.h"
 
+#include <chrono>
+
 EVENT_TYPE_ACCESSOR(Client)
 EVENT_TYPE_ACCESSOR(IStream)
 EVENT_TYPE_ACCESSOR(IpcClient)
@@ -50,6 +52,16 @@ EVENT_TYPE_ACCESSOR(IScreen)
 EVENT_TYPE_ACCESSOR(Clipboard)
 EVENT_TYPE_ACCESSOR(File)
 
+// timer deadlines are absolute so they must not follow changes to the
+// wall clock
+static
+double
+getTimerTime()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 // interrupt handler.  this just adds a quit event to the queue.
 static
 void
@@ -67,6 +79,7 @@ interrupt(Arch::ESignal, void* data)
 EventQueue::EventQueue() :
     m_systemTarget(0),
     m_nextType(Event::kLast),
+    m_numEvents(0),
     m_typesForClient(NULL),
     m_typesForIStream(NULL),
     m_typesForIpcClient(NULL),
@@ -88,7 +101,9 @@ EventQueue::EventQueue() :
     m_typesForClipboard(NULL),
     m_typesForFile(NULL),
     m_readyMutex(new Mutex),
-    m_readyCondVar(new CondVar<bool>(m_readyMutex, false))
+    m_readyCondVar(new CondVar<bool>(m_readyMutex, false)),
+    m_handlerSnapshot(new EventHandlerTable(HandlerTable())),
+    m_handlerReaders(0)
 {
     ARCH->setSignalHandler(Arch::kINTERRUPT, &interrupt, this);
     ARCH->setSignalHandler(Arch::kTERMINATE, &interrupt, this);
@@ -100,6 +115,10 @@ EventQueue::~EventQueue()
     delete m_buffer;
     delete m_readyCondVar;
     delete m_readyMutex;
+    delete m_handlerSnapshot.load();
+    for (size_t i = 0; i < m_retiredSnapshots.size(); ++i) {
+        delete m_retiredSnapshots[i];
+    }
 
     ARCH->setSignalHandler(Arch::kINTERRUPT, NULL, NULL);
     ARCH->setSignalHandler(Arch::kTERMINATE, NULL, NULL);
@@ -178,19 +197,20 @@ EventQueue::adoptBuffer(IEventQueueBuffer* buffer)
 
     LOG((CLOG_DEBUG "adopting new buffer"));
 
-    if (m_events.size() != 0) {
+    if (m_numEvents != 0) {
         // this can come as a nasty surprise to programmers expecting
         // their events to be raised, only to have them deleted.
-        LOG((CLOG_DEBUG "discarding %d event(s)", m_events.size()));
+        LOG((CLOG_DEBUG "discarding %d event(s)", m_numEvents));
     }
 
     // discard old buffer and old events
     delete m_buffer;
     for (EventTable::iterator i = m_events.begin(); i != m_events.end(); ++i) {
-        Event::deleteData(i->second);
+        Event::deleteData(*i);
     }
     m_events.clear();
     m_oldEventIDs.clear();
+    m_numEvents = 0;
 
     // use new buffer
     m_buffer = buffer;
@@ -337,12 +357,7 @@ EventQueue::newTimer(double duration, void* target)
         target = timer;
     }
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_timers.insert(timer);
-    // initial duration is requested duration plus whatever's on
-    // the clock currently because the latter will be subtracted
-    // the next time we check for timers.
-    m_timerQueue.push(Timer(timer, duration,
-                            duration + m_time.getTime(), target, false));
+    m_timers.add(timer, duration, getTimerTime(), target, false);
     return timer;
 }
 
@@ -356,12 +371,7 @@ EventQueue::newOneShotTimer(double duration, void* target)
         target = timer;
     }
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_timers.insert(timer);
-    // initial duration is requested duration plus whatever's on
-    // the clock currently because the latter will be subtracted
-    // the next time we check for timers.
-    m_timerQueue.push(Timer(timer, duration,
-                            duration + m_time.getTime(), target, true));
+    m_timers.add(timer, duration, getTimerTime(), target, true);
     return timer;
 }
 
@@ -369,20 +379,17 @@ void
 EventQueue::deleteTimer(EventQueueTimer* timer)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
-    for (TimerQueue::iterator index = m_timerQueue.begin();
-                            index != m_timerQueue.end(); ++index) {
-        if (index->getTimer() == timer) {
-            m_timerQueue.erase(index);
-            break;
-        }
-    }
-    Timers::iterator index = m_timers.find(timer);
-    if (index != m_timers.end()) {
-        m_timers.erase(index);
-    }
+    m_timers.remove(timer);
     m_buffer->deleteTimer(timer);
 }
 
+void
+EventQueue::resetTimer(EventQueueTimer* timer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_timers.reset(timer, getTimerTime());
+}
+
 void
 EventQueue::adoptHandler(Event::Type type, void* target, IEventJob* handler)
 {
@@ -390,6 +397,7 @@ EventQueue::adoptHandler(Event::Type type, void* target, IEventJob* handler)
     IEventJob*& job = m_handlers[target][type];
     delete job;
     job = handler;
+    publishHandlers();
 }
 
 void
@@ -405,6 +413,10 @@ EventQueue::removeHandler(Event::Type type, void* target)
             if (index2 != typeHandlers.end()) {
                 handler = index2->second;
                 typeHandlers.erase(index2);
+                if (typeHandlers.empty()) {
+                    m_handlers.erase(index);
+                }
+                publishHandlers();
             }
         }
     }
@@ -425,7 +437,8 @@ EventQueue::removeHandlers(void* target)
                             index2 != typeHandlers.end(); ++index2) {
                 handlers.push_back(index2->second);
             }
-            typeHandlers.clear();
+            m_handlers.erase(index);
+            publishHandlers();
         }
     }
 
@@ -439,35 +452,53 @@ EventQueue::removeHandlers(void* target)
 IEventJob*
 EventQueue::getHandler(Event::Type type, void* target) const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    HandlerTable::const_iterator index = m_handlers.find(target);
-    if (index != m_handlers.end()) {
-        const TypeHandlerTable& typeHandlers = index->second;
-        TypeHandlerTable::const_iterator index2 = typeHandlers.find(type);
-        if (index2 != typeHandlers.end()) {
-            return index2->second;
+    // announce the read before taking the snapshot so publishHandlers()
+    // won't delete it from under us
+    ++m_handlerReaders;
+    IEventJob* handler = m_handlerSnapshot.load()->find(type, target);
+    --m_handlerReaders;
+    return handler;
+}
+
+void
+EventQueue::publishHandlers()
+{
+    // note -- must have m_mutex locked on entry
+
+    const EventHandlerTable* old =
+        m_handlerSnapshot.exchange(new EventHandlerTable(m_handlers));
+    m_retiredSnapshots.push_back(old);
+
+    // readers that start from now on see the new snapshot so if there
+    // are none now then none can be using a retired one
+    if (m_handlerReaders.load() == 0) {
+        for (size_t i = 0; i < m_retiredSnapshots.size(); ++i) {
+            delete m_retiredSnapshots[i];
         }
+        m_retiredSnapshots.clear();
     }
-    return NULL;
 }
 
 UInt32
 EventQueue::saveEvent(const Event& event)
 {
+    // saved events always have a type so Event() can mark free slots
+    assert(event.getType() != Event::kUnknown);
+
     // choose id
     UInt32 id;
     if (!m_oldEventIDs.empty()) {
         // reuse an id
         id = m_oldEventIDs.back();
         m_oldEventIDs.pop_back();
+        m_events[id] = event;
     }
     else {
         // make a new id
         id = static_cast<UInt32>(m_events.size());
+        m_events.push_back(event);
     }
-
-    // save data
-    m_events[id] = event;
+    ++m_numEvents;
     return id;
 }
 
@@ -475,14 +506,15 @@ Event
 EventQueue::removeEvent(UInt32 eventID)
 {
     // look up id
-    EventTable::iterator index = m_events.find(eventID);
-    if (index == m_events.end()) {
+    if (eventID >= m_events.size() ||
+        m_events[eventID].getType() == Event::kUnknown) {
         return Event();
     }
 
     // get data
-    Event event = index->second;
-    m_events.erase(index);
+    Event event = m_events[eventID];
+    m_events[eventID] = Event();
+    --m_numEvents;
 
     // save old id for reuse
     m_oldEventIDs.push_back(eventID);
@@ -493,58 +525,24 @@ EventQueue::removeEvent(UInt32 eventID)
 bool
 EventQueue::hasTimerExpired(Event& event)
 {
-    // return true if there's a timer in the timer priority queue that
-    // has expired.  if returning true then fill in event appropriately
-    // and reset and reinsert the timer.
-    if (m_timerQueue.empty()) {
-        return false;
-    }
-
-    // get time elapsed since last check
-    const double time = m_time.getTime();
-    m_time.reset();
-
-    // countdown elapsed time
-    for (TimerQueue::iterator index = m_timerQueue.begin();
-                            index != m_timerQueue.end(); ++index) {
-        (*index) -= time;
-    }
-
-    // done if no timers are expired
-    if (m_timerQueue.top() > 0.0) {
+    // return true if a timer has expired.  if returning true then fill
+    // in event appropriately.  the timer queue restarts the timer.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    void* target;
+    if (!m_timers.expire(getTimerTime(), m_timerEvent, target)) {
         return false;
     }
-
-    // remove timer from queue
-    Timer timer = m_timerQueue.top();
-    m_timerQueue.pop();
-
-    // prepare event and reset the timer's clock
-    timer.fillEvent(m_timerEvent);
-    event = Event(Event::kTimer, timer.getTarget(), &m_timerEvent);
-    timer.reset();
-
-    // reinsert timer into queue if it's not a one-shot
-    if (!timer.isOneShot()) {
-        m_timerQueue.push(timer);
-    }
-
+    event = Event(Event::kTimer, target, &m_timerEvent);
     return true;
 }
 
 double
 EventQueue::getNextTimerTimeout() const
 {
-    // return -1 if no timers, 0 if the top timer has expired, otherwise
-    // the time until the top timer in the timer priority queue will
-    // expire.
-    if (m_timerQueue.empty()) {
-        return -1.0;
-    }
-    if (m_timerQueue.top() <= 0.0) {
-        return 0.0;
-    }
-    return m_timerQueue.top();
+    // return -1 if no timers, 0 if a timer has expired, otherwise the
+    // time until the next timer expires.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timers.getTimeout(getTimerTime());
 }
 
 Event::Type EventQueue::getRegisteredType(const std::string& name) const
@@ -575,75 +573,3 @@ EventQueue::waitForReady() const
         }
     }
 }
-
-//
-// EventQueue::Timer
-//
-
-EventQueue::Timer::Timer(EventQueueTimer* timer, double timeout,
-                double initialTime, void* target, bool oneShot) :
-    m_timer(timer),
-    m_timeout(timeout),
-    m_target(target),
-    m_oneShot(oneShot),
-    m_time(initialTime)
-{
-    assert(m_timeout > 0.0);
-}
-
-EventQueue::Timer::~Timer()
-{
-    // do nothing
-}
-
-void
-EventQueue::Timer::reset()
-{
-    m_time = m_timeout;
-}
-
-EventQueue::Timer&
-EventQueue::Timer::operator-=(double dt)
-{
-    m_time -= dt;
-    return *this;
-}
-
-EventQueue::Timer::operator double() const
-{
-    return m_time;
-}
-
-bool
-EventQueue::Timer::isOneShot() const
-{
-    return m_oneShot;
-}
-
-EventQueueTimer*
-EventQueue::Timer::getTimer() const
-{
-    return m_timer;
-}
-
-void*
-EventQueue::Timer::getTarget() const
-{
-    return m_target;
-}
-
-void
-EventQueue::Timer::fillEvent(TimerEvent& event) const
-{
-    event.m_timer = m_timer;
-    event.m_count = 0;
-    if (m_time <= 0.0) {
-        event.m_count = static_cast<UInt32>((m_timeout - m_time) / m_timeout);
-    }
-}
-
-bool
-EventQueue::Timer::operator<(const Timer& t) const
-{
-    return m_time < t.m_time;
-}
@@ -22,12 +22,13 @@
 #include "arch/IArchMultithread.h"
 #include "base/IEventQueue.h"
 #include "base/Event.h"
-#include "base/PriorityQueue.h"
-#include "base/Stopwatch.h"
+#include "base/EventHandlerTable.h"
+#include "base/EventTimerQueue.h"
 #include "common/stdmap.h"
-#include "common/stdset.h"
+#include "common/stdvector.h"
 #include "base/NonBlockingStream.h"
 
+#include <atomic>
 #include <mutex>
 #include <queue>
 
@@ -52,6 +53,7 @@ public:
     virtual EventQueueTimer*
                         newOneShotTimer(double duration, void* target);
     virtual void        deleteTimer(EventQueueTimer*);
+    virtual void        resetTimer(EventQueueTimer*);
     virtual void        adoptHandler(Event::Type type,
                             void* target, IEventJob* handler);
     virtual void        removeHandler(Event::Type type, void* target);
@@ -70,45 +72,16 @@ private:
     bool                hasTimerExpired(Event& event);
     double                getNextTimerTimeout() const;
     void                addEventToBuffer(const Event& event);
+    void                publishHandlers();
     bool                parent_requests_shutdown() const;
 
 private:
-    class Timer {
-    public:
-        Timer(EventQueueTimer*, double timeout, double initialTime,
-                            void* target, bool oneShot);
-        ~Timer();
-
-        void            reset();
-
-        Timer&            operator-=(double);
-
-                        operator double() const;
-
-        bool            isOneShot() const;
-        EventQueueTimer*
-                        getTimer() const;
-        void*            getTarget() const;
-        void            fillEvent(TimerEvent&) const;
-
-        bool            operator<(const Timer&) const;
-
-    private:
-        EventQueueTimer*    m_timer;
-        double                m_timeout;
-        void*                m_target;
-        bool                m_oneShot;
-        double                m_time;
-    };
-
-    typedef std::set<EventQueueTimer*> Timers;
-    typedef PriorityQueue<Timer> TimerQueue;
-    typedef std::map<UInt32, Event> EventTable;
+    typedef std::vector<Event> EventTable;
     typedef std::vector<UInt32> EventIDList;
     typedef std::map<Event::Type, const char*> TypeMap;
     typedef std::map<std::string, Event::Type> NameMap;
-    typedef std::map<Event::Type, IEventJob*> TypeHandlerTable;
-    typedef std::map<void*, TypeHandlerTable> HandlerTable;
+    typedef EventHandlerTable::TypeHandlerTable TypeHandlerTable;
+    typedef EventHandlerTable::HandlerTable HandlerTable;
 
     int                    m_systemTarget;
     mutable std::mutex m_mutex;
@@ -121,18 +94,25 @@ private:
     // buffer of events
     IEventQueueBuffer*    m_buffer;
 
-    // saved events
+    // saved events.  an event's id is its index in m_events and ids of
+    // removed events are reused before m_events grows, so saving and
+    // removing an event doesn't allocate.  free slots hold Event().
     EventTable            m_events;
     EventIDList        m_oldEventIDs;
+    UInt32                m_numEvents;
 
     // timers
-    Stopwatch            m_time;
-    Timers                m_timers;
-    TimerQueue            m_timerQueue;
+    EventTimerQueue        m_timers;
     TimerEvent            m_timerEvent;
 
-    // event handlers
+    // event handlers.  m_handlers is changed with m_mutex locked and
+    // then copied to a new snapshot for getHandler(), which reads it
+    // without locking.  a replaced snapshot is deleted once no reader
+    // can still be using it.
     HandlerTable        m_handlers;
+    std::atomic<const EventHandlerTable*>    m_handlerSnapshot;
+    mutable std::atomic<UInt32>    m_handlerReaders;
+    std::vector<const EventHandlerTable*>    m_retiredSnapshots;
 
 public:
     //
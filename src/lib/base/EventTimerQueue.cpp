@@ -0,0 +1,226 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventTimerQueue.h"
+
+#include <cassert>
+
+//
+// EventTimerQueue
+//
+
+const UInt32 EventTimerQueue::kNotQueued;
+
+EventTimerQueue::EventTimerQueue()
+{
+    // do nothing
+}
+
+void
+EventTimerQueue::add(EventQueueTimer* eventTimer, double duration,
+                double now, void* target, bool oneShot)
+{
+    assert(eventTimer != NULL);
+    assert(duration > 0.0);
+    assert(m_slots.find(eventTimer) == m_slots.end());
+
+    UInt32 index;
+    if (m_freeTimers.empty()) {
+        index = static_cast<UInt32>(m_timers.size());
+        m_timers.push_back(Timer());
+    }
+    else {
+        index = m_freeTimers.back();
+        m_freeTimers.pop_back();
+    }
+    m_slots[eventTimer] = index;
+
+    Timer& timer     = m_timers[index];
+    timer.m_timer    = eventTimer;
+    timer.m_target   = target;
+    timer.m_duration = duration;
+    timer.m_deadline = now + duration;
+    timer.m_oneShot  = oneShot;
+    timer.m_position = kNotQueued;
+    push(index);
+}
+
+void
+EventTimerQueue::remove(EventQueueTimer* eventTimer)
+{
+    std::unordered_map<EventQueueTimer*, UInt32>::iterator i =
+        m_slots.find(eventTimer);
+    if (i == m_slots.end()) {
+        return;
+    }
+
+    UInt32 index = i->second;
+    m_slots.erase(i);
+    if (m_timers[index].m_position != kNotQueued) {
+        removeAt(m_timers[index].m_position);
+    }
+    m_timers[index].m_timer = NULL;
+    m_freeTimers.push_back(index);
+}
+
+void
+EventTimerQueue::reset(EventQueueTimer* eventTimer, double now)
+{
+    std::unordered_map<EventQueueTimer*, UInt32>::iterator i =
+        m_slots.find(eventTimer);
+    if (i == m_slots.end()) {
+        return;
+    }
+
+    UInt32 index = i->second;
+    Timer& timer = m_timers[index];
+    timer.m_deadline = now + timer.m_duration;
+    if (timer.m_position == kNotQueued) {
+        push(index);
+    }
+    else if (timer.m_deadline < m_heap[timer.m_position].m_wakeup) {
+        // only if the clock went backwards
+        m_heap[timer.m_position].m_wakeup = timer.m_deadline;
+        siftUp(timer.m_position);
+    }
+
+    // otherwise leave the entry where it is.  expire() moves it to the
+    // new deadline when it reaches the top of the heap.
+}
+
+bool
+EventTimerQueue::expire(double now, TimerEvent& event, void*& target)
+{
+    while (!m_heap.empty() && m_heap[0].m_wakeup <= now) {
+        Timer& timer = m_timers[m_heap[0].m_timer];
+        if (timer.m_deadline > now) {
+            // timer was reset after it was queued
+            m_heap[0].m_wakeup = timer.m_deadline;
+            siftDown(0);
+            continue;
+        }
+
+        // count the periods since the timer was last due
+        event.m_timer = timer.m_timer;
+        event.m_count = static_cast<UInt32>(
+            (timer.m_duration + now - timer.m_deadline) / timer.m_duration);
+        target        = timer.m_target;
+
+        if (timer.m_oneShot) {
+            removeAt(0);
+        }
+        else {
+            timer.m_deadline   = now + timer.m_duration;
+            m_heap[0].m_wakeup = timer.m_deadline;
+            siftDown(0);
+        }
+        return true;
+    }
+    return false;
+}
+
+double
+EventTimerQueue::getTimeout(double now) const
+{
+    // the top entry may wake up before its timer's deadline, which only
+    // costs an early check
+    if (m_heap.empty()) {
+        return -1.0;
+    }
+    if (m_heap[0].m_wakeup <= now) {
+        return 0.0;
+    }
+    return m_heap[0].m_wakeup - now;
+}
+
+void
+EventTimerQueue::push(UInt32 index)
+{
+    HeapEntry entry;
+    entry.m_wakeup = m_timers[index].m_deadline;
+    entry.m_timer  = index;
+    m_heap.push_back(entry);
+    m_timers[index].m_position = static_cast<UInt32>(m_heap.size() - 1);
+    siftUp(m_timers[index].m_position);
+}
+
+void
+EventTimerQueue::removeAt(UInt32 position)
+{
+    assert(position < m_heap.size());
+
+    m_timers[m_heap[position].m_timer].m_position = kNotQueued;
+
+    // fill the hole with the last entry and restore the heap around it
+    HeapEntry last = m_heap.back();
+    m_heap.pop_back();
+    if (position < m_heap.size()) {
+        place(position, last);
+        if (position > 0 &&
+            last.m_wakeup < m_heap[(position - 1) / 2].m_wakeup) {
+            siftUp(position);
+        }
+        else {
+            siftDown(position);
+        }
+    }
+}
+
+void
+EventTimerQueue::siftUp(UInt32 position)
+{
+    HeapEntry entry = m_heap[position];
+    while (position > 0) {
+        UInt32 parent = (position - 1) / 2;
+        if (!(entry.m_wakeup < m_heap[parent].m_wakeup)) {
+            break;
+        }
+        place(position, m_heap[parent]);
+        position = parent;
+    }
+    place(position, entry);
+}
+
+void
+EventTimerQueue::siftDown(UInt32 position)
+{
+    HeapEntry entry = m_heap[position];
+    const UInt32 size = static_cast<UInt32>(m_heap.size());
+    for (;;) {
+        UInt32 child = 2 * position + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size &&
+            m_heap[child + 1].m_wakeup < m_heap[child].m_wakeup) {
+            ++child;
+        }
+        if (!(m_heap[child].m_wakeup < entry.m_wakeup)) {
+            break;
+        }
+        place(position, m_heap[child]);
+        position = child;
+    }
+    place(position, entry);
+}
+
+void
+EventTimerQueue::place(UInt32 position, const HeapEntry& entry)
+{
+    m_heap[position] = entry;
+    m_timers[entry.m_timer].m_position = position;
+}
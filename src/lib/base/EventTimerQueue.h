@@ -0,0 +1,128 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/IEventQueue.h"
+#include "common/stdvector.h"
+
+#include <unordered_map>
+
+//! Event queue timers
+/*!
+Keeps the timers of an EventQueue in a binary heap ordered by absolute
+deadline, so checking for expired timers doesn't touch the timers that
+haven't expired.  Each timer remembers its place in the heap so it can
+be removed without searching.  Restarting a timer only moves its
+deadline later, so reset() just records the new deadline and the heap
+catches up when the old one comes around.  Times are in seconds on any
+clock that doesn't go backwards.
+*/
+class EventTimerQueue {
+public:
+    typedef IEventQueue::TimerEvent TimerEvent;
+
+    EventTimerQueue();
+
+    //! @name manipulators
+    //@{
+
+    //! Add timer
+    /*!
+    Adds \c timer to expire \c duration seconds after \c now, sending
+    its event to \c target.  A timer that isn't one-shot then expires
+    every \c duration seconds until it's removed.
+    */
+    void                add(EventQueueTimer* timer, double duration,
+                            double now, void* target, bool oneShot);
+
+    //! Remove timer
+    /*!
+    Removes \c timer, which then never expires.  Does nothing if the
+    timer isn't in the queue.
+    */
+    void                remove(EventQueueTimer* timer);
+
+    //! Restart timer
+    /*!
+    Makes \c timer next expire its full duration after \c now, as if it
+    had just been added.  A one-shot timer that already expired is
+    started again.  Takes constant time and doesn't allocate.
+    */
+    void                reset(EventQueueTimer* timer, double now);
+
+    //! Get expired timer
+    /*!
+    If a timer has expired at \c now, fills in \c event and \c target
+    for it, restarts it (or stops it if it's one-shot) and returns true.
+    Otherwise returns false.
+    */
+    bool                expire(double now, TimerEvent& event, void*& target);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get time until the next timer expires
+    /*!
+    Returns the seconds from \c now until the next timer may expire, 0
+    if one has already expired, or -1 if there are no running timers.
+    */
+    double                getTimeout(double now) const;
+
+    //! Get number of timers
+    size_t                getSize() const { return m_slots.size(); }
+
+    //@}
+
+private:
+    static const UInt32    kNotQueued = 0xffffffffu;
+
+    // the heap holds each timer's wakeup next to its index so ordering
+    // the heap doesn't have to look at the timers
+    struct HeapEntry {
+    public:
+        double            m_wakeup;
+        UInt32            m_timer;
+    };
+
+    struct Timer {
+    public:
+        EventQueueTimer*    m_timer;
+        void*            m_target;
+        double            m_duration;
+        double            m_deadline;
+        bool            m_oneShot;
+        UInt32            m_position;
+    };
+
+    void                push(UInt32 index);
+    void                removeAt(UInt32 position);
+    void                siftUp(UInt32 position);
+    void                siftDown(UInt32 position);
+    void                place(UInt32 position, const HeapEntry& entry);
+
+    // timers by index.  indexes of removed timers are reused before
+    // m_timers grows.
+    std::vector<Timer>    m_timers;
+    std::vector<UInt32>    m_freeTimers;
+    std::unordered_map<EventQueueTimer*, UInt32>    m_slots;
+
+    // running timers.  an entry's wakeup is never after its timer's
+    // deadline but may be before it if the timer was reset.
+    std::vector<HeapEntry>    m_heap;
+};
@@ -193,7 +193,8 @@ REGISTER_EVENT(IpcServer, messageReceived)
 
 REGISTER_EVENT(Clipboard, clipboardGrabbed)
 REGISTER_EVENT(Clipboard, clipboardChanged)
-REGISTER_EVENT(Clipboard, clipboardSending)
+REGISTER_EVENT(Clipboard, clipboardRequested)
+REGISTER_EVENT(Clipboard, clipboardFetched)
 
 //
 // File
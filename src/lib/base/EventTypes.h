@@ -699,7 +699,8 @@ public:
     ClipboardEvents() :
         m_clipboardGrabbed(Event::kUnknown),
         m_clipboardChanged(Event::kUnknown),
-        m_clipboardSending(Event::kUnknown) { }
+        m_clipboardRequested(Event::kUnknown),
+        m_clipboardFetched(Event::kUnknown) { }
 
     //! @name accessors
     //@{
@@ -720,19 +721,29 @@ public:
     */
     Event::Type        clipboardChanged();
 
-    //! Clipboard sending event type
+    //! Get clipboard requested event type
     /*!
-    Returns the clipboard sending event type. This is used to send
-    clipboard chunks.
+    Returns the clipboard requested event type.  This is sent when an
+    application asks for promised clipboard data that hasn't arrived
+    yet.  The data is a pointer to a IScreen::ClipboardRequestInfo.
     */
-    Event::Type        clipboardSending();
+    Event::Type        clipboardRequested();
+
+    //! Get clipboard fetched event type
+    /*!
+    Returns the clipboard fetched event type.  This is sent when the
+    data asked of a client that offered its clipboard has arrived.  The
+    data is a pointer to a IScreen::ClipboardInfo.
+    */
+    Event::Type        clipboardFetched();
 
     //@}
 
 private:
     Event::Type        m_clipboardGrabbed;
     Event::Type        m_clipboardChanged;
-    Event::Type        m_clipboardSending;
+    Event::Type        m_clipboardRequested;
+    Event::Type        m_clipboardFetched;
 };
 
 class FileEvents : public EventTypes {
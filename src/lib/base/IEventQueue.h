@@ -144,6 +144,16 @@ public:
     */
     virtual void        deleteTimer(EventQueueTimer*) = 0;
 
+    //! Restart a timer
+    /*!
+    Restarts the countdown of a previously created timer, as if it had
+    just been created with the same duration.  A one-shot timer that has
+    already expired is started again.  This is much cheaper than deleting
+    and recreating the timer, so use it for timeouts that are pushed back
+    by every message, like heartbeats.
+    */
+    virtual void        resetTimer(EventQueueTimer*) = 0;
+
     //! Register an event handler for an event type
     /*!
     Registers an event handler for \p type and \p target.  The \p handler
@@ -22,10 +22,12 @@
 #include "base/log_outputters.h"
 #include "common/Version.h"
 
+#include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <ctime>
+#include <vector>
 
 // names of priorities
 static const char*        g_priority[] = {
@@ -52,25 +54,42 @@ static const int        g_defaultMaxPriority = kDEBUG;
 static const int        g_defaultMaxPriority = kINFO;
 #endif
 
+// names of timestamp precisions
+static const char*        g_timestampPrecision[] = {
+    "s",
+    "ms",
+    "us"
+};
+
+// each thread formats its messages in its own buffer, which is kept
+// between messages so printing doesn't allocate once it's big enough
+static thread_local std::vector<char>    g_buffer;
+
+// each thread's last formatted timestamp, to the second
+static thread_local time_t    g_timestampSecond = -1;
+static thread_local char    g_timestamp[64];
+static thread_local size_t    g_timestampLength = 0;
+
 //
 // Log
 //
 
 Log*                 Log::s_log = NULL;
 
-Log::Log()
+Log::Log() :
+    m_maxPriority(g_defaultMaxPriority),
+    m_timestampPrecision(kTimestampSeconds)
 {
     assert(s_log == NULL);
 
-    // other initalization
-    m_maxPriority = g_defaultMaxPriority;
-    m_maxNewlineLength = 0;
     insert(new ConsoleLogOutputter);
 
     s_log = this;
 }
 
-Log::Log(Log* src)
+Log::Log(Log* src) :
+    m_maxPriority(g_defaultMaxPriority),
+    m_timestampPrecision(kTimestampSeconds)
 {
     s_log = src;
 }
@@ -115,7 +134,7 @@ Log::print(const char* file, int line, const char* fmt, ...)
 {
     // check if fmt begins with a priority argument
     ELevel priority = kINFO;
-    if ((strlen(fmt) > 2) && (fmt[0] == '%' && fmt[1] == 'z')) {
+    if (fmt[0] == '%' && fmt[1] == 'z' && fmt[2] != '\0') {
 
         // 060 in octal is 0 (48 in decimal), so subtracting this converts ascii
         // number it a true number. we could use atoi instead, but this is how
@@ -131,77 +150,97 @@ Log::print(const char* file, int line, const char* fmt, ...)
         return;
     }
 
-    // compute prefix padding length
-    char stack[1024];
+    // always leave room for the prefix
+    std::vector<char>& buffer = g_buffer;
+    if (buffer.size() < 1024) {
+        buffer.resize(1024);
+    }
 
-    // compute suffix padding length
-    int sPad = m_maxNewlineLength;
+    // print the prefix to the buffer.  do not prefix time and file for
+    // kPRINT (CLOG_PRINT)
+    size_t length = 0;
+    if (priority != kPRINT) {
+        length = formatPrefix(&buffer[0], priority);
+    }
 
-    // print to buffer, leaving space for a newline at the end and prefix
-    // at the beginning.
-    char* buffer = stack;
-    int len            = (int)(sizeof(stack) / sizeof(stack[0]));
+    // print the message after the prefix, growing the buffer until it fits
     while (true) {
-        // try printing into the buffer
+        int space = (int)(buffer.size() - length);
+
         va_list args;
         va_start(args, fmt);
-        int n = ARCH->vsnprintf(buffer, len    - sPad, fmt, args);
+        int n = ARCH->vsnprintf(&buffer[length], space, fmt, args);
         va_end(args);
 
-        // if the buffer wasn't big enough then make it bigger and try again
-        if (n < 0 || n > (int)len) {
-            if (buffer != stack) {
-                delete[] buffer;
-            }
-            len     *= 2;
-            buffer = new char[len];
-        }
-
-        // if the buffer was big enough then continue
-        else {
+        if (n >= 0 && n < space) {
+            length += n;
             break;
         }
+        buffer.resize(n < 0 ? 2 * buffer.size() : length + n + 1);
     }
 
-    // print the prefix to the buffer.    leave space for priority label.
-    // do not prefix time and file for kPRINT (CLOG_PRINT)
-    if (priority != kPRINT) {
-
-        struct tm *tm;
-        char timestamp[50];
-        time_t t;
-        time(&t);
-        tm = localtime(&t);
-        sprintf(timestamp, "%04i-%02i-%02iT%02i:%02i:%02i", tm->tm_year + 1900, tm->tm_mon+1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec);
-
-        // square brackets, spaces, comma and null terminator take about 10
-        size_t size = 10;
-        size += strlen(timestamp);
-        size += strlen(g_priority[priority]);
-        size += strlen(buffer);
 #ifndef NDEBUG
-        size += strlen(file);
-        // assume there is no file contains over 100k lines of code
-        size += 6;
+    if (priority != kPRINT && file != NULL) {
+        // newline, tab, comma, line number and terminator
+        size_t size = length + strlen(file) + 16;
+        if (buffer.size() < size) {
+            buffer.resize(size);
+        }
+        sprintf(&buffer[length], "\n\t%s,%d", file, line);
+    }
 #endif
-        char* message = new char[size];
 
-#ifndef NDEBUG
-        sprintf(message, "[%s] %s: %s\n\t%s,%d", timestamp, g_priority[priority], buffer, file, line);
+    output(priority, &buffer[0]);
+}
+
+size_t
+Log::formatPrefix(char* buffer, ELevel priority) const
+{
+    using namespace std::chrono;
+    long long now = duration_cast<microseconds>(
+                            system_clock::now().time_since_epoch()).count();
+    time_t second = (time_t)(now / 1000000);
+    int micros    = (int)(now % 1000000);
+
+    // the date and time only change once a second
+    if (second != g_timestampSecond) {
+        struct tm tm;
+#if SYSAPI_WIN32
+        localtime_s(&tm, &second);
 #else
-        sprintf(message, "[%s] %s: %s", timestamp, g_priority[priority], buffer);
+        localtime_r(&second, &tm);
 #endif
-
-        output(priority, message);
-        delete[] message;
-    } else {
-        output(priority, buffer);
+        g_timestampLength = snprintf(g_timestamp, sizeof(g_timestamp),
+                            "%04i-%02i-%02iT%02i:%02i:%02i",
+                            tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                            tm.tm_hour, tm.tm_min, tm.tm_sec);
+        g_timestampSecond = second;
     }
 
-    // clean up
-    if (buffer != stack) {
-        delete[] buffer;
+    char* end = buffer;
+    *end++ = '[';
+    memcpy(end, g_timestamp, g_timestampLength);
+    end += g_timestampLength;
+    switch (getTimestampPrecision()) {
+    case kTimestampMilliseconds:
+        end += sprintf(end, ".%03i", micros / 1000);
+        break;
+
+    case kTimestampMicroseconds:
+        end += sprintf(end, ".%06i", micros);
+        break;
+
+    default:
+        break;
     }
+    *end++ = ']';
+    *end++ = ' ';
+    size_t nameLength = strlen(g_priority[priority]);
+    memcpy(end, g_priority[priority], nameLength);
+    end += nameLength;
+    *end++ = ':';
+    *end++ = ' ';
+    return end - buffer;
 }
 
 void
@@ -266,19 +305,45 @@ Log::setFilter(const char* maxPriority)
 void
 Log::setFilter(int maxPriority)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
     m_maxPriority = maxPriority;
 }
 
 int
 Log::getFilter() const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_maxPriority;
+    return m_maxPriority.load(std::memory_order_relaxed);
+}
+
+bool
+Log::setTimestampPrecision(const char* name)
+{
+    if (name != NULL) {
+        for (int i = kTimestampSeconds; i <= kTimestampMicroseconds; ++i) {
+            if (strcmp(name, g_timestampPrecision[i]) == 0) {
+                setTimestampPrecision((ETimestampPrecision)i);
+                return true;
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+void
+Log::setTimestampPrecision(ETimestampPrecision precision)
+{
+    m_timestampPrecision = precision;
+}
+
+Log::ETimestampPrecision
+Log::getTimestampPrecision() const
+{
+    return (ETimestampPrecision)
+        m_timestampPrecision.load(std::memory_order_relaxed);
 }
 
 void
-Log::output(ELevel priority, char* msg)
+Log::output(ELevel priority, const char* msg)
 {
     assert(priority >= -1 && priority < g_numPriority);
     assert(msg != NULL);
@@ -24,6 +24,7 @@
 #include "common/stdlist.h"
 
 #include <stdarg.h>
+#include <atomic>
 #include <mutex>
 
 #define CLOG (Log::getInstance())
@@ -41,6 +42,13 @@ LOGC() provide convenient access.
 */
 class Log {
 public:
+    //! Timestamp precision
+    enum ETimestampPrecision {
+        kTimestampSeconds,        //!< [2018-01-01T00:00:00]
+        kTimestampMilliseconds,    //!< [2018-01-01T00:00:00.000]
+        kTimestampMicroseconds    //!< [2018-01-01T00:00:00.000000]
+    };
+
     Log();
     Log(Log* src);
     ~Log();
@@ -95,6 +103,18 @@ public:
     //! Set the minimum priority filter (by ordinal).
     void                setFilter(int);
 
+    //! Set the timestamp precision
+    /*!
+    Sets how finely the time each message was logged is shown.  The
+    default is whole seconds.  setTimestampPrecision(const char*)
+    accepts "s", "ms" or "us" and returns true if \c name was
+    recognized;  if \c name is NULL then it simply returns true.
+    */
+    bool                setTimestampPrecision(const char* name);
+
+    //! Set the timestamp precision (by enumerant)
+    void                setTimestampPrecision(ETimestampPrecision);
+
     //@}
     //! @name accessors
     //@{
@@ -103,7 +123,9 @@ public:
     /*!
     Print a log message using the printf-like \c format and arguments
     preceded by the filename and line number.  If \c file is NULL then
-    neither the file nor the line are printed.
+    neither the file nor the line are printed.  Messages are formatted
+    in a buffer owned by the calling thread, so once that has grown to
+    fit the longest message printing doesn't allocate.
     */
     void                print(const char* file, int line,
                             const char* format, ...);
@@ -111,6 +133,9 @@ public:
     //! Get the minimum priority level.
     int                    getFilter() const;
 
+    //! Get the timestamp precision
+    ETimestampPrecision    getTimestampPrecision() const;
+
     //! Get the filter name of the current filter level.
     const char*            getFilterName() const;
 
@@ -126,7 +151,8 @@ public:
     //@}
 
 private:
-    void                output(ELevel priority, char* msg);
+    size_t                formatPrefix(char* buffer, ELevel priority) const;
+    void                output(ELevel priority, const char* msg);
 
 private:
     typedef std::list<ILogOutputter*> OutputterList;
@@ -136,8 +162,8 @@ private:
     mutable std::mutex m_mutex;
     OutputterList        m_outputters;
     OutputterList        m_alwaysOutputters;
-    int                    m_maxNewlineLength;
-    int                    m_maxPriority;
+    std::atomic<int>    m_maxPriority;
+    std::atomic<int>    m_timestampPrecision;
 };
 
 /*!
@@ -0,0 +1,410 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/TraceLog.h"
+
+#include <cassert>
+#include <cstring>
+#if SYSAPI_WIN32
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+// the ring each thread writes to, valid while g_ringGeneration matches
+// the trace log's generation
+static thread_local UInt32                    g_ringGeneration = 0;
+static thread_local TraceLog::RingHeader*    g_ring = NULL;
+
+//
+// TraceLog
+//
+
+const char                    TraceLog::kMagic[8] = "BTRACE1";
+const UInt32                TraceLog::kByteOrder;
+const UInt32                TraceLog::kPadding;
+const UInt32                TraceLog::kNoFormat;
+std::atomic<TraceLog*>        TraceLog::s_instance(NULL);
+std::atomic<UInt32>            TraceLog::s_generation(0);
+
+TraceLog::TraceLog(const char* filename, UInt32 ringSize, UInt32 rings) :
+    m_rings(rings),
+    m_ringSize((ringSize + 7) & ~7u),
+    m_data(NULL),
+    m_size(0),
+    m_mapped(false),
+#if SYSAPI_WIN32
+    m_file(NULL),
+    m_mapping(NULL),
+#else
+    m_fd(-1),
+#endif
+    m_start(std::chrono::steady_clock::now()),
+    m_nextRing(0),
+    m_dropped(0)
+{
+    assert(m_ringSize >= 2 * kMaxRecordSize);
+    assert(s_instance.load() == NULL);
+
+    // the low 16 bits of the generation are kept with each call site's
+    // format so must never be zero, which means not registered
+    do {
+        m_generation = ++s_generation;
+    } while ((m_generation & 0xffff) == 0);
+
+    m_size = sizeof(FileHeader) + kFormatTableSize +
+                (size_t)m_rings * (sizeof(RingHeader) + m_ringSize);
+    if (filename == NULL || !map(filename)) {
+        if (filename != NULL) {
+            LOG((CLOG_WARN "cannot map trace log %s, tracing to memory", filename));
+        }
+        m_data = new UInt8[m_size];
+        memset(m_data, 0, m_size);
+    }
+
+    FileHeader* header = reinterpret_cast<FileHeader*>(m_data);
+    memcpy(header->m_magic, kMagic, sizeof(header->m_magic));
+    header->m_byteOrder       = kByteOrder;
+    header->m_rings           = m_rings;
+    header->m_ringSize        = m_ringSize;
+    header->m_formatTableSize = kFormatTableSize;
+    header->m_formatTableUsed = 0;
+    header->m_formats         = 0;
+    header->m_startTime       = std::chrono::duration_cast<
+                                    std::chrono::microseconds>(
+                                    std::chrono::system_clock::now().
+                                        time_since_epoch()).count();
+
+    s_instance = this;
+}
+
+TraceLog::~TraceLog()
+{
+    s_instance = NULL;
+    if (m_mapped) {
+        unmap();
+    }
+    else {
+        delete[] m_data;
+    }
+}
+
+UInt32
+TraceLog::addFormat(const char* file, int line, const char* fmt)
+{
+    std::lock_guard<std::mutex> lock(m_formatMutex);
+
+    std::unordered_map<const char*, UInt32>::const_iterator i =
+        m_formatIndex.find(fmt);
+    if (i != m_formatIndex.end()) {
+        return i->second;
+    }
+
+    // split off the priority as Log::print() does
+    const char* key = fmt;
+    int level = kINFO;
+    if (fmt[0] == '%' && fmt[1] == 'z' && fmt[2] != '\0') {
+        level = fmt[2] - '\060';
+        fmt += 3;
+    }
+    if (file == NULL) {
+        file = "";
+    }
+
+    FileHeader* header = reinterpret_cast<FileHeader*>(m_data);
+    size_t fileLength = strlen(file) + 1;
+    size_t fmtLength  = strlen(fmt) + 1;
+    UInt32 size = (UInt32)((sizeof(FormatHeader) + fileLength +
+                            fmtLength + 3) & ~(size_t)3);
+    UInt32 format = kNoFormat;
+    if (header->m_formats < kNoFormat &&
+        header->m_formatTableUsed + size <= kFormatTableSize) {
+        UInt8* entry = m_data + sizeof(FileHeader) +
+                            header->m_formatTableUsed;
+        FormatHeader formatHeader;
+        formatHeader.m_size  = size;
+        formatHeader.m_level = level;
+        formatHeader.m_line  = line;
+        memset(entry, 0, size);
+        memcpy(entry, &formatHeader, sizeof(formatHeader));
+        memcpy(entry + sizeof(formatHeader), file, fileLength);
+        memcpy(entry + sizeof(formatHeader) + fileLength, fmt, fmtLength);
+
+        // count the format last so a reader never sees half of one
+        format = header->m_formats;
+        header->m_formatTableUsed += size;
+        header->m_formats = format + 1;
+    }
+    m_formatIndex[key] = format;
+    return format;
+}
+
+UInt32
+TraceLog::getCallSiteFormat(std::atomic<UInt32>& callSite,
+                const char* file, int line, const char* fmt)
+{
+    UInt32 generation = m_generation & 0xffff;
+    UInt32 value = callSite.load(std::memory_order_relaxed);
+    if ((value >> 16) == generation) {
+        return value & 0xffff;
+    }
+
+    UInt32 format = addFormat(file, line, fmt);
+    callSite.store((generation << 16) | format, std::memory_order_relaxed);
+    return format;
+}
+
+void
+TraceLog::write(UInt32 format, Encoder& encoder)
+{
+    RingHeader* ring = getRing();
+    if (ring == NULL) {
+        m_dropped++;
+        return;
+    }
+
+    // fill in the header and round the record up to a multiple of 8
+    UInt32 size = (encoder.m_size + 7) & ~7u;
+    RecordHeader header;
+    header.m_size   = size;
+    header.m_format = format;
+    header.m_time   = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - m_start).count();
+    memcpy(encoder.m_data, &header, sizeof(header));
+    memset(encoder.m_data + encoder.m_size, 0, size - encoder.m_size);
+
+    UInt8* data = reinterpret_cast<UInt8*>(ring + 1);
+    std::uint64_t head = ring->m_head;
+    UInt32 offset = (UInt32)(head % m_ringSize);
+    if (offset + size > m_ringSize) {
+        // records never wrap so pad out the end of the ring.  only the
+        // size and format of the padding are needed.
+        UInt32 padding = m_ringSize - offset;
+        reserve(ring, head, padding);
+        RecordHeader paddingHeader;
+        paddingHeader.m_size   = padding;
+        paddingHeader.m_format = kPadding;
+        memcpy(data + offset, &paddingHeader, 2 * sizeof(UInt32));
+        head  += padding;
+        offset = 0;
+    }
+    reserve(ring, head, size);
+    memcpy(data + offset, encoder.m_data, size);
+
+    // publish the record only once it's complete, so a crash leaves
+    // every record between the tail and head whole
+    std::atomic_thread_fence(std::memory_order_release);
+    ring->m_head = head + size;
+}
+
+TraceLog::RingHeader*
+TraceLog::getRing()
+{
+    if (g_ringGeneration == m_generation) {
+        return g_ring;
+    }
+
+    RingHeader* ring = NULL;
+    UInt32 index = m_nextRing++;
+    if (index < m_rings) {
+        ring = reinterpret_cast<RingHeader*>(m_data + sizeof(FileHeader) +
+                            kFormatTableSize +
+                            (size_t)index * (sizeof(RingHeader) + m_ringSize));
+        ring->m_thread = index + 1;
+    }
+
+    g_ringGeneration = m_generation;
+    g_ring           = ring;
+    return ring;
+}
+
+void
+TraceLog::reserve(RingHeader* ring, std::uint64_t head, UInt32 size)
+{
+    // move the tail past the records the new one will overwrite.  the
+    // tail moves first so it never points into a record being written.
+    const UInt8* data = reinterpret_cast<const UInt8*>(ring + 1);
+    std::uint64_t tail = ring->m_tail;
+    while (head + size - tail > m_ringSize) {
+        UInt32 recordSize;
+        memcpy(&recordSize, data + tail % m_ringSize, sizeof(recordSize));
+        tail += recordSize;
+    }
+    ring->m_tail = tail;
+}
+
+bool
+TraceLog::map(const char* filename)
+{
+#if SYSAPI_WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    ULARGE_INTEGER size;
+    size.QuadPart = m_size;
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+                            size.HighPart, size.LowPart, NULL);
+    void* data = NULL;
+    if (mapping != NULL) {
+        data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_size);
+    }
+    if (data == NULL) {
+        if (mapping != NULL) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    m_file    = file;
+    m_mapping = mapping;
+#else
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    void* data = MAP_FAILED;
+    if (ftruncate(fd, (off_t)m_size) == 0) {
+        data = mmap(NULL, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (data == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    m_fd = fd;
+#endif
+
+    // the new file is all zeros
+    m_data   = static_cast<UInt8*>(data);
+    m_mapped = true;
+    return true;
+}
+
+void
+TraceLog::unmap()
+{
+#if SYSAPI_WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(static_cast<HANDLE>(m_mapping));
+    CloseHandle(static_cast<HANDLE>(m_file));
+#else
+    munmap(m_data, m_size);
+    close(m_fd);
+#endif
+    m_data   = NULL;
+    m_mapped = false;
+}
+
+//
+// TraceLog::Encoder
+//
+
+void
+TraceLog::Encoder::add(int value)
+{
+    SInt32 v = value;
+    append(kArgInt, &v, sizeof(v));
+}
+
+void
+TraceLog::Encoder::add(unsigned int value)
+{
+    UInt32 v = value;
+    append(kArgUInt, &v, sizeof(v));
+}
+
+void
+TraceLog::Encoder::add(long value)
+{
+    std::int64_t v = value;
+    append(kArgInt64, &v, sizeof(v));
+}
+
+void
+TraceLog::Encoder::add(unsigned long value)
+{
+    std::uint64_t v = value;
+    append(kArgUInt64, &v, sizeof(v));
+}
+
+void
+TraceLog::Encoder::add(long long value)
+{
+    std::int64_t v = value;
+    append(kArgInt64, &v, sizeof(v));
+}
+
+void
+TraceLog::Encoder::add(unsigned long long value)
+{
+    std::uint64_t v = value;
+    append(kArgUInt64, &v, sizeof(v));
+}
+
+void
+TraceLog::Encoder::add(double value)
+{
+    append(kArgDouble, &value, sizeof(value));
+}
+
+void
+TraceLog::Encoder::add(const char* value)
+{
+    if (value == NULL) {
+        value = "(null)";
+    }
+
+    // the type, the length, then as much of the string as fits
+    const UInt32 overhead = 1 + sizeof(UInt16);
+    if (m_size + overhead > kMaxRecordSize) {
+        m_size = kMaxRecordSize;
+        return;
+    }
+    size_t length = strlen(value);
+    if (length > kMaxRecordSize - m_size - overhead) {
+        length = kMaxRecordSize - m_size - overhead;
+    }
+    UInt16 n = (UInt16)length;
+    m_data[m_size] = kArgString;
+    memcpy(m_data + m_size + 1, &n, sizeof(n));
+    memcpy(m_data + m_size + overhead, value, length);
+    m_size += overhead + n;
+}
+
+void
+TraceLog::Encoder::add(const void* value)
+{
+    std::uint64_t v = reinterpret_cast<std::uintptr_t>(value);
+    append(kArgPointer, &v, sizeof(v));
+}
+
+void
+TraceLog::Encoder::append(char type, const void* value, UInt32 size)
+{
+    // drop the arguments that don't fit
+    if (m_size + 1 + size > kMaxRecordSize) {
+        m_size = kMaxRecordSize;
+        return;
+    }
+    m_data[m_size] = type;
+    memcpy(m_data + m_size + 1, value, size);
+    m_size += 1 + size;
+}
@@ -0,0 +1,309 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/Log.h"
+#include "common/basic_types.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+//! Binary trace log
+/*!
+Records messages from the LOGT() macro without formatting them.  Each
+record holds the time, the call site and the raw arguments, and goes
+into a ring owned by the thread that wrote it, so writing takes no lock
+and older records are overwritten once a ring is full.  The rings are
+kept in a memory mapped file so the records survive the process
+crashing.  barrier-logdump decodes the file into text using the format
+strings, which are stored once per call site.
+
+Only one trace log may exist at a time.  While it exists LOGT() writes
+to it whatever the log filter;  otherwise LOGT() is the same as LOG().
+*/
+class TraceLog {
+public:
+    enum {
+        kDefaultRings = 16,
+        kDefaultRingSize = 1024 * 1024,
+        kFormatTableSize = 256 * 1024,
+        kMaxRecordSize = 512
+    };
+
+    //! Argument types
+    enum EArgType {
+        kArgInt = 'i',
+        kArgUInt = 'u',
+        kArgInt64 = 'I',
+        kArgUInt64 = 'U',
+        kArgDouble = 'd',
+        kArgString = 's',
+        kArgPointer = 'p'
+    };
+
+    //! File header
+    /*!
+    The file is this header, the format table, then \c m_rings rings
+    each a RingHeader followed by \c m_ringSize bytes of records.
+    */
+    struct FileHeader {
+    public:
+        char            m_magic[8];
+        UInt32            m_byteOrder;
+        UInt32            m_rings;
+        UInt32            m_ringSize;
+        UInt32            m_formatTableSize;
+        UInt32            m_formatTableUsed;
+        UInt32            m_formats;
+        std::uint64_t    m_startTime;
+    };
+
+    //! Ring header
+    /*!
+    Records lie between the total bytes ever written to the ring, \c
+    m_head, and the start of the oldest record that hasn't been
+    overwritten, \c m_tail.  A ring whose \c m_thread is zero was never
+    used.
+    */
+    struct RingHeader {
+    public:
+        UInt32            m_thread;
+        UInt32            m_reserved;
+        std::uint64_t    m_head;
+        std::uint64_t    m_tail;
+    };
+
+    //! Record header
+    /*!
+    Followed by the arguments, each a type byte then its value.  Records
+    take a multiple of 8 bytes and never wrap around the end of a ring;
+    a record with format \c kPadding fills the space they leave.  Its
+    \c m_time may not be written.
+    */
+    struct RecordHeader {
+    public:
+        UInt32            m_size;
+        UInt32            m_format;
+        std::uint64_t    m_time;
+    };
+
+    //! Format table entry
+    /*!
+    Followed by the nul terminated file name and format.  Formats are
+    numbered by their position in the table.
+    */
+    struct FormatHeader {
+    public:
+        UInt32            m_size;
+        SInt32            m_level;
+        SInt32            m_line;
+    };
+
+    static const char    kMagic[8];
+    static const UInt32    kByteOrder = 0x01020304;
+    static const UInt32    kPadding = 0xffffffffu;
+    static const UInt32    kNoFormat = 0xffff;
+
+    //! Call site
+    /*!
+    Writes one record for the call site whose registration is kept in
+    \c format.  Used by LOGT().
+    */
+    class Record {
+    public:
+        Record(std::atomic<UInt32>& format) : m_format(format) { }
+
+        template <typename... Args>
+        void            operator()(const char* file, int line,
+                            const char* fmt, Args... args);
+
+    private:
+        std::atomic<UInt32>&    m_format;
+    };
+
+    //! Open trace log
+    /*!
+    Maps \c filename, replacing any existing file, to hold \c rings
+    rings of \c ringSize bytes.  If \c filename is NULL or can't be
+    mapped then the records are only kept in memory.  A thread that
+    writes after all the rings are taken has its records dropped.
+    */
+    TraceLog(const char* filename, UInt32 ringSize = kDefaultRingSize,
+                            UInt32 rings = kDefaultRings);
+    ~TraceLog();
+
+    //! @name manipulators
+    //@{
+
+    //! Register a format
+    /*!
+    Returns the number of the format \c fmt, which may start with a
+    priority as for Log::print(), adding it to the format table if it
+    isn't there.  Returns kNoFormat if the table is full.
+    */
+    UInt32                addFormat(const char* file, int line,
+                            const char* fmt);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the mapped data
+    /*!
+    Returns the file contents, as barrier-logdump would read them.
+    */
+    const void*            getData() const { return m_data; }
+
+    //! Get the size of the mapped data
+    size_t                getSize() const { return m_size; }
+
+    //! Get number of dropped records
+    UInt32                getDropped() const { return m_dropped; }
+
+    //! Check if a trace log exists
+    static bool            isEnabled()
+    {
+        return s_instance.load(std::memory_order_acquire) != NULL;
+    }
+
+    //! Get the trace log
+    /*!
+    Returns the trace log or NULL if there isn't one.
+    */
+    static TraceLog*    getInstance()
+    {
+        return s_instance.load(std::memory_order_acquire);
+    }
+
+    //@}
+
+private:
+    // collects a record's arguments
+    class Encoder {
+    public:
+        Encoder() : m_size(sizeof(RecordHeader)) { }
+
+        void            add(int);
+        void            add(unsigned int);
+        void            add(long);
+        void            add(unsigned long);
+        void            add(long long);
+        void            add(unsigned long long);
+        void            add(double);
+        void            add(const char*);
+        void            add(const void*);
+
+    private:
+        void            append(char type, const void* value, UInt32 size);
+
+    public:
+        UInt8            m_data[kMaxRecordSize];
+        UInt32            m_size;
+    };
+
+    // records are only written if the call site was registered with
+    // this trace log, so a call site keeps the generation it registered
+    // with in the top 16 bits of its format
+    UInt32                getCallSiteFormat(std::atomic<UInt32>& callSite,
+                            const char* file, int line, const char* fmt);
+    void                write(UInt32 format, Encoder& encoder);
+    RingHeader*            getRing();
+    void                reserve(RingHeader* ring, std::uint64_t head,
+                            UInt32 size);
+
+    bool                map(const char* filename);
+    void                unmap();
+
+private:
+    static std::atomic<TraceLog*>    s_instance;
+    static std::atomic<UInt32>    s_generation;
+
+    UInt32                m_generation;
+    UInt32                m_rings;
+    UInt32                m_ringSize;
+    UInt8*                m_data;
+    size_t                m_size;
+    bool                m_mapped;
+#if SYSAPI_WIN32
+    void*                m_file;
+    void*                m_mapping;
+#else
+    int                    m_fd;
+#endif
+
+    std::chrono::steady_clock::time_point    m_start;
+    std::atomic<UInt32>    m_nextRing;
+    std::atomic<UInt32>    m_dropped;
+
+    // registering formats is rare so takes a lock
+    std::mutex            m_formatMutex;
+    std::unordered_map<const char*, UInt32>    m_formatIndex;
+};
+
+template <typename... Args>
+void
+TraceLog::Record::operator()(const char* file, int line,
+                const char* fmt, Args... args)
+{
+    TraceLog* trace = getInstance();
+    if (trace == NULL) {
+        return;
+    }
+
+    UInt32 format = trace->getCallSiteFormat(m_format, file, line, fmt);
+    if (format == kNoFormat) {
+        trace->m_dropped++;
+        return;
+    }
+
+    Encoder encoder;
+    int unused[] = { 0, (encoder.add(args), 0)... };
+    (void)unused;
+    trace->write(format, encoder);
+}
+
+/*!
+\def LOGT(arg)
+Write to the trace log if there is one, otherwise to the log.  This is
+invoked like LOG() and should be used where formatting the message
+would cost more than the work being logged.
+\code
+LOGT((CLOG_DEBUG2 "read %d byte integer: %d", len, value));
+\endcode
+Arguments must be numbers, pointers or C strings.  Strings are copied
+when the record is written and may be truncated.
+*/
+
+#if defined(NOLOGGING)
+#define LOGT(_a1)
+#else
+#define LOGT(_a1) \
+    do { \
+        if (TraceLog::isEnabled()) { \
+            static std::atomic<UInt32> s_traceFormat(0); \
+            (TraceLog::Record(s_traceFormat)) _a1; \
+        } \
+        else { \
+            LOG(_a1); \
+        } \
+    } while (false)
+#endif
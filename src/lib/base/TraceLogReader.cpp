@@ -0,0 +1,400 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/TraceLogReader.h"
+#include "base/String.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// a decoded record argument
+class Arg {
+public:
+    Arg() : m_type(0), m_int(0), m_double(0.0) { }
+
+    std::int64_t        asInt() const
+    {
+        return m_type == TraceLog::kArgDouble ?
+                            (std::int64_t)m_double : m_int;
+    }
+
+    // a negative int is shown as a 32 bit unsigned, as printf would
+    std::uint64_t        asUInt() const
+    {
+        return m_type == TraceLog::kArgInt ?
+                            (UInt32)m_int : (std::uint64_t)asInt();
+    }
+
+    double                asDouble() const
+    {
+        return m_type == TraceLog::kArgDouble ? m_double : (double)m_int;
+    }
+
+public:
+    char                m_type;
+    std::int64_t        m_int;
+    double                m_double;
+    std::string            m_string;
+};
+
+template <typename T>
+bool
+readValue(const UInt8*& data, const UInt8* end, T& value)
+{
+    if ((size_t)(end - data) < sizeof(T)) {
+        return false;
+    }
+    memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return true;
+}
+
+void
+readArgs(const UInt8* data, UInt32 size, std::vector<Arg>& args)
+{
+    const UInt8* end = data + size;
+    while (data < end) {
+        Arg arg;
+        arg.m_type = (char)*data++;
+
+        bool ok;
+        switch (arg.m_type) {
+        case TraceLog::kArgInt: {
+            SInt32 value;
+            ok = readValue(data, end, value);
+            arg.m_int = value;
+            break;
+        }
+
+        case TraceLog::kArgUInt: {
+            UInt32 value;
+            ok = readValue(data, end, value);
+            arg.m_int = value;
+            break;
+        }
+
+        case TraceLog::kArgInt64:
+        case TraceLog::kArgUInt64:
+        case TraceLog::kArgPointer:
+            ok = readValue(data, end, arg.m_int);
+            break;
+
+        case TraceLog::kArgDouble:
+            ok = readValue(data, end, arg.m_double);
+            break;
+
+        case TraceLog::kArgString: {
+            UInt16 length = 0;
+            ok = readValue(data, end, length) &&
+                    (size_t)(end - data) >= length;
+            if (ok) {
+                arg.m_string.assign(reinterpret_cast<const char*>(data),
+                            length);
+                data += length;
+            }
+            break;
+        }
+
+        default:
+            // the zeros padding the record out, or garbage
+            ok = false;
+            break;
+        }
+
+        if (!ok) {
+            break;
+        }
+        args.push_back(arg);
+    }
+}
+
+}
+
+//
+// TraceLogReader
+//
+
+TraceLogReader::TraceLogReader(const void* data, size_t size) :
+    m_data(static_cast<const UInt8*>(data)),
+    m_size(size),
+    m_valid(false)
+{
+    if (m_size < sizeof(m_header)) {
+        return;
+    }
+    memcpy(&m_header, m_data, sizeof(m_header));
+    if (memcmp(m_header.m_magic, TraceLog::kMagic,
+                            sizeof(m_header.m_magic)) != 0 ||
+        m_header.m_byteOrder != TraceLog::kByteOrder ||
+        m_header.m_ringSize < sizeof(TraceLog::RecordHeader) ||
+        m_header.m_formatTableUsed > m_header.m_formatTableSize) {
+        return;
+    }
+
+    // the file must be big enough for all the rings
+    std::uint64_t expected = sizeof(m_header) +
+                (std::uint64_t)m_header.m_formatTableSize +
+                (std::uint64_t)m_header.m_rings *
+                    (sizeof(TraceLog::RingHeader) + m_header.m_ringSize);
+    if (expected > m_size) {
+        return;
+    }
+
+    readFormats();
+    m_valid = true;
+}
+
+void
+TraceLogReader::read(MessageList& messages) const
+{
+    if (!m_valid) {
+        return;
+    }
+
+    size_t first = messages.size();
+    for (UInt32 i = 0; i < m_header.m_rings; ++i) {
+        readRing(i, messages);
+    }
+
+    // each ring is in order but threads interleave
+    std::stable_sort(messages.begin() + first, messages.end(),
+        [](const Message& a, const Message& b) {
+            return a.m_time < b.m_time;
+        });
+}
+
+std::string
+TraceLogReader::format(const char* fmt, const UInt8* data, UInt32 size)
+{
+    std::vector<Arg> args;
+    readArgs(data, size, args);
+
+    std::string result;
+    size_t next = 0;
+    for (const char* scan = fmt; *scan != '\0'; ++scan) {
+        if (*scan != '%') {
+            result += *scan;
+            continue;
+        }
+        if (scan[1] == '%') {
+            result += '%';
+            ++scan;
+            continue;
+        }
+
+        // keep the flags, width and precision.  drop the length since
+        // each argument is passed at its widest.
+        const char* end = scan + 1;
+        std::string spec("%");
+        while (*end != '\0' && strchr("-+ #0", *end) != NULL) {
+            spec += *end++;
+        }
+        for (int part = 0; part < 2; ++part) {
+            if (part == 1) {
+                if (*end != '.') {
+                    break;
+                }
+                spec += *end++;
+            }
+            if (*end == '*') {
+                ++end;
+                if (next < args.size()) {
+                    spec += barrier::string::sprintf("%d",
+                            (int)args[next++].asInt());
+                }
+            }
+            while (*end >= '0' && *end <= '9') {
+                spec += *end++;
+            }
+        }
+        while (*end != '\0' && strchr("hlLqjzt", *end) != NULL) {
+            ++end;
+        }
+        if (*end == '\0') {
+            result.append(scan);
+            break;
+        }
+
+        const char* start = scan;
+        char conversion   = *end;
+        scan = end;
+        if (next == args.size()) {
+            result += "<missing>";
+            continue;
+        }
+        const Arg& arg = args[next++];
+
+        switch (conversion) {
+        case 'd':
+        case 'i':
+            spec += "lld";
+            result += barrier::string::sprintf(spec.c_str(),
+                            (long long)arg.asInt());
+            break;
+
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            spec += "ll";
+            spec += conversion;
+            result += barrier::string::sprintf(spec.c_str(),
+                            (unsigned long long)arg.asUInt());
+            break;
+
+        case 'c':
+            spec += conversion;
+            result += barrier::string::sprintf(spec.c_str(), (int)arg.asInt());
+            break;
+
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            spec += conversion;
+            result += barrier::string::sprintf(spec.c_str(), arg.asDouble());
+            break;
+
+        case 's':
+            spec += conversion;
+            if (arg.m_type == TraceLog::kArgString) {
+                result += barrier::string::sprintf(spec.c_str(),
+                            arg.m_string.c_str());
+            }
+            else {
+                result += barrier::string::sprintf(spec.c_str(), "<not a string>");
+            }
+            break;
+
+        case 'p':
+            result += barrier::string::sprintf("0x%llx",
+                            (unsigned long long)arg.asUInt());
+            break;
+
+        default:
+            // unknown conversion, show it as written
+            result.append(start, end + 1);
+            break;
+        }
+    }
+    return result;
+}
+
+void
+TraceLogReader::readFormats()
+{
+    const UInt8* table = m_data + sizeof(m_header);
+    const UInt8* end   = table + m_header.m_formatTableUsed;
+    for (UInt32 i = 0; i < m_header.m_formats; ++i) {
+        TraceLog::FormatHeader header;
+        if ((size_t)(end - table) < sizeof(header)) {
+            break;
+        }
+        memcpy(&header, table, sizeof(header));
+        if (header.m_size < sizeof(header) ||
+            header.m_size > (size_t)(end - table) ||
+            header.m_level < kPRINT || header.m_level > kDEBUG5) {
+            break;
+        }
+
+        // both strings must be terminated within the entry
+        const char* file   = reinterpret_cast<const char*>(table) +
+                                sizeof(header);
+        const char* last   = reinterpret_cast<const char*>(table) +
+                                header.m_size;
+        const char* fileEnd = std::find(file, last, '\0');
+        const char* fmtEnd  = fileEnd == last ? last :
+                                std::find(fileEnd + 1, last, '\0');
+        if (fmtEnd == last) {
+            break;
+        }
+
+        Format format;
+        format.m_level  = header.m_level;
+        format.m_line   = header.m_line;
+        format.m_file   = file;
+        format.m_format = fileEnd + 1;
+        m_formats.push_back(format);
+        table += header.m_size;
+    }
+}
+
+void
+TraceLogReader::readRing(UInt32 index, MessageList& messages) const
+{
+    const UInt32 ringSize = m_header.m_ringSize;
+    const UInt8* ringStart = m_data + sizeof(m_header) +
+                m_header.m_formatTableSize +
+                (size_t)index * (sizeof(TraceLog::RingHeader) + ringSize);
+
+    TraceLog::RingHeader ring;
+    memcpy(&ring, ringStart, sizeof(ring));
+    if (ring.m_thread == 0 || ring.m_head < ring.m_tail ||
+        ring.m_head - ring.m_tail > ringSize) {
+        return;
+    }
+
+    const UInt8* data = ringStart + sizeof(ring);
+    for (std::uint64_t position = ring.m_tail; position < ring.m_head; ) {
+        UInt32 offset = (UInt32)(position % ringSize);
+        TraceLog::RecordHeader header;
+        if (ringSize - offset < 2 * sizeof(UInt32)) {
+            break;
+        }
+        memcpy(&header, data + offset, 2 * sizeof(UInt32));
+        if (header.m_size < 2 * sizeof(UInt32) || header.m_size % 8 != 0 ||
+            header.m_size > ringSize - offset ||
+            header.m_size > ring.m_head - position) {
+            // the ring is damaged from here on
+            break;
+        }
+        position += header.m_size;
+        if (header.m_format == TraceLog::kPadding) {
+            continue;
+        }
+        if (header.m_size < sizeof(header)) {
+            break;
+        }
+        memcpy(&header, data + offset, sizeof(header));
+
+        Message message;
+        message.m_time   = m_header.m_startTime + header.m_time;
+        message.m_thread = ring.m_thread;
+        const UInt8* args = data + offset + sizeof(header);
+        UInt32 argsSize   = header.m_size - sizeof(header);
+        if (header.m_format < m_formats.size()) {
+            const Format& format = m_formats[header.m_format];
+            message.m_level = format.m_level;
+            message.m_file  = format.m_file;
+            message.m_line  = format.m_line;
+            message.m_text  = this->format(format.m_format, args, argsSize);
+        }
+        else {
+            message.m_level = kPRINT;
+            message.m_line  = 0;
+            message.m_text  = barrier::string::sprintf(
+                            "<unknown format %u>", header.m_format);
+        }
+        messages.push_back(message);
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/TraceLog.h"
+#include "common/stdvector.h"
+
+#include <cstdint>
+#include <string>
+
+//! Trace log decoder
+/*!
+Decodes the records in a file written by TraceLog.  The file may have
+been left by a process that crashed, so the reader checks everything
+and skips what it can't make sense of.
+*/
+class TraceLogReader {
+public:
+    //! Decoded record
+    class Message {
+    public:
+        std::uint64_t    m_time;        //!< Microseconds since the epoch
+        UInt32            m_thread;    //!< Ring the record was in, from 1
+        int                m_level;
+        std::string        m_file;
+        int                m_line;
+        std::string        m_text;
+    };
+
+    typedef std::vector<Message> MessageList;
+
+    /*!
+    Reads the file contents in \c data, which must stay valid while the
+    reader is used.
+    */
+    TraceLogReader(const void* data, size_t size);
+
+    //! @name accessors
+    //@{
+
+    //! Check the file
+    /*!
+    Returns true if the data is a trace log written on a machine with
+    the same byte order.
+    */
+    bool                isValid() const { return m_valid; }
+
+    //! Decode the records
+    /*!
+    Appends the records of all rings to \c messages, oldest first.
+    */
+    void                read(MessageList& messages) const;
+
+    //! Format a record
+    /*!
+    Returns \c fmt formatted with the record arguments in \c args.
+    Arguments that don't suit their conversion are converted, and
+    conversions without an argument print <missing>.
+    */
+    static std::string    format(const char* fmt, const UInt8* args,
+                            UInt32 size);
+
+    //@}
+
+private:
+    class Format {
+    public:
+        int                m_level;
+        int                m_line;
+        const char*        m_file;
+        const char*        m_format;
+    };
+
+    void                readFormats();
+    void                readRing(UInt32 index, MessageList& messages) const;
+
+private:
+    const UInt8*        m_data;
+    size_t                m_size;
+    bool                m_valid;
+    TraceLog::FileHeader    m_header;
+    std::vector<Format>    m_formats;
+};
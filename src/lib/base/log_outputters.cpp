@@ -21,10 +21,24 @@
 #include "arch/Arch.h"
 #include "base/String.h"
 
-#include <fstream>
+#include <algorithm>
+#include <cerrno>
+#include <new>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#if SYSAPI_WIN32
+#    include <io.h>
+#else
+#    include <pthread.h>
+#    include <sys/uio.h>
+#    include <unistd.h>
+#endif
 
 enum EFileLogOutputter {
-    kFileSizeLimit = 1024 // kb
+    kFileBufferSize = 1024 // kb
 };
 
 //
@@ -238,47 +252,418 @@ BufferedLogOutputter::write(ELevel, const char* message)
 // FileLogOutputter
 //
 
-FileLogOutputter::FileLogOutputter(const char* logFile)
-{
+const UInt32            FileLogOutputter::kDefaultMaxSize   = 1024 * 1024;
+const UInt32            FileLogOutputter::kDefaultKeepFiles = 1;
+
+#if !SYSAPI_WIN32
+// outputters to prepare for a fork.  never destroyed so the fork
+// handlers can run during exit.
+static std::mutex*                        s_forkMutex = new std::mutex;
+static std::vector<FileLogOutputter*>*    s_forkOutputters =
+                                            new std::vector<FileLogOutputter*>;
+static std::once_flag                    s_forkHandlersInstalled;
+#endif
+
+FileLogOutputter::FileLogOutputter(const char* logFile) :
+    m_maxFileSize(kDefaultMaxSize),
+    m_keepFiles(kDefaultKeepFiles),
+    m_syncInterval(-1.0),
+    m_reopen(false),
+    m_stop(false),
+    m_buffer(kFileBufferSize * 1024),
+    m_start(0),
+    m_used(0),
+    m_writing(false),
+    m_dropped(0),
+    m_totalDropped(0),
+    m_fd(-1),
+    m_fileSize(0)
+{
+#if !SYSAPI_WIN32
+    std::call_once(s_forkHandlersInstalled, [] {
+        pthread_atfork(&FileLogOutputter::prepareFork,
+                       &FileLogOutputter::parentForked,
+                       &FileLogOutputter::childForked);
+    });
+    {
+        std::lock_guard<std::mutex> lock(*s_forkMutex);
+        s_forkOutputters->push_back(this);
+    }
+#endif
+
     setLogFilename(logFile);
 }
 
 FileLogOutputter::~FileLogOutputter()
 {
+#if !SYSAPI_WIN32
+    {
+        std::lock_guard<std::mutex> lock(*s_forkMutex);
+        s_forkOutputters->erase(std::remove(s_forkOutputters->begin(),
+                                    s_forkOutputters->end(), this),
+                                s_forkOutputters->end());
+    }
+#endif
+
+    // the writer thread writes whatever is left before it exits
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        startWriter();
+        m_changed.notify_all();
+    }
+    m_thread.join();
 }
 
 void
 FileLogOutputter::setLogFilename(const char* logFile)
 {
     assert(logFile != NULL);
+
+    // messages already written belong in the old file
+    flush();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_fileName = logFile;
+    m_reopen   = true;
+    startWriter();
+    m_changed.notify_all();
+}
+
+void
+FileLogOutputter::setRotation(UInt32 maxSize, UInt32 keepFiles)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxFileSize = maxSize;
+    m_keepFiles   = keepFiles;
+}
+
+void
+FileLogOutputter::setSyncInterval(double interval)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_syncInterval = interval;
+}
+
+void
+FileLogOutputter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_used > 0 || m_reopen) {
+        startWriter();
+    }
+    while ((m_used > 0 || m_writing || m_reopen) && !m_stop) {
+        m_changed.wait(lock);
+    }
+}
+
+UInt32
+FileLogOutputter::getDropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totalDropped;
 }
 
 bool
-FileLogOutputter::write(ELevel level, const char *message)
+FileLogOutputter::write(ELevel, const char* message)
+{
+    const size_t length = strlen(message);
+    const size_t size   = m_buffer.size();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool wasEmpty = (m_used == 0 && m_dropped == 0);
+    if (m_stop || m_used + length + 1 > size) {
+        // never wait for the disk.  drop the message and let the writer
+        // note that it did.
+        ++m_dropped;
+        ++m_totalDropped;
+    }
+    else {
+        // append the message and a newline, wrapping around the end
+        size_t end   = (m_start + m_used) % size;
+        size_t first = std::min(length, size - end);
+        memcpy(&m_buffer[end], message, first);
+        memcpy(&m_buffer[0], message + first, length - first);
+        m_buffer[(end + length) % size] = '\n';
+        m_used += length + 1;
+    }
+    startWriter();
+    if (wasEmpty) {
+        m_changed.notify_all();
+    }
+    return true;
+}
+
+void
+FileLogOutputter::startWriter()
+{
+    // call with m_mutex locked.  there's no writer yet in a new
+    // outputter or in a forked child.
+    if (!m_thread.joinable()) {
+        m_thread = std::thread(&FileLogOutputter::writerThread, this);
+    }
+}
+
+void
+FileLogOutputter::prepareFork()
+{
+#if !SYSAPI_WIN32
+    // hold every outputter's lock across the fork with everything
+    // written, so both processes start with consistent, empty buffers
+    s_forkMutex->lock();
+    for (FileLogOutputter* outputter : *s_forkOutputters) {
+        std::unique_lock<std::mutex> lock(outputter->m_mutex);
+        while (outputter->m_writing || outputter->m_reopen ||
+                (outputter->m_used > 0 && outputter->m_thread.joinable())) {
+            outputter->m_changed.wait(lock);
+        }
+        lock.release();
+    }
+#endif
+}
+
+void
+FileLogOutputter::parentForked()
+{
+#if !SYSAPI_WIN32
+    for (FileLogOutputter* outputter : *s_forkOutputters) {
+        outputter->m_mutex.unlock();
+    }
+    s_forkMutex->unlock();
+#endif
+}
+
+void
+FileLogOutputter::childForked()
+{
+#if !SYSAPI_WIN32
+    // the writer thread wasn't copied.  its thread, lock and condition
+    // objects refer to it so they're replaced rather than destroyed.
+    for (FileLogOutputter* outputter : *s_forkOutputters) {
+        new (&outputter->m_thread) std::thread;
+        new (&outputter->m_changed) std::condition_variable;
+        new (&outputter->m_mutex) std::mutex;
+    }
+    new (s_forkMutex) std::mutex;
+#endif
+}
+
+void
+FileLogOutputter::writerThread()
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    std::string fileName = m_fileName;
+    bool unsynced = false;
+    Clock::time_point syncTime;
+
+    for (;;) {
+        // wait for messages, a new file or time to sync
+        bool syncDue = false;
+        while (m_used == 0 && m_dropped == 0 && !m_reopen && !m_stop) {
+            if (!unsynced) {
+                m_changed.wait(lock);
+            }
+            else if (m_changed.wait_until(lock, syncTime) ==
+                        std::cv_status::timeout) {
+                syncDue = true;
+                break;
+            }
+        }
+
+        if (m_reopen) {
+            m_reopen  = false;
+            m_writing = true;
+            fileName  = m_fileName;
+            lock.unlock();
+            closeFile();
+            openFile(fileName);
+            unsynced = false;
+            lock.lock();
+            m_writing = false;
+            m_changed.notify_all();
+            continue;
+        }
+        if (syncDue) {
+            m_writing = true;
+            lock.unlock();
+            syncFile();
+            unsynced = false;
+            lock.lock();
+            m_writing = false;
+            m_changed.notify_all();
+            continue;
+        }
+        if (m_used == 0 && m_dropped == 0) {
+            break;
+        }
+
+        // take the waiting messages.  writers only append after them so
+        // they can be read without the lock.
+        const size_t start       = m_start;
+        const size_t used        = m_used;
+        const UInt32 dropped     = m_dropped;
+        const UInt32 maxFileSize = m_maxFileSize;
+        const UInt32 keepFiles   = m_keepFiles;
+        const double interval    = m_syncInterval;
+        m_dropped = 0;
+        m_writing = true;
+        lock.unlock();
+
+        const size_t first = std::min(used, m_buffer.size() - start);
+        writeFile(&m_buffer[start], first, &m_buffer[0], used - first);
+        if (dropped > 0) {
+            std::string note = barrier::string::sprintf(
+                "%u log messages dropped\n", dropped);
+            writeFile(note.data(), note.size(), NULL, 0);
+        }
+
+        if (interval >= 0.0) {
+            Clock::time_point now = Clock::now();
+            if (!unsynced) {
+                unsynced = true;
+                syncTime = now + std::chrono::duration_cast<Clock::duration>(
+                                    std::chrono::duration<double>(interval));
+            }
+            if (now >= syncTime) {
+                syncFile();
+                unsynced = false;
+            }
+        }
+        if (m_fileSize > maxFileSize) {
+            if (unsynced) {
+                syncFile();
+                unsynced = false;
+            }
+            rotateFile(fileName, keepFiles);
+        }
+
+        lock.lock();
+        m_start   = (start + used) % m_buffer.size();
+        m_used   -= used;
+        m_writing = false;
+        m_changed.notify_all();
+    }
+
+    lock.unlock();
+    if (unsynced) {
+        syncFile();
+    }
+    closeFile();
+}
+
+void
+FileLogOutputter::openFile(const std::string& fileName)
 {
-    bool moveFile = false;
+#if SYSAPI_WIN32
+    m_fd = _open(fileName.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY,
+                            _S_IREAD | _S_IWRITE);
+    m_fileSize = (m_fd != -1) ? static_cast<size_t>(_filelength(m_fd)) : 0;
+#else
+    m_fd = ::open(fileName.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC,
+                            0644);
+    struct stat info;
+    m_fileSize = (m_fd != -1 && fstat(m_fd, &info) == 0) ?
+                            static_cast<size_t>(info.st_size) : 0;
+#endif
+}
 
-    std::ofstream m_handle;
-    m_handle.open(m_fileName.c_str(), std::fstream::app);
-    if (m_handle.is_open() && m_handle.fail() != true) {
-        m_handle << message << std::endl;
+void
+FileLogOutputter::closeFile()
+{
+    if (m_fd != -1) {
+#if SYSAPI_WIN32
+        _close(m_fd);
+#else
+        ::close(m_fd);
+#endif
+        m_fd = -1;
+    }
+}
+
+void
+FileLogOutputter::rotateFile(const std::string& fileName, UInt32 keepFiles)
+{
+    closeFile();
 
-        // when file size exceeds limits, move to 'old log' filename.
-        size_t p = m_handle.tellp();
-        if (p > (kFileSizeLimit * 1024)) {
-            moveFile = true;
+    // shift the old files along, losing the oldest
+    if (keepFiles == 0) {
+        remove(fileName.c_str());
+    }
+    else {
+        std::string oldest = barrier::string::sprintf("%s.%u",
+                                fileName.c_str(), keepFiles);
+        remove(oldest.c_str());
+        for (UInt32 i = keepFiles - 1; i > 0; --i) {
+            std::string from = barrier::string::sprintf("%s.%u",
+                                    fileName.c_str(), i);
+            std::string to   = barrier::string::sprintf("%s.%u",
+                                    fileName.c_str(), i + 1);
+            rename(from.c_str(), to.c_str());
         }
+        std::string newest = barrier::string::sprintf("%s.1",
+                                fileName.c_str());
+        rename(fileName.c_str(), newest.c_str());
     }
-    m_handle.close();
 
-    if (moveFile) {
-        std::string oldLogFilename = barrier::string::sprintf("%s.1", m_fileName.c_str());
-        remove(oldLogFilename.c_str());
-        rename(m_fileName.c_str(), oldLogFilename.c_str());
+    openFile(fileName);
+}
+
+void
+FileLogOutputter::writeFile(const char* data1, size_t size1,
+                const char* data2, size_t size2)
+{
+    if (m_fd == -1) {
+        return;
     }
+    m_fileSize += size1 + size2;
 
-    return true;
+#if SYSAPI_WIN32
+    _write(m_fd, data1, static_cast<unsigned int>(size1));
+    if (size2 > 0) {
+        _write(m_fd, data2, static_cast<unsigned int>(size2));
+    }
+#else
+    // one system call for both parts, finishing any short write
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<char*>(data1);
+    iov[0].iov_len  = size1;
+    iov[1].iov_base = const_cast<char*>(data2);
+    iov[1].iov_len  = size2;
+    struct iovec* next = iov;
+    int count = (size2 > 0) ? 2 : 1;
+    while (count > 0) {
+        ssize_t n = writev(m_fd, next, count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        while (count > 0 && static_cast<size_t>(n) >= next->iov_len) {
+            n -= next->iov_len;
+            ++next;
+            --count;
+        }
+        if (count > 0) {
+            next->iov_base = static_cast<char*>(next->iov_base) + n;
+            next->iov_len -= n;
+        }
+    }
+#endif
+}
+
+void
+FileLogOutputter::syncFile()
+{
+    if (m_fd != -1) {
+#if SYSAPI_WIN32
+        _commit(m_fd);
+#else
+        fsync(m_fd);
+#endif
+    }
 }
 
 void
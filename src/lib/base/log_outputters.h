@@ -23,9 +23,13 @@
 #include "common/basic_types.h"
 #include "common/stddeque.h"
 
+#include <condition_variable>
 #include <list>
 #include <fstream>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 //! Stop traversing log chain outputter
 /*!
@@ -66,11 +70,24 @@ public:
 //! Write log to file
 /*!
 This outputter writes output to the file.  The level for each
-message is ignored.
+message is ignored.  Messages are copied into a fixed size buffer and
+a background thread appends them to the file, which it keeps open, so
+writing a message never waits for the disk.  If the buffer is full the
+message is dropped and the file later notes how many were dropped.
+The file is rotated when it grows past a size limit.
+
+The writer thread isn't copied when the process forks.  The child
+starts its own on the next write, so the outputter can be used on
+either side of a fork, such as when daemonizing.
 */
-
 class FileLogOutputter : public ILogOutputter {
 public:
+    //! Default size in bytes the file is rotated at
+    static const UInt32    kDefaultMaxSize;
+
+    //! Default number of old files kept
+    static const UInt32    kDefaultKeepFiles;
+
     FileLogOutputter(const char* logFile);
     virtual ~FileLogOutputter();
 
@@ -82,8 +99,74 @@ public:
 
     void                setLogFilename(const char* title);
 
+    //! Set rotation
+    /*!
+    Rotates the file when it grows past \c maxSize bytes, keeping up
+    to \c keepFiles old files named with the suffixes .1 (newest) to
+    .N.  With no old files the log simply starts over.
+    */
+    void                setRotation(UInt32 maxSize, UInt32 keepFiles);
+
+    //! Set sync interval
+    /*!
+    Flushes written messages to the disk at most \c interval seconds
+    after writing them.  A negative interval, the default, leaves that
+    to the operating system.
+    */
+    void                setSyncInterval(double interval);
+
+    //! Write buffered messages
+    /*!
+    Waits until every message written so far is in the file.
+    */
+    void                flush();
+
+    //! Get number of dropped messages
+    UInt32                getDropped() const;
+
+private:
+    void                startWriter();
+    void                writerThread();
+    void                openFile(const std::string& fileName);
+    void                closeFile();
+    void                rotateFile(const std::string& fileName,
+                            UInt32 keepFiles);
+    void                writeFile(const char* data1, size_t size1,
+                            const char* data2, size_t size2);
+    void                syncFile();
+
+    // fork handlers for every outputter
+    static void            prepareFork();
+    static void            parentForked();
+    static void            childForked();
+
 private:
+    mutable std::mutex    m_mutex;
+    std::condition_variable    m_changed;
+
+    // settings, shared with the writer thread
     std::string            m_fileName;
+    UInt32                m_maxFileSize;
+    UInt32                m_keepFiles;
+    double                m_syncInterval;
+    bool                m_reopen;
+    bool                m_stop;
+
+    // messages waiting to be written.  they wrap around the end of
+    // m_buffer.  the writer thread reads them without the lock, so
+    // they're only removed after they're written.
+    std::vector<char>    m_buffer;
+    size_t                m_start;
+    size_t                m_used;
+    bool                m_writing;
+    UInt32                m_dropped;
+    UInt32                m_totalDropped;
+
+    // the file, used only by the writer thread
+    int                    m_fd;
+    size_t                m_fileSize;
+
+    std::thread            m_thread;
 };
 
 //! Write log to system log
@@ -257,10 +257,10 @@ Client::leave()
     m_screen->leave();
 
     if (m_enableClipboard) {
-        // send clipboards that we own and that have changed
+        // offer clipboards that we own and that have changed
         for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
             if (m_ownClipboard[id]) {
-                sendClipboard(id);
+                offerClipboard(id);
             }
         }
     }
@@ -377,10 +377,52 @@ Client::getName() const
     return m_name;
 }
 
+bool
+Client::promiseClipboard(ClipboardID id, UInt32 formats)
+{
+    if (!m_screen->promiseClipboard(id, formats)) {
+        return false;
+    }
+    m_ownClipboard[id]  = false;
+    m_sentClipboard[id] = false;
+    return true;
+}
+
+void
+Client::fulfilClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+    m_screen->fulfilClipboard(id, clipboard);
+}
+
+void
+Client::offerClipboard(ClipboardID id)
+{
+    assert(m_screen != NULL);
+    assert(m_server != NULL);
+
+    // get the formats but not the data.  the server asks for the data
+    // when something on another screen wants it.  if the screen has to
+    // get the data to list the formats then send the data instead.
+    UInt32 formats;
+    IClipboard::Time time;
+    if (!m_screen->getClipboardFormats(id, formats, time)) {
+        sendClipboard(id);
+        return;
+    }
+
+    // offer if changed or not yet offered
+    if (m_sentClipboard[id] && time != 0 && time == m_timeClipboard[id]) {
+        return;
+    }
+    m_sentClipboard[id] = true;
+    m_timeClipboard[id] = time;
+    m_dataClipboard[id].clear();
+    m_server->onClipboardOffered(id, formats);
+}
+
 void
 Client::sendClipboard(ClipboardID id)
 {
-    // note -- m_mutex must be locked on entry
     assert(m_screen != NULL);
     assert(m_server != NULL);
 
@@ -407,7 +449,7 @@ Client::sendClipboard(ClipboardID id)
         if (!m_sentClipboard[id] || data != m_dataClipboard[id]) {
             m_sentClipboard[id] = true;
             m_dataClipboard[id] = data;
-            m_server->onClipboardChanged(id, &clipboard);
+            m_server->onClipboardChanged(id, clipboard);
         }
     }
 }
@@ -508,6 +550,10 @@ Client::setupScreen()
                             getEventTarget(),
                             new TMethodEventJob<Client>(this,
                                 &Client::handleClipboardGrabbed));
+    m_events->adoptHandler(m_events->forClipboard().clipboardRequested(),
+                            getEventTarget(),
+                            new TMethodEventJob<Client>(this,
+                                &Client::handleClipboardRequested));
 }
 
 void
@@ -564,6 +610,8 @@ Client::cleanupScreen()
                             getEventTarget());
         m_events->removeHandler(m_events->forClipboard().clipboardGrabbed(),
                             getEventTarget());
+        m_events->removeHandler(m_events->forClipboard().clipboardRequested(),
+                            getEventTarget());
         delete m_server;
         m_server = NULL;
     }
@@ -671,13 +719,23 @@ Client::handleClipboardGrabbed(const Event& event, void*)
     m_sentClipboard[info->m_id] = false;
     m_timeClipboard[info->m_id] = 0;
 
-    // if we're not the active screen then send the clipboard now,
+    // if we're not the active screen then offer the clipboard now,
     // otherwise we'll wait until we leave.
     if (!m_active) {
-        sendClipboard(info->m_id);
+        offerClipboard(info->m_id);
     }
 }
 
+void
+Client::handleClipboardRequested(const Event& event, void*)
+{
+    const IScreen::ClipboardRequestInfo* info =
+        static_cast<const IScreen::ClipboardRequestInfo*>(event.getData());
+
+    // ask the server for the promised data
+    m_server->onClipboardRequested(info->m_id, info->m_formats);
+}
+
 void
 Client::handleHello(const Event&, void*)
 {
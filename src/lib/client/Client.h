@@ -24,6 +24,7 @@
 #include "barrier/DragInformation.h"
 #include "barrier/INode.h"
 #include "barrier/ClientArgs.h"
+#include "barrier/LatencyTrace.h"
 #include "net/NetworkAddress.h"
 #include "base/EventTypes.h"
 #include "mt/CondVar.h"
@@ -94,6 +95,21 @@ public:
     //! Send dragging file information back to server
     void sendDragInfo(UInt32 fileCount, std::string& info, size_t size);
 
+    //! Promise clipboard
+    /*!
+    Takes ownership of the screen's clipboard with the \c formats the
+    server offered but not their data.  Returns false if the screen
+    can't do that, in which case the data must be given with
+    setClipboard().
+    */
+    bool                promiseClipboard(ClipboardID, UInt32 formats);
+
+    //! Fulfil clipboard promise
+    /*!
+    Gives the screen's promised clipboard the data it asked for.
+    */
+    void                fulfilClipboard(ClipboardID, const IClipboard*);
+
 
     //@}
     //! @name accessors
@@ -131,6 +147,13 @@ public:
     //! Return drag file list
     DragFileList        getDragFileList() { return m_dragFileList; }
 
+    //! Return input latency histograms
+    /*!
+    Traces are only recorded when the server enables the latencyTracing
+    option.
+    */
+    LatencyTrace&        getLatencyTrace() { return m_latencyTrace; }
+
     //@}
 
     // IScreen overrides
@@ -163,6 +186,7 @@ public:
     virtual std::string getName() const;
 
 private:
+    void                offerClipboard(ClipboardID);
     void                sendClipboard(ClipboardID);
     void                sendEvent(Event::Type, void*);
     void                sendConnectionFailedEvent(const char* msg);
@@ -185,6 +209,7 @@ private:
     void                handleDisconnected(const Event&, void*);
     void                handleShapeChanged(const Event&, void*);
     void                handleClipboardGrabbed(const Event&, void*);
+    void                handleClipboardRequested(const Event&, void*);
     void                handleHello(const Event&, void*);
     void                handleSuspend(const Event& event, void*);
     void                handleResume(const Event& event, void*);
@@ -224,4 +249,5 @@ private:
     bool                m_useSecureNetwork;
     ClientArgs            m_args;
     bool                m_enableClipboard;
+    LatencyTrace        m_latencyTrace;
 };
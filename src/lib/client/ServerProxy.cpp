@@ -21,8 +21,10 @@
 #include "client/Client.h"
 #include "barrier/FileChunk.h"
 #include "barrier/ClipboardChunk.h"
-#include "barrier/StreamChunker.h"
 #include "barrier/Clipboard.h"
+#include "barrier/LatencyTrace.h"
+#include "barrier/MessageTable.h"
+#include "barrier/ProtocolMessage.h"
 #include "barrier/ProtocolUtil.h"
 #include "barrier/option_types.h"
 #include "barrier/protocol_types.h"
@@ -32,8 +34,12 @@
 #include "base/TMethodEventJob.h"
 #include "base/XBase.h"
 
+#include <algorithm>
 #include <memory>
 
+// log the latency histograms after this many traces
+static const UInt32        kLatencyReportInterval = 1000;
+
 //
 // ServerProxy
 //
@@ -49,6 +55,13 @@ ServerProxy::ServerProxy(Client* client, barrier::IStream* stream, IEventQueue*
     m_dxMouse(0),
     m_dyMouse(0),
     m_ignoreMouse(false),
+    m_clipboardStreamer(stream),
+    m_compression(true),
+    m_traced(false),
+    m_traceSequence(0),
+    m_traceStart(0),
+    m_traceWritten(0),
+    m_traceRead(0),
     m_keepAliveAlarm(0.0),
     m_keepAliveAlarmTimer(NULL),
     m_parser(&ServerProxy::parseHandshakeMessage),
@@ -57,6 +70,10 @@ ServerProxy::ServerProxy(Client* client, barrier::IStream* stream, IEventQueue*
     assert(m_client != NULL);
     assert(m_stream != NULL);
 
+    // the server has the same protocol version or newer so it can
+    // decompress what we send
+    m_clipboardStreamer.setCompression(true);
+
     // initialize modifier translation table
     for (KeyModifierID id = 0; id < kKeyModifierIDLast; ++id)
         m_modifierTranslationTable[id] = id;
@@ -67,10 +84,13 @@ ServerProxy::ServerProxy(Client* client, barrier::IStream* stream, IEventQueue*
                             new TMethodEventJob<ServerProxy>(this,
                                 &ServerProxy::handleData));
 
-    m_events->adoptHandler(m_events->forClipboard().clipboardSending(),
-                            this,
+    // send more of a clipboard as the server takes it
+    m_events->adoptHandler(m_events->forIStream().outputFlushed(),
+                            m_stream->getEventTarget(),
                             new TMethodEventJob<ServerProxy>(this,
-                                &ServerProxy::handleClipboardSendingEvent));
+                                &ServerProxy::handleOutputFlushed));
+
+    addMessageHandlers();
 
     // send heartbeat
     setKeepAliveRate(kKeepAliveRate);
@@ -78,10 +98,17 @@ ServerProxy::ServerProxy(Client* client, barrier::IStream* stream, IEventQueue*
 
 ServerProxy::~ServerProxy()
 {
+    // report latency traces not yet reported
+    const LatencyTrace& trace = m_client->getLatencyTrace();
+    if (trace.getCount(LatencyTrace::kTotal) % kLatencyReportInterval != 0) {
+        trace.report();
+    }
+
     setKeepAliveRate(-1.0);
     m_events->removeHandler(m_events->forIStream().inputReady(),
                             m_stream->getEventTarget());
-    m_events->removeHandler(m_events->forClipboard().clipboardSending(), this);
+    m_events->removeHandler(m_events->forIStream().outputFlushed(),
+                            m_stream->getEventTarget());
 }
 
 void
@@ -144,180 +171,94 @@ ServerProxy::handleData(const Event&, void*)
     flushCompressedMouse();
 }
 
+// adapts a message handler that can't fail
+template <void (ServerProxy::*handler)()>
 ServerProxy::EResult
-ServerProxy::parseHandshakeMessage(const UInt8* code)
+ServerProxy::okay()
 {
-    if (memcmp(code, kMsgQInfo, 4) == 0) {
-        queryInfo();
-    }
-
-    else if (memcmp(code, kMsgCInfoAck, 4) == 0) {
-        infoAcknowledgment();
-    }
-
-    else if (memcmp(code, kMsgDSetOptions, 4) == 0) {
-        setOptions();
-
-        // handshake is complete
-        m_parser = &ServerProxy::parseMessage;
-        m_client->handshakeComplete();
-    }
-
-    else if (memcmp(code, kMsgCResetOptions, 4) == 0) {
-        resetOptions();
-    }
-
-    else if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
-        // echo keep alives and reset alarm
-        ProtocolUtil::writef(m_stream, kMsgCKeepAlive);
-        resetKeepAliveAlarm();
-    }
-
-    else if (memcmp(code, kMsgCNoop, 4) == 0) {
-        // accept and discard no-op
-    }
-
-    else if (memcmp(code, kMsgCClose, 4) == 0) {
-        // server wants us to hangup
-        LOG((CLOG_DEBUG1 "recv close"));
-        m_client->disconnect(NULL);
-        return kDisconnect;
-    }
-
-    else if (memcmp(code, kMsgEIncompatible, 4) == 0) {
-        SInt32 major, minor;
-        ProtocolUtil::readf(m_stream,
-                        kMsgEIncompatible + 4, &major, &minor);
-        LOG((CLOG_ERR "server has incompatible version %d.%d", major, minor));
-        m_client->disconnect("server has incompatible version");
-        return kDisconnect;
-    }
-
-    else if (memcmp(code, kMsgEBusy, 4) == 0) {
-        LOG((CLOG_ERR "server already has a connected client with name \"%s\"", m_client->getName().c_str()));
-        m_client->disconnect("server already has a connected client with our name");
-        return kDisconnect;
-    }
+    (this->*handler)();
+    return kOkay;
+}
 
-    else if (memcmp(code, kMsgEUnknown, 4) == 0) {
-        LOG((CLOG_ERR "server refused client with name \"%s\"", m_client->getName().c_str()));
-        m_client->disconnect("server refused client with our name");
-        return kDisconnect;
-    }
+void
+ServerProxy::addMessageHandlers()
+{
+    // messages during the handshake
+    m_handshakeMessages.add(kMsgQInfo,         &ServerProxy::okay<&ServerProxy::queryInfo>);
+    m_handshakeMessages.add(kMsgCInfoAck,      &ServerProxy::okay<&ServerProxy::infoAcknowledgment>);
+    m_handshakeMessages.add(kMsgDSetOptions,   &ServerProxy::handshakeComplete);
+    m_handshakeMessages.add(kMsgCResetOptions, &ServerProxy::okay<&ServerProxy::resetOptions>);
+    m_handshakeMessages.add(kMsgCKeepAlive,    &ServerProxy::okay<&ServerProxy::keepAlive>);
+    m_handshakeMessages.add(kMsgCNoop,         &ServerProxy::okay<&ServerProxy::noop>);
+    m_handshakeMessages.add(kMsgCClose,        &ServerProxy::close);
+    m_handshakeMessages.add(kMsgEIncompatible, &ServerProxy::incompatible);
+    m_handshakeMessages.add(kMsgEBusy,         &ServerProxy::busy);
+    m_handshakeMessages.add(kMsgEUnknown,      &ServerProxy::unknownClient);
+    m_handshakeMessages.add(kMsgEBad,          &ServerProxy::protocolError);
+
+    // messages after the handshake
+    m_messages.add(kMsgDMouseMove,    &ServerProxy::okay<&ServerProxy::mouseMove>);
+    m_messages.add(kMsgDMouseRelMove, &ServerProxy::okay<&ServerProxy::mouseRelativeMove>);
+    m_messages.add(kMsgDMouseWheel,   &ServerProxy::okay<&ServerProxy::mouseWheel>);
+    m_messages.add(kMsgDKeyDown,      &ServerProxy::okay<&ServerProxy::keyDown>);
+    m_messages.add(kMsgDKeyUp,        &ServerProxy::okay<&ServerProxy::keyUp>);
+    m_messages.add(kMsgDMouseDown,    &ServerProxy::okay<&ServerProxy::mouseDown>);
+    m_messages.add(kMsgDMouseUp,      &ServerProxy::okay<&ServerProxy::mouseUp>);
+    m_messages.add(kMsgDKeyRepeat,    &ServerProxy::okay<&ServerProxy::keyRepeat>);
+    m_messages.add(kMsgCKeepAlive,    &ServerProxy::okay<&ServerProxy::keepAlive>);
+    m_messages.add(kMsgCNoop,         &ServerProxy::okay<&ServerProxy::noop>);
+    m_messages.add(kMsgCEnter,        &ServerProxy::okay<&ServerProxy::enter>);
+    m_messages.add(kMsgCLeave,        &ServerProxy::okay<&ServerProxy::leave>);
+    m_messages.add(kMsgCClipboard,    &ServerProxy::okay<&ServerProxy::grabClipboard>);
+    m_messages.add(kMsgCScreenSaver,  &ServerProxy::okay<&ServerProxy::screensaver>);
+    m_messages.add(kMsgQInfo,         &ServerProxy::okay<&ServerProxy::queryInfo>);
+    m_messages.add(kMsgCInfoAck,      &ServerProxy::okay<&ServerProxy::infoAcknowledgment>);
+    m_messages.add(kMsgDClipboard,    &ServerProxy::okay<&ServerProxy::setClipboard>);
+    m_messages.add(kMsgDClipboardSummary, &ServerProxy::okay<&ServerProxy::clipboardSummary>);
+    m_messages.add(kMsgDClipboardOffer, &ServerProxy::okay<&ServerProxy::clipboardOffer>);
+    m_messages.add(kMsgQClipboard,    &ServerProxy::okay<&ServerProxy::queryClipboard>);
+    m_messages.add(kMsgCResetOptions, &ServerProxy::okay<&ServerProxy::resetOptions>);
+    m_messages.add(kMsgDSetOptions,   &ServerProxy::okay<&ServerProxy::setOptions>);
+    m_messages.add(kMsgDFileTransfer, &ServerProxy::okay<&ServerProxy::fileChunkReceived>);
+    m_messages.add(kMsgDDragInfo,     &ServerProxy::okay<&ServerProxy::dragInfoReceived>);
+    m_messages.add(kMsgCClose,        &ServerProxy::close);
+    m_messages.add(kMsgEBad,          &ServerProxy::protocolError);
+    m_messages.add(kMsgDInputBatch,   &ServerProxy::inputBatch);
+    m_messages.add(kMsgDLatencyTrace, &ServerProxy::okay<&ServerProxy::latencyTrace>);
+
+    // messages allowed in an input batch
+    m_batchMessages.add(kMsgDMouseMove,    &ServerProxy::okay<&ServerProxy::mouseMove>);
+    m_batchMessages.add(kMsgDMouseRelMove, &ServerProxy::okay<&ServerProxy::mouseRelativeMove>);
+    m_batchMessages.add(kMsgDMouseWheel,   &ServerProxy::okay<&ServerProxy::mouseWheel>);
+    m_batchMessages.add(kMsgDKeyDown,      &ServerProxy::okay<&ServerProxy::keyDown>);
+    m_batchMessages.add(kMsgDKeyUp,        &ServerProxy::okay<&ServerProxy::keyUp>);
+    m_batchMessages.add(kMsgDMouseDown,    &ServerProxy::okay<&ServerProxy::mouseDown>);
+    m_batchMessages.add(kMsgDMouseUp,      &ServerProxy::okay<&ServerProxy::mouseUp>);
+    m_batchMessages.add(kMsgDKeyRepeat,    &ServerProxy::okay<&ServerProxy::keyRepeat>);
+    m_batchMessages.add(kMsgDLatencyTrace, &ServerProxy::okay<&ServerProxy::latencyTrace>);
+}
 
-    else if (memcmp(code, kMsgEBad, 4) == 0) {
-        LOG((CLOG_ERR "server disconnected due to a protocol error"));
-        m_client->disconnect("server reported a protocol error");
-        return kDisconnect;
-    }
-    else {
+ServerProxy::EResult
+ServerProxy::parseHandshakeMessage(const UInt8* code)
+{
+    MessageHandler handler = m_handshakeMessages.find(code);
+    if (handler == NULL) {
         return kUnknown;
     }
-
-    return kOkay;
+    return (this->*handler)();
 }
 
 ServerProxy::EResult
 ServerProxy::parseMessage(const UInt8* code)
 {
-    if (memcmp(code, kMsgDMouseMove, 4) == 0) {
-        mouseMove();
-    }
-
-    else if (memcmp(code, kMsgDMouseRelMove, 4) == 0) {
-        mouseRelativeMove();
-    }
-
-    else if (memcmp(code, kMsgDMouseWheel, 4) == 0) {
-        mouseWheel();
-    }
-
-    else if (memcmp(code, kMsgDKeyDown, 4) == 0) {
-        keyDown();
-    }
-
-    else if (memcmp(code, kMsgDKeyUp, 4) == 0) {
-        keyUp();
-    }
-
-    else if (memcmp(code, kMsgDMouseDown, 4) == 0) {
-        mouseDown();
-    }
-
-    else if (memcmp(code, kMsgDMouseUp, 4) == 0) {
-        mouseUp();
-    }
-
-    else if (memcmp(code, kMsgDKeyRepeat, 4) == 0) {
-        keyRepeat();
-    }
-
-    else if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
-        // echo keep alives and reset alarm
-        ProtocolUtil::writef(m_stream, kMsgCKeepAlive);
-        resetKeepAliveAlarm();
-    }
-
-    else if (memcmp(code, kMsgCNoop, 4) == 0) {
-        // accept and discard no-op
-    }
-
-    else if (memcmp(code, kMsgCEnter, 4) == 0) {
-        enter();
-    }
-
-    else if (memcmp(code, kMsgCLeave, 4) == 0) {
-        leave();
-    }
-
-    else if (memcmp(code, kMsgCClipboard, 4) == 0) {
-        grabClipboard();
-    }
-
-    else if (memcmp(code, kMsgCScreenSaver, 4) == 0) {
-        screensaver();
-    }
-
-    else if (memcmp(code, kMsgQInfo, 4) == 0) {
-        queryInfo();
-    }
-
-    else if (memcmp(code, kMsgCInfoAck, 4) == 0) {
-        infoAcknowledgment();
-    }
-
-    else if (memcmp(code, kMsgDClipboard, 4) == 0) {
-        setClipboard();
-    }
-
-    else if (memcmp(code, kMsgCResetOptions, 4) == 0) {
-        resetOptions();
-    }
-
-    else if (memcmp(code, kMsgDSetOptions, 4) == 0) {
-        setOptions();
-    }
-
-    else if (memcmp(code, kMsgDFileTransfer, 4) == 0) {
-        fileChunkReceived();
-    }
-    else if (memcmp(code, kMsgDDragInfo, 4) == 0) {
-        dragInfoReceived();
+    MessageHandler handler = m_messages.find(code);
+    if (handler == NULL) {
+        return kUnknown;
     }
 
-    else if (memcmp(code, kMsgCClose, 4) == 0) {
-        // server wants us to hangup
-        LOG((CLOG_DEBUG1 "recv close"));
-        m_client->disconnect(NULL);
-        return kDisconnect;
-    }
-    else if (memcmp(code, kMsgEBad, 4) == 0) {
-        LOG((CLOG_ERR "server disconnected due to a protocol error"));
-        m_client->disconnect("server reported a protocol error");
-        return kDisconnect;
-    }
-    else {
-        return kUnknown;
+    EResult result = dispatch(handler);
+    if (result != kOkay) {
+        return result;
     }
 
     // send a reply.  this is intended to work around a delay when
@@ -359,12 +300,44 @@ ServerProxy::onGrabClipboard(ClipboardID id)
 }
 
 void
-ServerProxy::onClipboardChanged(ClipboardID id, const IClipboard* clipboard)
+ServerProxy::onClipboardOffered(ClipboardID id, UInt32 formats)
+{
+    std::vector<UInt32> offered;
+    for (UInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+        if ((formats & (1u << format)) != 0) {
+            offered.push_back(format);
+        }
+    }
+    LOG((CLOG_DEBUG "sending clipboard %d offer seqnum=%d formats=%d", id, m_seqNum, (int)offered.size()));
+    ProtocolUtil::writef(m_stream, kMsgDClipboardOffer, id, m_seqNum, &offered);
+}
+
+void
+ServerProxy::onClipboardChanged(ClipboardID id, Clipboard& clipboard)
 {
-    std::string data = IClipboard::marshall(clipboard);
+    // the data is taken from clipboard
     LOG((CLOG_DEBUG "sending clipboard %d seqnum=%d", id, m_seqNum));
+    m_clipboardStreamer.send(id, m_seqNum, clipboard);
+}
+
+void
+ServerProxy::onClipboardRequested(ClipboardID id, UInt32 formats)
+{
+    // the screen may still be waiting on an offer that's been replaced
+    const ClipboardSummary& summary = m_clipboardSummary[id];
+    if (!summary.m_promised) {
+        LOG((CLOG_DEBUG "ignored request for clipboard %d (not promised)", id));
+        return;
+    }
 
-    StreamChunker::sendClipboard(data, data.size(), id, m_seqNum, m_events, this);
+    std::vector<UInt32> wanted;
+    for (UInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+        if ((formats & (1u << format)) != 0) {
+            wanted.push_back(format);
+        }
+    }
+    LOG((CLOG_DEBUG "query clipboard %d seqnum=%d formats=%d", id, summary.m_sequence, (int)wanted.size()));
+    ProtocolUtil::writef(m_stream, kMsgQClipboard, id, summary.m_sequence, &wanted);
 }
 
 void
@@ -512,6 +485,154 @@ ServerProxy::translateModifierMask(KeyModifierMask mask) const
     return newMask;
 }
 
+ServerProxy::EResult
+ServerProxy::handshakeComplete()
+{
+    setOptions();
+
+    // handshake is complete
+    m_parser = &ServerProxy::parseMessage;
+    m_client->handshakeComplete();
+    return kOkay;
+}
+
+ServerProxy::EResult
+ServerProxy::close()
+{
+    // server wants us to hangup
+    LOG((CLOG_DEBUG1 "recv close"));
+    m_client->disconnect(NULL);
+    return kDisconnect;
+}
+
+ServerProxy::EResult
+ServerProxy::incompatible()
+{
+    SInt32 major, minor;
+    ProtocolUtil::readf(m_stream,
+                    kMsgEIncompatible + 4, &major, &minor);
+    LOG((CLOG_ERR "server has incompatible version %d.%d", major, minor));
+    m_client->disconnect("server has incompatible version");
+    return kDisconnect;
+}
+
+ServerProxy::EResult
+ServerProxy::busy()
+{
+    LOG((CLOG_ERR "server already has a connected client with name \"%s\"", m_client->getName().c_str()));
+    m_client->disconnect("server already has a connected client with our name");
+    return kDisconnect;
+}
+
+ServerProxy::EResult
+ServerProxy::unknownClient()
+{
+    LOG((CLOG_ERR "server refused client with name \"%s\"", m_client->getName().c_str()));
+    m_client->disconnect("server refused client with our name");
+    return kDisconnect;
+}
+
+ServerProxy::EResult
+ServerProxy::inputBatch()
+{
+    // parse
+    UInt16 count;
+    if (!MsgDInputBatch::read(m_stream, count)) {
+        LOG((CLOG_ERR "incomplete input batch from server"));
+        m_client->disconnect("incomplete message from server");
+        return kDisconnect;
+    }
+    LOG((CLOG_DEBUG2 "recv input batch count=%d", count));
+
+    // handle each message.  the batch is acknowledged as a whole by
+    // the single reply that follows it.
+    for (UInt16 i = 0; i < count; ++i) {
+        UInt8 code[4];
+        if (m_stream->read(code, 4) != 4) {
+            LOG((CLOG_ERR "incomplete input batch from server"));
+            m_client->disconnect("incomplete message from server");
+            return kDisconnect;
+        }
+
+        MessageHandler handler = m_batchMessages.find(code);
+        if (handler == NULL) {
+            LOG((CLOG_ERR "invalid message in input batch from server: %c%c%c%c", code[0], code[1], code[2], code[3]));
+            m_client->disconnect("invalid message from server");
+            return kDisconnect;
+        }
+        dispatch(handler);
+    }
+
+    return kOkay;
+}
+
+ServerProxy::EResult
+ServerProxy::dispatch(MessageHandler handler)
+{
+    // a latency trace describes the message after it
+    bool traced = m_traced;
+    m_traced    = false;
+
+    EResult result = (this->*handler)();
+    if (traced) {
+        endLatencyTrace();
+    }
+    return result;
+}
+
+ServerProxy::EResult
+ServerProxy::protocolError()
+{
+    LOG((CLOG_ERR "server disconnected due to a protocol error"));
+    m_client->disconnect("server reported a protocol error");
+    return kDisconnect;
+}
+
+void
+ServerProxy::keepAlive()
+{
+    // echo keep alives and reset alarm
+    MsgCKeepAlive::write(m_stream);
+    if (m_keepAliveAlarmTimer != NULL) {
+        m_events->resetTimer(m_keepAliveAlarmTimer);
+    }
+}
+
+void
+ServerProxy::latencyTrace()
+{
+    // parse
+    MsgDLatencyTrace::read(m_stream, m_traceSequence, m_traceStart, m_traceWritten);
+    m_traceRead = LatencyTrace::getTimestamp();
+    m_traced    = true;
+}
+
+void
+ServerProxy::endLatencyTrace()
+{
+    UInt32 done = LatencyTrace::getTimestamp();
+    double server  = LatencyTrace::getInterval(m_traceStart, m_traceWritten);
+    double network = LatencyTrace::getInterval(m_traceWritten, m_traceRead);
+    double client  = LatencyTrace::getInterval(m_traceRead, done);
+    double total   = LatencyTrace::getInterval(m_traceStart, done);
+    LOG((CLOG_DEBUG2 "latency trace %u: server=%.0fus network=%.0fus client=%.0fus", m_traceSequence, 1.0e+6 * server, 1.0e+6 * network, 1.0e+6 * client));
+
+    LatencyTrace& trace = m_client->getLatencyTrace();
+    trace.record(LatencyTrace::kServer, server);
+    trace.record(LatencyTrace::kNetwork, network);
+    trace.record(LatencyTrace::kClient, client);
+    trace.record(LatencyTrace::kTotal, total);
+    if (trace.getCount(LatencyTrace::kTotal) % kLatencyReportInterval == 0) {
+        trace.report();
+    }
+}
+
+void
+ServerProxy::noop()
+{
+    // accept and discard no-op
+}
+
 void
 ServerProxy::enter()
 {
@@ -550,28 +671,177 @@ void
 ServerProxy::setClipboard()
 {
     // parse
-    static std::string dataCached;
     ClipboardID id;
     UInt32 seq;
 
-    int r = ClipboardChunk::assemble(m_stream, dataCached, id, seq);
+    int r = ClipboardChunk::assemble(m_stream, m_clipboardTransfer, id, seq);
 
     if (r == kStart) {
-        size_t size = ClipboardChunk::getExpectedSize();
-        LOG((CLOG_DEBUG "receiving clipboard %d size=%d", id, size));
+        size_t size = m_clipboardTransfer[id].m_data.getExpectedSize();
+        LOG((CLOG_DEBUG "receiving clipboard %d size=%d", id, (int)size));
     }
     else if (r == kFinish) {
-        LOG((CLOG_DEBUG "received clipboard %d size=%d", id, dataCached.size()));
+        ClipboardUnmarshaller& data = m_clipboardTransfer[id].m_data;
+        LOG((CLOG_DEBUG "received clipboard %d size=%d", id, (int)data.getSize()));
 
-        // forward
         Clipboard clipboard;
-        clipboard.unmarshall(dataCached, 0);
+        data.unmarshall(clipboard, 0);
+
+        // the formats missing from a summary or asked for from an offer
+        ClipboardSummary& summary = m_clipboardSummary[id];
+        if (summary.m_used) {
+            if (!summary.m_waiting || seq != summary.m_sequence) {
+                LOG((CLOG_DEBUG "ignored clipboard %d for old summary seqnum=%d", id, seq));
+                return;
+            }
+            if (!summary.m_offer) {
+                applyClipboardSummary(id, &clipboard);
+            }
+            else if (summary.m_promised) {
+                m_client->fulfilClipboard(id, &clipboard);
+            }
+            else {
+                summary.m_waiting = false;
+                m_client->setClipboard(id, &clipboard);
+                LOG((CLOG_INFO "clipboard was updated"));
+            }
+            return;
+        }
+
+        // forward
         m_client->setClipboard(id, &clipboard);
 
         LOG((CLOG_INFO "clipboard was updated"));
     }
 }
 
+void
+ServerProxy::clipboardSummary()
+{
+    // parse
+    ClipboardID id;
+    UInt32 seq;
+    std::vector<UInt32> formats, sizes, hashes;
+    ProtocolUtil::readf(m_stream, kMsgDClipboardSummary + 4,
+                            &id, &seq, &formats, &sizes, &hashes);
+    LOG((CLOG_DEBUG "recv clipboard %d summary seqnum=%d formats=%d", id, seq, (int)formats.size()));
+
+    // validate
+    if (id >= kClipboardEnd || sizes.size() != formats.size() ||
+        hashes.size() != 2 * formats.size()) {
+        LOG((CLOG_ERR "invalid clipboard %d summary", id));
+        return;
+    }
+
+    // replaces any summary still waiting for data.  skip formats newer
+    // than ours, as unmarshalling does.
+    ClipboardSummary& summary = m_clipboardSummary[id];
+    summary.m_used     = true;
+    summary.m_offer    = false;
+    summary.m_promised = false;
+    summary.m_sequence = seq;
+    summary.m_summary.clear();
+    summary.m_requested.clear();
+    for (size_t i = 0; i < formats.size(); ++i) {
+        if (formats[i] < IClipboard::kNumFormats) {
+            ClipboardCache::Entry entry;
+            entry.m_format = static_cast<IClipboard::EFormat>(formats[i]);
+            entry.m_size   = sizes[i];
+            entry.m_hash   = ((std::uint64_t)hashes[2 * i] << 32) |
+                                hashes[2 * i + 1];
+            summary.m_summary.push_back(entry);
+        }
+    }
+
+    applyClipboardSummary(id, NULL);
+}
+
+void
+ServerProxy::clipboardOffer()
+{
+    // parse
+    ClipboardID id;
+    UInt32 seq;
+    std::vector<UInt32> formats;
+    ProtocolUtil::readf(m_stream, kMsgDClipboardOffer + 4, &id, &seq, &formats);
+    LOG((CLOG_DEBUG "recv clipboard %d offer seqnum=%d formats=%d", id, seq, (int)formats.size()));
+
+    // validate
+    if (id >= kClipboardEnd) {
+        LOG((CLOG_ERR "invalid clipboard %d offer", id));
+        return;
+    }
+
+    // skip formats newer than ours, as unmarshalling does
+    UInt32 offered = 0;
+    std::vector<UInt32> known;
+    for (size_t i = 0; i < formats.size(); ++i) {
+        if (formats[i] < IClipboard::kNumFormats) {
+            offered |= (1u << formats[i]);
+            known.push_back(formats[i]);
+        }
+    }
+
+    // replaces any summary or offer still waiting for data
+    ClipboardSummary& summary = m_clipboardSummary[id];
+    summary.m_used     = true;
+    summary.m_offer    = true;
+    summary.m_sequence = seq;
+    summary.m_summary.clear();
+    summary.m_requested.clear();
+
+    // the screen asks for the data when an application wants it
+    summary.m_promised = m_client->promiseClipboard(id, offered);
+    summary.m_waiting  = summary.m_promised;
+    if (!summary.m_promised) {
+        // the screen needs the data now
+        LOG((CLOG_DEBUG "query clipboard %d seqnum=%d formats=%d", id, seq, (int)known.size()));
+        ProtocolUtil::writef(m_stream, kMsgQClipboard, id, seq, &known);
+        summary.m_waiting = true;
+    }
+}
+
+void
+ServerProxy::queryClipboard()
+{
+    // parse
+    ClipboardID id;
+    UInt32 seq;
+    std::vector<UInt32> formats;
+    ProtocolUtil::readf(m_stream, kMsgQClipboard + 4, &id, &seq, &formats);
+    LOG((CLOG_DEBUG "recv clipboard %d query seqnum=%d formats=%d", id, seq, (int)formats.size()));
+
+    // validate
+    if (id >= kClipboardEnd) {
+        return;
+    }
+
+    // the server wants data we offered.  send each format asked for,
+    // empty if the clipboard no longer has it.
+    Clipboard source;
+    m_client->getClipboard(id, &source);
+    Clipboard clipboard;
+    if (source.open(0)) {
+        if (clipboard.open(0)) {
+            clipboard.empty();
+            for (size_t i = 0; i < formats.size(); ++i) {
+                if (formats[i] < IClipboard::kNumFormats) {
+                    IClipboard::EFormat format =
+                        static_cast<IClipboard::EFormat>(formats[i]);
+                    String data;
+                    source.take(format, data);
+                    clipboard.adopt(format, data);
+                }
+            }
+            clipboard.close();
+        }
+        source.close();
+    }
+
+    LOG((CLOG_DEBUG "sending clipboard %d seqnum=%d", id, seq));
+    m_clipboardStreamer.send(id, seq, clipboard);
+}
+
 void
 ServerProxy::grabClipboard()
 {
@@ -598,7 +868,7 @@ ServerProxy::keyDown()
 
     // parse
     UInt16 id, mask, button;
-    ProtocolUtil::readf(m_stream, kMsgDKeyDown + 4, &id, &mask, &button);
+    MsgDKeyDown::read(m_stream, id, mask, button);
     LOG((CLOG_DEBUG1 "recv key down id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
     // translate
@@ -621,8 +891,7 @@ ServerProxy::keyRepeat()
 
     // parse
     UInt16 id, mask, count, button;
-    ProtocolUtil::readf(m_stream, kMsgDKeyRepeat + 4,
-                                &id, &mask, &count, &button);
+    MsgDKeyRepeat::read(m_stream, id, mask, count, button);
     LOG((CLOG_DEBUG1 "recv key repeat id=0x%08x, mask=0x%04x, count=%d, button=0x%04x", id, mask, count, button));
 
     // translate
@@ -645,7 +914,7 @@ ServerProxy::keyUp()
 
     // parse
     UInt16 id, mask, button;
-    ProtocolUtil::readf(m_stream, kMsgDKeyUp + 4, &id, &mask, &button);
+    MsgDKeyUp::read(m_stream, id, mask, button);
     LOG((CLOG_DEBUG1 "recv key up id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
     // translate
@@ -696,7 +965,7 @@ ServerProxy::mouseMove()
     // parse
     bool ignore;
     SInt16 x, y;
-    ProtocolUtil::readf(m_stream, kMsgDMouseMove + 4, &x, &y);
+    MsgDMouseMove::read(m_stream, x, y);
 
     // note if we should ignore the move
     ignore = m_ignoreMouse;
@@ -729,7 +998,7 @@ ServerProxy::mouseRelativeMove()
     // parse
     bool ignore;
     SInt16 dx, dy;
-    ProtocolUtil::readf(m_stream, kMsgDMouseRelMove + 4, &dx, &dy);
+    MsgDMouseRelMove::read(m_stream, dx, dy);
 
     // note if we should ignore the move
     ignore = m_ignoreMouse;
@@ -792,6 +1061,10 @@ ServerProxy::resetOptions()
     // reset keep alive
     setKeepAliveRate(kKeepAliveRate);
 
+    // reset compression
+    m_compression = true;
+    m_clipboardStreamer.setCompression(true);
+
     // reset modifier translation table
     for (KeyModifierID id = 0; id < kKeyModifierIDLast; ++id) {
         m_modifierTranslationTable[id] = id;
@@ -834,6 +1107,11 @@ ServerProxy::setOptions()
             // update keep alive
             setKeepAliveRate(1.0e-3 * static_cast<double>(options[i + 1]));
         }
+        else if (options[i] == kOptionCompression) {
+            m_compression = (options[i + 1] != 0);
+            m_clipboardStreamer.setCompression(m_compression);
+            LOG((CLOG_DEBUG1 "compression %s", m_compression ? "on" : "off"));
+        }
 
         if (id != kKeyModifierIDNull) {
             m_modifierTranslationTable[id] =
@@ -862,12 +1140,12 @@ ServerProxy::infoAcknowledgment()
 void
 ServerProxy::fileChunkReceived()
 {
-    int result = FileChunk::assemble(
-                    m_stream,
-                    m_client->getReceivedFileData(),
-                    m_client->getExpectedFileSize());
+    int result = FileChunk::assemble(m_stream, m_fileTransfer);
 
     if (result == kFinish) {
+        m_client->getReceivedFileData().swap(m_fileTransfer.m_data);
+        m_client->getExpectedFileSize() = m_fileTransfer.m_progress.getSize();
+        m_fileTransfer.m_data.clear();
         m_events->addEvent(Event(m_events->forFile().fileRecieveCompleted(), m_client));
     }
     else if (result == kStart) {
@@ -890,14 +1168,102 @@ ServerProxy::dragInfoReceived()
 }
 
 void
-ServerProxy::handleClipboardSendingEvent(const Event& event, void*)
+ServerProxy::applyClipboardSummary(ClipboardID id, const IClipboard* received)
+{
+    ClipboardSummary& summary = m_clipboardSummary[id];
+    summary.m_waiting = false;
+
+    // take what we can from the cache before adding the received
+    // formats, which may push it out
+    const size_t n = summary.m_summary.size();
+    std::vector<String> data(n);
+    std::vector<bool> cached(n);
+    for (size_t i = 0; i < n; ++i) {
+        const ClipboardCache::Entry& entry = summary.m_summary[i];
+        cached[i] = m_clipboardCache.find(entry.m_hash, entry.m_size, data[i]);
+    }
+
+    std::vector<UInt32> missing;
+    bool valid = true;
+    if (received != NULL && !received->open(0)) {
+        received = NULL;
+    }
+    for (size_t i = 0; i < n && valid; ++i) {
+        const ClipboardCache::Entry& entry = summary.m_summary[i];
+        if (cached[i]) {
+            continue;
+        }
+        if (received != NULL && received->has(entry.m_format)) {
+            // the client may have grabbed the clipboard since the summary
+            data[i] = received->get(entry.m_format);
+            valid   = (data[i].size() == entry.m_size &&
+                        ClipboardCache::hash(data[i].data(), data[i].size()) == entry.m_hash);
+        }
+        else if (std::find(summary.m_requested.begin(), summary.m_requested.end(),
+                            (UInt32)entry.m_format) != summary.m_requested.end()) {
+            valid = false;
+        }
+        else {
+            // not asked for or pushed out of the cache since
+            missing.push_back(entry.m_format);
+        }
+        if (!valid) {
+            LOG((CLOG_WARN "clipboard %d format %d doesn't match its summary", id, entry.m_format));
+        }
+    }
+    if (received != NULL) {
+        received->close();
+    }
+    if (!valid) {
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!cached[i] && !data[i].empty()) {
+            m_clipboardCache.add(summary.m_summary[i].m_hash, data[i]);
+        }
+    }
+
+    if (!missing.empty()) {
+        LOG((CLOG_DEBUG "query clipboard %d seqnum=%d formats=%d of %d", id, summary.m_sequence, (int)missing.size(), (int)n));
+        ProtocolUtil::writef(m_stream, kMsgQClipboard,
+                            id, summary.m_sequence, &missing);
+        summary.m_waiting = true;
+        summary.m_requested.swap(missing);
+        return;
+    }
+
+    // forward
+    Clipboard clipboard;
+    if (clipboard.open(0)) {
+        clipboard.empty();
+        for (size_t i = 0; i < n; ++i) {
+            clipboard.add(summary.m_summary[i].m_format, data[i]);
+        }
+        clipboard.close();
+    }
+    m_client->setClipboard(id, &clipboard);
+
+    LOG((CLOG_INFO "clipboard was updated"));
+}
+
+void
+ServerProxy::handleOutputFlushed(const Event&, void*)
 {
-    ClipboardChunk::send(m_stream, event.getData());
+    m_clipboardStreamer.flush();
 }
 
 void
 ServerProxy::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
 {
+    if (mark == kDataStart) {
+        m_fileCompressor.start();
+    }
+    else if (mark == kDataChunk && m_compression &&
+                m_fileCompressor.compress(data, dataSize, m_compressed)) {
+        FileChunk::send(m_stream, kDataCompressed, &m_compressed[0], m_compressed.size());
+        return;
+    }
     FileChunk::send(m_stream, mark, data, dataSize);
 }
 
@@ -18,6 +18,12 @@
 
 #pragma once
 
+#include "barrier/ChunkCompressor.h"
+#include "barrier/ClipboardCache.h"
+#include "barrier/ClipboardChunk.h"
+#include "barrier/ClipboardStreamer.h"
+#include "barrier/FileChunk.h"
+#include "barrier/MessageTable.h"
 #include "barrier/clipboard_types.h"
 #include "barrier/key_types.h"
 #include "base/Event.h"
@@ -49,7 +55,9 @@ public:
 
     void                onInfoChanged();
     bool                onGrabClipboard(ClipboardID);
-    void                onClipboardChanged(ClipboardID, const IClipboard*);
+    void                onClipboardOffered(ClipboardID, UInt32 formats);
+    void                onClipboardChanged(ClipboardID, Clipboard&);
+    void                onClipboardRequested(ClipboardID, UInt32 formats);
 
     //@}
 
@@ -69,6 +77,25 @@ protected:
     EResult                parseMessage(const UInt8* code);
 
 private:
+    typedef EResult (ServerProxy::*MessageParser)(const UInt8*);
+    typedef EResult (ServerProxy::*MessageHandler)();
+
+    // the latest clipboard summary or offer received for a clipboard
+    class ClipboardSummary {
+    public:
+        ClipboardSummary() : m_used(false), m_waiting(false), m_offer(false),
+            m_promised(false), m_sequence(0) { }
+
+    public:
+        bool            m_used;
+        bool            m_waiting;
+        bool            m_offer;
+        bool            m_promised;
+        UInt32            m_sequence;
+        ClipboardCache::Summary    m_summary;
+        std::vector<UInt32>    m_requested;
+    };
+
     // if compressing mouse motion then send the last motion now
     void                flushCompressedMouse();
 
@@ -86,9 +113,27 @@ private:
     void                handleKeepAliveAlarm(const Event&, void*);
 
     // message handlers
+    void                addMessageHandlers();
+    template <void (ServerProxy::*handler)()>
+    EResult                okay();
+    EResult                handshakeComplete();
+    EResult                close();
+    EResult                incompatible();
+    EResult                busy();
+    EResult                unknownClient();
+    EResult                protocolError();
+    EResult                inputBatch();
+    EResult                dispatch(MessageHandler handler);
+    void                latencyTrace();
+    void                endLatencyTrace();
+    void                keepAlive();
+    void                noop();
     void                enter();
     void                leave();
     void                setClipboard();
+    void                clipboardSummary();
+    void                clipboardOffer();
+    void                queryClipboard();
     void                grabClipboard();
     void                keyDown();
     void                keyRepeat();
@@ -105,11 +150,14 @@ private:
     void                infoAcknowledgment();
     void                fileChunkReceived();
     void                dragInfoReceived();
-    void                handleClipboardSendingEvent(const Event&, void*);
+    void                handleOutputFlushed(const Event&, void*);
 
-private:
-    typedef EResult (ServerProxy::*MessageParser)(const UInt8*);
+    // set the clipboard from the summary using the formats in
+    // \c received and the cache, or ask for the formats still missing
+    void                applyClipboardSummary(ClipboardID,
+                            const IClipboard* received);
 
+private:
     Client*            m_client;
     barrier::IStream*    m_stream;
 
@@ -122,11 +170,35 @@ private:
 
     bool                m_ignoreMouse;
 
+    ClipboardSummary    m_clipboardSummary[kClipboardEnd];
+    ClipboardCache        m_clipboardCache;
+    ClipboardStreamer    m_clipboardStreamer;
+    ClipboardTransfer    m_clipboardTransfer[kClipboardEnd];
+
+    // file chunks are compressed like clipboards, unless the server
+    // disables the compression option
+    bool                m_compression;
+    ChunkCompressor        m_fileCompressor;
+    String                m_compressed;
+
+    // the file being received.  the client gets it once it's complete.
+    FileTransfer        m_fileTransfer;
+
+    // latency trace for the next message
+    bool                m_traced;
+    UInt32                m_traceSequence;
+    UInt32                m_traceStart;
+    UInt32                m_traceWritten;
+    UInt32                m_traceRead;
+
     KeyModifierID        m_modifierTranslationTable[kKeyModifierIDLast];
 
     double                m_keepAliveAlarm;
     EventQueueTimer*    m_keepAliveAlarmTimer;
 
     MessageParser        m_parser;
+    MessageTable<MessageHandler>    m_handshakeMessages;
+    MessageTable<MessageHandler>    m_messages;
+    MessageTable<MessageHandler>    m_batchMessages;
     IEventQueue*        m_events;
 };
@@ -18,15 +18,23 @@
 
 #include "io/StreamBuffer.h"
 
+#include <cassert>
+#include <cstring>
+#include <new>
+
 //
 // StreamBuffer
 //
 
-const UInt32            StreamBuffer::kChunkSize = 4096;
+const UInt32            StreamBuffer::kMinCapacity     = 4096;
+const UInt32            StreamBuffer::kMaxIdleCapacity = 1024 * 1024;
+const UInt32            StreamBuffer::kMaxCapacity     = 0xffffffffu;
 
 StreamBuffer::StreamBuffer() :
-    m_size(0),
-    m_headUsed(0)
+    m_capacity(0),
+    m_head(0),
+    m_tail(0),
+    m_prepared(0)
 {
     // do nothing
 }
@@ -36,111 +44,102 @@ StreamBuffer::~StreamBuffer()
     // do nothing
 }
 
-const void*
-StreamBuffer::peek(UInt32 n)
+void*
+StreamBuffer::prepare(UInt32 n)
 {
-    assert(n <= m_size);
-
-    // if requesting no data then return NULL so we don't try to access
-    // an empty list.
-    if (n == 0) {
-        return NULL;
+    if (m_capacity - m_tail < n) {
+        UInt32 size = m_tail - m_head;
+        if (m_capacity - size >= n && size <= m_capacity / 2) {
+            // enough room if the data is moved to the front
+            memmove(&m_buffer[0], &m_buffer[m_head], size);
+        }
+        else {
+            // the data plus n more bytes must fit in a UInt32
+            if (n > kMaxCapacity - size) {
+                throw std::bad_alloc();
+            }
+
+            // grow geometrically, keeping at most half the buffer full,
+            // so that appending and compacting stay amortized O(1).  stop
+            // doubling before the capacity overflows.
+            UInt32 capacity = (m_capacity < kMinCapacity) ?
+                                kMinCapacity : m_capacity;
+            while (capacity - size < n || size > capacity / 2) {
+                if (capacity > kMaxCapacity / 2) {
+                    capacity = kMaxCapacity;
+                    break;
+                }
+                capacity *= 2;
+            }
+            std::unique_ptr<UInt8[]> buffer(new UInt8[capacity]);
+            if (size > 0) {
+                memcpy(&buffer[0], &m_buffer[m_head], size);
+            }
+            m_buffer.swap(buffer);
+            m_capacity = capacity;
+        }
+        m_head = 0;
+        m_tail = size;
     }
 
-    // reserve space in first chunk
-    ChunkList::iterator head = m_chunks.begin();
-    head->reserve(n + m_headUsed);
+    m_prepared = n;
+    return &m_buffer[m_tail];
+}
 
-    // consolidate chunks into the first chunk until it has n bytes
-    ChunkList::iterator scan = head;
-    ++scan;
-    while (head->size() - m_headUsed < n && scan != m_chunks.end()) {
-        head->insert(head->end(), scan->begin(), scan->end());
-        scan = m_chunks.erase(scan);
-    }
+void
+StreamBuffer::commit(UInt32 n)
+{
+    assert(n <= m_prepared);
 
-    return static_cast<const void*>(&(head->begin()[m_headUsed]));
+    m_tail    += n;
+    m_prepared = 0;
 }
 
 void
-StreamBuffer::pop(UInt32 n)
+StreamBuffer::consume(UInt32 n)
 {
-    // discard all chunks if n is greater than or equal to m_size
-    if (n >= m_size) {
-        m_size     = 0;
-        m_headUsed = 0;
-        m_chunks.clear();
-        return;
-    }
+    m_prepared = 0;
 
-    // update size
-    m_size -= n;
-
-    // discard chunks until more than n bytes would've been discarded
-    ChunkList::iterator scan = m_chunks.begin();
-    assert(scan != m_chunks.end());
-    while (scan->size() - m_headUsed <= n) {
-        n         -= (UInt32)scan->size() - m_headUsed;
-        m_headUsed = 0;
-        scan       = m_chunks.erase(scan);
-        assert(scan != m_chunks.end());
+    if (n < m_tail - m_head) {
+        m_head += n;
+        return;
     }
 
-    // remove left over bytes from the head chunk
-    if (n > 0) {
-        m_headUsed += n;
+    // the buffer is empty so start writing at the front again.  don't
+    // hang on to the memory after an unusually large transfer.
+    m_head = 0;
+    m_tail = 0;
+    if (m_capacity > kMaxIdleCapacity) {
+        m_buffer.reset();
+        m_capacity = 0;
     }
 }
 
 void
-StreamBuffer::write(const void* vdata, UInt32 n)
+StreamBuffer::write(const void* data, UInt32 n)
 {
-    assert(vdata != NULL);
+    assert(data != NULL);
 
-    // ignore if no data, otherwise update size
+    // ignore if no data
     if (n == 0) {
         return;
     }
-    m_size += n;
-
-    // cast data to bytes
-    const UInt8* data = static_cast<const UInt8*>(vdata);
 
-    // point to last chunk if it has space, otherwise append an empty chunk
-    ChunkList::iterator scan = m_chunks.end();
-    if (scan != m_chunks.begin()) {
-        --scan;
-        if (scan->size() >= kChunkSize) {
-            ++scan;
-        }
-    }
-    if (scan == m_chunks.end()) {
-        scan = m_chunks.insert(scan, Chunk());
-    }
+    memcpy(prepare(n), data, n);
+    commit(n);
+}
 
-    // append data in chunks
-    while (n > 0) {
-        // choose number of bytes for next chunk
-        assert(scan->size() <= kChunkSize);
-        UInt32 count = kChunkSize - (UInt32)scan->size();
-        if (count > n)
-            count = n;
-
-        // transfer data
-        scan->insert(scan->end(), data, data + count);
-        n    -= count;
-        data += count;
-
-        // append another empty chunk if we're not done yet
-        if (n > 0) {
-            ++scan;
-            scan = m_chunks.insert(scan, Chunk());
-        }
+const void*
+StreamBuffer::data() const
+{
+    if (m_head == m_tail) {
+        return NULL;
     }
+    return &m_buffer[m_head];
 }
 
 UInt32
 StreamBuffer::getSize() const
 {
-    return m_size;
+    return m_tail - m_head;
 }
@@ -18,13 +18,16 @@
 
 #pragma once
 
-#include "base/EventTypes.h"
-#include "common/stdlist.h"
-#include "common/stdvector.h"
+#include "common/basic_types.h"
+
+#include <memory>
 
 //! FIFO of bytes
 /*!
-This class maintains a FIFO (first-in, last-out) buffer of bytes.
+This class maintains a FIFO (first-in, first-out) buffer of bytes.  The
+bytes are kept contiguous in a single growable block so they can be read
+and written in place, e.g. by passing the block straight to recv() or
+send().
 */
 class StreamBuffer {
 public:
@@ -34,20 +37,31 @@ public:
     //! @name manipulators
     //@{
 
-    //! Read data without removing from buffer
+    //! Reserve space for writing
+    /*!
+    Return a pointer to at least \c n bytes of contiguous writable memory
+    just past the end of the buffered data.  The caller fills some prefix
+    of it then calls commit() with the number of bytes written.  The
+    pointer is invalidated by any other manipulator.  Throws
+    std::bad_alloc if the buffered data plus \c n bytes would not fit
+    in a UInt32.
+    */
+    void*                prepare(UInt32 n);
+
+    //! Append prepared data
     /*!
-    Return a pointer to memory with the next \c n bytes in the buffer
-    (which must be <= getSize()).  The caller must not modify the returned
-    memory nor delete it.
+    Appends the first \c n bytes of the memory returned by the last call
+    to prepare() to the buffer.  \c n must not exceed the size passed to
+    prepare().
     */
-    const void*            peek(UInt32 n);
+    void                commit(UInt32 n);
 
     //! Discard data
     /*!
     Discards the next \c n bytes.  If \c n >= getSize() then the buffer
     is cleared.
     */
-    void                pop(UInt32 n);
+    void                consume(UInt32 n);
 
     //! Write data to buffer
     /*!
@@ -59,6 +73,14 @@ public:
     //! @name accessors
     //@{
 
+    //! Read data without removing from buffer
+    /*!
+    Return a pointer to all getSize() bytes in the buffer, or NULL if the
+    buffer is empty.  The caller must not modify the returned memory nor
+    delete it.  The pointer is invalidated by any manipulator.
+    */
+    const void*            data() const;
+
     //! Get size of buffer
     /*!
     Returns the number of bytes in the buffer.
@@ -68,12 +90,13 @@ public:
     //@}
 
 private:
-    static const UInt32    kChunkSize;
-
-    typedef std::vector<UInt8> Chunk;
-    typedef std::list<Chunk> ChunkList;
+    static const UInt32    kMinCapacity;
+    static const UInt32    kMaxIdleCapacity;
+    static const UInt32    kMaxCapacity;
 
-    ChunkList            m_chunks;
-    UInt32                m_size;
-    UInt32                m_headUsed;
+    std::unique_ptr<UInt8[]>    m_buffer;
+    UInt32                m_capacity;
+    UInt32                m_head;
+    UInt32                m_tail;
+    UInt32                m_prepared;
 };
@@ -23,11 +23,14 @@
 #include "net/TSocketMultiplexerMethodJob.h"
 #include "arch/XArch.h"
 #include "common/DataDirectories.h"
+#include "base/Log.h"
 #include "base/String.h"
 
 static const char s_certificateDir[] = { "SSL" };
 static const char s_certificateFilename[] = { "Barrier.pem" };
 
+const int SecureListenSocket::kMaxPendingHandshakes = 32;
+
 //
 // SecureListenSocket
 //
@@ -36,8 +39,17 @@ SecureListenSocket::SecureListenSocket(
         IEventQueue* events,
         SocketMultiplexer* socketMultiplexer,
         IArchNetwork::EAddressFamily family) :
-    TCPListenSocket(events, socketMultiplexer, family)
+    TCPListenSocket(events, socketMultiplexer, family),
+    m_handshakeTimeout(SecureSocket::kHandshakeTimeout),
+    m_maxPendingHandshakes(kMaxPendingHandshakes)
+{
+}
+
+void
+SecureListenSocket::setHandshakeLimits(double timeout, int maxPending)
 {
+    m_handshakeTimeout     = timeout;
+    m_maxPendingHandshakes = maxPending;
 }
 
 IDataSocket*
@@ -45,6 +57,16 @@ SecureListenSocket::accept()
 {
     SecureSocket* socket = NULL;
     try {
+        if (SecureSocket::getPendingAccepts() >= m_maxPendingHandshakes) {
+            ArchSocket refused = ARCH->acceptSocket(m_socket, NULL);
+            if (refused != NULL) {
+                ARCH->closeSocket(refused);
+            }
+            setListeningJob();
+            LOG((CLOG_WARN "too many secure handshakes in progress, refused connection"));
+            return NULL;
+        }
+
         socket = new SecureSocket(
                         m_events,
                         m_socketMultiplexer,
@@ -66,6 +88,7 @@ SecureListenSocket::accept()
             return NULL;
         }
 
+        socket->setHandshakeTimeout(m_handshakeTimeout);
         socket->secureAccept();
 
         return dynamic_cast<IDataSocket*>(socket);
@@ -30,7 +30,23 @@ public:
         SocketMultiplexer* socketMultiplexer,
         IArchNetwork::EAddressFamily family);
 
+    //! Default cap on accepted sockets still in their handshake
+    static const int    kMaxPendingHandshakes;
+
+    //! Set the handshake limits
+    /*!
+    Accepted sockets must finish their handshake within \c timeout
+    seconds.  While \c maxPending accepted sockets are in their
+    handshake, further connections are closed as soon as they're
+    accepted so they can't hold up the connected ones.
+    */
+    void                setHandshakeLimits(double timeout, int maxPending);
+
     // IListenSocket overrides
     virtual IDataSocket*
                         accept();
+
+private:
+    double                m_handshakeTimeout;
+    int                    m_maxPendingHandshakes;
 };
@@ -20,6 +20,8 @@
 #include "net/TSocketMultiplexerMethodJob.h"
 #include "base/TMethodEventJob.h"
 #include "net/TCPSocket.h"
+#include "net/NetworkAddress.h"
+#include "base/IEventQueue.h"
 #include "mt/Lock.h"
 #include "arch/XArch.h"
 #include "base/Log.h"
@@ -28,11 +30,35 @@
 
 #include <openssl/ssl.h>
 #include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+#include <cstdio>
 #include <cstring>
+#include <climits>
 #include <cstdlib>
+#include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <fstream>
 #include <memory>
+#include <vector>
+
+#ifdef SYSAPI_WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <windows.h>
+#include <sddl.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+#define SSL_SESSION_up_ref(session) \
+    CRYPTO_add(&(session)->references, 1, CRYPTO_LOCK_SSL_SESSION)
+#endif
 
 //
 // SecureSocket
@@ -40,7 +66,7 @@
 
 #define MAX_ERROR_SIZE 65535
 
-static const float s_retryDelay = 0.01f;
+const double SecureSocket::kHandshakeTimeout = 10.0;
 
 enum {
     kMsgSize = 128
@@ -51,11 +77,207 @@ static const char kFingerprintDirName[] = "SSL/Fingerprints";
 static const char kFingerprintTrustedServersFilename[] = "TrustedServers.txt";
 //static const char kFingerprintTrustedClientsFilename[] = "TrustedClients.txt";
 
+static const char kSessionFilename[] = "SSL/Session.pem";
+
 struct Ssl {
     SSL_CTX*    m_context;
     SSL*        m_ssl;
 };
 
+//
+// TLS session resumption
+//
+// the server encrypts session tickets with a key made at startup and
+// shared by every accepted socket, so it holds no per-session state.
+// the client keeps the last session for each server in memory and the
+// latest one on disk so a restarted client can resume too.
+//
+
+namespace {
+
+// accepted sockets still in their handshake
+std::atomic<int> s_pendingAccepts(0);
+
+std::mutex s_sessionMutex;
+
+// never freed; they may be needed up to exit
+std::map<std::string, SSL_SESSION*> s_sessions;
+
+std::string
+sessionFilename()
+{
+    return barrier::string::sprintf("%s/%s",
+                            DataDirectories::profile().c_str(),
+                            kSessionFilename);
+}
+
+// returns a reference the caller must free
+SSL_SESSION*
+findSession(const std::string& server)
+{
+    std::lock_guard<std::mutex> lock(s_sessionMutex);
+    auto index = s_sessions.find(server);
+    if (index != s_sessions.end()) {
+        SSL_SESSION_up_ref(index->second);
+        return index->second;
+    }
+
+    // the file starts with the server it's for
+    SSL_SESSION* session = NULL;
+    FILE* file = fopen(sessionFilename().c_str(), "r");
+    if (file != NULL) {
+        char line[256];
+        if (fgets(line, sizeof(line), file) != NULL &&
+            server + "\n" == line) {
+            session = PEM_read_SSL_SESSION(file, NULL, NULL, NULL);
+        }
+        fclose(file);
+    }
+    if (session != NULL) {
+        SSL_SESSION_up_ref(session);
+        s_sessions[server] = session;
+    }
+    return session;
+}
+
+// creates a file only the user can read.  an existing file is removed
+// first so its permissions aren't kept.
+FILE*
+createPrivateFile(const std::string& path)
+{
+    remove(path.c_str());
+#ifdef SYSAPI_WIN32
+    // a protected DACL that only grants the owner access, so the file
+    // doesn't inherit the directory's permissions
+    PSECURITY_DESCRIPTOR descriptor = NULL;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorA(
+                            "D:P(A;;FA;;;OW)", SDDL_REVISION_1,
+                            &descriptor, NULL)) {
+        return NULL;
+    }
+    SECURITY_ATTRIBUTES security;
+    security.nLength              = sizeof(security);
+    security.lpSecurityDescriptor = descriptor;
+    security.bInheritHandle       = FALSE;
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_WRITE, 0, &security,
+                            CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+    LocalFree(descriptor);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    int fd = _open_osfhandle(reinterpret_cast<intptr_t>(handle), _O_WRONLY);
+    if (fd < 0) {
+        CloseHandle(handle);
+        return NULL;
+    }
+    FILE* file = _fdopen(fd, "w");
+    if (file == NULL) {
+        _close(fd);
+    }
+#else
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return NULL;
+    }
+    FILE* file = fdopen(fd, "w");
+    if (file == NULL) {
+        close(fd);
+    }
+#endif
+    return file;
+}
+
+bool
+replaceFile(const std::string& from, const std::string& to)
+{
+#ifdef SYSAPI_WIN32
+    return (MoveFileExA(from.c_str(), to.c_str(),
+                            MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+    return (rename(from.c_str(), to.c_str()) == 0);
+#endif
+}
+
+// adopts session
+void
+saveSession(const std::string& server, SSL_SESSION* session)
+{
+    std::lock_guard<std::mutex> lock(s_sessionMutex);
+    SSL_SESSION*& entry = s_sessions[server];
+    if (entry != NULL) {
+        SSL_SESSION_free(entry);
+    }
+    entry = session;
+
+    // the session holds the resumption secret.  it's written aside and
+    // moved over the old one so a crash can't leave half a file.
+    std::string filename  = sessionFilename();
+    std::string temporary = filename + ".tmp";
+    FILE* file = createPrivateFile(temporary);
+    if (file == NULL) {
+        LOG((CLOG_DEBUG "unable to save secure session to %s", temporary.c_str()));
+        return;
+    }
+    bool written = (fprintf(file, "%s\n", server.c_str()) > 0 &&
+                    PEM_write_SSL_SESSION(file, session) == 1);
+    written = (fclose(file) == 0 && written);
+    if (!written || !replaceFile(temporary, filename)) {
+        LOG((CLOG_DEBUG "unable to save secure session to %s", filename.c_str()));
+        remove(temporary.c_str());
+    }
+}
+
+void
+forgetSession(const std::string& server)
+{
+    std::lock_guard<std::mutex> lock(s_sessionMutex);
+    auto index = s_sessions.find(server);
+    if (index != s_sessions.end()) {
+        SSL_SESSION_free(index->second);
+        s_sessions.erase(index);
+    }
+    remove(sessionFilename().c_str());
+}
+
+// called by openssl when the server sends a session, which with TLS 1.3
+// is after the handshake
+int
+handleNewSession(SSL* ssl, SSL_SESSION* session)
+{
+    const std::string* server =
+                            static_cast<const std::string*>(SSL_get_app_data(ssl));
+    if (server == NULL || server->empty()) {
+        return 0;
+    }
+    LOG((CLOG_DEBUG1 "saving secure session for %s", server->c_str()));
+    saveSession(*server, session);
+    return 1;
+}
+
+// tickets from one accepted socket are good for the next
+void
+setTicketKeys(SSL_CTX* context)
+{
+    static std::once_flag s_once;
+    static std::vector<unsigned char> s_keys;
+    std::call_once(s_once, [context] {
+        long size = SSL_CTX_get_tlsext_ticket_keys(context, NULL, 0);
+        if (size > 0) {
+            s_keys.resize(size);
+            if (RAND_bytes(s_keys.data(), (int)size) != 1) {
+                s_keys.clear();
+            }
+        }
+    });
+
+    if (!s_keys.empty()) {
+        SSL_CTX_set_tlsext_ticket_keys(context, s_keys.data(),
+                            (long)s_keys.size());
+    }
+}
+
+}
+
 SecureSocket::SecureSocket(
         IEventQueue* events,
         SocketMultiplexer* socketMultiplexer,
@@ -63,7 +285,11 @@ SecureSocket::SecureSocket(
     TCPSocket(events, socketMultiplexer, family),
     m_ssl(nullptr),
     m_secureReady(false),
-    m_fatal(false)
+    m_fatal(false),
+    m_writeRetrySize(0),
+    m_handshakeTimeout(kHandshakeTimeout),
+    m_handshakeTimer(NULL),
+    m_acceptPending(false)
 {
 }
 
@@ -74,7 +300,11 @@ SecureSocket::SecureSocket(
     TCPSocket(events, socketMultiplexer, socket),
     m_ssl(nullptr),
     m_secureReady(false),
-    m_fatal(false)
+    m_fatal(false),
+    m_writeRetrySize(0),
+    m_handshakeTimeout(kHandshakeTimeout),
+    m_handshakeTimer(NULL),
+    m_acceptPending(false)
 {
 }
 
@@ -85,6 +315,7 @@ SecureSocket::~SecureSocket()
     // could cause events to get called on a dead object. TCPSocket
     // will do this, too, but the double-call is harmless
     removeJob();
+    stopHandshake();
     freeSSLResources();
 
     // removing sleep() because I have no idea why you would want to do it
@@ -97,6 +328,7 @@ void
 SecureSocket::close()
 {
     isFatal(true);
+    stopHandshake();
     freeSSLResources();
     TCPSocket::close();
 }
@@ -123,6 +355,9 @@ SecureSocket::connect(const NetworkAddress& addr)
                 new TMethodEventJob<SecureSocket>(this,
                         &SecureSocket::handleTCPConnected));
 
+    m_sessionKey = barrier::string::sprintf("%s:%d",
+                            addr.getHostname().c_str(), addr.getPort());
+
     TCPSocket::connect(addr);
 }
 
@@ -140,29 +375,51 @@ std::unique_ptr<ISocketMultiplexerJob> SecureSocket::newJob()
 void
 SecureSocket::secureConnect()
 {
+    Lock lock(&getMutex());
+    startHandshake();
+
+    // the client speaks first
     setJob(std::make_unique<TSocketMultiplexerMethodJob<SecureSocket>>(
                     this, &SecureSocket::serviceConnect,
-                    getSocket(), isReadable(), isWritable()));
+                    getSocket(), false, true));
 }
 
 void
 SecureSocket::secureAccept()
 {
+    Lock lock(&getMutex());
+    startHandshake();
+    m_acceptPending = true;
+    ++s_pendingAccepts;
+
     setJob(std::make_unique<TSocketMultiplexerMethodJob<SecureSocket>>(
                     this, &SecureSocket::serviceAccept,
-                    getSocket(), isReadable(), isWritable()));
+                    getSocket(), true, false));
+}
+
+void
+SecureSocket::setHandshakeTimeout(double seconds)
+{
+    m_handshakeTimeout = seconds;
+}
+
+int
+SecureSocket::getPendingAccepts()
+{
+    return s_pendingAccepts;
 }
 
 TCPSocket::EJobResult
 SecureSocket::doRead()
 {
-    static UInt8 buffer[4096];
-    memset(buffer, 0, sizeof(buffer));
     int bytesRead = 0;
     int status = 0;
 
+    // decrypt straight into the input buffer
+    bool wasEmpty = (m_inputBuffer.getSize() == 0);
     if (isSecureReady()) {
-        status = secureRead(buffer, sizeof(buffer), bytesRead);
+        status = secureRead(m_inputBuffer.prepare(kReadSize),
+                            kReadSize, bytesRead);
         if (status < 0) {
             return kBreak;
         }
@@ -175,13 +432,12 @@ SecureSocket::doRead()
     }
 
     if (bytesRead > 0) {
-        bool wasEmpty = (m_inputBuffer.getSize() == 0);
-
         // slurp up as much as possible
         do {
-            m_inputBuffer.write(buffer, bytesRead);
+            m_inputBuffer.commit(bytesRead);
 
-            status = secureRead(buffer, sizeof(buffer), bytesRead);
+            status = secureRead(m_inputBuffer.prepare(kReadSize),
+                                kReadSize, bytesRead);
             if (status < 0) {
                 return kBreak;
             }
@@ -211,49 +467,34 @@ SecureSocket::doRead()
 TCPSocket::EJobResult
 SecureSocket::doWrite()
 {
-    static bool s_retry = false;
-    static int s_retrySize = 0;
-    static std::unique_ptr<char[]> s_staticBuffer;
-    static std::size_t s_staticBufferSize = 0;
-
-    // write data
-    int bufferSize = 0;
-    int bytesWrote = 0;
-    int status = 0;
-
     if (!isSecureReady())
         return kRetry;
 
-    if (s_retry) {
-        bufferSize = s_retrySize;
-    } else {
+    // encrypt straight from the output buffer.  a write that wants to be
+    // retried must be repeated with the same length; the buffer may have
+    // moved or grown since but the bytes already handed over are unchanged.
+    std::size_t bufferSize = m_writeRetrySize;
+    if (bufferSize == 0) {
         bufferSize = m_outputBuffer.getSize();
-        if (bufferSize > s_staticBufferSize) {
-            s_staticBuffer.reset(new char[bufferSize]);
-            s_staticBufferSize = bufferSize;
-        }
-        if (bufferSize > 0) {
-            memcpy(s_staticBuffer.get(), m_outputBuffer.peek(bufferSize), bufferSize);
-        }
     }
 
     if (bufferSize == 0) {
         return kRetry;
     }
 
-    status = secureWrite(s_staticBuffer.get(), bufferSize, bytesWrote);
+    std::size_t bytesWrote = 0;
+    int status = secureWrite(m_outputBuffer.data(), bufferSize, bytesWrote);
     if (status > 0) {
-        s_retry = false;
+        m_writeRetrySize = 0;
     } else if (status < 0) {
         return kBreak;
     } else if (status == 0) {
-        s_retry = true;
-        s_retrySize = bufferSize;
+        m_writeRetrySize = bufferSize;
         return kNew;
     }
 
     if (bytesWrote > 0) {
-        discardWrittenData(bytesWrote);
+        discardWrittenData(static_cast<int>(bytesWrote));
         return kNew;
     }
 
@@ -267,7 +508,7 @@ SecureSocket::secureRead(void* buffer, int size, int& read)
         LOG((CLOG_DEBUG2 "reading secure socket"));
         read = SSL_read(m_ssl->m_ssl, buffer, size);
 
-        static int retry;
+        int retry = 0;
 
         // Check result will cleanup the connection in the case of a fatal
         checkResult(read, retry);
@@ -287,17 +528,28 @@ SecureSocket::secureRead(void* buffer, int size, int& read)
 }
 
 int
-SecureSocket::secureWrite(const void* buffer, int size, int& wrote)
+SecureSocket::secureWrite(const void* buffer, std::size_t size, std::size_t& wrote)
 {
+    int result = 0;
     if (m_ssl->m_ssl != NULL) {
         LOG((CLOG_DEBUG2 "writing secure socket:%p", this));
 
-        wrote = SSL_write(m_ssl->m_ssl, buffer, size);
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+        wrote = 0;
+        result = SSL_write_ex(m_ssl->m_ssl, buffer, size, &wrote) == 1 ?
+                            static_cast<int>(wrote) : -1;
+#else
+        // older libraries take an int so write what fits, the rest goes
+        // on the next pass
+        int n = size > INT_MAX ? INT_MAX : static_cast<int>(size);
+        result = SSL_write(m_ssl->m_ssl, buffer, n);
+        wrote = result > 0 ? static_cast<std::size_t>(result) : 0;
+#endif
 
-        static int retry;
+        int retry = 0;
 
         // Check result will cleanup the connection in the case of a fatal
-        checkResult(wrote, retry);
+        checkResult(result, retry);
 
         if (retry) {
             return 0;
@@ -310,7 +562,7 @@ SecureSocket::secureWrite(const void* buffer, int size, int& wrote)
     // According to SSL spec, r must not be negative and not have an error code
     // from SSL_get_error(). If this happens, it is itself an error. Let the
     // parent handle the case
-    return wrote;
+    return result;
 }
 
 bool
@@ -319,6 +571,13 @@ SecureSocket::isSecureReady()
     return m_secureReady;
 }
 
+bool
+SecureSocket::isSessionReused() const
+{
+    return m_ssl != NULL && m_ssl->m_ssl != NULL &&
+            SSL_session_reused(m_ssl->m_ssl) == 1;
+}
+
 void
 SecureSocket::initSsl(bool server)
 {
@@ -365,6 +624,16 @@ bool SecureSocket::loadCertificates(const std::string& filename)
         return false;
     }
 
+    // sessions only resume with the certificate they were made with
+    unsigned char fingerprint[EVP_MAX_MD_SIZE];
+    unsigned int fingerprintLen = 0;
+    X509* cert = SSL_CTX_get0_certificate(m_ssl->m_context);
+    if (cert != NULL &&
+        X509_digest(cert, EVP_sha1(), fingerprint, &fingerprintLen) > 0) {
+        SSL_CTX_set_session_id_context(m_ssl->m_context, fingerprint,
+                            fingerprintLen);
+    }
+
     return true;
 }
 
@@ -397,11 +666,22 @@ SecureSocket::initContext(bool server)
     SSL_METHOD* m = const_cast<SSL_METHOD*>(method);
     m_ssl->m_context = SSL_CTX_new(m);
 
+    if (m_ssl->m_context == NULL) {
+        showError("");
+        return;
+    }
+
     // drop SSLv3 support
     SSL_CTX_set_options(m_ssl->m_context, SSL_OP_NO_SSLv3);
 
-    if (m_ssl->m_context == NULL) {
-        showError("");
+    // resume earlier sessions instead of a full handshake
+    if (server) {
+        setTicketKeys(m_ssl->m_context);
+    }
+    else {
+        SSL_CTX_set_session_cache_mode(m_ssl->m_context,
+                            SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(m_ssl->m_context, &handleNewSession);
     }
 }
 
@@ -413,6 +693,21 @@ SecureSocket::createSSL()
     if (m_ssl->m_ssl == NULL) {
         assert(m_ssl->m_context != NULL);
         m_ssl->m_ssl = SSL_new(m_ssl->m_context);
+
+        // let doWrite() hand over whatever the output buffer holds, from
+        // wherever it lives now
+        SSL_set_mode(m_ssl->m_ssl, SSL_MODE_ENABLE_PARTIAL_WRITE |
+                            SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+        // offer the last session with this server
+        SSL_set_app_data(m_ssl->m_ssl, &m_sessionKey);
+        if (!m_sessionKey.empty()) {
+            SSL_SESSION* session = findSession(m_sessionKey);
+            if (session != NULL) {
+                SSL_set_session(m_ssl->m_ssl, session);
+                SSL_SESSION_free(session);
+            }
+        }
     }
 }
 
@@ -427,42 +722,33 @@ SecureSocket::secureAccept(int socket)
     LOG((CLOG_DEBUG2 "accepting secure socket"));
     int r = SSL_accept(m_ssl->m_ssl);
 
-    static int retry;
+    int retry = 0;
 
     checkResult(r, retry);
 
     if (isFatal()) {
-        // tell user and sleep so the socket isn't hammered.
         LOG((CLOG_ERR "failed to accept secure socket"));
         LOG((CLOG_INFO "client connection may not be secure"));
         m_secureReady = false;
-        ARCH->sleep(1);
-        retry = 0;
         return -1; // Failed, error out
     }
 
-    // If not fatal and no retry, state is good
-    if (retry == 0) {
-        m_secureReady = true;
-        LOG((CLOG_INFO "accepted secure socket"));
-        if (CLOG->getFilter() >= kDEBUG1) {
-            showSecureCipherInfo();
-        }
-        showSecureConnectInfo();
-        return 1;
-    }
-
     // If not fatal and retry is set, not ready, and return retry
     if (retry > 0) {
         LOG((CLOG_DEBUG2 "retry accepting secure socket"));
         m_secureReady = false;
-        ARCH->sleep(s_retryDelay);
         return 0;
     }
 
-    // no good state exists here
-    LOG((CLOG_ERR "unexpected state attempting to accept connection"));
-    return -1;
+    // If not fatal and no retry, state is good
+    m_secureReady = true;
+    LOG((CLOG_INFO "accepted secure socket%s",
+        isSessionReused() ? ", resumed session" : ""));
+    if (CLOG->getFilter() >= kDEBUG1) {
+        showSecureCipherInfo();
+    }
+    showSecureConnectInfo();
+    return 1;
 }
 
 int
@@ -476,13 +762,12 @@ SecureSocket::secureConnect(int socket)
     LOG((CLOG_DEBUG2 "connecting secure socket"));
     int r = SSL_connect(m_ssl->m_ssl);
 
-    static int retry;
+    int retry = 0;
 
     checkResult(r, retry);
 
     if (isFatal()) {
         LOG((CLOG_ERR "failed to connect secure socket"));
-        retry = 0;
         return -1;
     }
 
@@ -490,23 +775,21 @@ SecureSocket::secureConnect(int socket)
     if (retry > 0) {
         LOG((CLOG_DEBUG2 "retry connect secure socket"));
         m_secureReady = false;
-        ARCH->sleep(s_retryDelay);
         return 0;
     }
 
-    retry = 0;
     // No error, set ready, process and return ok
     m_secureReady = true;
     if (verifyCertFingerprint()) {
-        LOG((CLOG_INFO "connected to secure socket"));
+        LOG((CLOG_INFO "connected to secure socket%s",
+            isSessionReused() ? ", resumed session" : ""));
         if (!showCertificate()) {
-            disconnect();
             return -1;// Cert fail, error
         }
     }
     else {
         LOG((CLOG_ERR "failed to verify server certificate fingerprint"));
-        disconnect();
+        forgetSession(m_sessionKey);
         return -1; // Fingerprint failed, error
     }
     LOG((CLOG_DEBUG2 "connected secure socket"));
@@ -617,7 +900,11 @@ SecureSocket::checkResult(int status, int& retry)
     if (isFatal()) {
         retry = 0;
         showError("");
-        disconnect();
+
+        // a failed handshake is disconnected by its job
+        if (m_secureReady) {
+            disconnect();
+        }
     }
 }
 
@@ -741,6 +1028,11 @@ MultiplexerJobStatus SecureSocket::serviceConnect(ISocketMultiplexerJob* job,
 
     Lock lock(&getMutex());
 
+    // the handshake timed out
+    if (isFatal()) {
+        return {false, {}};
+    }
+
     int status = 0;
 #ifdef SYSAPI_WIN32
     status = secureConnect(static_cast<int>(getSocket()->m_socket));
@@ -750,22 +1042,20 @@ MultiplexerJobStatus SecureSocket::serviceConnect(ISocketMultiplexerJob* job,
 
     // If status < 0, error happened
     if (status < 0) {
+        stopHandshake();
+        disconnect();
         return {false, {}};
     }
 
     // If status > 0, success
     if (status > 0) {
+        stopHandshake();
         sendEvent(m_events->forIDataSocket().secureConnected());
         return newJobOrStopServicing();
     }
 
     // Retry case
-    return {
-        true,
-        std::make_unique<TSocketMultiplexerMethodJob<SecureSocket>>(
-            this, &SecureSocket::serviceConnect,
-            getSocket(), isReadable(), isWritable())
-    };
+    return {true, newHandshakeJob(&SecureSocket::serviceConnect)};
 }
 
 MultiplexerJobStatus SecureSocket::serviceAccept(ISocketMultiplexerJob* job,
@@ -774,27 +1064,88 @@ MultiplexerJobStatus SecureSocket::serviceAccept(ISocketMultiplexerJob* job,
     (void) read;
     Lock lock(&getMutex());
 
+    // the handshake timed out
+    if (isFatal()) {
+        return {false, {}};
+    }
+
     int status = 0;
 #ifdef SYSAPI_WIN32
     status = secureAccept(static_cast<int>(getSocket()->m_socket));
 #elif SYSAPI_UNIX
     status = secureAccept(getSocket()->m_fd);
 #endif
-        // If status < 0, error happened
+    // If status < 0, error happened
     if (status < 0) {
+        stopHandshake();
+        disconnect();
         return {false, {}};
     }
 
     // If status > 0, success
     if (status > 0) {
+        stopHandshake();
         sendEvent(m_events->forClientListener().accepted());
         return newJobOrStopServicing();
     }
 
     // Retry case
-    return {true, std::make_unique<TSocketMultiplexerMethodJob<SecureSocket>>(
-            this, &SecureSocket::serviceAccept,
-            getSocket(), isReadable(), isWritable())};
+    return {true, newHandshakeJob(&SecureSocket::serviceAccept)};
+}
+
+std::unique_ptr<ISocketMultiplexerJob>
+SecureSocket::newHandshakeJob(ServiceMethod method)
+{
+    // wait for whatever the handshake is blocked on instead of polling
+    bool wantWrite = (SSL_want_write(m_ssl->m_ssl) != 0);
+    return std::make_unique<TSocketMultiplexerMethodJob<SecureSocket>>(
+                    this, method, getSocket(), !wantWrite, wantWrite);
+}
+
+void
+SecureSocket::startHandshake()
+{
+    // note -- must have the mutex locked on entry
+    if (m_handshakeTimer == NULL) {
+        m_handshakeTimer = m_events->newOneShotTimer(m_handshakeTimeout, NULL);
+        m_events->adoptHandler(Event::kTimer, m_handshakeTimer,
+                    new TMethodEventJob<SecureSocket>(this,
+                        &SecureSocket::handleHandshakeTimeout));
+    }
+}
+
+void
+SecureSocket::stopHandshake()
+{
+    // note -- must have the mutex locked on entry, or be in the destructor
+    if (m_handshakeTimer != NULL) {
+        m_events->removeHandler(Event::kTimer, m_handshakeTimer);
+        m_events->deleteTimer(m_handshakeTimer);
+        m_handshakeTimer = NULL;
+    }
+    if (m_acceptPending) {
+        m_acceptPending = false;
+        --s_pendingAccepts;
+    }
+}
+
+void
+SecureSocket::handleHandshakeTimeout(const Event&, void*)
+{
+    {
+        Lock lock(&getMutex());
+        if (m_handshakeTimer == NULL) {
+            // finished while the timer event was queued
+            return;
+        }
+        stopHandshake();
+        isFatal(true);
+    }
+
+    // the job sees the socket is fatal if it runs before it's removed
+    LOG((CLOG_WARN "secure handshake timed out"));
+    removeJob();
+    disconnect();
 }
 
 void
@@ -23,6 +23,7 @@
 class IEventQueue;
 class SocketMultiplexer;
 class ISocketMultiplexerJob;
+class EventQueueTimer;
 
 struct Ssl;
 
@@ -32,6 +33,9 @@ A secure socket using SSL.
 */
 class SecureSocket : public TCPSocket {
 public:
+    //! Default handshake timeout in seconds
+    static const double    kHandshakeTimeout;
+
     SecureSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer, IArchNetwork::EAddressFamily family);
     SecureSocket(IEventQueue* events,
         SocketMultiplexer* socketMultiplexer,
@@ -48,10 +52,25 @@ public:
     bool                isFatal() const override { return m_fatal; }
     void                isFatal(bool b) { m_fatal = b; }
     bool                isSecureReady();
+
+    //! Test if the handshake resumed an earlier session
+    bool                isSessionReused() const;
     void                secureConnect();
     void                secureAccept();
+
+    //! Set the handshake timeout
+    /*!
+    A handshake that takes longer than \c seconds from secureConnect() or
+    secureAccept() fails and the socket disconnects.  Defaults to
+    kHandshakeTimeout.
+    */
+    void                setHandshakeTimeout(double seconds);
+
+    //! Get the number of accepted sockets still in their handshake
+    static int            getPendingAccepts();
     int                    secureRead(void* buffer, int size, int& read);
-    int                    secureWrite(const void* buffer, int size, int& wrote);
+    int                    secureWrite(const void* buffer, std::size_t size,
+                            std::size_t& wrote);
     EJobResult            doRead() override;
     EJobResult            doWrite() override;
     void                initSsl(bool server);
@@ -71,8 +90,16 @@ private:
     void formatFingerprint(std::string& fingerprint, bool hex = true, bool separator = true);
     bool                verifyCertFingerprint();
 
+    typedef MultiplexerJobStatus (SecureSocket::*ServiceMethod)(
+                            ISocketMultiplexerJob*, bool, bool, bool);
+
     MultiplexerJobStatus serviceConnect(ISocketMultiplexerJob*, bool, bool, bool);
     MultiplexerJobStatus serviceAccept(ISocketMultiplexerJob*, bool, bool, bool);
+    std::unique_ptr<ISocketMultiplexerJob> newHandshakeJob(ServiceMethod);
+
+    void                startHandshake();
+    void                stopHandshake();
+    void                handleHandshakeTimeout(const Event&, void*);
 
     void                showSecureConnectInfo();
     void                showSecureLibInfo();
@@ -86,4 +113,16 @@ private:
     Ssl*                m_ssl;
     bool                m_secureReady;
     bool                m_fatal;
+
+    // length of the last write if it has to be retried, otherwise 0
+    std::size_t            m_writeRetrySize;
+
+    // the server a client socket connects to, for session resumption
+    std::string            m_sessionKey;
+
+    double                m_handshakeTimeout;
+    EventQueueTimer*    m_handshakeTimer;
+
+    // true while counted in getPendingAccepts()
+    bool                m_acceptPending;
 };
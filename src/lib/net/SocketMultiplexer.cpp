@@ -33,30 +33,39 @@
 // SocketMultiplexer
 //
 
-class CursorMultiplexerJob : public ISocketMultiplexerJob {
-public:
-    MultiplexerJobStatus run(bool readable, bool writable, bool error) override
-    {
-        return {false, {}};
+static
+unsigned short
+getPollEvents(const ISocketMultiplexerJob* job)
+{
+    unsigned short events = 0;
+    if (job->isReadable()) {
+        events |= IArchNetwork::kPOLLIN;
     }
-
-    ArchSocket getSocket() const override { return {}; }
-    bool isReadable() const override { return false; }
-    bool isWritable() const override { return false; }
-    bool isCursor() const override { return true; }
-};
+    if (job->isWritable()) {
+        events |= IArchNetwork::kPOLLOUT;
+    }
+    return events;
+}
 
 
-SocketMultiplexer::SocketMultiplexer() :
+SocketMultiplexer::SocketMultiplexer(bool usePollSet) :
     m_mutex(new Mutex),
     m_thread(NULL),
     m_update(false),
-    m_jobsReady(new CondVar<bool>(m_mutex, false)),
-    m_jobListLock(new CondVar<bool>(m_mutex, false)),
-    m_jobListLockLocked(new CondVar<bool>(m_mutex, false)),
-    m_jobListLocker(NULL),
-    m_jobListLockLocker(NULL)
+    m_commandsQueued(0),
+    m_commandsReady(new CondVar<bool>(m_mutex, false)),
+    m_commandsApplied(new CondVar<UInt32>(m_mutex, 0)),
+    m_pollSet(NULL)
 {
+    if (usePollSet) {
+        try {
+            m_pollSet = ARCH->newPollSet();
+        }
+        catch (XArchNetwork& e) {
+            LOG((CLOG_WARN "cannot create poll set, using poll: %s", e.what()));
+        }
+    }
+
     // start thread
     m_thread = new Thread(new TMethodJob<SocketMultiplexer>(
                                 this, &SocketMultiplexer::serviceThread));
@@ -68,12 +77,12 @@ SocketMultiplexer::~SocketMultiplexer()
     m_thread->unblockPollSocket();
     m_thread->wait();
     delete m_thread;
-    delete m_jobsReady;
-    delete m_jobListLock;
-    delete m_jobListLockLocked;
-    delete m_jobListLocker;
-    delete m_jobListLockLocker;
+    delete m_commandsReady;
+    delete m_commandsApplied;
     delete m_mutex;
+    if (m_pollSet != NULL) {
+        ARCH->closePollSet(m_pollSet);
+    }
 }
 
 void SocketMultiplexer::addSocket(ISocket* socket, std::unique_ptr<ISocketMultiplexerJob>&& job)
@@ -81,32 +90,8 @@ void SocketMultiplexer::addSocket(ISocket* socket, std::unique_ptr<ISocketMultip
     assert(socket != NULL);
     assert(job    != NULL);
 
-    // prevent other threads from locking the job list
-    lockJobListLock();
-
-    // break thread out of poll
-    m_thread->unblockPollSocket();
-
-    // lock the job list
-    lockJobList();
-
-    // insert/replace job
-    SocketJobMap::iterator i = m_socketJobMap.find(socket);
-    if (i == m_socketJobMap.end()) {
-        // we *must* put the job at the end so the order of jobs in
-        // the list continue to match the order of jobs in pfds in
-        // serviceThread().
-        JobCursor j = m_socketJobs.insert(m_socketJobs.end(), std::move(job));
-        m_update     = true;
-        m_socketJobMap.insert(std::make_pair(socket, j));
-    }
-    else {
-        *(i->second) = std::move(job);
-        m_update = true;
-    }
-
-    // unlock the job list
-    unlockJobList();
+    // the service thread installs the job before it next polls
+    queueCommand(socket, std::move(job));
 }
 
 void
@@ -114,235 +99,278 @@ SocketMultiplexer::removeSocket(ISocket* socket)
 {
     assert(socket != NULL);
 
-    // prevent other threads from locking the job list
-    lockJobListLock();
+    UInt32 sequence = queueCommand(socket, NULL);
 
-    // break thread out of poll
-    m_thread->unblockPollSocket();
-
-    // lock the job list
-    lockJobList();
-
-    // remove job.  rather than removing it from the map we put NULL
-    // in the list instead so the order of jobs in the list continues
-    // to match the order of jobs in pfds in serviceThread().
-    SocketJobMap::iterator i = m_socketJobMap.find(socket);
-    if (i != m_socketJobMap.end()) {
-        if (*(i->second)) {
-            i->second->reset();
-            m_update = true;
-        }
+    // a job removing a socket can't wait for the service thread, which
+    // is running it.  the removal is applied before any more jobs run.
+    if (Thread::getCurrentThread() == *m_thread) {
+        return;
     }
 
-    // unlock the job list
-    unlockJobList();
+    // wait until the job is gone so the caller can safely destroy
+    // anything the job refers to
+    Lock lock(m_mutex);
+    while (static_cast<SInt32>(
+                static_cast<UInt32>(*m_commandsApplied) - sequence) < 0) {
+        m_commandsApplied->wait();
+    }
 }
 
 void
 SocketMultiplexer::serviceThread(void*)
 {
     std::vector<IArchNetwork::PollEntry> pfds;
-    IArchNetwork::PollEntry pfd;
+    std::vector<IArchNetwork::PollSetEntry> ready;
+    JobCommands commands;
 
     // service the connections
     for (;;) {
         Thread::testCancel();
 
-        // wait until there are jobs to handle
+        // wait until there are jobs to handle or changes to make and
+        // take the queued changes
+        UInt32 sequence;
         {
             Lock lock(m_mutex);
-            while (!(bool)*m_jobsReady) {
-                m_jobsReady->wait();
+            while (!(bool)*m_commandsReady && m_socketJobMap.empty()) {
+                m_commandsReady->wait();
             }
+            *m_commandsReady = false;
+            commands.swap(m_commands);
+            sequence = m_commandsQueued;
         }
 
-        // lock the job list
-        lockJobListLock();
-        lockJobList();
-
-        // collect poll entries
-        if (m_update) {
-            m_update = false;
-            pfds.clear();
-            pfds.reserve(m_socketJobMap.size());
-
-            JobCursor cursor    = newCursor();
-            JobCursor jobCursor = nextCursor(cursor);
-            while (jobCursor != m_socketJobs.end()) {
-                if (*jobCursor) {
-                    pfd.m_socket = (*jobCursor)->getSocket();
-                    pfd.m_events = 0;
-                    if ((*jobCursor)->isReadable()) {
-                        pfd.m_events |= IArchNetwork::kPOLLIN;
-                    }
-                    if ((*jobCursor)->isWritable()) {
-                        pfd.m_events |= IArchNetwork::kPOLLOUT;
-                    }
-                    pfds.push_back(pfd);
-                }
-                jobCursor = nextCursor(cursor);
-            }
-            deleteCursor(cursor);
+        // apply them and release any threads waiting on them
+        if (!commands.empty()) {
+            applyCommands(commands);
+            commands.clear();
+
+            Lock lock(m_mutex);
+            *m_commandsApplied = sequence;
+            m_commandsApplied->broadcast();
         }
 
-        int status;
-        try {
-            // check for status
-            if (!pfds.empty()) {
-                status = ARCH->pollSocket(&pfds[0], (int)pfds.size(), -1);
-            }
-            else {
-                status = 0;
-            }
+        if (m_pollSet != NULL) {
+            serviceReadyJobs(ready);
         }
-        catch (XArchNetwork& e) {
-            LOG((CLOG_WARN "error in socket multiplexer: %s", e.what()));
-            status = 0;
+        else {
+            serviceJobs(pfds);
         }
+    }
+}
 
-        if (status != 0) {
-            // iterate over socket jobs, invoking each and saving the
-            // new job.
-            UInt32 i             = 0;
-            JobCursor cursor    = newCursor();
-            JobCursor jobCursor = nextCursor(cursor);
-            while (i < pfds.size() && jobCursor != m_socketJobs.end()) {
-                if (*jobCursor != NULL) {
-                    // get poll state
-                    unsigned short revents = pfds[i].m_revents;
-                    bool read  = ((revents & IArchNetwork::kPOLLIN) != 0);
-                    bool write = ((revents & IArchNetwork::kPOLLOUT) != 0);
-                    bool error = ((revents & (IArchNetwork::kPOLLERR |
-                                              IArchNetwork::kPOLLNVAL)) != 0);
-
-                    // run job
-                    MultiplexerJobStatus status = (*jobCursor)->run(read, write, error);
-
-                    if (!status.continue_servicing) {
-                        Lock lock(m_mutex);
-                        jobCursor->reset();
-                        m_update = true;
-                    } else if (status.new_job) {
-                        Lock lock(m_mutex);
-                        *jobCursor = std::move(status.new_job);
-                        m_update = true;
-                    }
-                    ++i;
-                }
-
-                // next job
-                jobCursor = nextCursor(cursor);
-            }
-            deleteCursor(cursor);
+UInt32
+SocketMultiplexer::queueCommand(ISocket* socket,
+                std::unique_ptr<ISocketMultiplexerJob>&& job)
+{
+    UInt32 sequence;
+    bool wasEmpty;
+    {
+        Lock lock(m_mutex);
+        wasEmpty = m_commands.empty();
+        m_commands.push_back(JobCommand{socket, std::move(job)});
+        sequence = ++m_commandsQueued;
+        if (wasEmpty) {
+            *m_commandsReady = true;
+            m_commandsReady->signal();
         }
+    }
 
-        // delete any removed socket jobs
-        for (SocketJobMap::iterator i = m_socketJobMap.begin();
-                            i != m_socketJobMap.end();) {
-            if (*(i->second) == NULL) {
-                m_socketJobs.erase(i->second);
-                m_socketJobMap.erase(i++);
-                m_update = true;
+    // break thread out of poll
+    if (wasEmpty) {
+        m_thread->unblockPollSocket();
+    }
+    return sequence;
+}
+
+void
+SocketMultiplexer::applyCommands(JobCommands& commands)
+{
+    for (JobCommands::iterator c = commands.begin(); c != commands.end(); ++c) {
+        ISocket* socket = c->m_socket;
+        SocketJobMap::iterator i = m_socketJobMap.find(socket);
+        if (c->m_job) {
+            if (i == m_socketJobMap.end()) {
+                // insert job.  we *must* put the job at the end so the
+                // order of jobs in the list continues to match the
+                // order of jobs in pfds in serviceJobs().
+                if (m_pollSet != NULL) {
+                    updatePollSet(socket, NULL, c->m_job.get());
+                }
+                JobCursor j = m_socketJobs.insert(m_socketJobs.end(),
+                                    std::move(c->m_job));
+                m_socketJobMap.insert(std::make_pair(socket, j));
             }
             else {
-                ++i;
+                // replace job
+                if (m_pollSet != NULL) {
+                    updatePollSet(socket, i->second->get(), c->m_job.get());
+                }
+                *(i->second) = std::move(c->m_job);
             }
+            m_update = true;
+        }
+        else if (i != m_socketJobMap.end()) {
+            // remove job
+            if (m_pollSet != NULL) {
+                updatePollSet(socket, i->second->get(), NULL);
+            }
+            m_socketJobs.erase(i->second);
+            m_socketJobMap.erase(i);
+            m_update = true;
         }
-
-        // unlock the job list
-        unlockJobList();
     }
 }
 
-SocketMultiplexer::JobCursor
-SocketMultiplexer::newCursor()
+void
+SocketMultiplexer::serviceJobs(std::vector<IArchNetwork::PollEntry>& pfds)
 {
-    Lock lock(m_mutex);
-    return m_socketJobs.insert(m_socketJobs.begin(), std::make_unique<CursorMultiplexerJob>());
-}
+    IArchNetwork::PollEntry pfd;
 
-SocketMultiplexer::JobCursor
-SocketMultiplexer::nextCursor(JobCursor cursor)
-{
-    Lock lock(m_mutex);
-    JobCursor j = m_socketJobs.end();
-    JobCursor i = cursor;
-    while (++i != m_socketJobs.end()) {
-        if (*i && !(*i)->isCursor()) {
-            // found a real job (as opposed to a cursor)
-            j = i;
-
-            // move our cursor just past the job
-            m_socketJobs.splice(++i, m_socketJobs, cursor);
-            break;
+    // collect poll entries
+    if (m_update) {
+        m_update = false;
+        pfds.clear();
+        pfds.reserve(m_socketJobMap.size());
+
+        for (JobCursor jobCursor = m_socketJobs.begin();
+                            jobCursor != m_socketJobs.end(); ++jobCursor) {
+            pfd.m_socket = (*jobCursor)->getSocket();
+            pfd.m_events = getPollEvents(jobCursor->get());
+            pfds.push_back(pfd);
         }
     }
-    return j;
-}
 
-void
-SocketMultiplexer::deleteCursor(JobCursor cursor)
-{
-    Lock lock(m_mutex);
-    m_socketJobs.erase(cursor);
-}
+    int status;
+    try {
+        // check for status
+        if (!pfds.empty()) {
+            status = ARCH->pollSocket(&pfds[0], (int)pfds.size(), -1);
+        }
+        else {
+            status = 0;
+        }
+    }
+    catch (XArchNetwork& e) {
+        LOG((CLOG_WARN "error in socket multiplexer: %s", e.what()));
+        status = 0;
+    }
 
-void
-SocketMultiplexer::lockJobListLock()
-{
-    Lock lock(m_mutex);
+    if (status != 0) {
+        // iterate over socket jobs, invoking each and saving the
+        // new job.  a job that stops servicing is left NULL so the
+        // rest still match pfds and is deleted below.
+        UInt32 i             = 0;
+        JobCursor jobCursor = m_socketJobs.begin();
+        while (i < pfds.size() && jobCursor != m_socketJobs.end()) {
+            // get poll state
+            unsigned short revents = pfds[i].m_revents;
+            bool read  = ((revents & IArchNetwork::kPOLLIN) != 0);
+            bool write = ((revents & IArchNetwork::kPOLLOUT) != 0);
+            bool error = ((revents & (IArchNetwork::kPOLLERR |
+                                      IArchNetwork::kPOLLNVAL)) != 0);
+
+            // run job
+            MultiplexerJobStatus status = (*jobCursor)->run(read, write, error);
+
+            if (!status.continue_servicing) {
+                jobCursor->reset();
+                m_update = true;
+            } else if (status.new_job) {
+                *jobCursor = std::move(status.new_job);
+                m_update = true;
+            }
 
-    // wait for the lock on the lock
-    while (*m_jobListLockLocked) {
-        m_jobListLockLocked->wait();
+            // next job
+            ++i;
+            ++jobCursor;
+        }
     }
 
-    // take ownership of the lock on the lock
-    *m_jobListLockLocked = true;
-    m_jobListLockLocker  = new Thread(Thread::getCurrentThread());
+    // delete any removed socket jobs
+    for (SocketJobMap::iterator i = m_socketJobMap.begin();
+                        i != m_socketJobMap.end();) {
+        if (*(i->second) == NULL) {
+            m_socketJobs.erase(i->second);
+            m_socketJobMap.erase(i++);
+            m_update = true;
+        }
+        else {
+            ++i;
+        }
+    }
 }
 
 void
-SocketMultiplexer::lockJobList()
+SocketMultiplexer::serviceReadyJobs(
+                std::vector<IArchNetwork::PollSetEntry>& ready)
 {
-    Lock lock(m_mutex);
-
-    // make sure we're the one that called lockJobListLock()
-    assert(*m_jobListLockLocker == Thread::getCurrentThread());
-
-    // wait for the job list lock
-    while (*m_jobListLock) {
-        m_jobListLock->wait();
+    // make room for every socket to be ready at once
+    if (ready.size() <= m_socketJobMap.size()) {
+        ready.resize(m_socketJobMap.size() + 1);
     }
 
-    // take ownership of the lock
-    *m_jobListLock      = true;
-    m_jobListLocker     = m_jobListLockLocker;
-    m_jobListLockLocker = NULL;
+    int n;
+    try {
+        n = ARCH->pollSocketSet(m_pollSet, &ready[0], (int)ready.size(), -1);
+    }
+    catch (XArchNetwork& e) {
+        LOG((CLOG_WARN "error in socket multiplexer: %s", e.what()));
+        n = 0;
+    }
 
-    // release the lock on the lock
-    *m_jobListLockLocked = false;
-    m_jobListLockLocked->broadcast();
+    // run the jobs of the ready sockets only
+    for (int k = 0; k < n; ++k) {
+        ISocket* socket = static_cast<ISocket*>(ready[k].m_key);
+        SocketJobMap::iterator i = m_socketJobMap.find(socket);
+        if (i == m_socketJobMap.end()) {
+            continue;
+        }
+        JobCursor jobCursor = i->second;
+
+        // get poll state
+        unsigned short revents = ready[k].m_revents;
+        bool read  = ((revents & IArchNetwork::kPOLLIN) != 0);
+        bool write = ((revents & IArchNetwork::kPOLLOUT) != 0);
+        bool error = ((revents & (IArchNetwork::kPOLLERR |
+                                  IArchNetwork::kPOLLNVAL)) != 0);
+
+        // run job
+        MultiplexerJobStatus status = (*jobCursor)->run(read, write, error);
+
+        if (!status.continue_servicing) {
+            updatePollSet(socket, jobCursor->get(), NULL);
+            m_socketJobs.erase(jobCursor);
+            m_socketJobMap.erase(i);
+        }
+        else if (status.new_job) {
+            updatePollSet(socket, jobCursor->get(), status.new_job.get());
+            *jobCursor = std::move(status.new_job);
+        }
+    }
 }
 
 void
-SocketMultiplexer::unlockJobList()
+SocketMultiplexer::updatePollSet(ISocket* socket,
+                const ISocketMultiplexerJob* oldJob,
+                const ISocketMultiplexerJob* newJob)
 {
-    Lock lock(m_mutex);
-
-    // make sure we're the one that called lockJobList()
-    assert(*m_jobListLocker == Thread::getCurrentThread());
-
-    // release the lock
-    delete m_jobListLocker;
-    m_jobListLocker = NULL;
-    *m_jobListLock  = false;
-    m_jobListLock->signal();
+    try {
+        // the job may be for a different socket object
+        if (oldJob != NULL &&
+            (newJob == NULL || oldJob->getSocket() != newJob->getSocket())) {
+            ARCH->removePollSetSocket(m_pollSet, oldJob->getSocket());
+            oldJob = NULL;
+        }
 
-    // set new jobs ready state
-    bool isReady = !m_socketJobMap.empty();
-    if (*m_jobsReady != isReady) {
-        *m_jobsReady = isReady;
-        m_jobsReady->signal();
+        // skip the system call if the events of interest haven't changed
+        if (newJob != NULL &&
+            (oldJob == NULL || getPollEvents(oldJob) != getPollEvents(newJob))) {
+            ARCH->setPollSetSocket(m_pollSet, newJob->getSocket(),
+                            getPollEvents(newJob), socket);
+        }
+    }
+    catch (XArchNetwork& e) {
+        LOG((CLOG_WARN "error in socket multiplexer: %s", e.what()));
     }
 }
@@ -19,8 +19,10 @@
 #pragma once
 
 #include "arch/IArchNetwork.h"
+#include "common/basic_types.h"
 #include "common/stdlist.h"
 #include "common/stdmap.h"
+#include "common/stdvector.h"
 #include <memory>
 
 template <class T>
@@ -33,17 +35,37 @@ class ISocketMultiplexerJob;
 //! Socket multiplexer
 /*!
 A socket multiplexer services multiple sockets simultaneously.
+
+Where the platform supports it, sockets are kept registered in a
+persistent poll set (epoll on Linux) and only the jobs of ready sockets
+are run.  Otherwise the job list is translated into a \c pollSocket()
+query whenever it changes and every job is run on each wakeup.
 */
 class SocketMultiplexer {
 public:
-    SocketMultiplexer();
+    /*!
+    If \c usePollSet is false then the \c pollSocket() path is used even
+    if the platform has a persistent poll set.
+    */
+    SocketMultiplexer(bool usePollSet = true);
     ~SocketMultiplexer();
 
     //! @name manipulators
     //@{
 
+    //! Add or replace the job for a socket
+    /*!
+    Queues \c job to service \c socket, replacing any existing job for
+    it.  This doesn't wait for the service thread to install the job.
+    */
     void                addSocket(ISocket*, std::unique_ptr<ISocketMultiplexerJob>&& job);
 
+    //! Remove the job for a socket
+    /*!
+    Removes the job for \c socket.  Unless called from a job, this waits
+    until the service thread has removed the job so it's guaranteed not
+    to run again once this returns.
+    */
     void                removeSocket(ISocket*);
 
     //@}
@@ -57,54 +79,58 @@ public:
     //@}
 
 private:
-    // list of jobs.  we use a list so we can safely iterate over it
-    // while other threads modify it.
+    // a queued change to the job list.  a NULL job removes the socket.
+    struct JobCommand {
+        ISocket*        m_socket;
+        std::unique_ptr<ISocketMultiplexerJob> m_job;
+    };
+    using JobCommands = std::vector<JobCommand>;
+
+    // list of jobs.  only the service thread touches the job list;
+    // other threads queue changes to it with queueCommand().
     using SocketJobs = std::list<std::unique_ptr<ISocketMultiplexerJob>>;
     typedef SocketJobs::iterator JobCursor;
     typedef std::map<ISocket*, JobCursor> SocketJobMap;
 
-    // service sockets.  the service thread will only access m_sockets
-    // and m_update while m_pollable and m_polling are true.  all other
-    // threads must only modify these when m_pollable and m_polling are
-    // false.  only the service thread sets m_polling.
+    // service sockets.  each pass applies the queued changes to the
+    // job list, polls and runs jobs.
     void                serviceThread(void*);
 
-    // create, iterate, and destroy a cursor.  a cursor is used to
-    // safely iterate through the job list while other threads modify
-    // the list.  it works by inserting a dummy item in the list and
-    // moving that item through the list.  the dummy item will never
-    // be removed by other edits so an iterator pointing at the item
-    // remains valid until we remove the dummy item in deleteCursor().
-    // nextCursor() finds the next non-dummy item, moves our dummy
-    // item just past it, and returns an iterator for the non-dummy
-    // item.  all cursor calls lock the mutex for their duration.
-    JobCursor            newCursor();
-    JobCursor            nextCursor(JobCursor);
-    void                deleteCursor(JobCursor);
-
-    // lock out locking the job list.  this blocks if another thread
-    // has already locked out locking.  once it returns, only the
-    // calling thread will be able to lock the job list after any
-    // current lock is released.
-    void                lockJobListLock();
-
-    // lock the job list.  this blocks if the job list is already
-    // locked.  the calling thread must have called requestJobLock.
-    void                lockJobList();
-
-    // unlock the job list and the lock out on locking.
-    void                unlockJobList();
+    // queue a change to the job list and return its sequence number.
+    // the service thread is only woken if the queue was empty;
+    // otherwise it has already been woken to collect the queue.
+    UInt32                queueCommand(ISocket*,
+                            std::unique_ptr<ISocketMultiplexerJob>&& job);
+
+    // apply queued changes to the job list
+    void                applyCommands(JobCommands& commands);
+
+    // poll and run jobs using pollSocket().  pfds is rebuilt from the
+    // job list if m_update is true.
+    void                serviceJobs(std::vector<IArchNetwork::PollEntry>& pfds);
+
+    // poll and run the jobs of ready sockets using the poll set
+    void                serviceReadyJobs(
+                            std::vector<IArchNetwork::PollSetEntry>& ready);
+
+    // update the poll set registration of socket when its job changes
+    // from oldJob to newJob.  either may be NULL.
+    void                updatePollSet(ISocket* socket,
+                            const ISocketMultiplexerJob* oldJob,
+                            const ISocketMultiplexerJob* newJob);
 
 private:
     Mutex*                m_mutex;
     Thread*                m_thread;
     bool                m_update;
-    CondVar<bool>*        m_jobsReady;
-    CondVar<bool>*        m_jobListLock;
-    CondVar<bool>*        m_jobListLockLocked;
-    Thread*                m_jobListLocker;
-    Thread*                m_jobListLockLocker;
+
+    // queued changes to the job list.  these are protected by m_mutex.
+    JobCommands            m_commands;
+    UInt32                m_commandsQueued;
+    CondVar<bool>*        m_commandsReady;
+    CondVar<UInt32>*    m_commandsApplied;
 
     SocketJobs            m_socketJobs;
     SocketJobMap        m_socketJobMap;
+    ArchPollSet            m_pollSet;
 };
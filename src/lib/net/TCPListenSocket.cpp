@@ -111,10 +111,12 @@ TCPListenSocket::accept()
 {
     IDataSocket* socket = NULL;
     try {
-        socket = new TCPSocket(m_events, m_socketMultiplexer, ARCH->acceptSocket(m_socket, NULL));
+        TCPSocket* tcpSocket = new TCPSocket(m_events, m_socketMultiplexer, ARCH->acceptSocket(m_socket, NULL));
+        socket = tcpSocket;
         if (socket != NULL) {
             setListeningJob();
         }
+        tcpSocket->acceptJob();
         return socket;
     }
     catch (XArchNetwork&) {
@@ -37,6 +37,8 @@
 // TCPSocket
 //
 
+const UInt32            TCPSocket::kReadSize = 16384;
+
 TCPSocket::TCPSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer, IArchNetwork::EAddressFamily family) :
     IDataSocket(events),
     m_events(events),
@@ -68,10 +70,10 @@ TCPSocket::TCPSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer,
 
     LOG((CLOG_DEBUG "Opening new socket: %08X", m_socket));
 
-    // socket starts in connected state
+    // socket starts in connected state.  the creator starts servicing it
+    // so a subclass is fully constructed before the multiplexer calls in.
     init();
     onConnected();
-    setJob(newJob());
 }
 
 TCPSocket::~TCPSocket()
@@ -144,9 +146,9 @@ TCPSocket::read(void* buffer, UInt32 n)
         n = size;
     }
     if (buffer != NULL && n != 0) {
-        memcpy(buffer, m_inputBuffer.peek(n), n);
+        memcpy(buffer, m_inputBuffer.data(), n);
     }
-    m_inputBuffer.pop(n);
+    m_inputBuffer.consume(n);
 
     // if no more data and we cannot read or write then send disconnected
     if (n > 0 && m_inputBuffer.getSize() == 0 && !m_readable && !m_writable) {
@@ -332,20 +334,18 @@ TCPSocket::init()
 TCPSocket::EJobResult
 TCPSocket::doRead()
 {
-    UInt8 buffer[4096];
-    memset(buffer, 0, sizeof(buffer));
-    size_t bytesRead = 0;
-
-    bytesRead = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
+    // read straight into the input buffer
+    bool wasEmpty = (m_inputBuffer.getSize() == 0);
+    size_t bytesRead = ARCH->readSocket(m_socket,
+                            m_inputBuffer.prepare(kReadSize), kReadSize);
 
     if (bytesRead > 0) {
-        bool wasEmpty = (m_inputBuffer.getSize() == 0);
-
         // slurp up as much as possible
         do {
-            m_inputBuffer.write(buffer, (UInt32)bytesRead);
+            m_inputBuffer.commit((UInt32)bytesRead);
 
-            bytesRead = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
+            bytesRead = ARCH->readSocket(m_socket,
+                            m_inputBuffer.prepare(kReadSize), kReadSize);
         } while (bytesRead > 0);
 
         // send input ready if input buffer was empty
@@ -377,7 +377,7 @@ TCPSocket::doWrite()
     int bytesWrote = 0;
 
     bufferSize = m_outputBuffer.getSize();
-    const void* buffer = m_outputBuffer.peek(bufferSize);
+    const void* buffer = m_outputBuffer.data();
     bytesWrote = (UInt32)ARCH->writeSocket(m_socket, buffer, bufferSize);
 
     if (bytesWrote > 0) {
@@ -412,6 +412,13 @@ MultiplexerJobStatus TCPSocket::newJobOrStopServicing()
         return {false, {}};
 }
 
+void
+TCPSocket::acceptJob()
+{
+    Lock lock(&m_mutex);
+    setJob(newJob());
+}
+
 std::unique_ptr<ISocketMultiplexerJob> TCPSocket::newJob()
 {
     // note -- must have m_mutex locked on entry
@@ -456,7 +463,7 @@ TCPSocket::sendEvent(Event::Type type)
 void
 TCPSocket::discardWrittenData(int bytesWrote)
 {
-    m_outputBuffer.pop(bytesWrote);
+    m_outputBuffer.consume(bytesWrote);
     if (m_outputBuffer.getSize() == 0) {
         sendEvent(m_events->forIStream().outputFlushed());
         m_flushed = true;
@@ -475,14 +482,14 @@ TCPSocket::onConnected()
 void
 TCPSocket::onInputShutdown()
 {
-    m_inputBuffer.pop(m_inputBuffer.getSize());
+    m_inputBuffer.consume(m_inputBuffer.getSize());
     m_readable = false;
 }
 
 void
 TCPSocket::onOutputShutdown()
 {
-    m_outputBuffer.pop(m_outputBuffer.getSize());
+    m_outputBuffer.consume(m_outputBuffer.getSize());
     m_writable = false;
 
     // we're now flushed
@@ -62,6 +62,13 @@ public:
 
     virtual std::unique_ptr<ISocketMultiplexerJob> newJob();
 
+    //! Start servicing an accepted socket
+    /*!
+    A socket made from an accepted \c ArchSocket isn't serviced until
+    this is called.
+    */
+    void                acceptJob();
+
 protected:
     enum EJobResult {
         kBreak = -1,    //!< Break the Job chain
@@ -99,6 +106,9 @@ private:
     MultiplexerJobStatus serviceConnected(ISocketMultiplexerJob*, bool, bool, bool);
 
 protected:
+    //! Bytes to make room for in the input buffer before each read
+    static const UInt32    kReadSize;
+
     bool                m_readable;
     bool                m_writable;
     bool                m_connected;
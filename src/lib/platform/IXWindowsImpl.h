@@ -173,6 +173,7 @@ public:
                              Window confine_to, Cursor cursor, Time time) = 0;
     virtual int XUngrabKeyboard(Display* display, Time time) = 0;
     virtual int XPending(Display* display) = 0;
+    virtual int XEventsQueued(Display* display, int mode) = 0;
     virtual int XPeekEvent(Display* display, XEvent* event_return) = 0;
     virtual Status XkbRefreshKeyboardMapping(XkbMapNotifyEvent* event) = 0;
     virtual int XRefreshKeyboardMapping(XMappingEvent* event_map) = 0;
@@ -47,7 +47,10 @@ XWindowsClipboard::XWindowsClipboard(IXWindowsImpl* impl, Display* display,
     m_time(0),
     m_owner(false),
     m_timeOwned(0),
-    m_timeLost(0)
+    m_timeLost(0),
+    m_promised(0),
+    m_wanted(0),
+    m_requested(0)
 {
     m_impl = impl;
     // get some atoms
@@ -116,6 +119,9 @@ XWindowsClipboard::lost(Time time)
         m_owner    = false;
         m_timeLost = time;
         clearCache();
+
+        // fail requests still waiting on promised data
+        pushReplies();
     }
 }
 
@@ -193,6 +199,19 @@ XWindowsClipboard::addSimpleRequest(Window requestor,
                     // ignore -- cannot convert
                 }
             }
+            else if ((m_promised & (1u << clipboardFormat)) != 0) {
+                // reply when fulfil() gives us the data
+                LOG((CLOG_DEBUG1 "waiting for promised format %d", clipboardFormat));
+                Reply* reply = new Reply(requestor, target, time,
+                                property, std::string(),
+                                converter->getAtom(), converter->getDataSize());
+                reply->m_pending = true;
+                if ((m_requested & (1u << clipboardFormat)) == 0) {
+                    m_wanted |= (1u << clipboardFormat);
+                }
+                insertReply(reply);
+                return true;
+            }
         }
     }
 
@@ -258,6 +277,96 @@ XWindowsClipboard::destroyRequest(Window requestor)
     return true;
 }
 
+void
+XWindowsClipboard::promise(UInt32 formats)
+{
+    assert(m_open);
+    assert(m_owner);
+
+    LOG((CLOG_DEBUG "promise clipboard %d formats: 0x%x", m_id, formats));
+    m_promised = formats;
+}
+
+void
+XWindowsClipboard::fulfil(const IClipboard* clipboard)
+{
+    if (!m_owner || m_promised == 0) {
+        LOG((CLOG_DEBUG "ignored data for clipboard %d (not promised)", m_id));
+        return;
+    }
+
+    // add the promised formats that arrived
+    if (clipboard->open(0)) {
+        for (SInt32 format = 0; format < kNumFormats; ++format) {
+            const UInt32 bit = (1u << format);
+            EFormat eFormat  = static_cast<EFormat>(format);
+            if ((m_promised & bit) != 0 && clipboard->has(eFormat)) {
+                m_data[format]  = clipboard->get(eFormat);
+                m_added[format] = true;
+                m_promised     &= ~bit;
+                m_wanted       &= ~bit;
+                m_requested    &= ~bit;
+                LOG((CLOG_DEBUG "fulfil %d bytes of clipboard %d format: %d", m_data[format].size(), m_id, format));
+            }
+        }
+        clipboard->close();
+    }
+
+    // the requested formats that didn't arrive never will.  requests
+    // that haven't been taken yet keep waiting.
+    const UInt32 missing = m_requested;
+    m_promised  &= ~missing;
+    m_wanted    &= ~missing;
+    m_requested  = 0;
+
+    // convert the data for the replies that were waiting on it and
+    // fail the ones waiting on missing formats
+    for (ReplyMap::iterator index = m_replies.begin();
+                                index != m_replies.end(); ++index) {
+        for (ReplyList::iterator index2 = index->second.begin();
+                                index2 != index->second.end(); ++index2) {
+            Reply* reply = *index2;
+            if (!reply->m_pending) {
+                continue;
+            }
+            IXWindowsClipboardConverter* converter =
+                getConverter(reply->m_target);
+            if (converter == NULL) {
+                continue;
+            }
+            if (!m_added[converter->getFormat()]) {
+                if ((missing & (1u << converter->getFormat())) != 0) {
+                    LOG((CLOG_DEBUG "clipboard %d format %d not sent", m_id, converter->getFormat()));
+                    reply->m_pending  = false;
+                    reply->m_property = None;
+                }
+                continue;
+            }
+            reply->m_pending = false;
+            try {
+                reply->m_data = converter->fromIClipboard(
+                                m_data[converter->getFormat()]);
+            }
+            catch (...) {
+                // cannot convert.  send failure.
+                reply->m_property = None;
+            }
+        }
+    }
+
+    // send the replies that are ready
+    pushReplies();
+}
+
+UInt32
+XWindowsClipboard::takeRequests()
+{
+    UInt32 formats = m_wanted;
+    m_requested   |= m_wanted;
+    m_wanted       = 0;
+    return formats;
+}
+
 Window
 XWindowsClipboard::getWindow() const
 {
@@ -289,6 +398,9 @@ XWindowsClipboard::empty()
     clearCache();
     m_cached = true;
 
+    // fail requests still waiting on promised data
+    pushReplies();
+
     // FIXME -- actually delete motif clipboard items?
     // FIXME -- do anything to motif clipboard properties?
 
@@ -370,6 +482,51 @@ XWindowsClipboard::close() const
     m_open  = false;
 }
 
+UInt32
+XWindowsClipboard::getFormats() const
+{
+    assert(m_open);
+
+    // ask an ICCCM owner for its targets unless we already have its data.
+    // note that some owners don't report every target they support so
+    // this may miss formats has() would find.
+    checkCache();
+    if (!m_cached && !m_motif) {
+        Atom target;
+        std::string data;
+        if (icccmGetSelection(m_atomTargets, &target, &data) &&
+            (target == m_atomAtom || target == m_atomTargets)) {
+            XWindowsUtil::convertAtomProperty(data);
+            const Atom* targets = reinterpret_cast<const Atom*>(data.data());
+            const UInt32 numTargets = data.size() / sizeof(Atom);
+
+            UInt32 formats = 0;
+            for (ConverterList::const_iterator index = m_converters.begin();
+                                index != m_converters.end(); ++index) {
+                IXWindowsClipboardConverter* converter = *index;
+                for (UInt32 i = 0; i < numTargets; ++i) {
+                    if (converter->getAtom() == targets[i]) {
+                        formats |= (1u << converter->getFormat());
+                        break;
+                    }
+                }
+            }
+            return formats;
+        }
+        LOG((CLOG_DEBUG1 "selection doesn't support TARGETS"));
+    }
+
+    // get the data to see which formats there are
+    fillCache();
+    UInt32 formats = m_promised;
+    for (SInt32 format = 0; format < kNumFormats; ++format) {
+        if (m_added[format]) {
+            formats |= (1u << format);
+        }
+    }
+    return formats;
+}
+
 IClipboard::Time
 XWindowsClipboard::getTime() const
 {
@@ -474,6 +631,22 @@ XWindowsClipboard::doClearCache()
         m_data[index]  = "";
         m_added[index] = false;
     }
+
+    // promised data won't arrive for what we've cleared.  fail the
+    // requests waiting on it.
+    m_promised  = 0;
+    m_wanted    = 0;
+    m_requested = 0;
+    for (ReplyMap::iterator index = m_replies.begin();
+                                index != m_replies.end(); ++index) {
+        for (ReplyList::iterator index2 = index->second.begin();
+                                index2 != index->second.end(); ++index2) {
+            if ((*index2)->m_pending) {
+                (*index2)->m_pending  = false;
+                (*index2)->m_property = None;
+            }
+        }
+    }
 }
 
 void
@@ -1002,6 +1175,11 @@ XWindowsClipboard::sendReply(Reply* reply)
         return true;
     }
 
+    // wait until the promised data arrives
+    if (reply->m_pending) {
+        return false;
+    }
+
     // start in failed state if property is None
     bool failed = (reply->m_property == None);
     if (!failed) {
@@ -1233,8 +1411,9 @@ Atom XWindowsClipboard::getTargetsData(std::string& data, int* format) const
                                 index != m_converters.end(); ++index) {
         IXWindowsClipboardConverter* converter = *index;
 
-        // skip formats we don't have
-        if (m_added[converter->getFormat()]) {
+        // skip formats we don't have or haven't been promised
+        if (m_added[converter->getFormat()] ||
+            (m_promised & (1u << converter->getFormat())) != 0) {
             XWindowsUtil::appendAtomData(data, converter->getAtom());
         }
     }
@@ -1502,6 +1681,7 @@ XWindowsClipboard::Reply::Reply(Window requestor, Atom target, ::Time time) :
     m_property(None),
     m_replied(false),
     m_done(false),
+    m_pending(false),
     m_data(),
     m_type(None),
     m_format(32),
@@ -1518,6 +1698,7 @@ XWindowsClipboard::Reply::Reply(Window requestor, Atom target, ::Time time,
     m_property(property),
     m_replied(false),
     m_done(false),
+    m_pending(false),
     m_data(data),
     m_type(type),
     m_format(format),
@@ -71,6 +71,32 @@ public:
     */
     bool                destroyRequest(Window requestor);
 
+    //! Promise formats
+    /*!
+    Advertises \c formats, a mask with bit (1 << format) set for each
+    EFormat, without having their data.  Requests for those formats
+    wait until fulfil() supplies the data.  Must be called after a
+    successful empty().
+    */
+    void                promise(UInt32 formats);
+
+    //! Fulfil promise
+    /*!
+    Adds the promised formats that \c clipboard has and answers the
+    requests waiting for them.  Formats returned by takeRequests() that
+    \c clipboard lacks are no longer promised and their requests fail.
+    Does nothing if the clipboard has been emptied or lost since
+    promise().
+    */
+    void                fulfil(const IClipboard* clipboard);
+
+    //! Take requested formats
+    /*!
+    Returns the promised formats that requests have started waiting
+    for since the last call.
+    */
+    UInt32                takeRequests();
+
     //! Get window
     /*!
     Returns the clipboard's window (passed the c'tor).
@@ -84,6 +110,15 @@ public:
     */
     Atom                getSelection() const;
 
+    //! Get formats
+    /*!
+    Returns a mask with bit (1 << format) set for each EFormat the
+    clipboard has.  Unlike has() this asks the owner which targets it
+    supports instead of converting them where it can.  Must be called
+    between a successful open() and close().
+    */
+    UInt32                getFormats() const;
+
     // IClipboard overrides
     virtual bool        empty();
     virtual void add(EFormat, const std::string& data);
@@ -236,6 +271,9 @@ private:
         // true iff the reply has sent its last message
         bool            m_done;
 
+        // true iff the reply is waiting for promised data
+        bool            m_pending;
+
         // the data to send and its type and format
         std::string m_data;
         Atom            m_type;
@@ -302,6 +340,12 @@ private:
     bool                m_added[kNumFormats];
     std::string m_data[kNumFormats];
 
+    // formats promised but not yet added, those requests are waiting on
+    // that haven't been taken by takeRequests() and those that have
+    UInt32                m_promised;
+    UInt32                m_wanted;
+    UInt32                m_requested;
+
     // conversion request replies
     ReplyMap            m_replies;
     ReplyEventMask        m_eventMasks;
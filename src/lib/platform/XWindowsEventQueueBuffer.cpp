@@ -23,7 +23,11 @@
 #include "base/Event.h"
 #include "base/IEventQueue.h"
 
+#include <cmath>
 #include <fcntl.h>
+#if HAVE_SYS_EVENTFD_H
+#    include <sys/eventfd.h>
+#endif
 #if HAVE_UNISTD_H
 #    include <unistd.h>
 #endif
@@ -54,45 +58,56 @@ class EventQueueTimer { };
 
 XWindowsEventQueueBuffer::XWindowsEventQueueBuffer(IXWindowsImpl* impl,
         Display* display, Window window, IEventQueue* events) :
-    m_events(events),
+    m_impl(impl),
     m_display(display),
     m_window(window),
-    m_waiting(false)
+    m_events(events),
+    m_preferUserEvent(false)
 {
-    m_impl = impl;
     assert(m_display != NULL);
     assert(m_window  != None);
 
-    m_userEvent = m_impl->XInternAtom(m_display, "BARRIER_USER_EVENT", False);
-    // set up for pipe hack
-    int result = pipe(m_pipefd);
+#if HAVE_SYS_EVENTFD_H
+    // an eventfd counts wakeups so one descriptor serves both ends
+    m_wakefd[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    assert(m_wakefd[0] != -1);
+    m_wakefd[1] = m_wakefd[0];
+#else
+    int result = pipe(m_wakefd);
     assert(result == 0);
 
     int pipeflags;
-    pipeflags = fcntl(m_pipefd[0], F_GETFL);
-    fcntl(m_pipefd[0], F_SETFL, pipeflags | O_NONBLOCK);
-    pipeflags = fcntl(m_pipefd[1], F_GETFL);
-    fcntl(m_pipefd[1], F_SETFL, pipeflags | O_NONBLOCK);
+    pipeflags = fcntl(m_wakefd[0], F_GETFL);
+    fcntl(m_wakefd[0], F_SETFL, pipeflags | O_NONBLOCK);
+    pipeflags = fcntl(m_wakefd[1], F_GETFL);
+    fcntl(m_wakefd[1], F_SETFL, pipeflags | O_NONBLOCK);
+#endif
 }
 
 XWindowsEventQueueBuffer::~XWindowsEventQueueBuffer()
 {
-    // release pipe hack resources
-    close(m_pipefd[0]);
-    close(m_pipefd[1]);
+    // release wakeup resources
+    close(m_wakefd[0]);
+    if (m_wakefd[1] != m_wakefd[0]) {
+        close(m_wakefd[1]);
+    }
 }
 
 int XWindowsEventQueueBuffer::getPendingCountLocked()
 {
-    Lock lock(&m_mutex);
+    // note -- m_mutex must be locked on entry
+
+    // flush pending requests and count the events xlib has buffered,
+    // reading any that have arrived.
+    //
     // work around a bug in old libx11 which causes the first XPending not to read events under
     // certain conditions. The issue happens when libx11 has not yet received replies for all
     // flushed events. In that case, internally XPending will not try to process received events
     // as the reply for the last event was not found. As a result, XPending will return the number
     // of pending events without regard to the events it has just read.
     // https://gitlab.freedesktop.org/xorg/lib/libx11/-/merge_requests/1 fixes this on libx11 side.
-    m_impl->XPending(m_display);
-    return m_impl->XPending(m_display);
+    m_impl->XEventsQueued(m_display, QueuedAfterFlush);
+    return m_impl->XEventsQueued(m_display, QueuedAfterFlush);
 }
 
 void
@@ -100,43 +115,41 @@ XWindowsEventQueueBuffer::waitForEvent(double dtimeout)
 {
     Thread::testCancel();
 
-    // clear out the pipe in preparation for waiting.
-
-    char buf[16];
-    ssize_t read_response = read(m_pipefd[0], buf, 15);
-
-    // with linux automake, warnings are treated as errors by default
-    if (read_response < 0)
-    {
-        // todo: handle read response
-    }
+    // clear out the wakeup in preparation for waiting.  a user event
+    // added after this writes it again.
+    clearWake();
 
+    // xlib may already have read events into its own buffer, where
+    // poll() can't see them, so only wait if it has none.  nothing else
+    // reads from the display while we wait, so once the buffer is empty
+    // the connection becomes readable when the next event arrives.
     {
         Lock lock(&m_mutex);
-        // we're now waiting for events
-        m_waiting = true;
-
-        // push out pending events
-        flush();
+        if (getPendingCountLocked() > 0) {
+            Thread::testCancel();
+            return;
+        }
     }
-    // calling flush may have queued up a new event.
-    if (!XWindowsEventQueueBuffer::isEmpty()) {
-        Thread::testCancel();
-        return;
+    {
+        Lock lock(&m_userMutex);
+        if (!m_userEvents.empty()) {
+            Thread::testCancel();
+            return;
+        }
     }
 
-    // use poll() to wait for a message from the X server or for timeout.
-    // this is a good deal more efficient than polling and sleeping.
+    // wait for a message from the X server, a user event or for
+    // timeout.  round the timeout up so we don't spin until a timer
+    // that's due in under a millisecond.
 #if HAVE_POLL
     struct pollfd pfds[2];
     pfds[0].fd     = ConnectionNumber(m_display);
     pfds[0].events = POLLIN;
-    pfds[1].fd     = m_pipefd[0];
+    pfds[1].fd     = m_wakefd[0];
     pfds[1].events = POLLIN;
     int timeout    = (dtimeout < 0.0) ? -1 :
-                        static_cast<int>(1000.0 * dtimeout);
-    int remaining  =  timeout;
-    int retval     =  0;
+                        static_cast<int>(std::ceil(1000.0 * dtimeout));
+    poll(pfds, 2, timeout);
 #else
     struct timeval timeout;
     struct timeval* timeoutPtr;
@@ -145,8 +158,8 @@ XWindowsEventQueueBuffer::waitForEvent(double dtimeout)
     }
     else {
         timeout.tv_sec  = static_cast<int>(dtimeout);
-        timeout.tv_usec = static_cast<int>(1.0e+6 *
-                                (dtimeout - timeout.tv_sec));
+        timeout.tv_usec = static_cast<int>(std::ceil(1.0e+6 *
+                                (dtimeout - timeout.tv_sec)));
         timeoutPtr      = &timeout;
     }
 
@@ -154,60 +167,23 @@ XWindowsEventQueueBuffer::waitForEvent(double dtimeout)
     fd_set rfds;
     FD_ZERO(&rfds);
     FD_SET(ConnectionNumber(m_display), &rfds);
-    FD_SET(m_pipefd[0], &rfds);
-     int nfds;
-     if (ConnectionNumber(m_display) > m_pipefd[0]) {
-         nfds = ConnectionNumber(m_display) + 1;
-     }
-     else {
-         nfds = m_pipefd[0] + 1;
-     }
-#endif
-    // It's possible that the X server has queued events locally
-    // in xlib's event buffer and not pushed on to the fd. Hence we
-    // can't simply monitor the fd as we may never be woken up.
-    // ie addEvent calls flush, XFlush may not send via the fd hence
-    // there is an event waiting to be sent but we must exit the poll
-    // before it can.
-    // Instead we poll for a brief period of time (so if events
-    // queued locally in the xlib buffer can be processed)
-    // and continue doing this until timeout is reached.
-    // The human eye can notice 60hz (ansi) which is 16ms, however
-    // we want to give the cpu a chance s owe up this to 25ms
-#define TIMEOUT_DELAY 25
-
-    while (((dtimeout < 0.0) || (remaining > 0)) && getPendingCountLocked() == 0 && retval == 0) {
-#if HAVE_POLL
-    retval = poll(pfds, 2, TIMEOUT_DELAY); //16ms = 60hz, but we make it > to play nicely with the cpu
-     if (pfds[1].revents & POLLIN) {
-         ssize_t read_response = read(m_pipefd[0], buf, 15);
-
-        // with linux automake, warnings are treated as errors by default
-        if (read_response < 0)
-        {
-            // todo: handle read response
-        }
-
-     }
-#else
-    retval = select(nfds,
+    FD_SET(m_wakefd[0], &rfds);
+    int nfds;
+    if (ConnectionNumber(m_display) > m_wakefd[0]) {
+        nfds = ConnectionNumber(m_display) + 1;
+    }
+    else {
+        nfds = m_wakefd[0] + 1;
+    }
+    select(nfds,
                         SELECT_TYPE_ARG234 &rfds,
                         SELECT_TYPE_ARG234 NULL,
                         SELECT_TYPE_ARG234 NULL,
-                        SELECT_TYPE_ARG5   TIMEOUT_DELAY);
-    if (FD_SET(m_pipefd[0], &rfds)) {
-        read(m_pipefd[0], buf, 15);
-    }
+                        SELECT_TYPE_ARG5   timeoutPtr);
 #endif
-        remaining-=TIMEOUT_DELAY;
-    }
-
-    {
-        // we're no longer waiting for events
-        Lock lock(&m_mutex);
-        m_waiting = false;
-    }
 
+    // the caller checks for events and waits again if there are none,
+    // so being interrupted is harmless
     Thread::testCancel();
 }
 
@@ -216,67 +192,57 @@ XWindowsEventQueueBuffer::getEvent(Event& event, UInt32& dataID)
 {
     Lock lock(&m_mutex);
 
-    // push out pending events
-    flush();
+    // take turns between user events and X events while there are both
+    // so neither can hold up the other
+    {
+        Lock userLock(&m_userMutex);
+        if (!m_userEvents.empty() &&
+            (m_preferUserEvent ||
+             m_impl->XEventsQueued(m_display, QueuedAlready) == 0)) {
+            dataID = m_userEvents.front();
+            m_userEvents.pop_front();
+            m_preferUserEvent = false;
+            return kUser;
+        }
+    }
 
     // get next event
     m_impl->XNextEvent(m_display, &m_event);
-
-    // process event
-    if (m_event.xany.type == ClientMessage &&
-        m_event.xclient.message_type == m_userEvent) {
-        dataID = static_cast<UInt32>(m_event.xclient.data.l[0]);
-        return kUser;
-    }
-    else {
-        event = Event(Event::kSystem,
-                            m_events->getSystemTarget(), &m_event);
-        return kSystem;
-    }
+    m_preferUserEvent = true;
+    event = Event(Event::kSystem, m_events->getSystemTarget(), &m_event);
+    return kSystem;
 }
 
 bool
 XWindowsEventQueueBuffer::addEvent(UInt32 dataID)
 {
-    // prepare a message
-    XEvent xevent;
-    xevent.xclient.type         = ClientMessage;
-    xevent.xclient.window       = m_window;
-    xevent.xclient.message_type = m_userEvent;
-    xevent.xclient.format       = 32;
-    xevent.xclient.data.l[0]    = static_cast<long>(dataID);
-
-    // save the message
-    Lock lock(&m_mutex);
-    m_postedEvents.push_back(xevent);
-
-    // if we're currently waiting for an event then send saved events to
-    // the X server now.  if we're not waiting then some other thread
-    // might be using the display connection so we can't safely use it
-    // too.
-    if (m_waiting) {
-        flush();
-        // Send a character through the round-trip pipe to wake a thread
-        // that is waiting for a ConnectionNumber() socket to be readable.
-        // The flush call can read incoming data from the socket and put
-        // it in Xlib's input buffer.  That sneaks it past the other thread.
-        ssize_t write_response = write(m_pipefd[1], "!", 1);
-
-        // with linux automake, warnings are treated as errors by default
-        if (write_response < 0)
-        {
-            // todo: handle read response
-        }
+    bool wasEmpty;
+    {
+        Lock lock(&m_userMutex);
+        wasEmpty = m_userEvents.empty();
+        m_userEvents.push_back(dataID);
     }
 
+    // waitForEvent() clears the wakeup before it checks for events so
+    // only the first of a run of events needs to write it
+    if (wasEmpty) {
+        wake();
+    }
     return true;
 }
 
 bool
 XWindowsEventQueueBuffer::isEmpty() const
 {
+    {
+        Lock lock(&m_userMutex);
+        if (!m_userEvents.empty()) {
+            return false;
+        }
+    }
+
     Lock lock(&m_mutex);
-    return (m_impl->XPending(m_display) == 0 );
+    return (m_impl->XPending(m_display) == 0);
 }
 
 EventQueueTimer*
@@ -292,14 +258,25 @@ XWindowsEventQueueBuffer::deleteTimer(EventQueueTimer* timer) const
 }
 
 void
-XWindowsEventQueueBuffer::flush()
+XWindowsEventQueueBuffer::wake()
 {
-    // note -- m_mutex must be locked on entry
+#if HAVE_SYS_EVENTFD_H
+    eventfd_t one = 1;
+#else
+    char one = '!';
+#endif
+    // the descriptor is non-blocking.  if it's full it's readable
+    // already so a failed write loses nothing.
+    ssize_t result = write(m_wakefd[1], &one, sizeof(one));
+    (void)result;
+}
 
-    // flush the posted event list to the X server
-    for (size_t i = 0; i < m_postedEvents.size(); ++i) {
-        m_impl->XSendEvent(m_display, m_window, False, 0, &m_postedEvents[i]);
-    }
-    m_impl->XFlush(m_display);
-    m_postedEvents.clear();
+void
+XWindowsEventQueueBuffer::clearWake()
+{
+    // reading an eventfd resets its count.  a pipe may need more reads
+    // but any leftover data only causes one early return from poll().
+    char buf[16];
+    ssize_t result = read(m_wakefd[0], buf, sizeof(buf));
+    (void)result;
 }
@@ -20,7 +20,7 @@
 
 #include "mt/Mutex.h"
 #include "base/IEventQueueBuffer.h"
-#include "common/stdvector.h"
+#include "common/stddeque.h"
 #include "XWindowsImpl.h"
 
 #include <X11/Xlib.h>
@@ -28,6 +28,12 @@
 class IEventQueue;
 
 //! Event queue buffer for X11
+/*!
+Events added with addEvent() stay in this process.  They're kept in a
+list and wake the waiting thread through a file descriptor that's
+polled along with the X connection, so they never travel through the X
+server.
+*/
 class XWindowsEventQueueBuffer : public IEventQueueBuffer {
 public:
     XWindowsEventQueueBuffer(IXWindowsImpl* impl, Display*, Window,
@@ -45,21 +51,29 @@ public:
     virtual void        deleteTimer(EventQueueTimer*) const;
 
 private:
-    void                flush();
+    void                wake();
+    void                clearWake();
 
     int getPendingCountLocked();
 
 private:
-    typedef std::vector<XEvent> EventList;
-     IXWindowsImpl*       m_impl;
+    typedef std::deque<UInt32> UserEventList;
+
+    IXWindowsImpl*       m_impl;
 
     Mutex                m_mutex;
     Display*            m_display;
     Window                m_window;
-    Atom                m_userEvent;
     XEvent                m_event;
-    EventList            m_postedEvents;
-    bool                m_waiting;
-    int                    m_pipefd[2];
     IEventQueue*        m_events;
+
+    // events from addEvent().  m_userMutex guards only the list so
+    // adding an event never waits for a thread using the display.
+    Mutex                m_userMutex;
+    UserEventList        m_userEvents;
+    bool                m_preferUserEvent;
+
+    // written when the first user event arrives to end the wait.  with
+    // eventfd both ends are the same descriptor, otherwise it's a pipe.
+    int                    m_wakefd[2];
 };
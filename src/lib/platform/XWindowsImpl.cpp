@@ -469,6 +469,11 @@ int XWindowsImpl::XPending(Display* display)
     return ::XPending(display);
 }
 
+int XWindowsImpl::XEventsQueued(Display* display, int mode)
+{
+    return ::XEventsQueued(display, mode);
+}
+
 int XWindowsImpl::XPeekEvent(Display* display, XEvent* event_return)
 {
     return ::XPeekEvent(display, event_return);
@@ -142,6 +142,7 @@ public:
                              Window confine_to, Cursor cursor, Time time);
     virtual int XUngrabKeyboard(Display* display, Time time);
     virtual int XPending(Display* display);
+    virtual int XEventsQueued(Display* display, int mode);
     virtual int XPeekEvent(Display* display, XEvent* event_return);
     virtual Status XkbRefreshKeyboardMapping(XkbMapNotifyEvent* event);
     virtual int XRefreshKeyboardMapping(XMappingEvent* event_map);
@@ -378,6 +378,38 @@ XWindowsScreen::setClipboard(ClipboardID id, const IClipboard* clipboard)
 	}
 }
 
+bool
+XWindowsScreen::promiseClipboard(ClipboardID id, UInt32 formats)
+{
+	// fail if we don't have the requested clipboard
+	if (m_clipboard[id] == NULL) {
+		return false;
+	}
+
+	// get the actual time.  ICCCM does not allow CurrentTime.
+	Time timestamp = XWindowsUtil::getCurrentTime(
+								m_display, m_clipboard[id]->getWindow());
+
+	// assert clipboard ownership and advertise the formats
+	if (!m_clipboard[id]->open(timestamp)) {
+		return false;
+	}
+	bool promised = m_clipboard[id]->empty();
+	if (promised) {
+		m_clipboard[id]->promise(formats);
+	}
+	m_clipboard[id]->close();
+	return promised;
+}
+
+void
+XWindowsScreen::fulfilClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+	if (m_clipboard[id] != NULL) {
+		m_clipboard[id]->fulfil(clipboard);
+	}
+}
+
 void
 XWindowsScreen::checkClipboards()
 {
@@ -470,6 +502,28 @@ XWindowsScreen::getClipboard(ClipboardID id, IClipboard* clipboard) const
 	return Clipboard::copy(clipboard, m_clipboard[id], timestamp);
 }
 
+bool
+XWindowsScreen::getClipboardFormats(ClipboardID id, UInt32& formats,
+				IClipboard::Time& time) const
+{
+	// fail if we don't have the requested clipboard
+	if (m_clipboard[id] == NULL) {
+		return false;
+	}
+
+	// get the actual time.  ICCCM does not allow CurrentTime.
+	Time timestamp = XWindowsUtil::getCurrentTime(
+								m_display, m_clipboard[id]->getWindow());
+
+	if (!m_clipboard[id]->open(timestamp)) {
+		return false;
+	}
+	formats = m_clipboard[id]->getFormats();
+	time    = m_clipboard[id]->getTime();
+	m_clipboard[id]->close();
+	return true;
+}
+
 void
 XWindowsScreen::getShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h) const
 {
@@ -1307,6 +1361,16 @@ XWindowsScreen::handleSystemEvent(const Event& event, void*)
 								xevent->xselectionrequest.target,
 								xevent->xselectionrequest.time,
 								xevent->xselectionrequest.property);
+
+				// ask for the promised data the request is waiting on
+				UInt32 formats = m_clipboard[id]->takeRequests();
+				if (formats != 0) {
+					ClipboardRequestInfo* info = (ClipboardRequestInfo*)
+								malloc(sizeof(ClipboardRequestInfo));
+					info->m_id      = id;
+					info->m_formats = formats;
+					sendEvent(m_events->forClipboard().clipboardRequested(), info);
+				}
 				return;
 			}
 		}
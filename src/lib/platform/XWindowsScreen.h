@@ -73,6 +73,8 @@ public:
     virtual void        enter();
     virtual bool        leave();
     virtual bool        setClipboard(ClipboardID, const IClipboard*);
+    virtual bool        promiseClipboard(ClipboardID, UInt32 formats);
+    virtual void        fulfilClipboard(ClipboardID, const IClipboard*);
     virtual void        checkClipboards();
     virtual void        openScreensaver(bool notify);
     virtual void        closeScreensaver();
@@ -81,6 +83,8 @@ public:
     virtual void        setOptions(const OptionsList& options);
     virtual void        setSequenceNumber(UInt32);
     virtual bool        isPrimary() const;
+    virtual bool        getClipboardFormats(ClipboardID, UInt32& formats,
+                            IClipboard::Time& time) const;
 
 protected:
     // IPlatformScreen overrides
@@ -42,6 +42,24 @@ BaseClientProxy::setJumpCursorPos(SInt32 x, SInt32 y)
     m_y = y;
 }
 
+void
+BaseClientProxy::fetchClipboard(ClipboardID, UInt32)
+{
+    // do nothing
+}
+
+bool
+BaseClientProxy::promiseClipboard(ClipboardID, UInt32)
+{
+    return false;
+}
+
+void
+BaseClientProxy::fulfilClipboard(ClipboardID, const IClipboard*)
+{
+    // do nothing
+}
+
 void
 BaseClientProxy::getJumpCursorPos(SInt32& x, SInt32& y) const
 {
@@ -49,6 +67,12 @@ BaseClientProxy::getJumpCursorPos(SInt32& x, SInt32& y) const
     y = m_y;
 }
 
+bool
+BaseClientProxy::getClipboardOffer(ClipboardID, UInt32&) const
+{
+    return false;
+}
+
 std::string BaseClientProxy::getName() const
 {
     return m_name;
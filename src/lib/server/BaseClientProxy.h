@@ -40,6 +40,32 @@ public:
     */
     void                setJumpCursorPos(SInt32 x, SInt32 y);
 
+    //! Ask for offered clipboard data
+    /*!
+    Ask the client for the \c formats (bit (1 << format) per
+    IClipboard::EFormat) of clipboard \c id it offered.  A
+    \c clipboardFetched event is sent when they arrive and getClipboard()
+    then has them.  The default does nothing.
+    */
+    virtual void        fetchClipboard(ClipboardID id, UInt32 formats);
+
+    //! Promise clipboard formats
+    /*!
+    Like setClipboard() but only tells the client which \c formats
+    the clipboard has.  The client sends a \c clipboardRequested event
+    when it wants the data, which is given with fulfilClipboard().
+    Returns false if the client can't take a promise and needs the data
+    now, which is the default.
+    */
+    virtual bool        promiseClipboard(ClipboardID id, UInt32 formats);
+
+    //! Fulfil a clipboard promise
+    /*!
+    Gives the client the formats it requested since the last
+    promiseClipboard().  The default does nothing.
+    */
+    virtual void        fulfilClipboard(ClipboardID id, const IClipboard*);
+
     //@}
     //! @name accessors
     //@{
@@ -56,6 +82,15 @@ public:
     */
     virtual bool        isPrimary() const { return false; }
 
+    //! Get clipboard offer
+    /*!
+    Return true if the client only offered the last clipboard it sent,
+    and set \c formats to the formats it offered.  Their data must be
+    fetched with fetchClipboard().  The default returns false.
+    */
+    virtual bool        getClipboardOffer(ClipboardID id,
+                            UInt32& formats) const;
+
     //@}
 
     // IScreen
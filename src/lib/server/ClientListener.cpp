@@ -139,11 +139,17 @@ ClientListener::handleClientConnecting(const Event&, void*)
                         &ClientListener::handleClientAccepted, socket));
 
     // When using non SSL, server accepts clients immediately, while SSL
-    // has to call secure accept which may require retry
+    // accepts once the handshake is done or disconnects if it fails
     if (!m_useSecureNetwork) {
         m_events->addEvent(Event(m_events->forClientListener().accepted(),
                                 socket->getEventTarget()));
     }
+    else {
+        m_events->adoptHandler(m_events->forISocket().disconnected(),
+                    socket->getEventTarget(),
+                    new TMethodEventJob<ClientListener>(this,
+                            &ClientListener::handleClientHandshakeFailed, socket));
+    }
 }
 
 void
@@ -152,6 +158,8 @@ ClientListener::handleClientAccepted(const Event&, void* vsocket)
     LOG((CLOG_NOTE "accepted client connection"));
 
     IDataSocket* socket = static_cast<IDataSocket*>(vsocket);
+    m_events->removeHandler(m_events->forISocket().disconnected(),
+                            socket->getEventTarget());
 
     // filter socket messages, including a packetizing filter
     barrier::IStream* stream = new PacketStreamFilter(m_events, socket, false);
@@ -173,6 +181,20 @@ ClientListener::handleClientAccepted(const Event&, void* vsocket)
                         &ClientListener::handleUnknownClient, client));
 }
 
+void
+ClientListener::handleClientHandshakeFailed(const Event&, void* vsocket)
+{
+    LOG((CLOG_NOTE "client connection failed its secure handshake"));
+
+    IDataSocket* socket = static_cast<IDataSocket*>(vsocket);
+    m_events->removeHandler(m_events->forClientListener().accepted(),
+                            socket->getEventTarget());
+    m_events->removeHandler(m_events->forISocket().disconnected(),
+                            socket->getEventTarget());
+    m_clientSockets.erase(socket);
+    delete socket;
+}
+
 void
 ClientListener::handleUnknownClient(const Event&, void* vclient)
 {
@@ -250,6 +272,10 @@ ClientListener::cleanupClientSockets()
 {
     ClientSockets::iterator it;
     for (it = m_clientSockets.begin(); it != m_clientSockets.end(); it++) {
+        m_events->removeHandler(m_events->forClientListener().accepted(),
+                                (*it)->getEventTarget());
+        m_events->removeHandler(m_events->forISocket().disconnected(),
+                                (*it)->getEventTarget());
         delete *it;
     }
     m_clientSockets.clear();
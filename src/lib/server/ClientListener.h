@@ -63,12 +63,20 @@ public:
     //! Get server which owns this listener
     Server*                getServer() { return m_server; }
 
+    //! Get number of accepted sockets
+    /*!
+    Returns the number of sockets accepted and not yet closed, including
+    those still in their secure handshake.
+    */
+    size_t                getNumClientSockets() const { return m_clientSockets.size(); }
+
     //@}
 
 private:
     // client connection event handlers
     void                handleClientConnecting(const Event&, void*);
     void                handleClientAccepted(const Event&, void*);
+    void                handleClientHandshakeFailed(const Event&, void*);
     void                handleUnknownClient(const Event&, void*);
     void                handleClientDisconnected(const Event&, void*);
 
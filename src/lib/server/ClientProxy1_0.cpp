@@ -18,6 +18,7 @@
 
 #include "server/ClientProxy1_0.h"
 
+#include "barrier/ProtocolMessage.h"
 #include "barrier/ProtocolUtil.h"
 #include "barrier/XBarrier.h"
 #include "io/IStream.h"
@@ -35,6 +36,13 @@ ClientProxy1_0::ClientProxy1_0(const std::string& name, barrier::IStream* stream
                                IEventQueue* events) :
     ClientProxy(name, stream),
     m_heartbeatTimer(NULL),
+    m_outputPending(false),
+    m_motionHeld(false),
+    m_xMotion(0),
+    m_yMotion(0),
+    m_relativeMotionHeld(false),
+    m_dxMotion(0),
+    m_dyMotion(0),
     m_parser(&ClientProxy1_0::parseHandshakeMessage),
     m_events(events)
 {
@@ -47,6 +55,10 @@ ClientProxy1_0::ClientProxy1_0(const std::string& name, barrier::IStream* stream
                             stream->getEventTarget(),
                             new TMethodEventJob<ClientProxy1_0>(this,
                                 &ClientProxy1_0::handleWriteError, NULL));
+    m_events->adoptHandler(m_events->forIStream().outputFlushed(),
+                            stream->getEventTarget(),
+                            new TMethodEventJob<ClientProxy1_0>(this,
+                                &ClientProxy1_0::handleOutputFlushed, NULL));
     m_events->adoptHandler(m_events->forIStream().inputShutdown(),
                             stream->getEventTarget(),
                             new TMethodEventJob<ClientProxy1_0>(this,
@@ -61,6 +73,14 @@ ClientProxy1_0::ClientProxy1_0(const std::string& name, barrier::IStream* stream
 
     setHeartbeatRate(kHeartRate, kHeartRate * kHeartBeatsUntilDeath);
 
+    // install message handlers
+    m_handshakeMessages.add(kMsgCNoop, &ClientProxy1_0::recvNoop);
+    m_handshakeMessages.add(kMsgDInfo, &ClientProxy1_0::recvHandshakeInfo);
+    addMessageHandler(kMsgDInfo,      &ClientProxy1_0::recvShapeChanged);
+    addMessageHandler(kMsgCNoop,      &ClientProxy1_0::recvNoop);
+    addMessageHandler(kMsgCClipboard, &ClientProxy1_0::recvGrabClipboard);
+    addMessageHandler(kMsgDClipboard, &ClientProxy1_0::recvClipboard);
+
     LOG((CLOG_DEBUG1 "querying client \"%s\" info", getName().c_str()));
     ProtocolUtil::writef(getStream(), kMsgQInfo);
 }
@@ -86,6 +106,8 @@ ClientProxy1_0::removeHandlers()
                             getStream()->getEventTarget());
     m_events->removeHandler(m_events->forIStream().outputError(),
                             getStream()->getEventTarget());
+    m_events->removeHandler(m_events->forIStream().outputFlushed(),
+                            getStream()->getEventTarget());
     m_events->removeHandler(m_events->forIStream().inputShutdown(),
                             getStream()->getEventTarget());
     m_events->removeHandler(m_events->forIStream().outputShutdown(),
@@ -116,9 +138,14 @@ ClientProxy1_0::removeHeartbeatTimer()
 void
 ClientProxy1_0::resetHeartbeatTimer()
 {
-    // reset the alarm
-    removeHeartbeatTimer();
-    addHeartbeatTimer();
+    // reset the alarm.  this happens for every batch of messages so
+    // restart the existing timer rather than make a new one.
+    if (m_heartbeatTimer != NULL) {
+        m_events->resetTimer(m_heartbeatTimer);
+    }
+    else {
+        ClientProxy1_0::addHeartbeatTimer();
+    }
 }
 
 void
@@ -166,48 +193,49 @@ ClientProxy1_0::handleData(const Event&, void*)
 bool
 ClientProxy1_0::parseHandshakeMessage(const UInt8* code)
 {
-    if (memcmp(code, kMsgCNoop, 4) == 0) {
-        // discard no-ops
-        LOG((CLOG_DEBUG2 "no-op from", getName().c_str()));
+    MessageHandler handler = m_handshakeMessages.find(code);
+    return (handler != NULL && (this->*handler)());
+}
+
+bool
+ClientProxy1_0::parseMessage(const UInt8* code)
+{
+    MessageHandler handler = m_messages.find(code);
+    return (handler != NULL && (this->*handler)());
+}
+
+bool
+ClientProxy1_0::recvHandshakeInfo()
+{
+    // future messages get parsed by parseMessage
+    m_parser = &ClientProxy1_0::parseMessage;
+    if (recvInfo()) {
+        m_events->addEvent(Event(m_events->forClientProxy().ready(), getEventTarget()));
+        addHeartbeatTimer();
         return true;
     }
-    else if (memcmp(code, kMsgDInfo, 4) == 0) {
-        // future messages get parsed by parseMessage
-        m_parser = &ClientProxy1_0::parseMessage;
-        if (recvInfo()) {
-            m_events->addEvent(Event(m_events->forClientProxy().ready(), getEventTarget()));
-            addHeartbeatTimer();
-            return true;
-        }
-    }
     return false;
 }
 
 bool
-ClientProxy1_0::parseMessage(const UInt8* code)
+ClientProxy1_0::recvShapeChanged()
 {
-    if (memcmp(code, kMsgDInfo, 4) == 0) {
-        if (recvInfo()) {
-            m_events->addEvent(
-                            Event(m_events->forIScreen().shapeChanged(), getEventTarget()));
-            return true;
-        }
-        return false;
-    }
-    else if (memcmp(code, kMsgCNoop, 4) == 0) {
-        // discard no-ops
-        LOG((CLOG_DEBUG2 "no-op from", getName().c_str()));
+    if (recvInfo()) {
+        m_events->addEvent(
+                        Event(m_events->forIScreen().shapeChanged(), getEventTarget()));
         return true;
     }
-    else if (memcmp(code, kMsgCClipboard, 4) == 0) {
-        return recvGrabClipboard();
-    }
-    else if (memcmp(code, kMsgDClipboard, 4) == 0) {
-        return recvClipboard();
-    }
     return false;
 }
 
+bool
+ClientProxy1_0::recvNoop()
+{
+    // discard no-ops
+    LOG((CLOG_DEBUG2 "no-op from", getName().c_str()));
+    return true;
+}
+
 void
 ClientProxy1_0::handleDisconnect(const Event&, void*)
 {
@@ -222,6 +250,21 @@ ClientProxy1_0::handleWriteError(const Event&, void*)
     disconnect();
 }
 
+void
+ClientProxy1_0::handleOutputFlushed(const Event&, void*)
+{
+    // the socket caught up so send the latest motion, if any
+    m_outputPending = false;
+    flushMotion();
+    outputFlushed();
+}
+
+void
+ClientProxy1_0::outputFlushed()
+{
+    // do nothing
+}
+
 void
 ClientProxy1_0::handleFlatline(const Event&, void*)
 {
@@ -258,6 +301,7 @@ void
 ClientProxy1_0::enter(SInt32 xAbs, SInt32 yAbs,
                 UInt32 seqNum, KeyModifierMask mask, bool)
 {
+    flushMotion();
     LOG((CLOG_DEBUG1 "send enter to \"%s\", %d,%d %d %04x", getName().c_str(), xAbs, yAbs, seqNum, mask));
     ProtocolUtil::writef(getStream(), kMsgCEnter,
                                 xAbs, yAbs, seqNum, mask);
@@ -266,6 +310,7 @@ ClientProxy1_0::enter(SInt32 xAbs, SInt32 yAbs,
 bool
 ClientProxy1_0::leave()
 {
+    flushMotion();
     LOG((CLOG_DEBUG1 "send leave to \"%s\"", getName().c_str()));
     ProtocolUtil::writef(getStream(), kMsgCLeave);
 
@@ -298,28 +343,32 @@ ClientProxy1_0::setClipboardDirty(ClipboardID id, bool dirty)
 void
 ClientProxy1_0::keyDown(KeyID key, KeyModifierMask mask, KeyButton)
 {
+    flushMotion();
     LOG((CLOG_DEBUG1 "send key down to \"%s\" id=%d, mask=0x%04x", getName().c_str(), key, mask));
-    ProtocolUtil::writef(getStream(), kMsgDKeyDown1_0, key, mask);
+    MsgDKeyDown1_0::write(getStream(), key, mask);
 }
 
 void
 ClientProxy1_0::keyRepeat(KeyID key, KeyModifierMask mask,
                 SInt32 count, KeyButton)
 {
+    flushMotion();
     LOG((CLOG_DEBUG1 "send key repeat to \"%s\" id=%d, mask=0x%04x, count=%d", getName().c_str(), key, mask, count));
-    ProtocolUtil::writef(getStream(), kMsgDKeyRepeat1_0, key, mask, count);
+    MsgDKeyRepeat1_0::write(getStream(), key, mask, count);
 }
 
 void
 ClientProxy1_0::keyUp(KeyID key, KeyModifierMask mask, KeyButton)
 {
+    flushMotion();
     LOG((CLOG_DEBUG1 "send key up to \"%s\" id=%d, mask=0x%04x", getName().c_str(), key, mask));
-    ProtocolUtil::writef(getStream(), kMsgDKeyUp1_0, key, mask);
+    MsgDKeyUp1_0::write(getStream(), key, mask);
 }
 
 void
 ClientProxy1_0::mouseDown(ButtonID button)
 {
+    flushMotion();
     LOG((CLOG_DEBUG1 "send mouse down to \"%s\" id=%d", getName().c_str(), button));
     ProtocolUtil::writef(getStream(), kMsgDMouseDown, button);
 }
@@ -327,6 +376,7 @@ ClientProxy1_0::mouseDown(ButtonID button)
 void
 ClientProxy1_0::mouseUp(ButtonID button)
 {
+    flushMotion();
     LOG((CLOG_DEBUG1 "send mouse up to \"%s\" id=%d", getName().c_str(), button));
     ProtocolUtil::writef(getStream(), kMsgDMouseUp, button);
 }
@@ -335,7 +385,7 @@ void
 ClientProxy1_0::mouseMove(SInt32 xAbs, SInt32 yAbs)
 {
     LOG((CLOG_DEBUG2 "send mouse move to \"%s\" %d,%d", getName().c_str(), xAbs, yAbs));
-    ProtocolUtil::writef(getStream(), kMsgDMouseMove, xAbs, yAbs);
+    sendMouseMove(xAbs, yAbs);
 }
 
 void
@@ -348,6 +398,7 @@ void
 ClientProxy1_0::mouseWheel(SInt32, SInt32 yDelta)
 {
     // clients prior to 1.3 only support the y axis
+    flushMotion();
     LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d", getName().c_str(), yDelta));
     ProtocolUtil::writef(getStream(), kMsgDMouseWheel1_0, yDelta);
 }
@@ -369,6 +420,7 @@ ClientProxy1_0::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
 void
 ClientProxy1_0::screensaver(bool on)
 {
+    flushMotion();
     LOG((CLOG_DEBUG1 "send screen saver to \"%s\" on=%d", getName().c_str(), on ? 1 : 0));
     ProtocolUtil::writef(getStream(), kMsgCScreenSaver, on ? 1 : 0);
 }
@@ -405,6 +457,59 @@ ClientProxy1_0::setOptions(const OptionsList& options)
     }
 }
 
+void
+ClientProxy1_0::sendMouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+    // while the socket is backed up only the latest position matters.
+    // it replaces any relative motion held before it.
+    if (m_outputPending) {
+        m_motionHeld         = true;
+        m_xMotion            = xAbs;
+        m_yMotion            = yAbs;
+        m_relativeMotionHeld = false;
+        m_dxMotion           = 0;
+        m_dyMotion           = 0;
+        return;
+    }
+
+    MsgDMouseMove::write(getStream(), xAbs, yAbs);
+    m_outputPending = true;
+}
+
+void
+ClientProxy1_0::sendMouseRelativeMove(SInt32 xRel, SInt32 yRel)
+{
+    // while the socket is backed up accumulate the motion
+    if (m_outputPending) {
+        m_relativeMotionHeld = true;
+        m_dxMotion          += xRel;
+        m_dyMotion          += yRel;
+        return;
+    }
+
+    MsgDMouseRelMove::write(getStream(), xRel, yRel);
+    m_outputPending = true;
+}
+
+void
+ClientProxy1_0::flushMotion()
+{
+    if (m_motionHeld) {
+        LOG((CLOG_DEBUG2 "send held mouse move to \"%s\" %d,%d", getName().c_str(), m_xMotion, m_yMotion));
+        MsgDMouseMove::write(getStream(), m_xMotion, m_yMotion);
+        m_motionHeld    = false;
+        m_outputPending = true;
+    }
+    if (m_relativeMotionHeld) {
+        LOG((CLOG_DEBUG2 "send held mouse relative move to \"%s\" %d,%d", getName().c_str(), m_dxMotion, m_dyMotion));
+        MsgDMouseRelMove::write(getStream(), m_dxMotion, m_dyMotion);
+        m_relativeMotionHeld = false;
+        m_dxMotion           = 0;
+        m_dyMotion           = 0;
+        m_outputPending      = true;
+    }
+}
+
 bool
 ClientProxy1_0::recvInfo()
 {
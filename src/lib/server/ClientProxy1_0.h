@@ -20,6 +20,7 @@
 
 #include "server/ClientProxy.h"
 #include "barrier/Clipboard.h"
+#include "barrier/MessageTable.h"
 #include "barrier/protocol_types.h"
 
 class Event;
@@ -62,8 +63,21 @@ public:
     virtual void        fileChunkSending(UInt8 mark, char* data, size_t dataSize);
 
 protected:
-    virtual bool        parseHandshakeMessage(const UInt8* code);
-    virtual bool        parseMessage(const UInt8* code);
+    typedef bool (ClientProxy1_0::*MessageHandler)();
+
+    //! Add message handler
+    /*!
+    Dispatch messages with \c code received after the handshake to
+    \c handler.  Each protocol version adds the messages it introduces.
+    */
+    template <class T>
+    void                addMessageHandler(const char* code, bool (T::*handler)())
+    {
+        m_messages.add(code, static_cast<MessageHandler>(handler));
+    }
+
+    bool                parseHandshakeMessage(const UInt8* code);
+    bool                parseMessage(const UInt8* code);
 
     virtual void        resetHeartbeatRate();
     virtual void        setHeartbeatRate(double rate, double alarm);
@@ -71,6 +85,44 @@ protected:
     virtual void        addHeartbeatTimer();
     virtual void        removeHeartbeatTimer();
     virtual bool        recvClipboard();
+    virtual bool        recvShapeChanged();
+
+    //! Send absolute motion
+    /*!
+    Writes a mouse move now if the client has taken everything sent so
+    far, otherwise holds the position until it has.  A held position is
+    replaced by later ones so a slow client only gets the latest.
+    */
+    void                sendMouseMove(SInt32 xAbs, SInt32 yAbs);
+
+    //! Send relative motion
+    /*!
+    Like sendMouseMove() except held motion is accumulated.
+    */
+    void                sendMouseRelativeMove(SInt32 xRel, SInt32 yRel);
+
+    //! Send held motion
+    /*!
+    Writes any motion held by sendMouseMove() or sendMouseRelativeMove().
+    Must be called before writing any other input so the client sees it
+    in order.
+    */
+    void                flushMotion();
+
+    //! Test if motion would be held
+    /*!
+    Returns true if motion sent now would be held until the client
+    catches up.
+    */
+    bool                isOutputPending() const { return m_outputPending; }
+
+    //! Handle drained output
+    /*!
+    Called when the client has taken everything sent so far, after any
+    held motion is sent.  Subclasses that send data a piece at a time
+    send more.
+    */
+    virtual void        outputFlushed();
 private:
     void                disconnect();
     void                removeHandlers();
@@ -78,9 +130,12 @@ private:
     void                handleData(const Event&, void*);
     void                handleDisconnect(const Event&, void*);
     void                handleWriteError(const Event&, void*);
+    void                handleOutputFlushed(const Event&, void*);
     void                handleFlatline(const Event&, void*);
 
     bool                recvInfo();
+    bool                recvHandshakeInfo();
+    bool                recvNoop();
     bool                recvGrabClipboard();
 
 protected:
@@ -102,6 +157,13 @@ private:
     ClientInfo            m_info;
     double                m_heartbeatAlarm;
     EventQueueTimer*    m_heartbeatTimer;
+    bool                m_outputPending;
+    bool                m_motionHeld;
+    SInt32                m_xMotion, m_yMotion;
+    bool                m_relativeMotionHeld;
+    SInt32                m_dxMotion, m_dyMotion;
     MessageParser        m_parser;
+    MessageTable<MessageHandler>    m_handshakeMessages;
+    MessageTable<MessageHandler>    m_messages;
     IEventQueue*        m_events;
 };
@@ -18,6 +18,7 @@
 
 #include "server/ClientProxy1_3.h"
 
+#include "barrier/ProtocolMessage.h"
 #include "barrier/ProtocolUtil.h"
 #include "base/Log.h"
 #include "base/IEventQueue.h"
@@ -38,6 +39,8 @@ ClientProxy1_3::ClientProxy1_3(const std::string& name, barrier::IStream* stream
     m_events(events)
 {
     setHeartbeatRate(kKeepAliveRate, kKeepAliveRate * kKeepAlivesUntilDeath);
+
+    addMessageHandler(kMsgCKeepAlive, &ClientProxy1_3::recvKeepAlive);
 }
 
 ClientProxy1_3::~ClientProxy1_3()
@@ -49,22 +52,17 @@ ClientProxy1_3::~ClientProxy1_3()
 void
 ClientProxy1_3::mouseWheel(SInt32 xDelta, SInt32 yDelta)
 {
+    flushMotion();
     LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d,%+d", getName().c_str(), xDelta, yDelta));
     ProtocolUtil::writef(getStream(), kMsgDMouseWheel, xDelta, yDelta);
 }
 
 bool
-ClientProxy1_3::parseMessage(const UInt8* code)
+ClientProxy1_3::recvKeepAlive()
 {
-    // process message
-    if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
-        // reset alarm
-        resetHeartbeatTimer();
-        return true;
-    }
-    else {
-        return ClientProxy1_2::parseMessage(code);
-    }
+    // reset alarm
+    resetHeartbeatTimer();
+    return true;
 }
 
 void
@@ -80,14 +78,6 @@ ClientProxy1_3::setHeartbeatRate(double rate, double)
     ClientProxy1_2::setHeartbeatRate(rate, rate * kKeepAlivesUntilDeath);
 }
 
-void
-ClientProxy1_3::resetHeartbeatTimer()
-{
-    // reset the alarm but not the keep alive timer
-    ClientProxy1_2::removeHeartbeatTimer();
-    ClientProxy1_2::addHeartbeatTimer();
-}
-
 void
 ClientProxy1_3::addHeartbeatTimer()
 {
@@ -126,5 +116,5 @@ ClientProxy1_3::handleKeepAlive(const Event&, void*)
 void
 ClientProxy1_3::keepAlive()
 {
-    ProtocolUtil::writef(getStream(), kMsgCKeepAlive);
+    MsgCKeepAlive::write(getStream());
 }
@@ -18,7 +18,6 @@
 #include "server/ClientProxy1_5.h"
 
 #include "server/Server.h"
-#include "barrier/FileChunk.h"
 #include "barrier/StreamChunker.h"
 #include "barrier/ProtocolUtil.h"
 #include "io/IStream.h"
@@ -41,6 +40,9 @@ ClientProxy1_5::ClientProxy1_5(const std::string& name, barrier::IStream* stream
                             this,
                             new TMethodEventJob<ClientProxy1_3>(this,
                                 &ClientProxy1_3::handleKeepAlive, NULL));
+
+    addMessageHandler(kMsgDFileTransfer, &ClientProxy1_5::fileChunkReceived);
+    addMessageHandler(kMsgDDragInfo,     &ClientProxy1_5::dragInfoReceived);
 }
 
 ClientProxy1_5::~ClientProxy1_5()
@@ -51,6 +53,7 @@ ClientProxy1_5::~ClientProxy1_5()
 void
 ClientProxy1_5::sendDragInfo(UInt32 fileCount, const char* info, size_t size)
 {
+    flushMotion();
     std::string data(info, size);
 
     ProtocolUtil::writef(getStream(), kMsgDDragInfo, fileCount, &data);
@@ -63,32 +66,15 @@ ClientProxy1_5::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
 }
 
 bool
-ClientProxy1_5::parseMessage(const UInt8* code)
-{
-    if (memcmp(code, kMsgDFileTransfer, 4) == 0) {
-        fileChunkReceived();
-    }
-    else if (memcmp(code, kMsgDDragInfo, 4) == 0) {
-        dragInfoReceived();
-    }
-    else {
-        return ClientProxy1_4::parseMessage(code);
-    }
-
-    return true;
-}
-
-void
 ClientProxy1_5::fileChunkReceived()
 {
     Server* server = getServer();
-    int result = FileChunk::assemble(
-                    getStream(),
-                    server->getReceivedFileData(),
-                    server->getExpectedFileSize());
-
+    int result = FileChunk::assemble(getStream(), m_fileTransfer);
 
     if (result == kFinish) {
+        server->getReceivedFileData().swap(m_fileTransfer.m_data);
+        server->getExpectedFileSize() = m_fileTransfer.m_progress.getSize();
+        m_fileTransfer.m_data.clear();
         m_events->addEvent(Event(m_events->forFile().fileRecieveCompleted(), server));
     }
     else if (result == kStart) {
@@ -97,9 +83,10 @@ ClientProxy1_5::fileChunkReceived()
             LOG((CLOG_DEBUG "start receiving %s", filename.c_str()));
         }
     }
+    return true;
 }
 
-void
+bool
 ClientProxy1_5::dragInfoReceived()
 {
     // parse
@@ -108,4 +95,5 @@ ClientProxy1_5::dragInfoReceived()
     ProtocolUtil::readf(getStream(), kMsgDDragInfo + 4, &fileNum, &content);
 
     m_server->dragInfoReceived(fileNum, content);
+    return true;
 }
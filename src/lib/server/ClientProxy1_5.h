@@ -18,6 +18,7 @@
 #pragma once
 
 #include "server/ClientProxy1_4.h"
+#include "barrier/FileChunk.h"
 #include "base/Stopwatch.h"
 #include "common/stdvector.h"
 
@@ -33,10 +34,12 @@ public:
 
     virtual void        sendDragInfo(UInt32 fileCount, const char* info, size_t size);
     virtual void        fileChunkSending(UInt8 mark, char* data, size_t dataSize);
-    virtual bool        parseMessage(const UInt8* code);
-    void                fileChunkReceived();
-    void                dragInfoReceived();
+    bool                fileChunkReceived();
+    bool                dragInfoReceived();
 
 private:
     IEventQueue*        m_events;
+
+    // the file being received.  the server gets it once it's complete.
+    FileTransfer        m_fileTransfer;
 };
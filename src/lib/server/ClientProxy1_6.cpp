@@ -19,10 +19,8 @@
 
 #include "server/Server.h"
 #include "barrier/ProtocolUtil.h"
-#include "barrier/StreamChunker.h"
 #include "barrier/ClipboardChunk.h"
 #include "io/IStream.h"
-#include "base/TMethodEventJob.h"
 #include "base/Log.h"
 
 //
@@ -32,12 +30,9 @@
 ClientProxy1_6::ClientProxy1_6(const std::string& name, barrier::IStream* stream, Server* server,
                                IEventQueue* events) :
     ClientProxy1_5(name, stream, server, events),
+    m_clipboardStreamer(stream),
     m_events(events)
 {
-    m_events->adoptHandler(m_events->forClipboard().clipboardSending(),
-                                this,
-                                new TMethodEventJob<ClientProxy1_6>(this,
-                                    &ClientProxy1_6::handleClipboardSendingEvent));
 }
 
 ClientProxy1_6::~ClientProxy1_6()
@@ -53,40 +48,39 @@ ClientProxy1_6::setClipboard(ClipboardID id, const IClipboard* clipboard)
         m_clipboard[id].m_dirty = false;
         Clipboard::copy(&m_clipboard[id].m_clipboard, clipboard);
 
-        std::string data = m_clipboard[id].m_clipboard.marshall();
-
-        size_t size = data.size();
+        // the streamer takes the data of its own copy
+        Clipboard data;
+        Clipboard::copy(&data, clipboard);
         LOG((CLOG_DEBUG "sending clipboard %d to \"%s\"", id, getName().c_str()));
-
-        StreamChunker::sendClipboard(data, size, id, 0, m_events, this);
+        m_clipboardStreamer.send(id, 0, data);
     }
 }
 
 void
-ClientProxy1_6::handleClipboardSendingEvent(const Event& event, void*)
+ClientProxy1_6::outputFlushed()
 {
-    ClipboardChunk::send(getStream(), event.getData());
+    m_clipboardStreamer.flush();
 }
 
 bool
 ClientProxy1_6::recvClipboard()
 {
     // parse message
-    static std::string dataCached;
     ClipboardID id;
     UInt32 seq;
 
-    int r = ClipboardChunk::assemble(getStream(), dataCached, id, seq);
+    int r = ClipboardChunk::assemble(getStream(), m_clipboardTransfer, id, seq);
 
     if (r == kStart) {
-        size_t size = ClipboardChunk::getExpectedSize();
+        size_t size = m_clipboardTransfer[id].m_data.getExpectedSize();
         LOG((CLOG_DEBUG "receiving clipboard %d size=%d", id, size));
     }
     else if (r == kFinish) {
+        ClipboardUnmarshaller& data = m_clipboardTransfer[id].m_data;
         LOG((CLOG_DEBUG "received client \"%s\" clipboard %d seqnum=%d, size=%d",
-                getName().c_str(), id, seq, dataCached.size()));
+                getName().c_str(), id, seq, data.getSize()));
         // save clipboard
-        m_clipboard[id].m_clipboard.unmarshall(dataCached, 0);
+        data.unmarshall(m_clipboard[id].m_clipboard, 0);
         m_clipboard[id].m_sequenceNumber = seq;
 
         // notify
@@ -18,6 +18,8 @@
 #pragma once
 
 #include "server/ClientProxy1_5.h"
+#include "barrier/ClipboardChunk.h"
+#include "barrier/ClipboardStreamer.h"
 
 class Server;
 class IEventQueue;
@@ -32,8 +34,13 @@ public:
     virtual void        setClipboard(ClipboardID id, const IClipboard* clipboard);
     virtual bool        recvClipboard();
 
-private:
-    void                handleClipboardSendingEvent(const Event&, void*);
+protected:
+    // ClientProxy1_0 overrides
+    virtual void        outputFlushed();
+
+protected:
+    ClipboardStreamer    m_clipboardStreamer;
+    ClipboardTransfer    m_clipboardTransfer[kClipboardEnd];
 
 private:
     IEventQueue*        m_events;
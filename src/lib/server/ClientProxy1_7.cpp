@@ -0,0 +1,355 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_7.h"
+
+#include "server/Server.h"
+#include "barrier/LatencyTrace.h"
+#include "barrier/ProtocolMessage.h"
+#include "barrier/option_types.h"
+#include "io/IStream.h"
+#include "base/IEventQueue.h"
+#include "base/TMethodEventJob.h"
+#include "base/Log.h"
+
+// longest time input is held back waiting for more input
+static const double        kInputBatchDelay = 0.001;
+
+// send the batch early once it holds this many bytes
+static const UInt32        kMaxInputBatchSize = 1024;
+
+//
+// ClientProxy1_7
+//
+
+ClientProxy1_7::ClientProxy1_7(const std::string& name, barrier::IStream* stream, Server* server,
+                               IEventQueue* events) :
+    ClientProxy1_6(name, stream, server, events),
+    m_batching(false),
+    m_batchCount(0),
+    m_flushTimer(NULL),
+    m_flushArmed(false),
+    m_tracing(false),
+    m_traceSequence(0),
+    m_events(events)
+{
+    m_batch.reserve(kMaxInputBatchSize + MsgDInputBatch::kSize);
+}
+
+ClientProxy1_7::~ClientProxy1_7()
+{
+    removeFlushTimer();
+}
+
+void
+ClientProxy1_7::enter(SInt32 xAbs, SInt32 yAbs,
+                UInt32 seqNum, KeyModifierMask mask, bool forScreensaver)
+{
+    flushInput();
+    ClientProxy1_6::enter(xAbs, yAbs, seqNum, mask, forScreensaver);
+}
+
+bool
+ClientProxy1_7::leave()
+{
+    flushInput();
+    return ClientProxy1_6::leave();
+}
+
+void
+ClientProxy1_7::setClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+    flushInput();
+    ClientProxy1_6::setClipboard(id, clipboard);
+}
+
+void
+ClientProxy1_7::grabClipboard(ClipboardID id)
+{
+    flushInput();
+    ClientProxy1_6::grabClipboard(id);
+}
+
+void
+ClientProxy1_7::keyDown(KeyID key, KeyModifierMask mask, KeyButton button)
+{
+    traceInput();
+    if (!m_batching) {
+        ClientProxy1_6::keyDown(key, mask, button);
+        return;
+    }
+    LOG((CLOG_DEBUG1 "batch key down to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
+    batchInput<MsgDKeyDown>(key, mask, button);
+}
+
+void
+ClientProxy1_7::keyRepeat(KeyID key, KeyModifierMask mask,
+                SInt32 count, KeyButton button)
+{
+    traceInput();
+    if (!m_batching) {
+        ClientProxy1_6::keyRepeat(key, mask, count, button);
+        return;
+    }
+    LOG((CLOG_DEBUG1 "batch key repeat to \"%s\" id=%d, mask=0x%04x, count=%d, button=0x%04x", getName().c_str(), key, mask, count, button));
+    batchInput<MsgDKeyRepeat>(key, mask, count, button);
+}
+
+void
+ClientProxy1_7::keyUp(KeyID key, KeyModifierMask mask, KeyButton button)
+{
+    traceInput();
+    if (!m_batching) {
+        ClientProxy1_6::keyUp(key, mask, button);
+        return;
+    }
+    LOG((CLOG_DEBUG1 "batch key up to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
+    batchInput<MsgDKeyUp>(key, mask, button);
+}
+
+void
+ClientProxy1_7::mouseDown(ButtonID button)
+{
+    traceInput();
+    if (!m_batching) {
+        ClientProxy1_6::mouseDown(button);
+        return;
+    }
+    LOG((CLOG_DEBUG1 "batch mouse down to \"%s\" id=%d", getName().c_str(), button));
+    batchInput<MsgDMouseDown>(button);
+}
+
+void
+ClientProxy1_7::mouseUp(ButtonID button)
+{
+    traceInput();
+    if (!m_batching) {
+        ClientProxy1_6::mouseUp(button);
+        return;
+    }
+    LOG((CLOG_DEBUG1 "batch mouse up to \"%s\" id=%d", getName().c_str(), button));
+    batchInput<MsgDMouseUp>(button);
+}
+
+void
+ClientProxy1_7::mouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+    // held motion isn't traced
+    if (m_batching || !isOutputPending()) {
+        traceInput();
+    }
+    if (!m_batching) {
+        ClientProxy1_6::mouseMove(xAbs, yAbs);
+        return;
+    }
+    LOG((CLOG_DEBUG2 "batch mouse move to \"%s\" %d,%d", getName().c_str(), xAbs, yAbs));
+    batchInput<MsgDMouseMove>(xAbs, yAbs);
+}
+
+void
+ClientProxy1_7::mouseRelativeMove(SInt32 xRel, SInt32 yRel)
+{
+    // held motion isn't traced
+    if (m_batching || !isOutputPending()) {
+        traceInput();
+    }
+    if (!m_batching) {
+        ClientProxy1_6::mouseRelativeMove(xRel, yRel);
+        return;
+    }
+    LOG((CLOG_DEBUG2 "batch mouse relative move to \"%s\" %d,%d", getName().c_str(), xRel, yRel));
+    batchInput<MsgDMouseRelMove>(xRel, yRel);
+}
+
+void
+ClientProxy1_7::mouseWheel(SInt32 xDelta, SInt32 yDelta)
+{
+    traceInput();
+    if (!m_batching) {
+        ClientProxy1_6::mouseWheel(xDelta, yDelta);
+        return;
+    }
+    LOG((CLOG_DEBUG2 "batch mouse wheel to \"%s\" %+d,%+d", getName().c_str(), xDelta, yDelta));
+    batchInput<MsgDMouseWheel>(xDelta, yDelta);
+}
+
+void
+ClientProxy1_7::screensaver(bool on)
+{
+    flushInput();
+    ClientProxy1_6::screensaver(on);
+}
+
+void
+ClientProxy1_7::resetOptions()
+{
+    flushInput();
+    m_batching = false;
+    m_tracing  = false;
+    ClientProxy1_6::resetOptions();
+}
+
+void
+ClientProxy1_7::setOptions(const OptionsList& options)
+{
+    flushInput();
+    ClientProxy1_6::setOptions(options);
+
+    // check options
+    for (UInt32 i = 0, n = (UInt32)options.size(); i < n; i += 2) {
+        if (options[i] == kOptionInputBatching) {
+            m_batching = (options[i + 1] != 0);
+            LOG((CLOG_DEBUG1 "input batching for \"%s\" %s", getName().c_str(), m_batching ? "on" : "off"));
+        }
+        else if (options[i] == kOptionLatencyTracing) {
+            m_tracing = (options[i + 1] != 0);
+            LOG((CLOG_DEBUG1 "latency tracing for \"%s\" %s", getName().c_str(), m_tracing ? "on" : "off"));
+        }
+    }
+}
+
+void
+ClientProxy1_7::sendDragInfo(UInt32 fileCount, const char* info, size_t size)
+{
+    flushInput();
+    ClientProxy1_6::sendDragInfo(fileCount, info, size);
+}
+
+void
+ClientProxy1_7::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
+{
+    flushInput();
+    ClientProxy1_6::fileChunkSending(mark, data, dataSize);
+}
+
+void
+ClientProxy1_7::keepAlive()
+{
+    flushInput();
+    ClientProxy1_6::keepAlive();
+}
+
+bool
+ClientProxy1_7::recvShapeChanged()
+{
+    // the info acknowledgment must follow any input sent before it
+    flushInput();
+    return ClientProxy1_6::recvShapeChanged();
+}
+
+template <class Message, typename... Values>
+void
+ClientProxy1_7::batchInput(Values... values)
+{
+    // leave room for the batch header.  held motion comes first.
+    if (m_batch.empty()) {
+        flushMotion();
+        m_batch.resize(MsgDInputBatch::kSize);
+    }
+
+    size_t offset = m_batch.size();
+    m_batch.resize(offset + Message::kSize);
+    Message::encode(&m_batch[offset], values...);
+    ++m_batchCount;
+
+    // send now if the batch is full, otherwise by the deadline
+    if (m_batch.size() >= kMaxInputBatchSize || m_batchCount == 0xffff) {
+        flushInput();
+    }
+    else if (!m_flushArmed) {
+        armFlushTimer();
+    }
+}
+
+void
+ClientProxy1_7::flushInput()
+{
+    m_flushArmed = false;
+    if (m_batchCount == 0) {
+        return;
+    }
+
+    if (m_batchCount == 1) {
+        // a batch of one is just the message
+        getStream()->write(&m_batch[MsgDInputBatch::kSize],
+                            (UInt32)m_batch.size() - MsgDInputBatch::kSize);
+    }
+    else {
+        LOG((CLOG_DEBUG2 "send input batch to \"%s\" count=%d size=%d", getName().c_str(), m_batchCount, m_batch.size()));
+        MsgDInputBatch::encode(&m_batch[0], m_batchCount);
+        getStream()->write(&m_batch[0], (UInt32)m_batch.size());
+    }
+
+    m_batch.clear();
+    m_batchCount = 0;
+}
+
+void
+ClientProxy1_7::traceInput()
+{
+    if (!m_tracing) {
+        return;
+    }
+
+    UInt32 start   = LatencyTrace::toTimestamp(m_server->getInputTime());
+    UInt32 written = LatencyTrace::getTimestamp();
+    ++m_traceSequence;
+    if (m_batching) {
+        batchInput<MsgDLatencyTrace>(m_traceSequence, start, written);
+    }
+    else {
+        // the trace must come right before the input it describes
+        flushMotion();
+        MsgDLatencyTrace::write(getStream(), m_traceSequence, start, written);
+    }
+}
+
+void
+ClientProxy1_7::armFlushTimer()
+{
+    // the timer lives as long as the proxy.  a batch only restarts it,
+    // which is much cheaper than replacing the timer and its handler.
+    if (m_flushTimer == NULL) {
+        m_flushTimer = m_events->newOneShotTimer(kInputBatchDelay, NULL);
+        m_events->adoptHandler(Event::kTimer, m_flushTimer,
+                            new TMethodEventJob<ClientProxy1_7>(this,
+                                &ClientProxy1_7::handleFlushTimer));
+    }
+    else {
+        m_events->resetTimer(m_flushTimer);
+    }
+    m_flushArmed = true;
+}
+
+void
+ClientProxy1_7::removeFlushTimer()
+{
+    if (m_flushTimer != NULL) {
+        m_events->removeHandler(Event::kTimer, m_flushTimer);
+        m_events->deleteTimer(m_flushTimer);
+        m_flushTimer = NULL;
+    }
+}
+
+void
+ClientProxy1_7::handleFlushTimer(const Event&, void*)
+{
+    // the timer keeps running after an early flush.  ignore it then.
+    if (m_flushArmed) {
+        flushInput();
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "server/ClientProxy1_6.h"
+#include "common/stdvector.h"
+
+class EventQueueTimer;
+class Server;
+class IEventQueue;
+
+//! Proxy for client implementing protocol version 1.7
+/*!
+When the inputBatching option is enabled, input messages are held for
+up to kInputBatchDelay seconds and sent together as one kMsgDInputBatch
+packet.  Any other message flushes the held input first so the client
+sees messages in the order they were produced.
+
+When the latencyTracing option is enabled, each input message is
+preceded by a kMsgDLatencyTrace with the time the server began
+handling it.
+*/
+class ClientProxy1_7 : public ClientProxy1_6 {
+public:
+    ClientProxy1_7(const std::string& name, barrier::IStream* adoptedStream, Server* server,
+                   IEventQueue* events);
+    ~ClientProxy1_7();
+
+    // IClient overrides
+    virtual void        enter(SInt32 xAbs, SInt32 yAbs,
+                            UInt32 seqNum, KeyModifierMask mask,
+                            bool forScreensaver);
+    virtual bool        leave();
+    virtual void        setClipboard(ClipboardID, const IClipboard*);
+    virtual void        grabClipboard(ClipboardID);
+    virtual void        keyDown(KeyID, KeyModifierMask, KeyButton);
+    virtual void        keyRepeat(KeyID, KeyModifierMask,
+                            SInt32 count, KeyButton);
+    virtual void        keyUp(KeyID, KeyModifierMask, KeyButton);
+    virtual void        mouseDown(ButtonID);
+    virtual void        mouseUp(ButtonID);
+    virtual void        mouseMove(SInt32 xAbs, SInt32 yAbs);
+    virtual void        mouseRelativeMove(SInt32 xRel, SInt32 yRel);
+    virtual void        mouseWheel(SInt32 xDelta, SInt32 yDelta);
+    virtual void        screensaver(bool activate);
+    virtual void        resetOptions();
+    virtual void        setOptions(const OptionsList& options);
+    virtual void        sendDragInfo(UInt32 fileCount, const char* info, size_t size);
+    virtual void        fileChunkSending(UInt8 mark, char* data, size_t dataSize);
+
+protected:
+    // ClientProxy overrides
+    virtual void        keepAlive();
+    virtual bool        recvShapeChanged();
+
+    //! Send the batched input now
+    void                flushInput();
+
+private:
+    // append an encoded input message to the batch
+    template <class Message, typename... Values>
+    void                batchInput(Values... values);
+
+    // send a latency trace for the input about to be sent
+    void                traceInput();
+
+    void                armFlushTimer();
+    void                removeFlushTimer();
+    void                handleFlushTimer(const Event&, void*);
+
+private:
+    bool                m_batching;
+    std::vector<UInt8>    m_batch;
+    UInt16                m_batchCount;
+    EventQueueTimer*    m_flushTimer;
+    bool                m_flushArmed;
+    bool                m_tracing;
+    UInt32                m_traceSequence;
+    IEventQueue*        m_events;
+};
@@ -0,0 +1,334 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_8.h"
+
+#include "barrier/ClipboardCache.h"
+#include "barrier/ClipboardChunk.h"
+#include "barrier/ProtocolUtil.h"
+#include "barrier/protocol_types.h"
+#include "io/IStream.h"
+#include "base/IEventQueue.h"
+#include "base/Log.h"
+
+#include <cstdlib>
+
+//
+// ClientProxy1_8
+//
+
+ClientProxy1_8::ClientProxy1_8(const std::string& name, barrier::IStream* stream, Server* server,
+                               IEventQueue* events) :
+    ClientProxy1_7(name, stream, server, events),
+    m_events(events)
+{
+    for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+        m_summarySequence[id] = 0;
+        m_offered[id]         = false;
+        m_offeredFormats[id]  = 0;
+        m_promised[id]        = false;
+        m_requested[id]       = 0;
+        m_fetching[id]        = false;
+        m_fetchSequence[id]   = 0;
+    }
+    addMessageHandler(kMsgQClipboard, &ClientProxy1_8::recvClipboardQuery);
+    addMessageHandler(kMsgDClipboardOffer, &ClientProxy1_8::recvClipboardOffer);
+}
+
+ClientProxy1_8::~ClientProxy1_8()
+{
+}
+
+bool
+ClientProxy1_8::getClipboardOffer(ClipboardID id, UInt32& formats) const
+{
+    formats = m_offeredFormats[id];
+    return m_offered[id];
+}
+
+void
+ClientProxy1_8::fetchClipboard(ClipboardID id, UInt32 formats)
+{
+    std::vector<UInt32> wanted;
+    for (UInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+        if ((formats & (1u << format)) != 0) {
+            wanted.push_back(format);
+        }
+    }
+
+    // replies to older queries are ignored
+    UInt32 seq     = ++m_fetchSequence[id];
+    m_fetching[id] = true;
+    LOG((CLOG_DEBUG "query client \"%s\" clipboard %d seqnum=%d formats=%d", getName().c_str(), id, seq, (int)wanted.size()));
+    ProtocolUtil::writef(getStream(), kMsgQClipboard, id, seq, &wanted);
+}
+
+bool
+ClientProxy1_8::promiseClipboard(ClipboardID id, UInt32 formats)
+{
+    // ignore if this clipboard is already clean
+    if (!m_clipboard[id].m_dirty) {
+        return true;
+    }
+    flushInput();
+
+    // this clipboard is now clean.  the client asks for the data later.
+    m_clipboard[id].m_dirty = false;
+    m_promised[id]          = true;
+    m_requested[id]         = 0;
+
+    std::vector<UInt32> offered;
+    for (UInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+        if ((formats & (1u << format)) != 0) {
+            offered.push_back(format);
+        }
+    }
+
+    UInt32 seq = ++m_summarySequence[id];
+    LOG((CLOG_DEBUG "sending clipboard %d offer to \"%s\" seqnum=%d formats=%d", id, getName().c_str(), seq, (int)offered.size()));
+    ProtocolUtil::writef(getStream(), kMsgDClipboardOffer, id, seq, &offered);
+    return true;
+}
+
+void
+ClientProxy1_8::fulfilClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+    if (!m_promised[id] || m_requested[id] == 0) {
+        return;
+    }
+    sendFormats(id, m_summarySequence[id], m_requested[id], clipboard);
+    m_requested[id] = 0;
+}
+
+void
+ClientProxy1_8::setClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+    // ignore if this clipboard is already clean
+    if (!m_clipboard[id].m_dirty) {
+        return;
+    }
+    flushInput();
+
+    // this clipboard is now clean
+    m_clipboard[id].m_dirty = false;
+    m_promised[id]          = false;
+    m_requested[id]         = 0;
+    Clipboard::copy(&m_clipboard[id].m_clipboard, clipboard);
+
+    ClipboardCache::Summary summary;
+    ClipboardCache::summarize(&m_clipboard[id].m_clipboard, summary);
+
+    std::vector<UInt32> formats, sizes, hashes;
+    for (size_t i = 0; i < summary.size(); ++i) {
+        formats.push_back(summary[i].m_format);
+        sizes.push_back(summary[i].m_size);
+        hashes.push_back((UInt32)(summary[i].m_hash >> 32));
+        hashes.push_back((UInt32)summary[i].m_hash);
+    }
+
+    UInt32 seq = ++m_summarySequence[id];
+    LOG((CLOG_DEBUG "sending clipboard %d summary to \"%s\" seqnum=%d formats=%d", id, getName().c_str(), seq, (int)formats.size()));
+    ProtocolUtil::writef(getStream(), kMsgDClipboardSummary,
+                            id, seq, &formats, &sizes, &hashes);
+}
+
+bool
+ClientProxy1_8::recvClipboardQuery()
+{
+    // parse message
+    ClipboardID id;
+    UInt32 seq;
+    std::vector<UInt32> formats;
+    if (!ProtocolUtil::readf(getStream(), kMsgQClipboard + 4,
+                            &id, &seq, &formats)) {
+        return false;
+    }
+    LOG((CLOG_DEBUG "recv client \"%s\" clipboard %d query seqnum=%d formats=%d", getName().c_str(), id, seq, (int)formats.size()));
+
+    // validate
+    if (id >= kClipboardEnd) {
+        return false;
+    }
+
+    // the clipboard has changed since.  the client has the new summary.
+    if (seq != m_summarySequence[id]) {
+        LOG((CLOG_DEBUG "ignored query for old clipboard %d summary", id));
+        return true;
+    }
+
+    // the clipboard was offered.  the server may have to fetch the
+    // data first so it answers with fulfilClipboard().
+    if (m_promised[id]) {
+        UInt32 requested = 0;
+        for (size_t i = 0; i < formats.size(); ++i) {
+            if (formats[i] < IClipboard::kNumFormats) {
+                requested |= (1u << formats[i]);
+            }
+        }
+        m_requested[id] |= requested;
+
+        ClipboardRequestInfo* info =
+            (ClipboardRequestInfo*)malloc(sizeof(ClipboardRequestInfo));
+        info->m_id      = id;
+        info->m_formats = requested;
+        m_events->addEvent(Event(m_events->forClipboard().clipboardRequested(),
+                                 getEventTarget(), info));
+        return true;
+    }
+
+    // send just the formats asked for
+    const Clipboard& source = m_clipboard[id].m_clipboard;
+    Clipboard clipboard;
+    if (source.open(0)) {
+        if (clipboard.open(0)) {
+            clipboard.empty();
+            for (size_t i = 0; i < formats.size(); ++i) {
+                IClipboard::EFormat format =
+                    static_cast<IClipboard::EFormat>(formats[i]);
+                if (formats[i] < IClipboard::kNumFormats && source.has(format)) {
+                    clipboard.add(format, source.get(format));
+                }
+            }
+            clipboard.close();
+        }
+        source.close();
+    }
+
+    LOG((CLOG_DEBUG "sending clipboard %d to \"%s\" seqnum=%d", id, getName().c_str(), seq));
+    m_clipboardStreamer.send(id, seq, clipboard);
+    return true;
+}
+
+bool
+ClientProxy1_8::recvClipboardOffer()
+{
+    // parse message
+    ClipboardID id;
+    UInt32 seq;
+    std::vector<UInt32> formats;
+    if (!ProtocolUtil::readf(getStream(), kMsgDClipboardOffer + 4,
+                            &id, &seq, &formats)) {
+        return false;
+    }
+    LOG((CLOG_DEBUG "recv client \"%s\" clipboard %d offer seqnum=%d formats=%d", getName().c_str(), id, seq, (int)formats.size()));
+
+    // validate
+    if (id >= kClipboardEnd) {
+        return false;
+    }
+
+    // skip formats newer than ours, as unmarshalling does
+    UInt32 offered = 0;
+    for (size_t i = 0; i < formats.size(); ++i) {
+        if (formats[i] < IClipboard::kNumFormats) {
+            offered |= (1u << formats[i]);
+        }
+    }
+
+    // none of the data is known yet
+    m_offered[id]        = true;
+    m_offeredFormats[id] = offered;
+    m_fetching[id]       = false;
+    Clipboard& clipboard = m_clipboard[id].m_clipboard;
+    if (clipboard.open(0)) {
+        clipboard.empty();
+        clipboard.close();
+    }
+    m_clipboard[id].m_sequenceNumber = seq;
+
+    // notify
+    ClipboardInfo* info = (ClipboardInfo*)malloc(sizeof(ClipboardInfo));
+    info->m_id             = id;
+    info->m_sequenceNumber = seq;
+    m_events->addEvent(Event(m_events->forClipboard().clipboardChanged(),
+                             getEventTarget(), info));
+    return true;
+}
+
+bool
+ClientProxy1_8::recvClipboard()
+{
+    // parse message
+    ClipboardID id;
+    UInt32 seq;
+
+    int r = ClipboardChunk::assemble(getStream(), m_clipboardTransfer, id, seq);
+
+    if (r == kStart) {
+        size_t size = m_clipboardTransfer[id].m_data.getExpectedSize();
+        LOG((CLOG_DEBUG "receiving clipboard %d size=%d", id, (int)size));
+    }
+    else if (r == kFinish) {
+        ClipboardUnmarshaller& data = m_clipboardTransfer[id].m_data;
+        LOG((CLOG_DEBUG "received client \"%s\" clipboard %d seqnum=%d, size=%d",
+                getName().c_str(), id, seq, (int)data.getSize()));
+
+        if (m_fetching[id] && seq == m_fetchSequence[id]) {
+            // add the fetched formats to the offered clipboard
+            m_fetching[id] = false;
+            data.merge(m_clipboard[id].m_clipboard);
+
+            // notify
+            ClipboardInfo* info = (ClipboardInfo*)malloc(sizeof(ClipboardInfo));
+            info->m_id             = id;
+            info->m_sequenceNumber = m_clipboard[id].m_sequenceNumber;
+            m_events->addEvent(Event(m_events->forClipboard().clipboardFetched(),
+                                     getEventTarget(), info));
+            return true;
+        }
+
+        // save clipboard
+        m_offered[id] = false;
+        data.unmarshall(m_clipboard[id].m_clipboard, 0);
+        m_clipboard[id].m_sequenceNumber = seq;
+
+        // notify
+        ClipboardInfo* info = (ClipboardInfo*)malloc(sizeof(ClipboardInfo));
+        info->m_id             = id;
+        info->m_sequenceNumber = seq;
+        m_events->addEvent(Event(m_events->forClipboard().clipboardChanged(),
+                                 getEventTarget(), info));
+    }
+
+    return true;
+}
+
+void
+ClientProxy1_8::sendFormats(ClipboardID id, UInt32 seq,
+                UInt32 formats, const IClipboard* source)
+{
+    // each format asked for is sent, empty if the clipboard doesn't
+    // have it, so the client knows not to wait for it
+    Clipboard clipboard;
+    if (source->open(0)) {
+        if (clipboard.open(0)) {
+            clipboard.empty();
+            for (UInt32 format = 0; format != IClipboard::kNumFormats; ++format) {
+                IClipboard::EFormat eFormat = static_cast<IClipboard::EFormat>(format);
+                if ((formats & (1u << format)) != 0) {
+                    clipboard.add(eFormat, source->has(eFormat) ?
+                                            source->get(eFormat) : String());
+                }
+            }
+            clipboard.close();
+        }
+        source->close();
+    }
+
+    LOG((CLOG_DEBUG "sending clipboard %d to \"%s\" seqnum=%d", id, getName().c_str(), seq));
+    m_clipboardStreamer.send(id, seq, clipboard);
+}
@@ -0,0 +1,78 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "server/ClientProxy1_7.h"
+
+class Server;
+class IEventQueue;
+
+//! Proxy for client implementing protocol version 1.8
+/*!
+Sends a kMsgDClipboardSummary with the hash of each format instead of
+the clipboard data.  The client asks for the formats it doesn't have
+with kMsgQClipboard and only those are sent.
+
+Clipboards can also be offered with kMsgDClipboardOffer, in either
+direction.  Only the formats are sent and the data follows when the
+other side asks for it with kMsgQClipboard.
+*/
+class ClientProxy1_8 : public ClientProxy1_7 {
+public:
+    ClientProxy1_8(const std::string& name, barrier::IStream* adoptedStream, Server* server,
+                   IEventQueue* events);
+    ~ClientProxy1_8();
+
+    // BaseClientProxy overrides
+    virtual bool        getClipboardOffer(ClipboardID, UInt32& formats) const;
+    virtual void        fetchClipboard(ClipboardID, UInt32 formats);
+    virtual bool        promiseClipboard(ClipboardID, UInt32 formats);
+    virtual void        fulfilClipboard(ClipboardID, const IClipboard*);
+
+    // IClient overrides
+    virtual void        setClipboard(ClipboardID, const IClipboard*);
+
+protected:
+    // ClientProxy1_0 overrides
+    virtual bool        recvClipboard();
+
+private:
+    bool                recvClipboardQuery();
+    bool                recvClipboardOffer();
+
+    void                sendFormats(ClipboardID, UInt32 seq,
+                            UInt32 formats, const IClipboard*);
+
+private:
+    UInt32                m_summarySequence[kClipboardEnd];
+
+    // the client offered its clipboard instead of sending it
+    bool                m_offered[kClipboardEnd];
+    UInt32                m_offeredFormats[kClipboardEnd];
+
+    // the server's clipboard was offered to the client and these are
+    // the formats the client asked for since
+    bool                m_promised[kClipboardEnd];
+    UInt32                m_requested[kClipboardEnd];
+
+    // an outstanding query for offered formats
+    bool                m_fetching[kClipboardEnd];
+    UInt32                m_fetchSequence[kClipboardEnd];
+
+    IEventQueue*        m_events;
+};
@@ -0,0 +1,81 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_9.h"
+
+#include "barrier/protocol_types.h"
+#include "barrier/option_types.h"
+#include "base/Log.h"
+
+//
+// ClientProxy1_9
+//
+
+ClientProxy1_9::ClientProxy1_9(const std::string& name, barrier::IStream* stream, Server* server,
+                               IEventQueue* events) :
+    ClientProxy1_8(name, stream, server, events),
+    m_compression(true)
+{
+    m_clipboardStreamer.setCompression(true);
+}
+
+ClientProxy1_9::~ClientProxy1_9()
+{
+}
+
+void
+ClientProxy1_9::resetOptions()
+{
+    ClientProxy1_8::resetOptions();
+    setCompression(true);
+}
+
+void
+ClientProxy1_9::setOptions(const OptionsList& options)
+{
+    ClientProxy1_8::setOptions(options);
+
+    // check options
+    for (UInt32 i = 0, n = (UInt32)options.size(); i < n; i += 2) {
+        if (options[i] == kOptionCompression) {
+            setCompression(options[i + 1] != 0);
+            LOG((CLOG_DEBUG1 "compression for \"%s\" %s", getName().c_str(), m_compression ? "on" : "off"));
+        }
+    }
+}
+
+void
+ClientProxy1_9::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
+{
+    if (mark == kDataStart) {
+        m_fileCompressor.start();
+    }
+    else if (mark == kDataChunk && m_compression &&
+                m_fileCompressor.compress(data, dataSize, m_compressed)) {
+        ClientProxy1_8::fileChunkSending(kDataCompressed,
+                            &m_compressed[0], m_compressed.size());
+        return;
+    }
+    ClientProxy1_8::fileChunkSending(mark, data, dataSize);
+}
+
+void
+ClientProxy1_9::setCompression(bool compression)
+{
+    m_compression = compression;
+    m_clipboardStreamer.setCompression(compression);
+}
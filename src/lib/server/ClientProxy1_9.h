@@ -0,0 +1,53 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "server/ClientProxy1_8.h"
+#include "barrier/ChunkCompressor.h"
+
+class Server;
+class IEventQueue;
+
+//! Proxy for client implementing protocol version 1.9
+/*!
+Compresses clipboard and file chunks, sending them with a
+kDataCompressed mark, when that makes them smaller.  The compression
+option, on by default, turns this off for links fast enough that
+compressing costs more than it saves.
+*/
+class ClientProxy1_9 : public ClientProxy1_8 {
+public:
+    ClientProxy1_9(const std::string& name, barrier::IStream* adoptedStream, Server* server,
+                   IEventQueue* events);
+    ~ClientProxy1_9();
+
+    // IClient overrides
+    virtual void        resetOptions();
+    virtual void        setOptions(const OptionsList& options);
+
+    // BaseClientProxy overrides
+    virtual void        fileChunkSending(UInt8 mark, char* data, size_t dataSize);
+
+private:
+    void                setCompression(bool compression);
+
+private:
+    bool                m_compression;
+    ChunkCompressor        m_fileCompressor;
+    String                m_compressed;
+};
@@ -26,6 +26,9 @@
 #include "server/ClientProxy1_4.h"
 #include "server/ClientProxy1_5.h"
 #include "server/ClientProxy1_6.h"
+#include "server/ClientProxy1_7.h"
+#include "server/ClientProxy1_8.h"
+#include "server/ClientProxy1_9.h"
 #include "barrier/protocol_types.h"
 #include "barrier/ProtocolUtil.h"
 #include "barrier/XBarrier.h"
@@ -231,6 +234,18 @@ ClientProxyUnknown::handleData(const Event&, void*)
             case 6:
                 m_proxy = new ClientProxy1_6(name, m_stream, m_server, m_events);
                 break;
+
+            case 7:
+                m_proxy = new ClientProxy1_7(name, m_stream, m_server, m_events);
+                break;
+
+            case 8:
+                m_proxy = new ClientProxy1_8(name, m_stream, m_server, m_events);
+                break;
+
+            case 9:
+                m_proxy = new ClientProxy1_9(name, m_stream, m_server, m_events);
+                break;
             }
         }
 
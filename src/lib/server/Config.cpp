@@ -744,6 +744,15 @@ Config::readSectionOptions(ConfigReadContext& s)
 		else if (name == "clipboardSharing") {
 			addOption("", kOptionClipboardSharing, s.parseBoolean(value));
 		}
+		else if (name == "inputBatching") {
+			addOption("", kOptionInputBatching, s.parseBoolean(value));
+		}
+		else if (name == "latencyTracing") {
+			addOption("", kOptionLatencyTracing, s.parseBoolean(value));
+		}
+		else if (name == "compression") {
+			addOption("", kOptionCompression, s.parseBoolean(value));
+		}
 
 		else {
 			handled = false;
@@ -1360,6 +1369,15 @@ Config::getOptionName(OptionID id)
 	if (id == kOptionClipboardSharing) {
 		return "clipboardSharing";
 	}
+	if (id == kOptionInputBatching) {
+		return "inputBatching";
+	}
+	if (id == kOptionLatencyTracing) {
+		return "latencyTracing";
+	}
+	if (id == kOptionCompression) {
+		return "compression";
+	}
 	return NULL;
 }
 
@@ -1376,7 +1394,10 @@ std::string Config::getOptionValue(OptionID id, OptionValue value)
 		id == kOptionRelativeMouseMoves ||
 		id == kOptionWin32KeepForeground ||
 		id == kOptionScreenPreserveFocus ||
-		id == kOptionClipboardSharing) {
+		id == kOptionClipboardSharing ||
+		id == kOptionInputBatching ||
+		id == kOptionLatencyTracing ||
+		id == kOptionCompression) {
 		return (value != 0) ? "true" : "false";
 	}
 	if (id == kOptionModifierMapForShift ||
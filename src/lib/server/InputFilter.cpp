@@ -24,6 +24,7 @@
 #include "base/Log.h"
 #include "base/TMethodEventJob.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
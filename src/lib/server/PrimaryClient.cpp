@@ -137,6 +137,28 @@ PrimaryClient::disable()
     m_screen->disable();
 }
 
+bool
+PrimaryClient::promiseClipboard(ClipboardID id, UInt32 formats)
+{
+    // ignore if this clipboard is already clean
+    if (!m_clipboardDirty[id]) {
+        return true;
+    }
+
+    // the screen asks for the data when an application wants it
+    if (!m_screen->promiseClipboard(id, formats)) {
+        return false;
+    }
+    m_clipboardDirty[id] = false;
+    return true;
+}
+
+void
+PrimaryClient::fulfilClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+    m_screen->fulfilClipboard(id, clipboard);
+}
+
 void
 PrimaryClient::enter(SInt32 xAbs, SInt32 yAbs,
                 UInt32 seqNum, KeyModifierMask mask, bool screensaver)
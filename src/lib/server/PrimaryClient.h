@@ -116,6 +116,10 @@ public:
     virtual void        enable();
     virtual void        disable();
 
+    // BaseClientProxy overrides
+    virtual bool        promiseClipboard(ClipboardID, UInt32 formats);
+    virtual void        fulfilClipboard(ClipboardID, const IClipboard*);
+
     // IScreen overrides
     virtual void*        getEventTarget() const;
     virtual bool        getClipboard(ClipboardID id, IClipboard*) const;
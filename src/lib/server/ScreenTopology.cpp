@@ -0,0 +1,191 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ScreenTopology.h"
+
+#include "server/Config.h"
+
+#include <algorithm>
+
+namespace {
+
+class ClientScreenLess {
+public:
+    bool operator()(const std::pair<const BaseClientProxy*, UInt32>& a,
+                    const BaseClientProxy* b) const
+    {
+        return std::less<const BaseClientProxy*>()(a.first, b);
+    }
+};
+
+}
+
+//
+// ScreenTopology
+//
+
+const UInt32            ScreenTopology::kNoScreen = 0xffffffffu;
+
+ScreenTopology::ScreenTopology()
+{
+    // do nothing
+}
+
+void
+ScreenTopology::compile(const Config& config, const ClientList& clients)
+{
+    // number the screens
+    std::map<std::string, UInt32> ids;
+    Screens screens;
+    for (Config::const_iterator i = config.begin(); i != config.end(); ++i) {
+        ids.insert(std::make_pair(*i, (UInt32)screens.size()));
+
+        ClientList::const_iterator client = clients.find(*i);
+        Screen screen;
+        screen.m_client = (client != clients.end()) ? client->second : NULL;
+        screens.push_back(screen);
+    }
+
+    // copy the links.  they're ordered by side and then by the start
+    // of the interval so each side comes out sorted.
+    for (Config::const_iterator i = config.begin(); i != config.end(); ++i) {
+        Screen& screen = screens[ids[*i]];
+        for (Config::link_const_iterator j = config.beginNeighbor(*i);
+                                    j != config.endNeighbor(*i); ++j) {
+            std::map<std::string, UInt32>::const_iterator dst =
+                ids.find(config.getCanonicalName(j->second.getName()));
+            if (dst == ids.end()) {
+                continue;
+            }
+
+            Link link;
+            link.m_start    = j->first.getInterval().first;
+            link.m_end      = j->first.getInterval().second;
+            link.m_dstStart = j->second.getInterval().first;
+            link.m_dstEnd   = j->second.getInterval().second;
+            link.m_dst      = dst->second;
+            link.m_client   = screens[dst->second].m_client;
+            screen.m_links[j->first.getSide() - kFirstDirection].push_back(link);
+        }
+    }
+
+    ClientScreens clientScreens;
+    for (UInt32 id = 0; id != (UInt32)screens.size(); ++id) {
+        if (screens[id].m_client != NULL) {
+            clientScreens.push_back(std::make_pair(screens[id].m_client, id));
+        }
+    }
+    std::sort(clientScreens.begin(), clientScreens.end());
+
+    // cut over
+    m_screens.swap(screens);
+    m_clientScreens.swap(clientScreens);
+}
+
+BaseClientProxy*
+ScreenTopology::getNeighbor(const BaseClientProxy* src, EDirection dir,
+                            float position, float& positionOut) const
+{
+    // each step moves to another screen so a walk longer than the
+    // number of screens is going round in circles through screens
+    // that aren't connected
+    UInt32 screen = findScreen(src);
+    for (size_t n = 0; n != m_screens.size(); ++n) {
+        const Link* link = findLink(screen, dir, position);
+        if (link == NULL) {
+            return NULL;
+        }
+
+        // compute position on neighbor
+        float fraction = (position - link->m_start) /
+                            (link->m_end - link->m_start);
+        position = fraction * (link->m_dstEnd - link->m_dstStart) +
+                            link->m_dstStart;
+        if (link->m_client != NULL) {
+            positionOut = position;
+            return link->m_client;
+        }
+
+        // skip over unconnected screen
+        screen = link->m_dst;
+    }
+    return NULL;
+}
+
+bool
+ScreenTopology::hasNeighbor(const BaseClientProxy* client,
+                            EDirection dir, float position) const
+{
+    return (findLink(findScreen(client), dir, position) != NULL);
+}
+
+bool
+ScreenTopology::hasNeighbor(const BaseClientProxy* client, EDirection dir) const
+{
+    assert(dir >= kFirstDirection && dir <= kLastDirection);
+
+    UInt32 screen = findScreen(client);
+    if (screen == kNoScreen) {
+        return false;
+    }
+    return !m_screens[screen].m_links[dir - kFirstDirection].empty();
+}
+
+size_t
+ScreenTopology::getNumScreens() const
+{
+    return m_screens.size();
+}
+
+UInt32
+ScreenTopology::findScreen(const BaseClientProxy* client) const
+{
+    ClientScreens::const_iterator i =
+        std::lower_bound(m_clientScreens.begin(), m_clientScreens.end(),
+                            client, ClientScreenLess());
+    if (i == m_clientScreens.end() || i->first != client) {
+        return kNoScreen;
+    }
+    return i->second;
+}
+
+const ScreenTopology::Link*
+ScreenTopology::findLink(UInt32 screen, EDirection dir, float position) const
+{
+    assert(dir >= kFirstDirection && dir <= kLastDirection);
+
+    if (screen == kNoScreen) {
+        return NULL;
+    }
+
+    // find the last link starting at or before the position
+    const Links& links = m_screens[screen].m_links[dir - kFirstDirection];
+    size_t lo = 0, hi = links.size();
+    while (lo != hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (position < links[mid].m_start) {
+            hi = mid;
+        }
+        else {
+            lo = mid + 1;
+        }
+    }
+    if (lo == 0 || !(position < links[lo - 1].m_end)) {
+        return NULL;
+    }
+    return &links[lo - 1];
+}
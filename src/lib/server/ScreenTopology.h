@@ -0,0 +1,121 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "barrier/protocol_types.h"
+#include "common/stdmap.h"
+#include "common/stdvector.h"
+
+#include <string>
+
+class BaseClientProxy;
+class Config;
+
+//! Compiled screen layout
+/*!
+A copy of the links in a Config indexed by integer screen IDs instead
+of names.  Each side of each screen has its links sorted by position
+and each link points at the client of the neighboring screen, or NULL
+if it isn't connected, so finding a neighbor needs no string compares
+or allocations.  It must be compiled again whenever the configuration
+or the set of connected clients changes.
+*/
+class ScreenTopology {
+public:
+    //! Connected clients by canonical screen name
+    typedef std::map<std::string, BaseClientProxy*> ClientList;
+
+    ScreenTopology();
+
+    //! @name manipulators
+    //@{
+
+    //! Compile the layout
+    /*!
+    Replaces the layout with the screens and links in \c config and the
+    connected clients in \c clients.
+    */
+    void                compile(const Config& config, const ClientList& clients);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get neighbor
+    /*!
+    Returns the closest connected client in direction \c dir of \c src
+    at \c position, a fraction of the edge, and saves the position on
+    that client in \c positionOut.  Screens that aren't connected are
+    skipped over.  Returns NULL if there's no connected neighbor.
+    */
+    BaseClientProxy*    getNeighbor(const BaseClientProxy* src, EDirection dir,
+                            float position, float& positionOut) const;
+
+    //! Check for neighbor
+    /*!
+    Returns true if \c client's screen has a neighbor, connected or not,
+    at \c position along the edge given by the direction.
+    */
+    bool                hasNeighbor(const BaseClientProxy* client,
+                            EDirection dir, float position) const;
+
+    //! Check for neighbor
+    /*!
+    Returns true if \c client's screen has a neighbor, connected or not,
+    anywhere along the edge given by the direction.
+    */
+    bool                hasNeighbor(const BaseClientProxy* client,
+                            EDirection dir) const;
+
+    //! Get number of screens
+    size_t              getNumScreens() const;
+
+    //@}
+
+private:
+    class Link {
+    public:
+        float            m_start;
+        float            m_end;
+        float            m_dstStart;
+        float            m_dstEnd;
+        UInt32            m_dst;
+        BaseClientProxy*    m_client;
+    };
+    typedef std::vector<Link> Links;
+
+    class Screen {
+    public:
+        BaseClientProxy*    m_client;
+        Links            m_links[kNumDirections];
+    };
+    typedef std::vector<Screen> Screens;
+    typedef std::pair<const BaseClientProxy*, UInt32> ClientScreen;
+    typedef std::vector<ClientScreen> ClientScreens;
+
+    UInt32                findScreen(const BaseClientProxy*) const;
+    const Link*            findLink(UInt32 screen, EDirection, float position) const;
+
+private:
+    static const UInt32    kNoScreen;
+
+    Screens                m_screens;
+
+    // screen of each connected client, sorted by client
+    ClientScreens        m_clientScreens;
+};
@@ -42,6 +42,7 @@
 #include "base/TMethodJob.h"
 #include "base/IEventQueue.h"
 #include "base/Log.h"
+#include "base/TraceLog.h"
 #include "base/TMethodEventJob.h"
 
 #include <cstring>
@@ -83,6 +84,8 @@ Server::Server(
 	m_switchNeedsControl(false),
 	m_switchNeedsAlt(false),
 	m_relativeMoves(false),
+	m_latencyTracing(false),
+	m_inputTime(0.0),
 	m_keyboardBroadcasting(false),
 	m_lockedToScreen(false),
 	m_screen(screen),
@@ -283,6 +286,7 @@ Server::setConfig(const Config& config)
 
 	// cut over
 	processOptions();
+	compileTopology();
 
 	// add ScrollLock as a hotkey to lock to the screen.  this was a
 	// built-in feature in earlier releases and is now supported via
@@ -512,7 +516,7 @@ Server::switchScreen(BaseClientProxy* dst,
 		if (m_enableClipboard) {
 			// send the clipboard data to new active screen
 			for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
-				m_active->setClipboard(id, &m_clipboards[id].m_clipboard);
+				sendClipboard(m_active, id);
 			}
 		}
 
@@ -590,7 +594,7 @@ Server::hasAnyNeighbor(BaseClientProxy* client, EDirection dir) const
 {
 	assert(client != NULL);
 
-	return m_config->hasNeighbor(getName(client), dir);
+	return m_topology.hasNeighbor(client, dir);
 }
 
 BaseClientProxy*
@@ -601,44 +605,21 @@ Server::getNeighbor(BaseClientProxy* src,
 
 	assert(src != NULL);
 
-	// get source screen name
-    std::string srcName = getName(src);
-	assert(!srcName.empty());
-	LOG((CLOG_DEBUG2 "find neighbor on %s of \"%s\"", Config::dirName(dir), srcName.c_str()));
-
 	// convert position to fraction
 	float t = mapToFraction(src, dir, x, y);
 
-	// search for the closest neighbor that exists in direction dir
-	float tTmp;
-	for (;;) {
-        std::string dstName(m_config->getNeighbor(srcName, dir, t, &tTmp));
-
-		// if nothing in that direction then return NULL. if the
-		// destination is the source then we can make no more
-		// progress in this direction.  since we haven't found a
-		// connected neighbor we return NULL.
-		if (dstName.empty()) {
-			LOG((CLOG_DEBUG2 "no neighbor on %s of \"%s\"", Config::dirName(dir), srcName.c_str()));
-			return NULL;
-		}
-
-		// look up neighbor cell.  if the screen is connected and
-		// ready then we can stop.
-		ClientList::const_iterator index = m_clients.find(dstName);
-		if (index != m_clients.end()) {
-			LOG((CLOG_DEBUG2 "\"%s\" is on %s of \"%s\" at %f", dstName.c_str(), Config::dirName(dir), srcName.c_str(), t));
-			mapToPixel(index->second, dir, tTmp, x, y);
-			return index->second;
-		}
-
-		// skip over unconnected screen
-		LOG((CLOG_DEBUG2 "ignored \"%s\" on %s of \"%s\"", dstName.c_str(), Config::dirName(dir), srcName.c_str()));
-		srcName = dstName;
-
-		// use position on skipped screen
-		t = tTmp;
+	// search for the closest neighbor that exists in direction dir,
+	// skipping over unconnected screens
+	float tDst;
+	BaseClientProxy* dst = m_topology.getNeighbor(src, dir, t, tDst);
+	if (dst == NULL) {
+		LOGC(CLOG->getFilter() >= kDEBUG2, (CLOG_DEBUG2 "no neighbor on %s of \"%s\"", Config::dirName(dir), getName(src).c_str()));
+		return NULL;
 	}
+
+	LOGC(CLOG->getFilter() >= kDEBUG2, (CLOG_DEBUG2 "\"%s\" is on %s of \"%s\" at %f", getName(dst).c_str(), Config::dirName(dir), getName(src).c_str(), t));
+	mapToPixel(dst, dir, tDst, x, y);
+	return dst;
 }
 
 BaseClientProxy*
@@ -757,7 +738,6 @@ Server::avoidJumpZone(BaseClientProxy* dst,
 		return;
 	}
 
-    const std::string dstName(getName(dst));
 	SInt32 dx, dy, dw, dh;
 	dst->getShape(dx, dy, dw, dh);
 	float t = mapToFraction(dst, dir, x, y);
@@ -768,25 +748,25 @@ Server::avoidJumpZone(BaseClientProxy* dst,
 	// don't need to move inwards because that side can't provoke a jump.
 	switch (dir) {
 	case kLeft:
-		if (!m_config->getNeighbor(dstName, kRight, t, NULL).empty() &&
+		if (m_topology.hasNeighbor(dst, kRight, t) &&
 			x > dx + dw - 1 - z)
 			x = dx + dw - 1 - z;
 		break;
 
 	case kRight:
-		if (!m_config->getNeighbor(dstName, kLeft, t, NULL).empty() &&
+		if (m_topology.hasNeighbor(dst, kLeft, t) &&
 			x < dx + z)
 			x = dx + z;
 		break;
 
 	case kTop:
-		if (!m_config->getNeighbor(dstName, kBottom, t, NULL).empty() &&
+		if (m_topology.hasNeighbor(dst, kBottom, t) &&
 			y > dy + dh - 1 - z)
 			y = dy + dh - 1 - z;
 		break;
 
 	case kBottom:
-		if (!m_config->getNeighbor(dstName, kTop, t, NULL).empty() &&
+		if (m_topology.hasNeighbor(dst, kTop, t) &&
 			y < dy + z)
 			y = dy + z;
 		break;
@@ -1171,6 +1151,9 @@ Server::processOptions()
 		else if (id == kOptionRelativeMouseMoves) {
 			newRelativeMoves = (value != 0);
 		}
+		else if (id == kOptionLatencyTracing) {
+			m_latencyTracing = (value != 0);
+		}
 		else if (id == kOptionClipboardSharing) {
 			m_enableClipboard = (value != 0);
 
@@ -1246,6 +1229,10 @@ Server::handleClipboardGrabbed(const Event& event, void* vclient)
 	LOG((CLOG_INFO "screen \"%s\" grabbed clipboard %d from \"%s\"", getName(grabber).c_str(), info->m_id, clipboard.m_clipboardOwner.c_str()));
 	clipboard.m_clipboardOwner  = getName(grabber);
 	clipboard.m_clipboardSeqNum = info->m_sequenceNumber;
+	clipboard.m_promised        = false;
+	clipboard.m_formats         = 0;
+	clipboard.m_wanted          = 0;
+	clipboard.m_fetching        = false;
 
 	// clear the clipboard data (since it's not known at this point)
 	if (clipboard.m_clipboard.open(0)) {
@@ -1281,9 +1268,78 @@ Server::handleClipboardChanged(const Event& event, void* vclient)
 	onClipboardChanged(sender, info->m_id, info->m_sequenceNumber);
 }
 
+void
+Server::handleClipboardRequested(const Event& event, void* vclient)
+{
+	// ignore events from unknown clients
+	BaseClientProxy* client = static_cast<BaseClientProxy*>(vclient);
+	if (m_clientSet.count(client) == 0) {
+		return;
+	}
+	const IScreen::ClipboardRequestInfo* info =
+		static_cast<const IScreen::ClipboardRequestInfo*>(event.getData());
+	ClipboardInfo& clipboard = m_clipboards[info->m_id];
+
+	// the data is here already
+	if (!clipboard.m_promised) {
+		client->fulfilClipboard(info->m_id, &clipboard.m_clipboard);
+		return;
+	}
+
+	// fetch what's offered and not fetched yet
+	LOG((CLOG_DEBUG "screen \"%s\" requested clipboard %d", getName(client).c_str(), info->m_id));
+	UInt32 fetched = IClipboard::getFormats(&clipboard.m_clipboard);
+	clipboard.m_wanted |= (info->m_formats & clipboard.m_formats & ~fetched);
+	fetchClipboard(info->m_id);
+}
+
+void
+Server::handleClipboardFetched(const Event& event, void* vclient)
+{
+	// ignore events from unknown clients
+	BaseClientProxy* sender = static_cast<BaseClientProxy*>(vclient);
+	if (m_clientSet.count(sender) == 0) {
+		return;
+	}
+	const IScreen::ClipboardInfo* info =
+		static_cast<const IScreen::ClipboardInfo*>(event.getData());
+	ClipboardInfo& clipboard = m_clipboards[info->m_id];
+
+	// ignore if the clipboard has changed hands since
+	ClientList::const_iterator owner = m_clients.find(clipboard.m_clipboardOwner);
+	if (!clipboard.m_fetching || owner == m_clients.end() ||
+		owner->second != sender) {
+		LOG((CLOG_DEBUG "ignored screen \"%s\" clipboard %d data (not fetching)", getName(sender).c_str(), info->m_id));
+		return;
+	}
+	clipboard.m_fetching = false;
+	sender->getClipboard(info->m_id, &clipboard.m_clipboard);
+
+	// once every format is here the clipboard is like any other
+	UInt32 fetched = IClipboard::getFormats(&clipboard.m_clipboard);
+	if ((clipboard.m_formats & ~fetched) == 0) {
+		LOG((CLOG_INFO "screen \"%s\" updated clipboard %d", clipboard.m_clipboardOwner.c_str(), info->m_id));
+		clipboard.m_promised      = false;
+		clipboard.m_clipboardData = clipboard.m_clipboard.marshall();
+		m_active->setClipboard(info->m_id, &clipboard.m_clipboard);
+	}
+
+	// fetch anything requested meanwhile or answer the requests
+	fetchClipboard(info->m_id);
+}
+
+void
+Server::startInputTrace()
+{
+	if (m_latencyTracing) {
+		m_inputTime = ARCH->time();
+	}
+}
+
 void
 Server::handleKeyDownEvent(const Event& event, void*)
 {
+	startInputTrace();
 	IPlatformScreen::KeyInfo* info =
 		static_cast<IPlatformScreen::KeyInfo*>(event.getData());
 	onKeyDown(info->m_key, info->m_mask, info->m_button, info->m_screens);
@@ -1292,6 +1348,7 @@ Server::handleKeyDownEvent(const Event& event, void*)
 void
 Server::handleKeyUpEvent(const Event& event, void*)
 {
+	startInputTrace();
 	IPlatformScreen::KeyInfo* info =
 		 static_cast<IPlatformScreen::KeyInfo*>(event.getData());
 	onKeyUp(info->m_key, info->m_mask, info->m_button, info->m_screens);
@@ -1300,6 +1357,7 @@ Server::handleKeyUpEvent(const Event& event, void*)
 void
 Server::handleKeyRepeatEvent(const Event& event, void*)
 {
+	startInputTrace();
 	IPlatformScreen::KeyInfo* info =
 		static_cast<IPlatformScreen::KeyInfo*>(event.getData());
 	onKeyRepeat(info->m_key, info->m_mask, info->m_count, info->m_button);
@@ -1308,6 +1366,7 @@ Server::handleKeyRepeatEvent(const Event& event, void*)
 void
 Server::handleButtonDownEvent(const Event& event, void*)
 {
+	startInputTrace();
 	IPlatformScreen::ButtonInfo* info =
 		static_cast<IPlatformScreen::ButtonInfo*>(event.getData());
 	onMouseDown(info->m_button);
@@ -1316,6 +1375,7 @@ Server::handleButtonDownEvent(const Event& event, void*)
 void
 Server::handleButtonUpEvent(const Event& event, void*)
 {
+	startInputTrace();
 	IPlatformScreen::ButtonInfo* info =
 		static_cast<IPlatformScreen::ButtonInfo*>(event.getData());
 	onMouseUp(info->m_button);
@@ -1324,6 +1384,7 @@ Server::handleButtonUpEvent(const Event& event, void*)
 void
 Server::handleMotionPrimaryEvent(const Event& event, void*)
 {
+	startInputTrace();
 	IPlatformScreen::MotionInfo* info =
 		static_cast<IPlatformScreen::MotionInfo*>(event.getData());
 	onMouseMovePrimary(info->m_x, info->m_y);
@@ -1332,6 +1393,7 @@ Server::handleMotionPrimaryEvent(const Event& event, void*)
 void
 Server::handleMotionSecondaryEvent(const Event& event, void*)
 {
+	startInputTrace();
 	IPlatformScreen::MotionInfo* info =
 		static_cast<IPlatformScreen::MotionInfo*>(event.getData());
 	onMouseMoveSecondary(info->m_x, info->m_y);
@@ -1340,6 +1402,7 @@ Server::handleMotionSecondaryEvent(const Event& event, void*)
 void
 Server::handleWheelEvent(const Event& event, void*)
 {
+	startInputTrace();
 	IPlatformScreen::WheelInfo* info =
 		static_cast<IPlatformScreen::WheelInfo*>(event.getData());
 	onMouseWheel(info->m_xDelta, info->m_yDelta);
@@ -1549,8 +1612,31 @@ Server::onClipboardChanged(BaseClientProxy* sender,
 	// should be the expected client
 	assert(sender == m_clients.find(clipboard.m_clipboardOwner)->second);
 
-	// get data
+	// the data stays with the owner until a screen wants it
+	UInt32 formats;
+	if (sender->getClipboardOffer(id, formats)) {
+		LOG((CLOG_INFO "screen \"%s\" offered clipboard %d", clipboard.m_clipboardOwner.c_str(), id));
+		clipboard.m_promised = true;
+		clipboard.m_formats  = formats;
+		clipboard.m_wanted   = 0;
+		clipboard.m_fetching = false;
+		sender->getClipboard(id, &clipboard.m_clipboard);
+		clipboard.m_clipboardData.clear();
+
+		for (ClientList::const_iterator index = m_clients.begin();
+									index != m_clients.end(); ++index) {
+			BaseClientProxy* client = index->second;
+			client->setClipboardDirty(id, client != sender);
+		}
+		sendClipboard(m_active, id);
+		return;
+	}
+
+	// get data.  it replaces any earlier offer.
 	sender->getClipboard(id, &clipboard.m_clipboard);
+	clipboard.m_promised = false;
+	clipboard.m_wanted   = 0;
+	clipboard.m_fetching = false;
 
 	// ignore if data hasn't changed
     std::string data = clipboard.m_clipboard.marshall();
@@ -1574,6 +1660,52 @@ Server::onClipboardChanged(BaseClientProxy* sender,
 	m_active->setClipboard(id, &clipboard.m_clipboard);
 }
 
+void
+Server::sendClipboard(BaseClientProxy* client, ClipboardID id)
+{
+	ClipboardInfo& clipboard = m_clipboards[id];
+	if (!clipboard.m_promised) {
+		client->setClipboard(id, &clipboard.m_clipboard);
+	}
+	else if (!client->promiseClipboard(id, clipboard.m_formats)) {
+		// the client needs all of the data now
+		UInt32 fetched = IClipboard::getFormats(&clipboard.m_clipboard);
+		clipboard.m_wanted |= (clipboard.m_formats & ~fetched);
+		fetchClipboard(id);
+	}
+}
+
+void
+Server::fetchClipboard(ClipboardID id)
+{
+	ClipboardInfo& clipboard = m_clipboards[id];
+	if (clipboard.m_fetching) {
+		return;
+	}
+
+	// the owner may have gone.  the requests get what there is.
+	ClientList::const_iterator owner = m_clients.find(clipboard.m_clipboardOwner);
+	if (clipboard.m_wanted != 0 && owner == m_clients.end()) {
+		clipboard.m_promised      = false;
+		clipboard.m_wanted        = 0;
+		clipboard.m_clipboardData = clipboard.m_clipboard.marshall();
+		m_active->setClipboard(id, &clipboard.m_clipboard);
+	}
+
+	if (clipboard.m_wanted != 0) {
+		clipboard.m_fetching = true;
+		owner->second->fetchClipboard(id, clipboard.m_wanted);
+		clipboard.m_wanted   = 0;
+		return;
+	}
+
+	// everything requested is here
+	for (ClientList::const_iterator index = m_clients.begin();
+								index != m_clients.end(); ++index) {
+		index->second->fulfilClipboard(id, &clipboard.m_clipboard);
+	}
+}
+
 void
 Server::onScreensaver(bool activated)
 {
@@ -1737,7 +1869,7 @@ Server::onMouseUp(ButtonID id)
 bool
 Server::onMouseMovePrimary(SInt32 x, SInt32 y)
 {
-	LOG((CLOG_DEBUG4 "onMouseMovePrimary %d,%d", x, y));
+	LOGT((CLOG_DEBUG4 "onMouseMovePrimary %d,%d", x, y));
 
 	// mouse move on primary (server's) screen
 	if (m_active != m_primaryClient) {
@@ -1895,7 +2027,7 @@ Server::sendDragInfo(BaseClientProxy* newScreen)
 void
 Server::onMouseMoveSecondary(SInt32 dx, SInt32 dy)
 {
-	LOG((CLOG_DEBUG2 "onMouseMoveSecondary %+d,%+d", dx, dy));
+	LOGT((CLOG_DEBUG2 "onMouseMoveSecondary %+d,%+d", dx, dy));
 
 	// mouse move on secondary (client's) screen
 	assert(m_active != NULL);
@@ -2127,10 +2259,19 @@ Server::addClient(BaseClientProxy* client)
 							client->getEventTarget(),
 							new TMethodEventJob<Server>(this,
 								&Server::handleClipboardChanged, client));
+	m_events->adoptHandler(m_events->forClipboard().clipboardRequested(),
+							client->getEventTarget(),
+							new TMethodEventJob<Server>(this,
+								&Server::handleClipboardRequested, client));
+	m_events->adoptHandler(m_events->forClipboard().clipboardFetched(),
+							client->getEventTarget(),
+							new TMethodEventJob<Server>(this,
+								&Server::handleClipboardFetched, client));
 
 	// add to list
 	m_clientSet.insert(client);
 	m_clients.insert(std::make_pair(name, client));
+	compileTopology();
 
 	// initialize client data
 	SInt32 x, y;
@@ -2159,14 +2300,44 @@ Server::removeClient(BaseClientProxy* client)
 							client->getEventTarget());
 	m_events->removeHandler(m_events->forClipboard().clipboardChanged(),
 							client->getEventTarget());
+	m_events->removeHandler(m_events->forClipboard().clipboardRequested(),
+							client->getEventTarget());
+	m_events->removeHandler(m_events->forClipboard().clipboardFetched(),
+							client->getEventTarget());
 
 	// remove from list
-	m_clients.erase(getName(client));
+    std::string name = getName(client);
+	m_clients.erase(name);
 	m_clientSet.erase(i);
+	compileTopology();
+
+	// the clipboards it offered can't be fetched any more, even if it
+	// reconnects.  screens waiting for the data get what there is.
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		ClipboardInfo& clipboard = m_clipboards[id];
+		if (!clipboard.m_promised || clipboard.m_clipboardOwner != name) {
+			continue;
+		}
+		LOG((CLOG_DEBUG "screen \"%s\" left without sending clipboard %d", name.c_str(), id));
+		clipboard.m_promised      = false;
+		clipboard.m_wanted        = 0;
+		clipboard.m_fetching      = false;
+		clipboard.m_clipboardData = clipboard.m_clipboard.marshall();
+		for (ClientList::const_iterator index = m_clients.begin();
+									index != m_clients.end(); ++index) {
+			index->second->fulfilClipboard(id, &clipboard.m_clipboard);
+		}
+	}
 
 	return true;
 }
 
+void
+Server::compileTopology()
+{
+	m_topology.compile(*m_config, m_clients);
+}
+
 void
 Server::closeClient(BaseClientProxy* client, const char* msg)
 {
@@ -2308,7 +2479,11 @@ Server::ClipboardInfo::ClipboardInfo() :
 	m_clipboard(),
 	m_clipboardData(),
 	m_clipboardOwner(),
-	m_clipboardSeqNum(0)
+	m_clipboardSeqNum(0),
+	m_promised(false),
+	m_formats(0),
+	m_wanted(0),
+	m_fetching(false)
 {
 	// do nothing
 }
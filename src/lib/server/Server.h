@@ -19,6 +19,7 @@
 #pragma once
 
 #include "server/Config.h"
+#include "server/ScreenTopology.h"
 #include "barrier/clipboard_types.h"
 #include "barrier/Clipboard.h"
 #include "barrier/key_types.h"
@@ -179,6 +180,14 @@ public:
     //! Return fake drag file list
     DragFileList        getFakeDragFileList() { return m_fakeDragFileList; }
 
+    //! Get input time
+    /*!
+    Returns the time, from ARCH->time(), that the server began handling
+    the primary screen input event being relayed.  Only kept when the
+    latencyTracing option is enabled, otherwise returns 0.
+    */
+    double                getInputTime() const { return m_inputTime; }
+
     //@}
 
 private:
@@ -290,10 +299,23 @@ private:
     // process options from configuration
     void                processOptions();
 
+    // note when the current input event arrived if tracing latency
+    void                startInputTrace();
+
+    // send clipboard \c id to \c client, fetching offered data first
+    // if the client can't take a promise
+    void                sendClipboard(BaseClientProxy* client, ClipboardID id);
+
+    // fetch the wanted formats of offered clipboard \c id from its
+    // owner, or fulfil the clients' requests once there are none
+    void                fetchClipboard(ClipboardID id);
+
     // event handlers
     void                handleShapeChanged(const Event&, void*);
     void                handleClipboardGrabbed(const Event&, void*);
     void                handleClipboardChanged(const Event&, void*);
+    void                handleClipboardRequested(const Event&, void*);
+    void                handleClipboardFetched(const Event&, void*);
     void                handleKeyDownEvent(const Event&, void*);
     void                handleKeyUpEvent(const Event&, void*);
     void                handleKeyRepeatEvent(const Event&, void*);
@@ -340,6 +362,9 @@ private:
     // remove client from list and detach event handlers for client
     bool                removeClient(BaseClientProxy*);
 
+    // rebuild the compiled layout from the configuration and clients
+    void                compileTopology();
+
     // close a client
     void                closeClient(BaseClientProxy*, const char* msg);
 
@@ -382,6 +407,16 @@ private:
         std::string m_clipboardData;
         std::string m_clipboardOwner;
         UInt32            m_clipboardSeqNum;
+
+        // the owner only offered these formats.  m_clipboard has the
+        // ones fetched so far.
+        bool            m_promised;
+        UInt32            m_formats;
+
+        // formats to fetch from the owner and whether a fetch is
+        // outstanding
+        UInt32            m_wanted;
+        bool            m_fetching;
     };
 
     // the primary screen client
@@ -417,6 +452,9 @@ private:
     // current configuration
     Config*                m_config;
 
+    // m_config and m_clients compiled for finding neighbors
+    ScreenTopology        m_topology;
+
     // input filter (from m_config);
     InputFilter*        m_inputFilter;
 
@@ -452,6 +490,10 @@ private:
     // relative mouse move option
     bool                m_relativeMoves;
 
+    // latency tracing option and when the current input event arrived
+    bool                m_latencyTracing;
+    double                m_inputTime;
+
     // flag whether or not we have broadcasting enabled and the screens to
     // which we should send broadcasted keys.
     bool                m_keyboardBroadcasting;
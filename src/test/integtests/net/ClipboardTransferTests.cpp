@@ -0,0 +1,683 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#define BARRIER_TEST_ENV
+
+#include "test/mock/server/MockConfig.h"
+#include "test/mock/server/MockPrimaryClient.h"
+#include "test/mock/barrier/MockScreen.h"
+#include "test/mock/server/MockInputFilter.h"
+#include "test/global/TestEventQueue.h"
+#include "server/Server.h"
+#include "server/ClientListener.h"
+#include "server/ClientProxy.h"
+#include "client/Client.h"
+#include "barrier/Clipboard.h"
+#include "barrier/option_types.h"
+#include "net/SocketMultiplexer.h"
+#include "net/NetworkAddress.h"
+#include "net/TCPSocketFactory.h"
+#include "net/TCPSocket.h"
+#include "arch/Arch.h"
+#include "base/ILogOutputter.h"
+#include "base/Stopwatch.h"
+#include "base/TMethodEventJob.h"
+#include "base/Log.h"
+
+#include "test/global/gtest.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using ::testing::_;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::Invoke;
+using ::testing::DoAll;
+using ::testing::SetArgReferee;
+
+#define TEST_CLIPBOARD_PORT 24806
+#define TEST_CLIPBOARD_HOST "localhost"
+
+// a 4K screenshot
+const SInt32 kScreenshotWidth = 3840;
+const SInt32 kScreenshotHeight = 2160;
+
+// a 100 Mbit/s link, in bytes per second
+const double kSlowLinkRate = 100e6 / 8;
+
+// a client that keeps the clipboard instead of giving it to a screen
+class ClipboardClient : public Client {
+public:
+    ClipboardClient(TestEventQueue* events, const NetworkAddress& address,
+                ISocketFactory* socketFactory, barrier::Screen* screen,
+                const ClientArgs& args) :
+        Client(events, "stub", address, socketFactory, screen, args),
+        m_events(events),
+        m_updates(0) { }
+
+    virtual void        setClipboard(ClipboardID id, const IClipboard* clipboard)
+    {
+        m_clipboard[id] = IClipboard::marshall(clipboard);
+        ++m_updates;
+        m_events->raiseQuitEvent();
+    }
+
+    virtual void        grabClipboard(ClipboardID)
+    {
+        m_events->raiseQuitEvent();
+    }
+
+    TestEventQueue*        m_events;
+    String                m_clipboard[kClipboardEnd];
+    int                    m_updates;
+};
+
+// a screen with its own event target
+class ClipboardScreen : public MockScreen {
+public:
+    virtual void*        getEventTarget() const
+    {
+        return const_cast<ClipboardScreen*>(this);
+    }
+};
+
+// a socket that writes no faster than \c rate bytes per second, if
+// \c rate isn't zero
+class ThrottledSocket : public TCPSocket {
+public:
+    ThrottledSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer,
+                IArchNetwork::EAddressFamily family, const double& rate) :
+        TCPSocket(events, socketMultiplexer, family),
+        m_rate(rate) { }
+
+    virtual void        write(const void* buffer, UInt32 n)
+    {
+        if (m_rate > 0.0) {
+            ARCH->sleep(n / m_rate);
+        }
+        TCPSocket::write(buffer, n);
+    }
+
+private:
+    const double&        m_rate;
+};
+
+class ThrottledSocketFactory : public TCPSocketFactory {
+public:
+    ThrottledSocketFactory(IEventQueue* events, SocketMultiplexer* socketMultiplexer,
+                const double& rate) :
+        TCPSocketFactory(events, socketMultiplexer),
+        m_events(events),
+        m_socketMultiplexer(socketMultiplexer),
+        m_rate(rate) { }
+
+    virtual IDataSocket* create(IArchNetwork::EAddressFamily family, bool) const
+    {
+        return new ThrottledSocket(m_events, m_socketMultiplexer, family, m_rate);
+    }
+
+private:
+    IEventQueue*        m_events;
+    SocketMultiplexer*    m_socketMultiplexer;
+    const double&        m_rate;
+};
+
+// adds up the clipboard data sent
+class ClipboardLogOutputter : public ILogOutputter {
+public:
+    ClipboardLogOutputter() : m_sent(0), m_written(0) { }
+
+    virtual void        open(const char*) { }
+    virtual void        close() { }
+    virtual void        show(bool) { }
+    virtual bool        write(ELevel, const char* message)
+    {
+        const char* sent = strstr(message, "sent clipboard size=");
+        int size, written;
+        if (sent != NULL && sscanf(sent, "sent clipboard size=%d written=%d",
+                                    &size, &written) == 2) {
+            m_sent    += size;
+            m_written += written;
+        }
+        return true;
+    }
+
+public:
+    size_t                m_sent;
+
+    // after compression
+    size_t                m_written;
+};
+
+static void
+getClipboardScreenShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h)
+{
+    x = 0;
+    y = 0;
+    w = 1;
+    h = 1;
+}
+
+static void
+getClipboardCursorPos(SInt32& x, SInt32& y)
+{
+    x = 0;
+    y = 0;
+}
+
+// a 32 bpp bitmap in the kBitmap format, with a pattern that depends on
+// \c seed
+static String
+makeBitmap(SInt32 width, SInt32 height, UInt8 seed)
+{
+    String bitmap(40 + 4 * width * height, '\0');
+    UInt8* header = reinterpret_cast<UInt8*>(&bitmap[0]);
+    header[0]  = 40;
+    memcpy(header + 4, &width, 4);
+    memcpy(header + 8, &height, 4);
+    header[12] = 1;
+    header[14] = 32;
+
+    UInt8* pixel = header + 40;
+    for (SInt32 y = 0; y < height; ++y) {
+        for (SInt32 x = 0; x < width; ++x) {
+            *pixel++ = (UInt8)(x + seed);
+            *pixel++ = (UInt8)(y + seed);
+            *pixel++ = (UInt8)((x ^ y) + seed);
+            *pixel++ = 0;
+        }
+    }
+    return bitmap;
+}
+
+static void
+fillClipboard(Clipboard& clipboard, const String& text, const String& bitmap)
+{
+    clipboard.open(0);
+    clipboard.empty();
+    clipboard.add(IClipboard::kText, text);
+    if (!bitmap.empty()) {
+        clipboard.add(IClipboard::kBitmap, bitmap);
+    }
+    clipboard.close();
+}
+
+// the clipboard a screen reports
+static bool
+getScreenClipboard(ClipboardID, IClipboard* clipboard)
+{
+    Clipboard screen;
+    fillClipboard(screen, "some text", makeBitmap(640, 480, 0));
+    Clipboard::copy(clipboard, &screen);
+    return true;
+}
+
+static bool
+getScreenshotClipboard(ClipboardID, IClipboard* clipboard)
+{
+    Clipboard screen;
+    fillClipboard(screen, "screenshot",
+        makeBitmap(kScreenshotWidth, kScreenshotHeight, 0));
+    Clipboard::copy(clipboard, &screen);
+    return true;
+}
+
+const UInt32 kTextAndBitmap = (1u << IClipboard::kText) | (1u << IClipboard::kBitmap);
+
+class ClipboardTransferTests : public ::testing::Test
+{
+public:
+    ClipboardTransferTests() :
+        m_client(NULL),
+        m_proxy(NULL),
+        m_outputter(NULL),
+        m_clientLinkRate(0.0) { }
+
+    virtual void        SetUp();
+    virtual void        TearDown();
+
+    // runs the server and client until the client connects
+    void                connect();
+
+    // sends the clipboard from the server and returns the bytes sent
+    size_t                send(const Clipboard& clipboard);
+
+    // raises a clipboard event from \c target and runs until quit
+    void                raise(Event::Type type, void* target, void* data);
+    void                raiseGrabbed(void* target);
+    void                raiseRequested(void* target, UInt32 formats);
+
+    // the client offers its clipboard while the primary is active
+    void                offerFromClient();
+
+    // saves the clipboard given to a screen and quits
+    void                fulfil(ClipboardID, const IClipboard* clipboard);
+
+    void                quit() { m_events.raiseQuitEvent(); }
+
+    void                handleClientConnected(const Event&, void* vlistener);
+
+public:
+    TestEventQueue        m_events;
+    ClipboardClient*    m_client;
+    ClientProxy*        m_proxy;
+    ClipboardLogOutputter*    m_outputter;
+    int                    m_oldFilter;
+
+    // server
+    NetworkAddress*        m_serverAddress;
+    SocketMultiplexer*    m_serverSocketMultiplexer;
+    ClientListener*        m_listener;
+    NiceMock<MockScreen>    m_serverScreen;
+    NiceMock<MockPrimaryClient>    m_primaryClient;
+    NiceMock<MockConfig>    m_serverConfig;
+    NiceMock<MockInputFilter>    m_serverInputFilter;
+    Server*                m_server;
+    Clipboard            m_fulfilled;
+
+    // client
+    NiceMock<ClipboardScreen>    m_clientScreen;
+    SocketMultiplexer*    m_clientSocketMultiplexer;
+    double                m_clientLinkRate;
+};
+
+void
+ClipboardTransferTests::SetUp()
+{
+    // the server logs the size of each clipboard sent at DEBUG
+    m_oldFilter = CLOG->getFilter();
+    CLOG->setFilter(kDEBUG);
+    m_outputter = new ClipboardLogOutputter;
+    CLOG->insert(m_outputter);
+
+    connect();
+}
+
+void
+ClipboardTransferTests::TearDown()
+{
+    delete m_client;
+    delete m_clientSocketMultiplexer;
+    m_events.removeHandler(m_events.forClientListener().connected(), m_listener);
+    delete m_server;
+    delete m_listener;
+    delete m_serverSocketMultiplexer;
+    delete m_serverAddress;
+
+    CLOG->remove(m_outputter);
+    delete m_outputter;
+    CLOG->setFilter(m_oldFilter);
+}
+
+void
+ClipboardTransferTests::connect()
+{
+    m_serverAddress = new NetworkAddress(TEST_CLIPBOARD_HOST, TEST_CLIPBOARD_PORT);
+    m_serverAddress->resolve();
+
+    // server
+    m_serverSocketMultiplexer = new SocketMultiplexer;
+    TCPSocketFactory* serverSocketFactory = new TCPSocketFactory(&m_events, m_serverSocketMultiplexer);
+    m_listener = new ClientListener(*m_serverAddress, serverSocketFactory, &m_events, false);
+
+    m_events.adoptHandler(
+        m_events.forClientListener().connected(), m_listener,
+        new TMethodEventJob<ClipboardTransferTests>(
+            this, &ClipboardTransferTests::handleClientConnected, m_listener));
+
+    ON_CALL(m_serverConfig, isScreen(_)).WillByDefault(Return(true));
+    ON_CALL(m_primaryClient, getEventTarget()).WillByDefault(Return(&m_primaryClient));
+    ON_CALL(m_serverConfig, getInputFilter()).WillByDefault(Return(&m_serverInputFilter));
+
+    ServerArgs serverArgs;
+    m_server = new Server(m_serverConfig, &m_primaryClient, &m_serverScreen, &m_events, serverArgs);
+    m_server->m_mock = true;
+    m_listener->setServer(m_server);
+
+    // client
+    m_clientSocketMultiplexer = new SocketMultiplexer;
+    TCPSocketFactory* clientSocketFactory =
+        new ThrottledSocketFactory(&m_events, m_clientSocketMultiplexer, m_clientLinkRate);
+
+    ON_CALL(m_clientScreen, getShape(_, _, _, _)).WillByDefault(Invoke(getClipboardScreenShape));
+    ON_CALL(m_clientScreen, getCursorPos(_, _)).WillByDefault(Invoke(getClipboardCursorPos));
+
+    ClientArgs clientArgs;
+    clientArgs.m_enableCrypto = false;
+    m_client = new ClipboardClient(&m_events, *m_serverAddress, clientSocketFactory, &m_clientScreen, clientArgs);
+    m_client->connect();
+
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+    ASSERT_TRUE(m_proxy != NULL);
+}
+
+size_t
+ClipboardTransferTests::send(const Clipboard& clipboard)
+{
+    size_t sent    = m_outputter->m_sent;
+    int updates    = m_client->m_updates;
+
+    m_proxy->setClipboardDirty(kClipboardClipboard, true);
+    m_proxy->setClipboard(kClipboardClipboard, &clipboard);
+
+    m_events.initQuitTimeout(30);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+
+    EXPECT_EQ(updates + 1, m_client->m_updates);
+    EXPECT_EQ(clipboard.marshall(), m_client->m_clipboard[kClipboardClipboard]);
+    return m_outputter->m_sent - sent;
+}
+
+void
+ClipboardTransferTests::raise(Event::Type type, void* target, void* data)
+{
+    m_events.addEvent(Event(type, target, data));
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+}
+
+void
+ClipboardTransferTests::raiseGrabbed(void* target)
+{
+    IScreen::ClipboardInfo* info =
+        (IScreen::ClipboardInfo*)malloc(sizeof(IScreen::ClipboardInfo));
+    info->m_id             = kClipboardClipboard;
+    info->m_sequenceNumber = 0;
+    m_events.addEvent(Event(m_events.forClipboard().clipboardGrabbed(), target, info));
+}
+
+void
+ClipboardTransferTests::raiseRequested(void* target, UInt32 formats)
+{
+    IScreen::ClipboardRequestInfo* info =
+        (IScreen::ClipboardRequestInfo*)malloc(sizeof(IScreen::ClipboardRequestInfo));
+    info->m_id      = kClipboardClipboard;
+    info->m_formats = formats;
+    raise(m_events.forClipboard().clipboardRequested(), target, info);
+}
+
+void
+ClipboardTransferTests::offerFromClient()
+{
+    ON_CALL(m_clientScreen, getClipboardFormats(kClipboardClipboard, _, _))
+        .WillByDefault(DoAll(SetArgReferee<1>(kTextAndBitmap),
+                             SetArgReferee<2>(1), Return(true)));
+    ON_CALL(m_clientScreen, getClipboard(kClipboardClipboard, _))
+        .WillByDefault(Invoke(getScreenClipboard));
+    EXPECT_CALL(m_primaryClient, promiseClipboard(kClipboardClipboard, kTextAndBitmap))
+        .WillOnce(DoAll(Invoke(this, &ClipboardTransferTests::quit), Return(true)));
+
+    m_server->setActive(&m_primaryClient);
+    raiseGrabbed(&m_clientScreen);
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+}
+
+void
+ClipboardTransferTests::fulfil(ClipboardID, const IClipboard* clipboard)
+{
+    Clipboard::copy(&m_fulfilled, clipboard);
+    quit();
+}
+
+void
+ClipboardTransferTests::handleClientConnected(const Event&, void* vlistener)
+{
+    ClientListener* listener = static_cast<ClientListener*>(vlistener);
+    Server* server = listener->getServer();
+
+    m_proxy = listener->getNextClient();
+    ASSERT_TRUE(m_proxy != NULL);
+
+    BaseClientProxy* bcp = m_proxy;
+    server->adoptClient(bcp);
+    server->setActive(bcp);
+    m_events.raiseQuitEvent();
+}
+
+TEST_F(ClipboardTransferTests, send_sameClipboardAgain_notResent)
+{
+    Clipboard clipboard;
+    fillClipboard(clipboard, "some text", makeBitmap(640, 480, 0));
+
+    EXPECT_LT(640u * 480u * 4u, send(clipboard));
+    EXPECT_EQ(0, send(clipboard));
+}
+
+TEST_F(ClipboardTransferTests, send_textChanged_bitmapNotResent)
+{
+    String bitmap = makeBitmap(640, 480, 0);
+    Clipboard first;
+    fillClipboard(first, "some text", bitmap);
+    Clipboard second;
+    fillClipboard(second, "other text", bitmap);
+
+    send(first);
+    size_t sent = send(second);
+
+    EXPECT_LT(0u, sent);
+    EXPECT_GT(1024u, sent);
+}
+
+TEST_F(ClipboardTransferTests, send_earlierClipboard_takenFromCache)
+{
+    Clipboard first;
+    fillClipboard(first, "first", makeBitmap(640, 480, 1));
+    Clipboard second;
+    fillClipboard(second, "second", makeBitmap(640, 480, 2));
+
+    send(first);
+    send(second);
+
+    EXPECT_EQ(0, send(first));
+}
+
+TEST_F(ClipboardTransferTests, offer_notPasted_dataNotSent)
+{
+    EXPECT_CALL(m_clientScreen, getClipboard(_, _)).Times(0);
+    size_t sent = m_outputter->m_sent;
+
+    offerFromClient();
+
+    EXPECT_EQ(sent, m_outputter->m_sent);
+}
+
+TEST_F(ClipboardTransferTests, offer_primaryRequests_onlyRequestedFormatFetched)
+{
+    offerFromClient();
+    size_t sent = m_outputter->m_sent;
+
+    EXPECT_CALL(m_primaryClient, fulfilClipboard(kClipboardClipboard, _))
+        .WillOnce(Invoke(this, &ClipboardTransferTests::fulfil));
+    raiseRequested(&m_primaryClient, 1u << IClipboard::kText);
+
+    m_fulfilled.open(0);
+    EXPECT_EQ("some text", m_fulfilled.get(IClipboard::kText));
+    EXPECT_FALSE(m_fulfilled.has(IClipboard::kBitmap));
+    m_fulfilled.close();
+    EXPECT_GT(1024u, m_outputter->m_sent - sent);
+}
+
+TEST_F(ClipboardTransferTests, offer_ownerLeavesWhileFetching_requestsFulfilled)
+{
+    offerFromClient();
+    EXPECT_CALL(m_primaryClient, fulfilClipboard(kClipboardClipboard, _))
+        .Times(2)
+        .WillRepeatedly(Invoke(this, &ClipboardTransferTests::fulfil));
+
+    // the owner leaves before it sends the data
+    IScreen::ClipboardRequestInfo* info =
+        (IScreen::ClipboardRequestInfo*)malloc(sizeof(IScreen::ClipboardRequestInfo));
+    info->m_id      = kClipboardClipboard;
+    info->m_formats = 1u << IClipboard::kText;
+    m_events.addEvent(Event(m_events.forClipboard().clipboardRequested(),
+                            &m_primaryClient, info));
+    m_events.addEvent(Event(m_events.forClientProxy().disconnected(), m_proxy));
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+
+    m_fulfilled.open(0);
+    EXPECT_FALSE(m_fulfilled.has(IClipboard::kText));
+    m_fulfilled.close();
+
+    // later requests don't wait for it either
+    raiseRequested(&m_primaryClient, 1u << IClipboard::kText);
+}
+
+TEST_F(ClipboardTransferTests, offer_formatsNotListed_dataSentWithOffer)
+{
+    // like Windows and macOS, the screen must get the data to list the
+    // formats.  it's read once and sent right away.
+    ON_CALL(m_clientScreen, getClipboardFormats(kClipboardClipboard, _, _))
+        .WillByDefault(Return(false));
+    EXPECT_CALL(m_clientScreen, getClipboard(kClipboardClipboard, _))
+        .WillOnce(Invoke(getScreenClipboard));
+    EXPECT_CALL(m_primaryClient, promiseClipboard(_, _)).Times(0);
+    EXPECT_CALL(m_primaryClient, setClipboard(kClipboardClipboard, _))
+        .WillOnce(Invoke(this, &ClipboardTransferTests::fulfil));
+
+    m_server->setActive(&m_primaryClient);
+    raiseGrabbed(&m_clientScreen);
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+
+    m_fulfilled.open(0);
+    EXPECT_EQ("some text", m_fulfilled.get(IClipboard::kText));
+    EXPECT_EQ(makeBitmap(640, 480, 0), m_fulfilled.get(IClipboard::kBitmap));
+    m_fulfilled.close();
+}
+
+TEST_F(ClipboardTransferTests, promise_clientRequests_requestedFormatSent)
+{
+    // the primary owns the clipboard
+    ON_CALL(m_primaryClient, getClipboard(kClipboardClipboard, _))
+        .WillByDefault(Invoke(getScreenClipboard));
+    m_server->setActive(&m_primaryClient);
+    raiseGrabbed(&m_primaryClient);
+    IScreen::ClipboardInfo* info =
+        (IScreen::ClipboardInfo*)malloc(sizeof(IScreen::ClipboardInfo));
+    info->m_id             = kClipboardClipboard;
+    info->m_sequenceNumber = 0;
+    m_events.addEvent(Event(m_events.forClipboard().clipboardChanged(),
+                            &m_primaryClient, info));
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+
+    // and promises it to the client
+    EXPECT_CALL(m_clientScreen, promiseClipboard(kClipboardClipboard, kTextAndBitmap))
+        .WillOnce(DoAll(Invoke(this, &ClipboardTransferTests::quit), Return(true)));
+    m_proxy->setClipboardDirty(kClipboardClipboard, true);
+    m_proxy->promiseClipboard(kClipboardClipboard, kTextAndBitmap);
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+
+    size_t sent = m_outputter->m_sent;
+    EXPECT_CALL(m_clientScreen, fulfilClipboard(kClipboardClipboard, _))
+        .WillOnce(Invoke(this, &ClipboardTransferTests::fulfil));
+    raiseRequested(&m_clientScreen, 1u << IClipboard::kText);
+
+    m_fulfilled.open(0);
+    EXPECT_EQ("some text", m_fulfilled.get(IClipboard::kText));
+    EXPECT_FALSE(m_fulfilled.has(IClipboard::kBitmap));
+    m_fulfilled.close();
+    EXPECT_GT(1024u, m_outputter->m_sent - sent);
+}
+
+TEST_F(ClipboardTransferTests, compressionDisabled_bothWays_writtenAsIs)
+{
+    OptionsList options;
+    options.push_back(kOptionCompression);
+    options.push_back(0);
+    m_proxy->setOptions(options);
+
+    // primary to client
+    Clipboard clipboard;
+    fillClipboard(clipboard, "some text", makeBitmap(640, 480, 0));
+    size_t written = m_outputter->m_written;
+    size_t sent    = send(clipboard);
+    EXPECT_EQ(sent, m_outputter->m_written - written);
+
+    // client to primary
+    offerFromClient();
+    sent    = m_outputter->m_sent;
+    written = m_outputter->m_written;
+    EXPECT_CALL(m_primaryClient, fulfilClipboard(kClipboardClipboard, _))
+        .WillOnce(Invoke(this, &ClipboardTransferTests::fulfil));
+    raiseRequested(&m_primaryClient, 1u << IClipboard::kBitmap);
+
+    m_fulfilled.open(0);
+    EXPECT_EQ(makeBitmap(640, 480, 0), m_fulfilled.get(IClipboard::kBitmap));
+    m_fulfilled.close();
+    EXPECT_LT(0u, m_outputter->m_sent - sent);
+    EXPECT_EQ(m_outputter->m_sent - sent, m_outputter->m_written - written);
+}
+
+TEST_F(ClipboardTransferTests, benchmark_screenshotCopiedAgain)
+{
+    Clipboard clipboard;
+    fillClipboard(clipboard, "screenshot",
+        makeBitmap(kScreenshotWidth, kScreenshotHeight, 0));
+
+    Stopwatch stopwatch;
+    size_t firstSent = send(clipboard);
+    double first = stopwatch.getTime();
+
+    stopwatch.reset();
+    size_t againSent = send(clipboard);
+    double again = stopwatch.getTime();
+
+    LOG((CLOG_INFO "4K screenshot clipboard: first %.1fms %d bytes, again %.1fms %d bytes",
+        1000.0 * first, (int)firstSent, 1000.0 * again, (int)againSent));
+}
+
+TEST_F(ClipboardTransferTests, benchmark_screenshotPastedOverSlowLink)
+{
+    // copied on the client and pasted on the primary
+    offerFromClient();
+    ON_CALL(m_clientScreen, getClipboard(kClipboardClipboard, _))
+        .WillByDefault(Invoke(getScreenshotClipboard));
+    size_t sent    = m_outputter->m_sent;
+    size_t written = m_outputter->m_written;
+
+    EXPECT_CALL(m_primaryClient, fulfilClipboard(kClipboardClipboard, _))
+        .WillOnce(Invoke(this, &ClipboardTransferTests::fulfil));
+    m_clientLinkRate = kSlowLinkRate;
+    Stopwatch stopwatch;
+    raiseRequested(&m_primaryClient, 1u << IClipboard::kBitmap);
+    double pasted = stopwatch.getTime();
+    m_clientLinkRate = 0.0;
+
+    m_fulfilled.open(0);
+    EXPECT_EQ(makeBitmap(kScreenshotWidth, kScreenshotHeight, 0),
+              m_fulfilled.get(IClipboard::kBitmap));
+    m_fulfilled.close();
+
+    LOG((CLOG_INFO "4K screenshot pasted over %.0f Mbit/s: %.1fms %d bytes, %d written",
+        8.0 * kSlowLinkRate / 1e6, 1000.0 * pasted, m_outputter->m_sent - sent,
+        m_outputter->m_written - written));
+}
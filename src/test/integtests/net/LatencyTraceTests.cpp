@@ -0,0 +1,241 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#define BARRIER_TEST_ENV
+
+#include "test/mock/server/MockConfig.h"
+#include "test/mock/server/MockPrimaryClient.h"
+#include "test/mock/barrier/MockScreen.h"
+#include "test/mock/server/MockInputFilter.h"
+#include "test/global/TestEventQueue.h"
+#include "server/Server.h"
+#include "server/ClientListener.h"
+#include "server/ClientProxy.h"
+#include "client/Client.h"
+#include "barrier/IPlatformScreen.h"
+#include "barrier/LatencyTrace.h"
+#include "barrier/option_types.h"
+#include "net/SocketMultiplexer.h"
+#include "net/NetworkAddress.h"
+#include "net/TCPSocketFactory.h"
+#include "base/TMethodEventJob.h"
+#include "base/Log.h"
+
+#include "test/global/gtest.h"
+
+using ::testing::_;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::Invoke;
+
+#define TEST_LATENCY_PORT 24805
+#define TEST_LATENCY_HOST "localhost"
+
+const int kReplayEvents = 1000;
+const double kReplayInterval = 0.001;
+
+// a client that takes input without a platform screen to inject it into
+class ReplayClient : public Client {
+public:
+    ReplayClient(IEventQueue* events, const NetworkAddress& address,
+                ISocketFactory* socketFactory, barrier::Screen* screen,
+                const ClientArgs& args) :
+        Client(events, "stub", address, socketFactory, screen, args),
+        m_received(0) { }
+
+    virtual void        keyDown(KeyID, KeyModifierMask, KeyButton) { ++m_received; }
+    virtual void        keyUp(KeyID, KeyModifierMask, KeyButton) { ++m_received; }
+    virtual void        mouseDown(ButtonID) { ++m_received; }
+    virtual void        mouseUp(ButtonID) { ++m_received; }
+
+    int                    m_received;
+};
+
+static void
+getReplayScreenShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h)
+{
+    x = 0;
+    y = 0;
+    w = 1;
+    h = 1;
+}
+
+static void
+getReplayCursorPos(SInt32& x, SInt32& y)
+{
+    x = 0;
+    y = 0;
+}
+
+class LatencyTraceTests : public ::testing::Test
+{
+public:
+    LatencyTraceTests() :
+        m_filter(NULL),
+        m_client(NULL),
+        m_timer(NULL),
+        m_sent(0) { }
+
+    void                replay(bool inputBatching);
+
+    void                handleClientConnected(const Event&, void* vlistener);
+    void                handleReplayTimer(const Event&, void*);
+
+public:
+    TestEventQueue        m_events;
+    InputFilter*        m_filter;
+    ReplayClient*        m_client;
+    EventQueueTimer*    m_timer;
+    int                    m_sent;
+};
+
+// replays a synthetic stream of key and button presses through a real
+// server and client connected over localhost
+void
+LatencyTraceTests::replay(bool inputBatching)
+{
+    NetworkAddress serverAddress(TEST_LATENCY_HOST, TEST_LATENCY_PORT);
+    serverAddress.resolve();
+
+    // server
+    SocketMultiplexer serverSocketMultiplexer;
+    TCPSocketFactory* serverSocketFactory = new TCPSocketFactory(&m_events, &serverSocketMultiplexer);
+    ClientListener listener(serverAddress, serverSocketFactory, &m_events, false);
+    NiceMock<MockScreen> serverScreen;
+    NiceMock<MockPrimaryClient> primaryClient;
+    NiceMock<MockConfig> serverConfig;
+    NiceMock<MockInputFilter> serverInputFilter;
+    m_filter = &serverInputFilter;
+
+    m_events.adoptHandler(
+        m_events.forClientListener().connected(), &listener,
+        new TMethodEventJob<LatencyTraceTests>(
+            this, &LatencyTraceTests::handleClientConnected, &listener));
+
+    ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+    ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+    serverConfig.addOption("", kOptionLatencyTracing, 1);
+    serverConfig.addOption("", kOptionInputBatching, inputBatching ? 1 : 0);
+
+    ServerArgs serverArgs;
+    Server server(serverConfig, &primaryClient, &serverScreen, &m_events, serverArgs);
+    server.m_mock = true;
+    listener.setServer(&server);
+
+    // client
+    NiceMock<MockScreen> clientScreen;
+    SocketMultiplexer clientSocketMultiplexer;
+    TCPSocketFactory* clientSocketFactory = new TCPSocketFactory(&m_events, &clientSocketMultiplexer);
+
+    ON_CALL(clientScreen, getShape(_, _, _, _)).WillByDefault(Invoke(getReplayScreenShape));
+    ON_CALL(clientScreen, getCursorPos(_, _)).WillByDefault(Invoke(getReplayCursorPos));
+
+    ClientArgs clientArgs;
+    clientArgs.m_enableCrypto = false;
+    ReplayClient client(&m_events, serverAddress, clientSocketFactory, &clientScreen, clientArgs);
+    m_client = &client;
+
+    client.connect();
+
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.removeHandler(m_events.forClientListener().connected(), &listener);
+    m_events.cleanupQuitTimeout();
+    if (m_timer != NULL) {
+        m_events.removeHandler(Event::kTimer, m_timer);
+        m_events.deleteTimer(m_timer);
+        m_timer = NULL;
+    }
+
+    // every input was traced through every stage
+    const LatencyTrace& trace = client.getLatencyTrace();
+    EXPECT_EQ(kReplayEvents, client.m_received);
+    for (int i = 0; i < LatencyTrace::kNumStages; ++i) {
+        LatencyTrace::EStage stage = static_cast<LatencyTrace::EStage>(i);
+        EXPECT_EQ(kReplayEvents, (int)trace.getCount(stage));
+        EXPECT_LE(trace.getPercentile(stage, 0.5), trace.getPercentile(stage, 0.99));
+        EXPECT_LE(trace.getPercentile(stage, 0.99), trace.getPercentile(stage, 0.999));
+    }
+    EXPECT_GT(trace.getPercentile(LatencyTrace::kTotal, 0.5), 0.0);
+}
+
+void
+LatencyTraceTests::handleClientConnected(const Event&, void* vlistener)
+{
+    ClientListener* listener = static_cast<ClientListener*>(vlistener);
+    Server* server = listener->getServer();
+
+    ClientProxy* client = listener->getNextClient();
+    ASSERT_TRUE(client != NULL);
+
+    BaseClientProxy* bcp = client;
+    server->adoptClient(bcp);
+    server->setActive(bcp);
+
+    // start replaying
+    m_timer = m_events.newTimer(kReplayInterval, NULL);
+    m_events.adoptHandler(Event::kTimer, m_timer,
+        new TMethodEventJob<LatencyTraceTests>(
+            this, &LatencyTraceTests::handleReplayTimer));
+}
+
+void
+LatencyTraceTests::handleReplayTimer(const Event&, void*)
+{
+    if (m_sent == kReplayEvents) {
+        // wait for the client to handle the rest
+        if (m_client->getLatencyTrace().getCount(LatencyTrace::kTotal) >= kReplayEvents) {
+            m_events.raiseQuitEvent();
+        }
+        return;
+    }
+
+    // alternate presses and releases of a key and a button
+    switch (m_sent % 4) {
+    case 0:
+        m_events.addEvent(Event(m_events.forIKeyState().keyDown(), m_filter,
+                            IPlatformScreen::KeyInfo::alloc('a', 0, 38, 1)));
+        break;
+
+    case 1:
+        m_events.addEvent(Event(m_events.forIKeyState().keyUp(), m_filter,
+                            IPlatformScreen::KeyInfo::alloc('a', 0, 38, 1)));
+        break;
+
+    case 2:
+        m_events.addEvent(Event(m_events.forIPrimaryScreen().buttonDown(), m_filter,
+                            IPlatformScreen::ButtonInfo::alloc(kButtonLeft, 0)));
+        break;
+
+    case 3:
+        m_events.addEvent(Event(m_events.forIPrimaryScreen().buttonUp(), m_filter,
+                            IPlatformScreen::ButtonInfo::alloc(kButtonLeft, 0)));
+        break;
+    }
+    ++m_sent;
+}
+
+TEST_F(LatencyTraceTests, replay_unbatched_everyInputTraced)
+{
+    replay(false);
+}
+
+TEST_F(LatencyTraceTests, replay_batched_everyInputTraced)
+{
+    replay(true);
+}
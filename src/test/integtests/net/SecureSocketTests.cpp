@@ -0,0 +1,836 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#define BARRIER_TEST_ENV
+
+#include "test/mock/server/MockConfig.h"
+#include "test/mock/server/MockPrimaryClient.h"
+#include "test/mock/barrier/MockScreen.h"
+#include "test/mock/server/MockInputFilter.h"
+#include "test/global/TestEventQueue.h"
+#include "server/Server.h"
+#include "server/ClientListener.h"
+#include "server/ClientProxy.h"
+#include "client/Client.h"
+#include "barrier/IPlatformScreen.h"
+#include "net/SecureSocket.h"
+#include "net/SecureListenSocket.h"
+#include "net/SocketMultiplexer.h"
+#include "net/NetworkAddress.h"
+#include "net/TCPSocketFactory.h"
+#include "net/IDataSocket.h"
+#include "net/IListenSocket.h"
+#include "common/DataDirectories.h"
+#include "base/TMethodEventJob.h"
+#include "base/Stopwatch.h"
+#include "base/String.h"
+#include "base/Log.h"
+
+#include "test/global/gtest.h"
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using ::testing::_;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::Invoke;
+
+#if SYSAPI_WIN32
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#else
+#include <sys/stat.h>
+#endif
+
+#define TEST_SECURE_PORT 24807
+#define TEST_SECURE_HOST "localhost"
+#define TEST_SECURE_PROFILE "SecureSocketTests.profile"
+
+const int kSecureClients = 4;
+const UInt32 kSecureDataSize = 4 * 1024 * 1024;
+const UInt32 kSecureChunkSize = 64 * 1024;
+const int kStormClients = 100;
+const int kStormPings = 20;
+const UInt32 kPingSize = 64;
+
+// the byte at offset i of the data a client sends
+static
+UInt8
+patternByte(int client, UInt32 i)
+{
+    return (UInt8)((i + 7 * client) % 251);
+}
+
+// one end of a connection
+class SecureConnection {
+public:
+    SecureConnection() :
+        m_client(-1),
+        m_socket(NULL),
+        m_sent(0),
+        m_received(0),
+        m_corrupt(false),
+        m_resumed(false),
+        m_finished(false) { }
+
+    int                    m_client;
+    IDataSocket*        m_socket;
+    UInt32                m_sent;
+    UInt32                m_received;
+    bool                m_corrupt;
+    bool                m_resumed;
+    bool                m_finished;
+};
+
+// a client that notes when the first mouse event arrives
+class MouseClient : public Client {
+public:
+    MouseClient(TestEventQueue* events, const NetworkAddress& address,
+                ISocketFactory* socketFactory, barrier::Screen* screen,
+                const ClientArgs& args) :
+        Client(events, "stub", address, socketFactory, screen, args),
+        m_events(events),
+        m_firstMouse(-1.0) { }
+
+    virtual void        mouseDown(ButtonID)
+    {
+        if (m_firstMouse < 0.0) {
+            m_firstMouse = m_stopwatch.getTime();
+            m_events->raiseQuitEvent();
+        }
+    }
+
+    TestEventQueue*        m_events;
+    Stopwatch            m_stopwatch;
+    double                m_firstMouse;
+};
+
+static void
+getMouseScreenShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h)
+{
+    x = 0;
+    y = 0;
+    w = 1;
+    h = 1;
+}
+
+static void
+getMouseCursorPos(SInt32& x, SInt32& y)
+{
+    x = 0;
+    y = 0;
+}
+
+class SecureSocketTests : public ::testing::Test
+{
+public:
+    SecureSocketTests() :
+        m_reconnectEvents(NULL),
+        m_listen(NULL),
+        m_filter(NULL),
+        m_clientSocketFactory(NULL),
+        m_dataSize(0),
+        m_done(0),
+        m_refused(0),
+        m_serverDisconnects(0),
+        m_stormConnected(0),
+        m_stormFailed(0),
+        m_pings(0),
+        m_maxPing(0.0),
+        m_oldFilter(kINFO) { }
+
+    virtual void        SetUp();
+    virtual void        TearDown();
+
+    void                listen(SocketMultiplexer* multiplexer,
+                            const NetworkAddress& address,
+                            double handshakeTimeout, int maxPendingHandshakes);
+    SecureConnection*    connect(TCPSocketFactory* factory,
+                            const NetworkAddress& address, int client,
+                            bool secure);
+    void                closeAll();
+
+    double                echo(int clients, UInt32 dataSize);
+    double                reconnect();
+
+    void                handleConnecting(const Event&, void*);
+    void                handleServerInput(const Event&, void* vconnection);
+    void                handleServerDisconnected(const Event&, void* vconnection);
+    void                handlePingConnected(const Event&, void* vconnection);
+    void                handlePingInput(const Event&, void* vconnection);
+    void                handleStormConnected(const Event&, void* vconnection);
+    void                handleStormFailed(const Event&, void* vconnection);
+    void                handleSecureConnected(const Event&, void* vconnection);
+    void                handleClientOutputFlushed(const Event&, void* vconnection);
+    void                handleClientInput(const Event&, void* vconnection);
+    void                handleClientConnected(const Event&, void* vlistener);
+    void                handleGarbageConnected(const Event&, void* vconnection);
+    void                handleGarbageDisconnected(const Event&, void* vconnection);
+
+    void                sendChunk(SecureConnection* connection);
+    void                sendPing(SecureConnection* connection);
+    void                startStorm();
+    void                checkStormDone();
+
+public:
+    TestEventQueue        m_events;
+    TestEventQueue*        m_reconnectEvents;
+    IListenSocket*        m_listen;
+    InputFilter*        m_filter;
+    std::vector<std::unique_ptr<SecureConnection> > m_servers;
+    std::vector<SecureConnection> m_clients;
+    TCPSocketFactory*    m_clientSocketFactory;
+    NetworkAddress        m_address;
+    UInt32                m_dataSize;
+    int                    m_done;
+    int                    m_refused;
+    int                    m_serverDisconnects;
+    int                    m_stormConnected;
+    int                    m_stormFailed;
+    int                    m_pings;
+    Stopwatch            m_pingStopwatch;
+    double                m_maxPing;
+    int                    m_oldFilter;
+    std::string            m_oldProfile;
+};
+
+// writes a self signed certificate where the server looks for it and
+// trusts it on the client side
+void
+SecureSocketTests::SetUp()
+{
+    // per write logging would swamp the measurements
+    m_oldFilter = CLOG->getFilter();
+    CLOG->setFilter(kINFO);
+
+    m_oldProfile = DataDirectories::profile();
+    DataDirectories::profile(TEST_SECURE_PROFILE);
+    mkdir(TEST_SECURE_PROFILE, 0700);
+    mkdir(TEST_SECURE_PROFILE "/SSL", 0700);
+    mkdir(TEST_SECURE_PROFILE "/SSL/Fingerprints", 0700);
+
+    EVP_PKEY* key = NULL;
+    EVP_PKEY_CTX* context = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, NULL);
+    ASSERT_TRUE(context != NULL);
+    ASSERT_EQ(1, EVP_PKEY_keygen_init(context));
+    ASSERT_EQ(1, EVP_PKEY_CTX_set_rsa_keygen_bits(context, 2048));
+    ASSERT_EQ(1, EVP_PKEY_keygen(context, &key));
+    EVP_PKEY_CTX_free(context);
+
+    X509* cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_get_notBefore(cert), 0);
+    X509_gmtime_adj(X509_get_notAfter(cert), 60 * 60);
+    X509_set_pubkey(cert, key);
+    X509_NAME* name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+        reinterpret_cast<const unsigned char*>("Barrier"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    ASSERT_LT(0, X509_sign(cert, key, EVP_sha256()));
+
+    FILE* pem = fopen(TEST_SECURE_PROFILE "/SSL/Barrier.pem", "w");
+    ASSERT_TRUE(pem != NULL);
+    PEM_write_PrivateKey(pem, key, NULL, NULL, 0, NULL, NULL);
+    PEM_write_X509(pem, cert);
+    fclose(pem);
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestSize = 0;
+    ASSERT_EQ(1, X509_digest(cert, EVP_sha1(), digest, &digestSize));
+    std::string fingerprint;
+    for (unsigned int i = 0; i < digestSize; ++i) {
+        fingerprint += barrier::string::sprintf(i == 0 ? "%02X" : ":%02X",
+                            digest[i]);
+    }
+    std::ofstream trusted(TEST_SECURE_PROFILE
+                            "/SSL/Fingerprints/TrustedServers.txt");
+    trusted << fingerprint << std::endl;
+
+    X509_free(cert);
+    EVP_PKEY_free(key);
+}
+
+void
+SecureSocketTests::TearDown()
+{
+    remove(TEST_SECURE_PROFILE "/SSL/Fingerprints/TrustedServers.txt");
+    remove(TEST_SECURE_PROFILE "/SSL/Barrier.pem");
+    remove(TEST_SECURE_PROFILE "/SSL/Session.pem");
+    remove(TEST_SECURE_PROFILE "/SSL/Fingerprints");
+    remove(TEST_SECURE_PROFILE "/SSL");
+    remove(TEST_SECURE_PROFILE);
+    DataDirectories::profile(m_oldProfile);
+    CLOG->setFilter(m_oldFilter);
+}
+
+void
+SecureSocketTests::handleConnecting(const Event&, void*)
+{
+    IDataSocket* socket = m_listen->accept();
+    if (socket == NULL) {
+        ++m_refused;
+        return;
+    }
+
+    SecureConnection* connection = new SecureConnection;
+    connection->m_socket = socket;
+    m_servers.push_back(std::unique_ptr<SecureConnection>(connection));
+    m_events.adoptHandler(m_events.forIStream().inputReady(),
+        socket->getEventTarget(),
+        new TMethodEventJob<SecureSocketTests>(
+            this, &SecureSocketTests::handleServerInput, connection));
+    m_events.adoptHandler(m_events.forISocket().disconnected(),
+        socket->getEventTarget(),
+        new TMethodEventJob<SecureSocketTests>(
+            this, &SecureSocketTests::handleServerDisconnected, connection));
+}
+
+// echoes whatever arrives
+void
+SecureSocketTests::handleServerInput(const Event&, void* vconnection)
+{
+    SecureConnection* connection = static_cast<SecureConnection*>(vconnection);
+    UInt8 buffer[kSecureChunkSize];
+    UInt32 n;
+    while ((n = connection->m_socket->read(buffer, sizeof(buffer))) > 0) {
+        connection->m_socket->write(buffer, n);
+    }
+}
+
+void
+SecureSocketTests::handleServerDisconnected(const Event&, void* vconnection)
+{
+    SecureConnection* connection = static_cast<SecureConnection*>(vconnection);
+    if (!connection->m_finished) {
+        connection->m_finished = true;
+        ++m_serverDisconnects;
+        m_events.raiseQuitEvent();
+    }
+}
+
+void
+SecureSocketTests::handleSecureConnected(const Event&, void* vconnection)
+{
+    sendChunk(static_cast<SecureConnection*>(vconnection));
+}
+
+void
+SecureSocketTests::handleClientOutputFlushed(const Event&, void* vconnection)
+{
+    sendChunk(static_cast<SecureConnection*>(vconnection));
+}
+
+// checks the echo against what was sent
+void
+SecureSocketTests::handleClientInput(const Event&, void* vconnection)
+{
+    SecureConnection* connection = static_cast<SecureConnection*>(vconnection);
+    UInt8 buffer[kSecureChunkSize];
+    UInt32 n;
+    while ((n = connection->m_socket->read(buffer, sizeof(buffer))) > 0) {
+        for (UInt32 i = 0; i < n; ++i) {
+            if (buffer[i] != patternByte(connection->m_client,
+                                connection->m_received + i)) {
+                connection->m_corrupt = true;
+            }
+        }
+        connection->m_received += n;
+    }
+
+    if (connection->m_received == m_dataSize) {
+        if (++m_done == (int)m_clients.size()) {
+            m_events.raiseQuitEvent();
+        }
+    }
+}
+
+// queues the next couple of chunks so the output buffer is rarely empty
+void
+SecureSocketTests::sendChunk(SecureConnection* connection)
+{
+    UInt8 buffer[kSecureChunkSize];
+    for (int chunk = 0; chunk < 2 && connection->m_sent < m_dataSize;
+                            ++chunk) {
+        for (UInt32 i = 0; i < kSecureChunkSize; ++i) {
+            buffer[i] = patternByte(connection->m_client, connection->m_sent + i);
+        }
+        connection->m_socket->write(buffer, kSecureChunkSize);
+        connection->m_sent += kSecureChunkSize;
+    }
+}
+
+void
+SecureSocketTests::handlePingConnected(const Event&, void* vconnection)
+{
+    startStorm();
+    sendPing(static_cast<SecureConnection*>(vconnection));
+}
+
+// times each round trip while the other clients connect
+void
+SecureSocketTests::handlePingInput(const Event&, void* vconnection)
+{
+    SecureConnection* connection = static_cast<SecureConnection*>(vconnection);
+    UInt8 buffer[kPingSize];
+    UInt32 n;
+    while ((n = connection->m_socket->read(buffer, sizeof(buffer))) > 0) {
+        connection->m_received += n;
+    }
+    if (connection->m_received < connection->m_sent) {
+        return;
+    }
+
+    double ping = m_pingStopwatch.getTime();
+    if (ping > m_maxPing) {
+        m_maxPing = ping;
+    }
+    ++m_pings;
+    if (m_pings >= kStormPings &&
+        m_stormConnected + m_stormFailed == kStormClients) {
+        m_events.raiseQuitEvent();
+        return;
+    }
+    sendPing(connection);
+}
+
+void
+SecureSocketTests::handleStormConnected(const Event&, void* vconnection)
+{
+    SecureConnection* connection = static_cast<SecureConnection*>(vconnection);
+    if (!connection->m_finished) {
+        connection->m_finished = true;
+        ++m_stormConnected;
+    }
+}
+
+void
+SecureSocketTests::handleStormFailed(const Event&, void* vconnection)
+{
+    SecureConnection* connection = static_cast<SecureConnection*>(vconnection);
+    if (!connection->m_finished) {
+        connection->m_finished = true;
+        ++m_stormFailed;
+    }
+}
+
+void
+SecureSocketTests::sendPing(SecureConnection* connection)
+{
+    UInt8 buffer[kPingSize] = { 0 };
+    m_pingStopwatch.reset();
+    connection->m_socket->write(buffer, kPingSize);
+    connection->m_sent += kPingSize;
+}
+
+void
+SecureSocketTests::startStorm()
+{
+    for (int i = 1; i <= kStormClients; ++i) {
+        SecureConnection* connection =
+                            connect(m_clientSocketFactory, m_address, i, true);
+        void* target = connection->m_socket->getEventTarget();
+        m_events.adoptHandler(m_events.forIDataSocket().secureConnected(), target,
+            new TMethodEventJob<SecureSocketTests>(
+                this, &SecureSocketTests::handleStormConnected, connection));
+        m_events.adoptHandler(m_events.forIDataSocket().connectionFailed(), target,
+            new TMethodEventJob<SecureSocketTests>(
+                this, &SecureSocketTests::handleStormFailed, connection));
+        m_events.adoptHandler(m_events.forISocket().disconnected(), target,
+            new TMethodEventJob<SecureSocketTests>(
+                this, &SecureSocketTests::handleStormFailed, connection));
+    }
+}
+
+void
+SecureSocketTests::listen(SocketMultiplexer* multiplexer,
+                const NetworkAddress& address,
+                double handshakeTimeout, int maxPendingHandshakes)
+{
+    TCPSocketFactory socketFactory(&m_events, multiplexer);
+    m_listen = socketFactory.createListen(
+                            ARCH->getAddrFamily(address.getAddress()), true);
+    SecureListenSocket* listen = dynamic_cast<SecureListenSocket*>(m_listen);
+    ASSERT_TRUE(listen != NULL);
+    listen->setHandshakeLimits(handshakeTimeout, maxPendingHandshakes);
+    m_listen->bind(address);
+    m_events.adoptHandler(m_events.forIListenSocket().connecting(), m_listen,
+        new TMethodEventJob<SecureSocketTests>(
+            this, &SecureSocketTests::handleConnecting));
+}
+
+// m_clients must already have room for the client
+SecureConnection*
+SecureSocketTests::connect(TCPSocketFactory* factory,
+                const NetworkAddress& address, int client, bool secure)
+{
+    SecureConnection* connection = &m_clients[client];
+    connection->m_client = client;
+    connection->m_socket = factory->create(
+                            ARCH->getAddrFamily(address.getAddress()), secure);
+    connection->m_socket->connect(address);
+    return connection;
+}
+
+void
+SecureSocketTests::closeAll()
+{
+    for (size_t i = 0; i < m_clients.size(); ++i) {
+        SecureConnection* connection = &m_clients[i];
+        if (connection->m_socket == NULL) {
+            continue;
+        }
+        SecureSocket* socket = dynamic_cast<SecureSocket*>(connection->m_socket);
+        connection->m_resumed = (socket != NULL && socket->isSessionReused());
+        m_events.removeHandlers(connection->m_socket->getEventTarget());
+        delete connection->m_socket;
+        connection->m_socket = NULL;
+    }
+    for (size_t i = 0; i < m_servers.size(); ++i) {
+        m_events.removeHandlers(m_servers[i]->m_socket->getEventTarget());
+        delete m_servers[i]->m_socket;
+    }
+    m_servers.clear();
+    if (m_listen != NULL) {
+        m_events.removeHandlers(m_listen);
+        delete m_listen;
+        m_listen = NULL;
+    }
+}
+
+void
+SecureSocketTests::handleClientConnected(const Event&, void* vlistener)
+{
+    ClientListener* listener = static_cast<ClientListener*>(vlistener);
+    Server* server = listener->getServer();
+
+    ClientProxy* client = listener->getNextClient();
+    ASSERT_TRUE(client != NULL);
+
+    BaseClientProxy* bcp = client;
+    server->adoptClient(bcp);
+    server->setActive(bcp);
+
+    m_reconnectEvents->addEvent(Event(m_reconnectEvents->forIPrimaryScreen().buttonDown(), m_filter,
+                        IPlatformScreen::ButtonInfo::alloc(kButtonLeft, 0)));
+}
+
+// writes something that isn't a TLS handshake
+void
+SecureSocketTests::handleGarbageConnected(const Event&, void* vconnection)
+{
+    SecureConnection* connection = static_cast<SecureConnection*>(vconnection);
+    const char garbage[] = "GET / HTTP/1.0\r\n\r\n";
+    connection->m_socket->write(garbage, sizeof(garbage) - 1);
+}
+
+// the server closed the connection
+void
+SecureSocketTests::handleGarbageDisconnected(const Event&, void* vconnection)
+{
+    SecureConnection* connection = static_cast<SecureConnection*>(vconnection);
+    if (!connection->m_finished) {
+        connection->m_finished = true;
+        m_events.raiseQuitEvent();
+    }
+}
+
+// each client sends dataSize bytes which the server echoes back.  returns
+// the seconds taken.
+double
+SecureSocketTests::echo(int clients, UInt32 dataSize)
+{
+    m_clients.clear();
+    m_clients.resize(clients);
+    m_dataSize = dataSize;
+    m_done = 0;
+
+    NetworkAddress address(TEST_SECURE_HOST, TEST_SECURE_PORT);
+    address.resolve();
+
+    SocketMultiplexer serverSocketMultiplexer;
+    listen(&serverSocketMultiplexer, address,
+                            SecureSocket::kHandshakeTimeout,
+                            SecureListenSocket::kMaxPendingHandshakes);
+
+    SocketMultiplexer clientSocketMultiplexer;
+    TCPSocketFactory clientSocketFactory(&m_events, &clientSocketMultiplexer);
+    Stopwatch stopwatch;
+    for (int i = 0; i < clients; ++i) {
+        SecureConnection* connection =
+                            connect(&clientSocketFactory, address, i, true);
+        void* target = connection->m_socket->getEventTarget();
+        m_events.adoptHandler(m_events.forIDataSocket().secureConnected(), target,
+            new TMethodEventJob<SecureSocketTests>(
+                this, &SecureSocketTests::handleSecureConnected, connection));
+        m_events.adoptHandler(m_events.forIStream().outputFlushed(), target,
+            new TMethodEventJob<SecureSocketTests>(
+                this, &SecureSocketTests::handleClientOutputFlushed, connection));
+        m_events.adoptHandler(m_events.forIStream().inputReady(), target,
+            new TMethodEventJob<SecureSocketTests>(
+                this, &SecureSocketTests::handleClientInput, connection));
+    }
+
+    m_events.initQuitTimeout(60);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+    double elapsed = stopwatch.getTime();
+
+    closeAll();
+    return elapsed;
+}
+
+// connects a client to a server over TLS and returns the seconds until
+// the client gets the first mouse event
+double
+SecureSocketTests::reconnect()
+{
+    // a queue of its own so nothing is left over for the next round
+    TestEventQueue events;
+    m_reconnectEvents = &events;
+
+    NetworkAddress serverAddress(TEST_SECURE_HOST, TEST_SECURE_PORT);
+    serverAddress.resolve();
+
+    // server
+    SocketMultiplexer serverSocketMultiplexer;
+    TCPSocketFactory* serverSocketFactory = new TCPSocketFactory(&events, &serverSocketMultiplexer);
+    ClientListener listener(serverAddress, serverSocketFactory, &events, true);
+    NiceMock<MockScreen> serverScreen;
+    NiceMock<MockPrimaryClient> primaryClient;
+    NiceMock<MockConfig> serverConfig;
+    NiceMock<MockInputFilter> serverInputFilter;
+    m_filter = &serverInputFilter;
+
+    events.adoptHandler(
+        events.forClientListener().connected(), &listener,
+        new TMethodEventJob<SecureSocketTests>(
+            this, &SecureSocketTests::handleClientConnected, &listener));
+
+    ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+    ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+
+    ServerArgs serverArgs;
+    serverArgs.m_enableCrypto = true;
+    Server server(serverConfig, &primaryClient, &serverScreen, &events, serverArgs);
+    server.m_mock = true;
+    listener.setServer(&server);
+
+    // client
+    NiceMock<MockScreen> clientScreen;
+    SocketMultiplexer clientSocketMultiplexer;
+    TCPSocketFactory* clientSocketFactory = new TCPSocketFactory(&events, &clientSocketMultiplexer);
+
+    ON_CALL(clientScreen, getShape(_, _, _, _)).WillByDefault(Invoke(getMouseScreenShape));
+    ON_CALL(clientScreen, getCursorPos(_, _)).WillByDefault(Invoke(getMouseCursorPos));
+
+    ClientArgs clientArgs;
+    clientArgs.m_enableCrypto = true;
+    MouseClient client(&events, serverAddress, clientSocketFactory, &clientScreen, clientArgs);
+
+    client.m_stopwatch.reset();
+    client.connect();
+
+    events.initQuitTimeout(10);
+    events.loop();
+    events.removeHandler(events.forClientListener().connected(), &listener);
+    events.cleanupQuitTimeout();
+
+    EXPECT_LE(0.0, client.m_firstMouse);
+    return client.m_firstMouse;
+}
+
+TEST_F(SecureSocketTests, echo_manyClients_allDataIntact)
+{
+    double elapsed = echo(kSecureClients, kSecureDataSize);
+
+    for (int i = 0; i < kSecureClients; ++i) {
+        EXPECT_EQ(kSecureDataSize, m_clients[i].m_received);
+        EXPECT_FALSE(m_clients[i].m_corrupt);
+    }
+    LOG((CLOG_INFO "tls echo: %d clients, %.1f MB/s",
+        kSecureClients,
+        2.0 * kSecureClients * kSecureDataSize / elapsed / (1024 * 1024)));
+}
+
+TEST_F(SecureSocketTests, connect_again_sessionResumed)
+{
+    // a session left by another test was made with another certificate
+    echo(1, kSecureChunkSize);
+    EXPECT_FALSE(m_clients[0].m_resumed);
+
+    echo(1, kSecureChunkSize);
+    EXPECT_EQ(kSecureChunkSize, m_clients[0].m_received);
+    EXPECT_TRUE(m_clients[0].m_resumed);
+
+    // and the session was kept for the next process
+    std::ifstream file(TEST_SECURE_PROFILE "/SSL/Session.pem");
+    EXPECT_TRUE(file.good());
+
+#if !SYSAPI_WIN32
+    // where only the user can read it
+    struct stat info;
+    ASSERT_EQ(0, stat(TEST_SECURE_PROFILE "/SSL/Session.pem", &info));
+    EXPECT_EQ(0, (int)(info.st_mode & 077));
+#endif
+}
+
+TEST_F(SecureSocketTests, benchmark_reconnect_firstMouseEvent)
+{
+    double full    = reconnect();
+    double resumed = reconnect();
+
+    LOG((CLOG_INFO "reconnect to first mouse event: full handshake=%.1fms resumed=%.1fms",
+        1000.0 * full, 1000.0 * resumed));
+}
+
+TEST_F(SecureSocketTests, accept_silentClient_timesOut)
+{
+    m_clients.resize(1);
+    NetworkAddress address(TEST_SECURE_HOST, TEST_SECURE_PORT);
+    address.resolve();
+
+    SocketMultiplexer serverSocketMultiplexer;
+    listen(&serverSocketMultiplexer, address, 0.2,
+                            SecureListenSocket::kMaxPendingHandshakes);
+
+    // connects but never starts the handshake
+    SocketMultiplexer clientSocketMultiplexer;
+    TCPSocketFactory clientSocketFactory(&m_events, &clientSocketMultiplexer);
+    connect(&clientSocketFactory, address, 0, false);
+
+    Stopwatch stopwatch;
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+
+    EXPECT_EQ(1, m_serverDisconnects);
+    EXPECT_LE(0.2, stopwatch.getTime());
+    EXPECT_EQ(0, SecureSocket::getPendingAccepts());
+    closeAll();
+}
+
+TEST_F(SecureSocketTests, accept_tooManyHandshakes_refused)
+{
+    const int kMaxPending = 2;
+    m_clients.resize(kMaxPending + 1);
+    NetworkAddress address(TEST_SECURE_HOST, TEST_SECURE_PORT);
+    address.resolve();
+
+    SocketMultiplexer serverSocketMultiplexer;
+    listen(&serverSocketMultiplexer, address, 0.5, kMaxPending);
+
+    SocketMultiplexer clientSocketMultiplexer;
+    TCPSocketFactory clientSocketFactory(&m_events, &clientSocketMultiplexer);
+    for (int i = 0; i <= kMaxPending; ++i) {
+        connect(&clientSocketFactory, address, i, false);
+    }
+
+    // quits when the first handshake times out
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+
+    EXPECT_EQ(1, m_refused);
+    EXPECT_EQ(kMaxPending, (int)m_servers.size());
+    closeAll();
+    EXPECT_EQ(0, SecureSocket::getPendingAccepts());
+}
+
+TEST_F(SecureSocketTests, accept_garbageHandshake_socketDeleted)
+{
+    m_clients.resize(1);
+    NetworkAddress address(TEST_SECURE_HOST, TEST_SECURE_PORT);
+    address.resolve();
+
+    SocketMultiplexer serverSocketMultiplexer;
+    TCPSocketFactory* serverSocketFactory =
+                            new TCPSocketFactory(&m_events, &serverSocketMultiplexer);
+    ClientListener listener(address, serverSocketFactory, &m_events, true);
+
+    SocketMultiplexer clientSocketMultiplexer;
+    TCPSocketFactory clientSocketFactory(&m_events, &clientSocketMultiplexer);
+    SecureConnection* connection =
+                            connect(&clientSocketFactory, address, 0, false);
+    void* target = connection->m_socket->getEventTarget();
+    m_events.adoptHandler(m_events.forIDataSocket().connected(), target,
+        new TMethodEventJob<SecureSocketTests>(
+            this, &SecureSocketTests::handleGarbageConnected, connection));
+    m_events.adoptHandler(m_events.forISocket().disconnected(), target,
+        new TMethodEventJob<SecureSocketTests>(
+            this, &SecureSocketTests::handleGarbageDisconnected, connection));
+
+    // quits when the server closes the connection, well before the
+    // handshake would time out
+    Stopwatch stopwatch;
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+
+    EXPECT_TRUE(connection->m_finished);
+    EXPECT_GT(5.0, stopwatch.getTime());
+    EXPECT_EQ(0, listener.getNumClientSockets());
+    EXPECT_EQ(0, SecureSocket::getPendingAccepts());
+    closeAll();
+}
+
+TEST_F(SecureSocketTests, benchmark_connectionStorm_connectedClientNotDelayed)
+{
+    m_clients.resize(kStormClients + 1);
+    m_address = NetworkAddress(TEST_SECURE_HOST, TEST_SECURE_PORT);
+    m_address.resolve();
+
+    SocketMultiplexer serverSocketMultiplexer;
+    listen(&serverSocketMultiplexer, m_address,
+                            SecureSocket::kHandshakeTimeout,
+                            SecureListenSocket::kMaxPendingHandshakes);
+
+    // one client pings the server while the rest connect at once
+    SocketMultiplexer clientSocketMultiplexer;
+    TCPSocketFactory clientSocketFactory(&m_events, &clientSocketMultiplexer);
+    m_clientSocketFactory = &clientSocketFactory;
+    SecureConnection* connection =
+                            connect(&clientSocketFactory, m_address, 0, true);
+    void* target = connection->m_socket->getEventTarget();
+    m_events.adoptHandler(m_events.forIDataSocket().secureConnected(), target,
+        new TMethodEventJob<SecureSocketTests>(
+            this, &SecureSocketTests::handlePingConnected, connection));
+    m_events.adoptHandler(m_events.forIStream().inputReady(), target,
+        new TMethodEventJob<SecureSocketTests>(
+            this, &SecureSocketTests::handlePingInput, connection));
+
+    m_events.initQuitTimeout(60);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+
+    EXPECT_LE(kStormPings, m_pings);
+    EXPECT_EQ(kStormClients, m_stormConnected + m_stormFailed);
+    EXPECT_LT(0, m_stormConnected);
+    LOG((CLOG_INFO "connection storm: %d connected, %d failed, slowest ping %.1fms",
+        m_stormConnected, m_stormFailed, 1000.0 * m_maxPing));
+
+    closeAll();
+    m_clientSocketFactory = NULL;
+}
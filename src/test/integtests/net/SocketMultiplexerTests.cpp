@@ -0,0 +1,238 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/SocketMultiplexer.h"
+#include "net/ISocket.h"
+#include "net/ISocketMultiplexerJob.h"
+#include "net/NetworkAddress.h"
+#include "mt/CondVar.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+#include "base/Stopwatch.h"
+
+#include "test/global/gtest.h"
+#include <algorithm>
+#include <vector>
+
+#define TEST_MULTIPLEXER_PORT 24804
+#define TEST_MULTIPLEXER_HOST "127.0.0.1"
+
+const int kWakeupIterations = 200;
+const int kRearmIterations = 10000;
+const double kWakeupTimeout = 5.0;
+
+// the multiplexer only uses the socket object as a key
+class BenchmarkSocket : public ISocket {
+public:
+    virtual void        bind(const NetworkAddress&) { }
+    virtual void        close() { }
+    virtual void*        getEventTarget() const
+    {
+        return const_cast<void*>(static_cast<const void*>(this));
+    }
+};
+
+// drains the socket and counts the wakeup
+class BenchmarkJob : public ISocketMultiplexerJob {
+public:
+    BenchmarkJob(ArchSocket socket, CondVar<int>* wakeups) :
+        m_socket(ARCH->copySocket(socket)),
+        m_wakeups(wakeups) { }
+    virtual ~BenchmarkJob() { ARCH->closeSocket(m_socket); }
+
+    virtual MultiplexerJobStatus run(bool readable, bool, bool)
+    {
+        if (readable) {
+            char buffer[16];
+            ARCH->readSocket(m_socket, buffer, sizeof(buffer));
+
+            Lock lock(m_wakeups->getMutex());
+            *m_wakeups = *m_wakeups + 1;
+            m_wakeups->broadcast();
+        }
+        return {true, {}};
+    }
+
+    virtual ArchSocket    getSocket() const { return m_socket; }
+    virtual bool        isReadable() const { return true; }
+    virtual bool        isWritable() const { return false; }
+
+private:
+    ArchSocket            m_socket;
+    CondVar<int>*        m_wakeups;
+};
+
+class SocketMultiplexerTests : public ::testing::Test
+{
+public:
+    void                connectPairs(int count);
+    void                closePairs();
+    double                measureWakeup(bool usePollSet, int count);
+    double                measureRearm(bool usePollSet);
+
+public:
+    std::vector<ArchSocket>    m_writers;
+    std::vector<ArchSocket>    m_readers;
+};
+
+void
+SocketMultiplexerTests::connectPairs(int count)
+{
+    NetworkAddress address(TEST_MULTIPLEXER_HOST, TEST_MULTIPLEXER_PORT);
+    address.resolve();
+
+    ArchSocket listener = ARCH->newSocket(IArchNetwork::kINET,
+                                IArchNetwork::kSTREAM);
+    ARCH->setReuseAddrOnSocket(listener, true);
+    ARCH->bindSocket(listener, address.getAddress());
+    ARCH->listenOnSocket(listener);
+
+    for (int i = 0; i < count; ++i) {
+        ArchSocket writer = ARCH->newSocket(IArchNetwork::kINET,
+                                IArchNetwork::kSTREAM);
+        ARCH->connectSocket(writer, address.getAddress());
+
+        // the listen backlog is short so accept each connection now
+        ArchSocket reader = NULL;
+        while (reader == NULL) {
+            IArchNetwork::PollEntry pe = { listener, IArchNetwork::kPOLLIN, 0 };
+            ARCH->pollSocket(&pe, 1, kWakeupTimeout);
+            reader = ARCH->acceptSocket(listener, NULL);
+        }
+        ARCH->setNoDelayOnSocket(writer, true);
+
+        m_writers.push_back(writer);
+        m_readers.push_back(reader);
+    }
+
+    ARCH->closeSocket(listener);
+}
+
+void
+SocketMultiplexerTests::closePairs()
+{
+    for (size_t i = 0; i < m_writers.size(); ++i) {
+        ARCH->closeSocket(m_writers[i]);
+        ARCH->closeSocket(m_readers[i]);
+    }
+    m_writers.clear();
+    m_readers.clear();
+}
+
+// returns the mean time from a write on one socket until its job runs
+double
+SocketMultiplexerTests::measureWakeup(bool usePollSet, int count)
+{
+    connectPairs(count);
+
+    Mutex mutex;
+    CondVar<int> wakeups(&mutex, 0);
+    std::vector<BenchmarkSocket> sockets(count);
+    SocketMultiplexer multiplexer(usePollSet);
+    for (int i = 0; i < count; ++i) {
+        multiplexer.addSocket(&sockets[i],
+            std::make_unique<BenchmarkJob>(m_readers[i], &wakeups));
+    }
+
+    std::vector<double> times;
+    Stopwatch stopwatch;
+    for (int i = 0; i < kWakeupIterations; ++i) {
+        // spread the writes over the sockets
+        int index = static_cast<int>((i * 7919L) % count);
+
+        Lock lock(&mutex);
+        int expected = wakeups + 1;
+        stopwatch.reset();
+        ARCH->writeSocket(m_writers[index], "x", 1);
+        while (wakeups < expected) {
+            if (!wakeups.wait(stopwatch, kWakeupTimeout)) {
+                break;
+            }
+        }
+        times.push_back(stopwatch.getTime());
+        EXPECT_EQ(expected, wakeups);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        multiplexer.removeSocket(&sockets[i]);
+    }
+    closePairs();
+
+    std::sort(times.begin(), times.end());
+    double total = 0.0;
+    for (size_t i = 0; i < times.size(); ++i) {
+        total += times[i];
+    }
+    double mean = total / times.size();
+    LOG((CLOG_INFO "multiplexer wakeup with %s, %d sockets: mean=%.1fus p99=%.1fus",
+        usePollSet ? "poll set" : "poll", count, 1.0e+6 * mean,
+        1.0e+6 * times[times.size() * 99 / 100]));
+    return mean;
+}
+
+// returns the mean time a caller spends replacing a socket's job, as
+// TCPSocket does whenever it has new data to write
+double
+SocketMultiplexerTests::measureRearm(bool usePollSet)
+{
+    connectPairs(1);
+
+    Mutex mutex;
+    CondVar<int> wakeups(&mutex, 0);
+    BenchmarkSocket socket;
+    SocketMultiplexer multiplexer(usePollSet);
+
+    Stopwatch stopwatch;
+    for (int i = 0; i < kRearmIterations; ++i) {
+        multiplexer.addSocket(&socket,
+            std::make_unique<BenchmarkJob>(m_readers[0], &wakeups));
+    }
+    double mean = stopwatch.getTime() / kRearmIterations;
+
+    multiplexer.removeSocket(&socket);
+    closePairs();
+
+    LOG((CLOG_INFO "multiplexer rearm with %s: mean=%.2fus",
+        usePollSet ? "poll set" : "poll", 1.0e+6 * mean));
+    return mean;
+}
+
+TEST_F(SocketMultiplexerTests, rearmCost)
+{
+    measureRearm(true);
+    measureRearm(false);
+}
+
+TEST_F(SocketMultiplexerTests, wakeupLatency_10sockets)
+{
+    measureWakeup(true, 10);
+    measureWakeup(false, 10);
+}
+
+TEST_F(SocketMultiplexerTests, wakeupLatency_100sockets)
+{
+    measureWakeup(true, 100);
+    measureWakeup(false, 100);
+}
+
+TEST_F(SocketMultiplexerTests, wakeupLatency_1000sockets)
+{
+    measureWakeup(true, 1000);
+    measureWakeup(false, 1000);
+}
@@ -155,3 +155,155 @@ TEST_F(CXWindowsClipboardTests, get_withFormatAdded_returnsExpected)
 }
 
 #endif
+
+// run against a real or virtual display, e.g. under xvfb-run
+
+// gtest comes before the X headers, which define None and Bool
+#include "test/global/gtest.h"
+
+#include "platform/XWindowsClipboard.h"
+#include "platform/XWindowsImpl.h"
+#include "platform/XWindowsUtil.h"
+#include "barrier/Clipboard.h"
+#include "arch/Arch.h"
+#include "base/Stopwatch.h"
+
+#include <cstdlib>
+
+const double kNotifyTimeout = 2.0;
+
+class XWindowsClipboardPromiseTests : public ::testing::Test {
+public:
+    XWindowsClipboardPromiseTests() :
+        m_display(NULL),
+        m_requestor(NULL),
+        m_window(None),
+        m_requestorWindow(None) { }
+
+protected:
+    virtual void        SetUp();
+    virtual void        TearDown();
+
+    // waits for the owner's reply to a request for \c target.  returns
+    // the property holding the data, None if the request failed.
+    bool                waitForNotify(Atom target, Atom& property);
+
+protected:
+    XWindowsImpl        m_impl;
+    Display*            m_display;
+    Display*            m_requestor;
+    Window                m_window;
+    Window                m_requestorWindow;
+};
+
+static
+Window
+createWindow(Display* display)
+{
+    XSetWindowAttributes attr;
+    attr.event_mask        = PropertyChangeMask;
+    attr.override_redirect = True;
+    return XCreateWindow(display, DefaultRootWindow(display),
+                            0, 0, 1, 1, 0, 0, InputOnly, CopyFromParent,
+                            CWEventMask | CWOverrideRedirect, &attr);
+}
+
+void
+XWindowsClipboardPromiseTests::SetUp()
+{
+    const char* displayName = std::getenv("DISPLAY");
+    if (displayName == NULL) {
+        displayName = ":0.0";
+    }
+
+    // the requestor is another client with its own connection
+    m_display   = XOpenDisplay(displayName);
+    m_requestor = XOpenDisplay(displayName);
+    ASSERT_TRUE(m_display != NULL);
+    ASSERT_TRUE(m_requestor != NULL);
+    m_window          = createWindow(m_display);
+    m_requestorWindow = createWindow(m_requestor);
+    XSync(m_display, False);
+    XSync(m_requestor, False);
+}
+
+void
+XWindowsClipboardPromiseTests::TearDown()
+{
+    if (m_requestor != NULL) {
+        if (m_requestorWindow != None) {
+            XDestroyWindow(m_requestor, m_requestorWindow);
+        }
+        XCloseDisplay(m_requestor);
+    }
+    if (m_display != NULL) {
+        if (m_window != None) {
+            XDestroyWindow(m_display, m_window);
+        }
+        XCloseDisplay(m_display);
+    }
+}
+
+bool
+XWindowsClipboardPromiseTests::waitForNotify(Atom target, Atom& property)
+{
+    Stopwatch stopwatch;
+    while (stopwatch.getTime() < kNotifyTimeout) {
+        XEvent event;
+        XSync(m_requestor, False);
+        if (XCheckTypedWindowEvent(m_requestor, m_requestorWindow,
+                            SelectionNotify, &event)) {
+            if (event.xselection.target == target) {
+                property = event.xselection.property;
+                return true;
+            }
+            continue;
+        }
+        ARCH->sleep(0.01);
+    }
+    return false;
+}
+
+TEST_F(XWindowsClipboardPromiseTests, fulfil_someFormatsMissing_missingRequestsFail)
+{
+    XWindowsClipboard clipboard(&m_impl, m_display, m_window,
+                            kClipboardClipboard);
+    ASSERT_TRUE(clipboard.open(XWindowsUtil::getCurrentTime(m_display, m_window)));
+    ASSERT_TRUE(clipboard.empty());
+    clipboard.promise((1u << IClipboard::kText) | (1u << IClipboard::kHTML));
+    clipboard.close();
+
+    // the requestor asks for both promised formats
+    Atom text         = XInternAtom(m_display, "UTF8_STRING", False);
+    Atom html         = XInternAtom(m_display, "text/html", False);
+    Atom textProperty = XInternAtom(m_display, "BARRIER_TEST_TEXT", False);
+    Atom htmlProperty = XInternAtom(m_display, "BARRIER_TEST_HTML", False);
+    clipboard.addRequest(m_window, m_requestorWindow, text, CurrentTime,
+                            textProperty);
+    clipboard.addRequest(m_window, m_requestorWindow, html, CurrentTime,
+                            htmlProperty);
+    EXPECT_EQ((1u << IClipboard::kText) | (1u << IClipboard::kHTML),
+                            clipboard.takeRequests());
+
+    // only the text arrives
+    Clipboard fetched;
+    fetched.open(0);
+    fetched.add(IClipboard::kText, "some text");
+    fetched.close();
+    clipboard.fulfil(&fetched);
+    XSync(m_display, False);
+
+    Atom property = None;
+    ASSERT_TRUE(waitForNotify(text, property));
+    EXPECT_EQ(textProperty, property);
+
+    // replies to a requestor go one at a time
+    XDeleteProperty(m_requestor, m_requestorWindow, textProperty);
+    XSync(m_requestor, False);
+    clipboard.processRequest(m_requestorWindow, CurrentTime, textProperty);
+    XSync(m_display, False);
+
+    ASSERT_TRUE(waitForNotify(html, property));
+    EXPECT_EQ((Atom)None, property);
+    EXPECT_EQ(0u, clipboard.takeRequests());
+}
@@ -0,0 +1,246 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// run against a real or virtual display, e.g. under xvfb-run
+
+#include "test/mock/barrier/MockEventQueue.h"
+#include "platform/XWindowsEventQueueBuffer.h"
+#include "platform/XWindowsImpl.h"
+#include "mt/Thread.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+#include "base/Stopwatch.h"
+#include "base/TMethodJob.h"
+
+#include "test/global/gtest.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <sys/resource.h>
+
+using ::testing::NiceMock;
+
+const double kIdleTime = 1.0;
+const int kInjections = 20;
+const double kInjectDelay = 0.01;
+const double kInjectTimeout = 2.0;
+
+class XWindowsEventQueueBufferTests : public ::testing::Test {
+public:
+    XWindowsEventQueueBufferTests() :
+        m_display(NULL),
+        m_sender(NULL),
+        m_window(None),
+        m_atom(None),
+        m_buffer(NULL),
+        m_userEvent(false),
+        m_injectTime(0.0) { }
+
+protected:
+    virtual void        SetUp();
+    virtual void        TearDown();
+
+    // returns the time from injecting each event until waitForEvent()
+    // returns, sorted
+    std::vector<double>    measureLatency(bool userEvent);
+
+    void                inject(void*);
+    void                drain(IEventQueueBuffer::Type expected);
+    void                report(const char* name,
+                            const std::vector<double>& latencies);
+
+protected:
+    XWindowsImpl        m_impl;
+    NiceMock<MockEventQueue>    m_events;
+    Display*            m_display;
+    Display*            m_sender;
+    Window                m_window;
+    Atom                m_atom;
+    XWindowsEventQueueBuffer*    m_buffer;
+    bool                m_userEvent;
+    double                m_injectTime;
+};
+
+void
+XWindowsEventQueueBufferTests::SetUp()
+{
+    const char* displayName = std::getenv("DISPLAY");
+    if (displayName == NULL) {
+        displayName = ":0.0";
+    }
+
+    // events are injected through a second connection, as they would
+    // be from other clients
+    m_display = XOpenDisplay(displayName);
+    m_sender  = XOpenDisplay(displayName);
+    ASSERT_TRUE(m_display != NULL);
+    ASSERT_TRUE(m_sender != NULL);
+
+    XSetWindowAttributes attr;
+    attr.do_not_propagate_mask = 0;
+    attr.override_redirect     = True;
+    m_window = XCreateWindow(m_display, DefaultRootWindow(m_display),
+                            0, 0, 1, 1, 0, 0, InputOnly, CopyFromParent,
+                            CWDontPropagate | CWOverrideRedirect, &attr);
+    m_atom   = XInternAtom(m_sender, "BARRIER_TEST_EVENT", False);
+    XSync(m_display, False);
+
+    m_buffer = new XWindowsEventQueueBuffer(&m_impl, m_display, m_window,
+                            &m_events);
+}
+
+void
+XWindowsEventQueueBufferTests::TearDown()
+{
+    delete m_buffer;
+    if (m_window != None) {
+        XDestroyWindow(m_display, m_window);
+    }
+    if (m_display != NULL) {
+        XCloseDisplay(m_display);
+    }
+    if (m_sender != NULL) {
+        XCloseDisplay(m_sender);
+    }
+}
+
+std::vector<double>
+XWindowsEventQueueBufferTests::measureLatency(bool userEvent)
+{
+    m_userEvent = userEvent;
+
+    std::vector<double> latencies;
+    for (int i = 0; i < kInjections; ++i) {
+        Thread thread(new TMethodJob<XWindowsEventQueueBufferTests>(
+                            this, &XWindowsEventQueueBufferTests::inject));
+
+        // the buffer may return early without an event so wait until
+        // there is one
+        Stopwatch stopwatch;
+        while (m_buffer->isEmpty() && stopwatch.getTime() < kInjectTimeout) {
+            m_buffer->waitForEvent(kInjectTimeout - stopwatch.getTime());
+        }
+        double now = ARCH->time();
+
+        thread.wait();
+        latencies.push_back(now - m_injectTime);
+        drain(userEvent ? IEventQueueBuffer::kUser :
+                            IEventQueueBuffer::kSystem);
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+void
+XWindowsEventQueueBufferTests::inject(void*)
+{
+    ARCH->sleep(kInjectDelay);
+
+    m_injectTime = ARCH->time();
+    if (m_userEvent) {
+        m_buffer->addEvent(1);
+    }
+    else {
+        XEvent xevent;
+        memset(&xevent, 0, sizeof(xevent));
+        xevent.xclient.type         = ClientMessage;
+        xevent.xclient.window       = m_window;
+        xevent.xclient.message_type = m_atom;
+        xevent.xclient.format       = 32;
+        XSendEvent(m_sender, m_window, False, 0, &xevent);
+        XFlush(m_sender);
+    }
+}
+
+void
+XWindowsEventQueueBufferTests::drain(IEventQueueBuffer::Type expected)
+{
+    int count = 0;
+    while (!m_buffer->isEmpty()) {
+        Event event;
+        UInt32 dataID;
+        EXPECT_EQ(expected, m_buffer->getEvent(event, dataID));
+        ++count;
+    }
+    EXPECT_EQ(1, count);
+}
+
+void
+XWindowsEventQueueBufferTests::report(const char* name,
+                const std::vector<double>& latencies)
+{
+    LOG((CLOG_INFO "%s event latency: p50=%.2fms max=%.2fms", name,
+        1.0e+3 * latencies[latencies.size() / 2],
+        1.0e+3 * latencies.back()));
+}
+
+TEST_F(XWindowsEventQueueBufferTests, waitForEvent_idle_sleepsUntilTimeout)
+{
+    struct rusage before, after;
+    getrusage(RUSAGE_THREAD, &before);
+    Stopwatch stopwatch;
+    m_buffer->waitForEvent(kIdleTime);
+    double time = stopwatch.getTime();
+    getrusage(RUSAGE_THREAD, &after);
+
+    // every time the thread blocks and is woken counts as a voluntary
+    // context switch
+    double wakeups = (after.ru_nvcsw - before.ru_nvcsw) / time;
+    LOG((CLOG_INFO "idle wait: %.1f wakeups/sec", wakeups));
+
+    EXPECT_LE(kIdleTime, time + 0.001);
+    EXPECT_GE(5.0, wakeups);
+}
+
+TEST_F(XWindowsEventQueueBufferTests, waitForEvent_userEvent_wakesPromptly)
+{
+    std::vector<double> latencies = measureLatency(true);
+    report("user", latencies);
+
+    EXPECT_GT(0.005, latencies[latencies.size() / 2]);
+}
+
+TEST_F(XWindowsEventQueueBufferTests, waitForEvent_xEvent_wakesPromptly)
+{
+    std::vector<double> latencies = measureLatency(false);
+    report("X", latencies);
+
+    EXPECT_GT(0.005, latencies[latencies.size() / 2]);
+}
+
+TEST_F(XWindowsEventQueueBufferTests, waitForEvent_bufferedXEvent_noWait)
+{
+    // two events arrive together so reading the first into xlib reads
+    // the second too, where poll() can't see it
+    m_userEvent = false;
+    inject(NULL);
+    inject(NULL);
+    XSync(m_sender, False);
+    XSync(m_display, False);
+
+    Event event;
+    UInt32 dataID;
+    ASSERT_FALSE(m_buffer->isEmpty());
+    EXPECT_EQ(IEventQueueBuffer::kSystem, m_buffer->getEvent(event, dataID));
+
+    Stopwatch stopwatch;
+    m_buffer->waitForEvent(kInjectTimeout);
+    EXPECT_GT(0.005, stopwatch.getTime());
+    drain(IEventQueueBuffer::kSystem);
+}
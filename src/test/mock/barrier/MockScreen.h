@@ -33,4 +33,8 @@ public:
     MOCK_METHOD0(resetOptions, void());
     MOCK_METHOD1(setOptions, void(const OptionsList&));
     MOCK_METHOD0(enable, void());
+    MOCK_CONST_METHOD2(getClipboard, bool(ClipboardID, IClipboard*));
+    MOCK_CONST_METHOD3(getClipboardFormats, bool(ClipboardID, UInt32&, IClipboard::Time&));
+    MOCK_METHOD2(promiseClipboard, bool(ClipboardID, UInt32));
+    MOCK_METHOD2(fulfilClipboard, void(ClipboardID, const IClipboard*));
 };
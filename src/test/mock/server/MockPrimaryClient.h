@@ -38,4 +38,9 @@ public:
     MOCK_METHOD2(registerHotKey, UInt32(KeyID, KeyModifierMask));
     MOCK_CONST_METHOD0(getToggleMask, KeyModifierMask());
     MOCK_METHOD1(unregisterHotKey, void(UInt32));
+    MOCK_CONST_METHOD2(getClipboard, bool(ClipboardID, IClipboard*));
+    MOCK_METHOD1(grabClipboard, void(ClipboardID));
+    MOCK_METHOD2(setClipboard, void(ClipboardID, const IClipboard*));
+    MOCK_METHOD2(promiseClipboard, bool(ClipboardID, UInt32));
+    MOCK_METHOD2(fulfilClipboard, void(ClipboardID, const IClipboard*));
 };
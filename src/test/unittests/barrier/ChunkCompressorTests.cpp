@@ -0,0 +1,139 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/ChunkCompressor.h"
+
+#include "test/global/gtest.h"
+
+// bytes that don't repeat, from a linear congruential generator
+static String
+makeNoise(size_t size, UInt32 seed)
+{
+    String data(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        seed    = seed * 1103515245u + 12345u;
+        data[i] = static_cast<char>(seed >> 24);
+    }
+    return data;
+}
+
+// rows of pixels with a little noise, like a screenshot
+static String
+makeRows(size_t size)
+{
+    String noise = makeNoise(size / 64, 1);
+    String data(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<char>(i % 300 < 200 ? 0x40 : i & 0xff);
+        if (i % 64 == 0) {
+            data[i] = noise[i / 64];
+        }
+    }
+    return data;
+}
+
+TEST(ChunkCompressorTests, compress_repetitive_decompressesToOriginal)
+{
+    ChunkCompressor compressor;
+    String data = makeRows(32 * 1024);
+
+    String compressed;
+    ASSERT_TRUE(compressor.compress(data.data(), data.size(), compressed));
+    EXPECT_GT(data.size() / 2, compressed.size());
+
+    String decompressed;
+    EXPECT_TRUE(ChunkCompressor::decompress(compressed.data(), compressed.size(), decompressed));
+    EXPECT_EQ(data, decompressed);
+}
+
+TEST(ChunkCompressorTests, compress_longRuns_decompressesToOriginal)
+{
+    // matches and literals longer than fit in a token
+    ChunkCompressor compressor;
+    String data = makeNoise(2000, 2) + String(5000, 'a') + makeNoise(1000, 3);
+
+    String compressed;
+    ASSERT_TRUE(compressor.compress(data.data(), data.size(), compressed));
+
+    String decompressed;
+    EXPECT_TRUE(ChunkCompressor::decompress(compressed.data(), compressed.size(), decompressed));
+    EXPECT_EQ(data, decompressed);
+}
+
+TEST(ChunkCompressorTests, compress_belowThreshold_notCompressed)
+{
+    ChunkCompressor compressor;
+    String data(ChunkCompressor::kThreshold - 1, 'a');
+
+    String compressed;
+    EXPECT_FALSE(compressor.compress(data.data(), data.size(), compressed));
+}
+
+TEST(ChunkCompressorTests, compress_noise_skippedUntilStart)
+{
+    ChunkCompressor compressor;
+    String noise = makeNoise(32 * 1024, 4);
+    String rows  = makeRows(32 * 1024);
+
+    // the search gets faster then stops for a while
+    String compressed;
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_FALSE(compressor.compress(noise.data(), noise.size(), compressed));
+    }
+    EXPECT_FALSE(compressor.compress(rows.data(), rows.size(), compressed));
+
+    compressor.start();
+    EXPECT_TRUE(compressor.compress(rows.data(), rows.size(), compressed));
+}
+
+TEST(ChunkCompressorTests, decompress_appendsToData)
+{
+    ChunkCompressor compressor;
+    String data = makeRows(4096);
+    String compressed;
+    ASSERT_TRUE(compressor.compress(data.data(), data.size(), compressed));
+
+    String decompressed("before");
+    EXPECT_TRUE(ChunkCompressor::decompress(compressed.data(), compressed.size(), decompressed));
+    EXPECT_EQ("before" + data, decompressed);
+}
+
+TEST(ChunkCompressorTests, decompress_malformed_rejected)
+{
+    ChunkCompressor compressor;
+    String data = makeRows(4096);
+    String compressed;
+    ASSERT_TRUE(compressor.compress(data.data(), data.size(), compressed));
+
+    // cut short
+    String decompressed("before");
+    EXPECT_FALSE(ChunkCompressor::decompress(compressed.data(), compressed.size() - 1, decompressed));
+    EXPECT_EQ("before", decompressed);
+
+    // a size that doesn't match the data
+    String wrongSize = compressed;
+    wrongSize[3] = static_cast<char>(wrongSize[3] + 1);
+    EXPECT_FALSE(ChunkCompressor::decompress(wrongSize.data(), wrongSize.size(), decompressed));
+
+    // a match before the start of the data
+    const char badOffset[] = { 0, 0, 0, 8, 0x10, 'a', 0x10, 0x00, 0x20 };
+    EXPECT_FALSE(ChunkCompressor::decompress(badOffset, sizeof(badOffset), decompressed));
+
+    // too large
+    const char tooLarge[] = { 0x7f, 0, 0, 0, 0 };
+    EXPECT_FALSE(ChunkCompressor::decompress(tooLarge, sizeof(tooLarge), decompressed));
+}
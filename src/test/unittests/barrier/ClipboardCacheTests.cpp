@@ -0,0 +1,133 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/ClipboardCache.h"
+#include "barrier/Clipboard.h"
+
+#include "test/global/gtest.h"
+
+static
+std::uint64_t
+hashString(const String& data)
+{
+    return ClipboardCache::hash(data.data(), data.size());
+}
+
+TEST(ClipboardCacheTests, hash_knownValues_matchXXH64)
+{
+    EXPECT_EQ(0xef46db3751d8e999ULL, hashString(""));
+    EXPECT_EQ(0x44bc2cf5ad770999ULL, hashString("abc"));
+}
+
+TEST(ClipboardCacheTests, hash_everyLength_differs)
+{
+    // covers the 32 byte stripes and each kind of tail
+    String data;
+    std::uint64_t last = hashString(data);
+    for (int i = 0; i < 100; ++i) {
+        data += (char)i;
+        std::uint64_t hash = hashString(data);
+        EXPECT_NE(last, hash);
+        last = hash;
+    }
+}
+
+TEST(ClipboardCacheTests, find_added_returnsData)
+{
+    ClipboardCache cache;
+    String data("clipboard data");
+    cache.add(hashString(data), data);
+
+    String found;
+    EXPECT_TRUE(cache.find(hashString(data), (UInt32)data.size(), found));
+    EXPECT_EQ(data, found);
+    EXPECT_EQ(data.size(), cache.getSize());
+}
+
+TEST(ClipboardCacheTests, find_wrongSize_notFound)
+{
+    ClipboardCache cache;
+    String data("clipboard data");
+    cache.add(hashString(data), data);
+
+    String found;
+    EXPECT_FALSE(cache.find(hashString(data), (UInt32)data.size() + 1, found));
+    EXPECT_FALSE(cache.has(hashString(data) + 1, (UInt32)data.size()));
+}
+
+TEST(ClipboardCacheTests, add_full_leastRecentlyUsedDropped)
+{
+    ClipboardCache cache(30);
+    String first(10, 'a');
+    String second(10, 'b');
+    String third(10, 'c');
+    cache.add(hashString(first), first);
+    cache.add(hashString(second), second);
+    cache.add(hashString(third), third);
+
+    // using the first makes the second the oldest
+    String found;
+    EXPECT_TRUE(cache.find(hashString(first), 10, found));
+
+    String fourth(10, 'd');
+    cache.add(hashString(fourth), fourth);
+
+    EXPECT_TRUE(cache.has(hashString(first), 10));
+    EXPECT_FALSE(cache.has(hashString(second), 10));
+    EXPECT_TRUE(cache.has(hashString(third), 10));
+    EXPECT_TRUE(cache.has(hashString(fourth), 10));
+    EXPECT_EQ(30, cache.getSize());
+}
+
+TEST(ClipboardCacheTests, add_tooLarge_notSaved)
+{
+    ClipboardCache cache(10);
+    String data(11, 'a');
+    cache.add(hashString(data), data);
+
+    EXPECT_FALSE(cache.has(hashString(data), 11));
+    EXPECT_EQ(0, cache.getSize());
+}
+
+TEST(ClipboardCacheTests, add_twice_savedOnce)
+{
+    ClipboardCache cache;
+    String data("clipboard data");
+    cache.add(hashString(data), data);
+    cache.add(hashString(data), data);
+
+    EXPECT_EQ(data.size(), cache.getSize());
+}
+
+TEST(ClipboardCacheTests, summarize_twoFormats_hashedInOrder)
+{
+    Clipboard clipboard;
+    clipboard.open(0);
+    clipboard.add(IClipboard::kBitmap, "bitmap");
+    clipboard.add(IClipboard::kText, "text");
+    clipboard.close();
+
+    ClipboardCache::Summary summary;
+    ClipboardCache::summarize(&clipboard, summary);
+
+    ASSERT_EQ(2, summary.size());
+    EXPECT_EQ(IClipboard::kText, summary[0].m_format);
+    EXPECT_EQ(4, summary[0].m_size);
+    EXPECT_EQ(hashString("text"), summary[0].m_hash);
+    EXPECT_EQ(IClipboard::kBitmap, summary[1].m_format);
+    EXPECT_EQ(hashString("bitmap"), summary[1].m_hash);
+}
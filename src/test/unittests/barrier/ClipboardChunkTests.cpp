@@ -16,9 +16,67 @@
  */
 
 #include "barrier/ClipboardChunk.h"
+#include "barrier/ProtocolUtil.h"
 #include "barrier/protocol_types.h"
+#include "io/IStream.h"
+#include "io/StreamBuffer.h"
 
 #include "test/global/gtest.h"
+#include <cstring>
+
+// an in-memory stream that reads back what was written
+class ChunkStream : public barrier::IStream {
+public:
+    virtual void        close() { }
+    virtual UInt32        read(void* buffer, UInt32 n)
+    {
+        if (n > m_buffer.getSize()) {
+            n = m_buffer.getSize();
+        }
+        if (buffer != NULL && n != 0) {
+            memcpy(buffer, m_buffer.data(), n);
+        }
+        m_buffer.consume(n);
+        return n;
+    }
+    virtual void        write(const void* buffer, UInt32 n)
+    {
+        m_buffer.write(buffer, n);
+    }
+    virtual void        flush() { }
+    virtual void        shutdownInput() { }
+    virtual void        shutdownOutput() { }
+    virtual void*        getEventTarget() const { return NULL; }
+    virtual bool        isReady() const { return m_buffer.getSize() > 0; }
+    virtual UInt32        getSize() const { return m_buffer.getSize(); }
+
+    // writes a kMsgDClipboard and assembles it
+    int                    assemble(ClipboardTransfer* transfers, ClipboardID id,
+                            UInt8 mark, const String& data)
+    {
+        ProtocolUtil::writef(this, kMsgDClipboard, id, 0, mark, &data);
+        read(NULL, 4);
+
+        ClipboardID readID;
+        UInt32 sequence;
+        int result = ClipboardChunk::assemble(this, transfers, readID, sequence);
+        EXPECT_EQ(id, readID);
+        return result;
+    }
+
+private:
+    StreamBuffer        m_buffer;
+};
+
+static String
+marshallText(const String& text)
+{
+    Clipboard clipboard;
+    clipboard.open(0);
+    clipboard.add(IClipboard::kText, text);
+    clipboard.close();
+    return clipboard.marshall();
+}
 
 TEST(ClipboardChunkTests, start_formatStartChunk)
 {
@@ -74,3 +132,36 @@ TEST(ClipboardChunkTests, end_formatDataChunk)
 
     delete chunk;
 }
+
+TEST(ClipboardChunkTests, assemble_twoClipboardsInterleaved_bothReceived)
+{
+    ChunkStream stream;
+    ClipboardTransfer transfers[kClipboardEnd];
+    String first  = marshallText("first");
+    String second = marshallText("second");
+
+    EXPECT_EQ(kStart, stream.assemble(transfers, kClipboardClipboard, kDataStart,
+                        barrier::string::sizeTypeToString(first.size())));
+    EXPECT_EQ(kStart, stream.assemble(transfers, kClipboardSelection, kDataStart,
+                        barrier::string::sizeTypeToString(second.size())));
+    EXPECT_EQ(kNotFinish, stream.assemble(transfers, kClipboardSelection, kDataChunk, second));
+    EXPECT_EQ(kNotFinish, stream.assemble(transfers, kClipboardClipboard, kDataChunk, first));
+    EXPECT_EQ(kFinish, stream.assemble(transfers, kClipboardClipboard, kDataEnd, ""));
+    EXPECT_EQ(kFinish, stream.assemble(transfers, kClipboardSelection, kDataEnd, ""));
+
+    Clipboard clipboard;
+    EXPECT_TRUE(transfers[kClipboardClipboard].m_data.unmarshall(clipboard, 0));
+    EXPECT_EQ(first, clipboard.marshall());
+    EXPECT_TRUE(transfers[kClipboardSelection].m_data.unmarshall(clipboard, 0));
+    EXPECT_EQ(second, clipboard.marshall());
+    EXPECT_EQ(first.size(), transfers[kClipboardClipboard].m_progress.getReceived());
+    EXPECT_EQ(second.size(), transfers[kClipboardSelection].m_progress.getReceived());
+}
+
+TEST(ClipboardChunkTests, assemble_invalidID_error)
+{
+    ChunkStream stream;
+    ClipboardTransfer transfers[kClipboardEnd];
+
+    EXPECT_EQ(kError, stream.assemble(transfers, kClipboardEnd, kDataStart, "10"));
+}
@@ -0,0 +1,164 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/ClipboardStreamer.h"
+#include "barrier/ClipboardUnmarshaller.h"
+#include "barrier/protocol_types.h"
+#include "test/mock/io/MockStream.h"
+#include "common/stdvector.h"
+
+#include "test/global/gtest.h"
+
+#include <cstring>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+// keeps each message written
+class ClipboardMessages {
+public:
+    void                write(const void* data, UInt32 size)
+    {
+        m_messages.push_back(String(static_cast<const char*>(data), size));
+    }
+
+    // the id, mark and data of message \c i
+    UInt8                getID(size_t i) const { return m_messages[i][4]; }
+    UInt8                getMark(size_t i) const { return m_messages[i][9]; }
+    String                getData(size_t i) const { return m_messages[i].substr(14); }
+
+public:
+    std::vector<String>    m_messages;
+};
+
+static void
+fillClipboard(Clipboard& clipboard, size_t textSize)
+{
+    clipboard.open(0);
+    clipboard.empty();
+    clipboard.add(IClipboard::kText, String(textSize, 't'));
+    clipboard.add(IClipboard::kHTML, "<p>html</p>");
+    clipboard.close();
+}
+
+TEST(ClipboardStreamerTests, send_large_oneWindowAtATime)
+{
+    NiceMock<MockStream> stream;
+    ClipboardMessages messages;
+    ON_CALL(stream, write(_, _)).WillByDefault(Invoke(&messages, &ClipboardMessages::write));
+
+    Clipboard clipboard;
+    fillClipboard(clipboard, 10 * ClipboardStreamer::kChunkSize);
+    String expected = clipboard.marshall();
+
+    ClipboardStreamer streamer(&stream);
+    streamer.send(kClipboardClipboard, 1, clipboard);
+    EXPECT_EQ(ClipboardStreamer::kWindowChunks, messages.m_messages.size());
+
+    while (streamer.isSending()) {
+        size_t written = messages.m_messages.size();
+        streamer.flush();
+        EXPECT_GE(ClipboardStreamer::kWindowChunks, messages.m_messages.size() - written);
+    }
+
+    // start, data, end and the data unmarshalls to the clipboard
+    ClipboardUnmarshaller unmarshaller;
+    unmarshaller.reset(expected.size());
+    size_t last = messages.m_messages.size() - 1;
+    EXPECT_EQ(kDataStart, messages.getMark(0));
+    EXPECT_EQ(kDataEnd, messages.getMark(last));
+    for (size_t i = 1; i < last; ++i) {
+        EXPECT_EQ(kDataChunk, messages.getMark(i));
+        EXPECT_GE(ClipboardStreamer::kChunkSize, messages.getData(i).size());
+        unmarshaller.add(messages.getData(i).data(), messages.getData(i).size());
+    }
+
+    Clipboard received;
+    EXPECT_TRUE(unmarshaller.unmarshall(received, 0));
+    EXPECT_EQ(expected, received.marshall());
+}
+
+TEST(ClipboardStreamerTests, send_sameIDAgain_firstDropped)
+{
+    NiceMock<MockStream> stream;
+    ClipboardMessages messages;
+    ON_CALL(stream, write(_, _)).WillByDefault(Invoke(&messages, &ClipboardMessages::write));
+
+    Clipboard first;
+    fillClipboard(first, 10 * ClipboardStreamer::kChunkSize);
+    Clipboard second;
+    fillClipboard(second, 10);
+
+    ClipboardStreamer streamer(&stream);
+    streamer.send(kClipboardClipboard, 1, first);
+    streamer.send(kClipboardClipboard, 2, second);
+    while (streamer.isSending()) {
+        streamer.flush();
+    }
+
+    // the second starts over after the first window
+    size_t starts = 0;
+    for (size_t i = 0; i < messages.m_messages.size(); ++i) {
+        if (messages.getMark(i) == kDataStart) {
+            ++starts;
+        }
+    }
+    EXPECT_EQ(2, starts);
+    EXPECT_EQ(ClipboardStreamer::kWindowChunks + 3, messages.m_messages.size());
+}
+
+TEST(ClipboardStreamerTests, send_compression_compressedChunksUnmarshall)
+{
+    NiceMock<MockStream> stream;
+    ClipboardMessages messages;
+    ON_CALL(stream, write(_, _)).WillByDefault(Invoke(&messages, &ClipboardMessages::write));
+
+    Clipboard clipboard;
+    fillClipboard(clipboard, 10 * ClipboardStreamer::kChunkSize);
+    String expected = clipboard.marshall();
+
+    ClipboardStreamer streamer(&stream);
+    streamer.setCompression(true);
+    streamer.send(kClipboardClipboard, 1, clipboard);
+    while (streamer.isSending()) {
+        streamer.flush();
+    }
+
+    ClipboardUnmarshaller unmarshaller;
+    unmarshaller.reset(expected.size());
+    size_t last = messages.m_messages.size() - 1;
+    size_t sent = 0;
+    for (size_t i = 1; i < last; ++i) {
+        // the last few bytes are too few to compress
+        String data = messages.getData(i);
+        if (i + 1 < last) {
+            EXPECT_EQ(kDataCompressed, messages.getMark(i));
+            EXPECT_TRUE(unmarshaller.addCompressed(data.data(), data.size()));
+        }
+        else {
+            EXPECT_EQ(kDataChunk, messages.getMark(i));
+            EXPECT_TRUE(unmarshaller.add(data.data(), data.size()));
+        }
+        sent += data.size();
+    }
+    EXPECT_GT(expected.size() / 10, sent);
+
+    Clipboard received;
+    EXPECT_TRUE(unmarshaller.unmarshall(received, 0));
+    EXPECT_EQ(expected, received.marshall());
+}
@@ -0,0 +1,109 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/ClipboardUnmarshaller.h"
+#include "barrier/Clipboard.h"
+
+#include "test/global/gtest.h"
+
+static String
+makeMarshalled(const String& text, const String& html)
+{
+    Clipboard clipboard;
+    clipboard.open(0);
+    clipboard.add(IClipboard::kText, text);
+    clipboard.add(IClipboard::kHTML, html);
+    clipboard.close();
+    return clipboard.marshall();
+}
+
+TEST(ClipboardUnmarshallerTests, add_byteAtATime_sameClipboard)
+{
+    String data = makeMarshalled("some text", "<b>html</b>");
+    ClipboardUnmarshaller unmarshaller;
+    unmarshaller.reset(data.size());
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        EXPECT_FALSE(unmarshaller.isComplete());
+        ASSERT_TRUE(unmarshaller.add(&data[i], 1));
+    }
+
+    Clipboard clipboard;
+    EXPECT_TRUE(unmarshaller.isComplete());
+    EXPECT_TRUE(unmarshaller.unmarshall(clipboard, 0));
+    EXPECT_EQ(data, clipboard.marshall());
+}
+
+TEST(ClipboardUnmarshallerTests, add_pastExpectedSize_fails)
+{
+    String data = makeMarshalled("some text", "");
+    ClipboardUnmarshaller unmarshaller;
+    unmarshaller.reset(data.size() - 1);
+
+    EXPECT_FALSE(unmarshaller.add(data.data(), data.size()));
+    EXPECT_FALSE(unmarshaller.isComplete());
+}
+
+TEST(ClipboardUnmarshallerTests, add_formatLargerThanData_fails)
+{
+    // one text format claiming 1000 bytes
+    String data("\0\0\0\1\0\0\0\0\0\0\x03\xe8text", 16);
+    ClipboardUnmarshaller unmarshaller;
+    unmarshaller.reset(data.size());
+
+    EXPECT_FALSE(unmarshaller.add(data.data(), data.size()));
+
+    Clipboard clipboard;
+    EXPECT_FALSE(unmarshaller.unmarshall(clipboard, 0));
+}
+
+TEST(ClipboardUnmarshallerTests, add_unknownFormat_skipped)
+{
+    // an unknown format then text
+    String data("\0\0\0\2\0\0\0\x7f\0\0\0\3abc\0\0\0\0\0\0\0\2hi", 25);
+    ClipboardUnmarshaller unmarshaller;
+    unmarshaller.reset(data.size());
+    EXPECT_TRUE(unmarshaller.add(data.data(), data.size()));
+
+    Clipboard clipboard;
+    EXPECT_TRUE(unmarshaller.unmarshall(clipboard, 0));
+    clipboard.open(0);
+    EXPECT_EQ("hi", clipboard.get(IClipboard::kText));
+    EXPECT_FALSE(clipboard.has(IClipboard::kHTML));
+    clipboard.close();
+}
+
+TEST(ClipboardUnmarshallerTests, merge_otherFormatsKept)
+{
+    Clipboard clipboard;
+    clipboard.open(0);
+    clipboard.add(IClipboard::kBitmap, "bitmap");
+    clipboard.add(IClipboard::kText, "old text");
+    clipboard.close();
+
+    String data = makeMarshalled("new text", "html");
+    ClipboardUnmarshaller unmarshaller;
+    unmarshaller.reset(data.size());
+    unmarshaller.add(data.data(), data.size());
+    EXPECT_TRUE(unmarshaller.merge(clipboard));
+
+    clipboard.open(0);
+    EXPECT_EQ("new text", clipboard.get(IClipboard::kText));
+    EXPECT_EQ("html", clipboard.get(IClipboard::kHTML));
+    EXPECT_EQ("bitmap", clipboard.get(IClipboard::kBitmap));
+    clipboard.close();
+}
@@ -95,6 +95,78 @@ TEST(GenericArgsParsingTests, parseGenericArgs_logFileCmdWithSpace_saveLogFilena
     EXPECT_EQ(2, i);
 }
 
+TEST(GenericArgsParsingTests, parseGenericArgs_logTimestampsCmd_saveLogTimestamps)
+{
+    int i = 1;
+    const int argc = 3;
+    const char* kLogTimestampsCmd[argc] = { "stub", "--log-timestamps", "ms" };
+
+    ArgParser argParser(NULL);
+    ArgsBase argsBase;
+    argParser.setArgsBase(argsBase);
+
+    argParser.parseGenericArgs(argc, kLogTimestampsCmd, i);
+
+    String logTimestamps(argsBase.m_logTimestamps);
+
+    EXPECT_EQ("ms", logTimestamps);
+    EXPECT_EQ(2, i);
+}
+
+TEST(GenericArgsParsingTests, parseGenericArgs_logMaxSizeCmd_saveLogMaxSize)
+{
+    int i = 1;
+    const int argc = 3;
+    const char* kLogMaxSizeCmd[argc] = { "stub", "--log-max-size", "4096" };
+
+    ArgParser argParser(NULL);
+    ArgsBase argsBase;
+    argParser.setArgsBase(argsBase);
+
+    argParser.parseGenericArgs(argc, kLogMaxSizeCmd, i);
+
+    String logMaxSize(argsBase.m_logMaxSize);
+
+    EXPECT_EQ("4096", logMaxSize);
+    EXPECT_EQ(2, i);
+}
+
+TEST(GenericArgsParsingTests, parseGenericArgs_logKeepCmd_saveLogKeep)
+{
+    int i = 1;
+    const int argc = 3;
+    const char* kLogKeepCmd[argc] = { "stub", "--log-keep", "3" };
+
+    ArgParser argParser(NULL);
+    ArgsBase argsBase;
+    argParser.setArgsBase(argsBase);
+
+    argParser.parseGenericArgs(argc, kLogKeepCmd, i);
+
+    String logKeep(argsBase.m_logKeep);
+
+    EXPECT_EQ("3", logKeep);
+    EXPECT_EQ(2, i);
+}
+
+TEST(GenericArgsParsingTests, parseGenericArgs_logSyncCmd_saveLogSync)
+{
+    int i = 1;
+    const int argc = 3;
+    const char* kLogSyncCmd[argc] = { "stub", "--log-sync", "0.5" };
+
+    ArgParser argParser(NULL);
+    ArgsBase argsBase;
+    argParser.setArgsBase(argsBase);
+
+    argParser.parseGenericArgs(argc, kLogSyncCmd, i);
+
+    String logSync(argsBase.m_logSync);
+
+    EXPECT_EQ("0.5", logSync);
+    EXPECT_EQ(2, i);
+}
+
 TEST(GenericArgsParsingTests, parseGenericArgs_noDeamonCmd_daemonFalse)
 {
     int i = 1;
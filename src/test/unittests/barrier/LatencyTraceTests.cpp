@@ -0,0 +1,85 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/LatencyTrace.h"
+
+#include "test/global/gtest.h"
+
+TEST(LatencyTraceTests, getPercentile_empty_zero)
+{
+    LatencyTrace trace;
+
+    EXPECT_EQ(0u, trace.getCount(LatencyTrace::kTotal));
+    EXPECT_EQ(0.0, trace.getPercentile(LatencyTrace::kTotal, 0.5));
+}
+
+TEST(LatencyTraceTests, getPercentile_uniform_withinBucket)
+{
+    LatencyTrace trace;
+    for (int i = 1; i <= 1000; ++i) {
+        trace.record(LatencyTrace::kNetwork, 1.0e-6 * i);
+    }
+
+    // buckets are an eighth of an octave wide
+    EXPECT_EQ(1000u, trace.getCount(LatencyTrace::kNetwork));
+    EXPECT_NEAR(500.0e-6, trace.getPercentile(LatencyTrace::kNetwork, 0.5), 64.0e-6);
+    EXPECT_NEAR(990.0e-6, trace.getPercentile(LatencyTrace::kNetwork, 0.99), 128.0e-6);
+    EXPECT_GE(trace.getPercentile(LatencyTrace::kNetwork, 0.999), 999.0e-6);
+    EXPECT_EQ(0u, trace.getCount(LatencyTrace::kServer));
+}
+
+TEST(LatencyTraceTests, record_negative_countsAsZero)
+{
+    LatencyTrace trace;
+    trace.record(LatencyTrace::kClient, -1.0);
+
+    EXPECT_EQ(1u, trace.getCount(LatencyTrace::kClient));
+    EXPECT_EQ(1.0e-6, trace.getPercentile(LatencyTrace::kClient, 1.0));
+}
+
+TEST(LatencyTraceTests, record_huge_lastBucket)
+{
+    LatencyTrace trace;
+    trace.record(LatencyTrace::kTotal, 1.0e+6);
+
+    EXPECT_GT(trace.getPercentile(LatencyTrace::kTotal, 1.0), 16.0);
+}
+
+TEST(LatencyTraceTests, reset_discardsSamples)
+{
+    LatencyTrace trace;
+    trace.record(LatencyTrace::kTotal, 0.001);
+    trace.reset();
+
+    EXPECT_EQ(0u, trace.getCount(LatencyTrace::kTotal));
+}
+
+TEST(LatencyTraceTests, getInterval_acrossWrap_positive)
+{
+    UInt32 from = 0xfffffff0u;
+    UInt32 to   = 0x00000010u;
+
+    EXPECT_NEAR(32.0e-6, LatencyTrace::getInterval(from, to), 1.0e-9);
+    EXPECT_NEAR(-32.0e-6, LatencyTrace::getInterval(to, from), 1.0e-9);
+}
+
+TEST(LatencyTraceTests, toTimestamp_microseconds)
+{
+    EXPECT_EQ(1500000u, LatencyTrace::toTimestamp(1.5));
+    EXPECT_EQ(LatencyTrace::toTimestamp(1.0),
+                LatencyTrace::toTimestamp(1.0 + 4294.967296));
+}
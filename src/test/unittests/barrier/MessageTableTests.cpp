@@ -0,0 +1,93 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/MessageTable.h"
+#include "barrier/protocol_types.h"
+
+#include "test/global/gtest.h"
+
+class MessageTarget {
+public:
+    MessageTarget() : m_last(0) { }
+
+    int                    mouseMove() { return m_last = 1; }
+    int                    keyDown() { return m_last = 2; }
+    int                    keyDown1_6() { return m_last = 3; }
+
+    int                    m_last;
+};
+
+typedef int (MessageTarget::*TargetHandler)();
+
+TEST(MessageTableTests, find_added_callsHandler)
+{
+    MessageTable<TargetHandler> table;
+    table.add(kMsgDMouseMove, &MessageTarget::mouseMove);
+    table.add(kMsgDKeyDown, &MessageTarget::keyDown);
+
+    MessageTarget target;
+    TargetHandler handler = table.find(reinterpret_cast<const UInt8*>("DKDN"));
+
+    ASSERT_TRUE(handler != NULL);
+    EXPECT_EQ(2, (target.*handler)());
+}
+
+TEST(MessageTableTests, find_unknown_null)
+{
+    MessageTable<TargetHandler> table;
+    table.add(kMsgDMouseMove, &MessageTarget::mouseMove);
+
+    EXPECT_TRUE(table.find(reinterpret_cast<const UInt8*>("XXXX")) == NULL);
+}
+
+TEST(MessageTableTests, add_sameCode_replacesHandler)
+{
+    MessageTable<TargetHandler> table;
+    table.add(kMsgDKeyDown1_0, &MessageTarget::keyDown);
+    table.add(kMsgDKeyDown, &MessageTarget::keyDown1_6);
+
+    MessageTarget target;
+    TargetHandler handler = table.find(reinterpret_cast<const UInt8*>("DKDN"));
+
+    ASSERT_TRUE(handler != NULL);
+    EXPECT_EQ(3, (target.*handler)());
+}
+
+TEST(MessageTableTests, find_allProtocolMessages_distinct)
+{
+    const char* codes[] = {
+        kMsgCNoop, kMsgCClose, kMsgCEnter, kMsgCLeave, kMsgCClipboard,
+        kMsgCScreenSaver, kMsgCResetOptions, kMsgCInfoAck, kMsgCKeepAlive,
+        kMsgDKeyDown, kMsgDKeyRepeat, kMsgDKeyUp, kMsgDMouseDown,
+        kMsgDMouseUp, kMsgDMouseMove, kMsgDMouseRelMove, kMsgDMouseWheel,
+        kMsgDClipboard, kMsgDInfo, kMsgDSetOptions, kMsgDFileTransfer,
+        kMsgDDragInfo, kMsgQInfo, kMsgEIncompatible, kMsgEBusy,
+        kMsgEUnknown, kMsgEBad
+    };
+    const int n = sizeof(codes) / sizeof(codes[0]);
+
+    // use each code string as its own handler
+    MessageTable<const char*> table;
+    for (int i = 0; i < n; ++i) {
+        table.add(codes[i], codes[i]);
+    }
+
+    for (int i = 0; i < n; ++i) {
+        EXPECT_EQ(codes[i],
+            table.find(reinterpret_cast<const UInt8*>(codes[i])));
+    }
+}
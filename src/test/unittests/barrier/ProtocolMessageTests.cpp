@@ -0,0 +1,196 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "barrier/ProtocolMessage.h"
+#include "barrier/ProtocolUtil.h"
+#include "barrier/protocol_types.h"
+#include "io/StreamBuffer.h"
+#include "base/Log.h"
+#include "base/Stopwatch.h"
+
+#include "test/global/gtest.h"
+#include <cstring>
+#include <string>
+
+const int kBenchmarkIterations = 1000000;
+
+// an in-memory stream that reads back what was written
+class LoopbackStream : public barrier::IStream {
+public:
+    virtual void        close() { }
+    virtual UInt32        read(void* buffer, UInt32 n)
+    {
+        if (n > m_buffer.getSize()) {
+            n = m_buffer.getSize();
+        }
+        if (buffer != NULL && n != 0) {
+            memcpy(buffer, m_buffer.data(), n);
+        }
+        m_buffer.consume(n);
+        return n;
+    }
+    virtual void        write(const void* buffer, UInt32 n)
+    {
+        m_buffer.write(buffer, n);
+    }
+    virtual void        flush() { }
+    virtual void        shutdownInput() { }
+    virtual void        shutdownOutput() { }
+    virtual void*        getEventTarget() const { return NULL; }
+    virtual bool        isReady() const { return m_buffer.getSize() > 0; }
+    virtual UInt32        getSize() const { return m_buffer.getSize(); }
+
+    std::string            take()
+    {
+        std::string data(static_cast<const char*>(m_buffer.data()),
+                            m_buffer.getSize());
+        m_buffer.consume(m_buffer.getSize());
+        return data;
+    }
+
+private:
+    StreamBuffer        m_buffer;
+};
+
+TEST(ProtocolMessageTests, size_mouseMove_codeAndTwoShorts)
+{
+    EXPECT_EQ(8, MsgDMouseMove::kSize);
+    EXPECT_EQ(4, MsgDMouseMove::kPayloadSize);
+    EXPECT_EQ(4, MsgCKeepAlive::kSize);
+    EXPECT_EQ(12, MsgDKeyRepeat::kSize);
+}
+
+TEST(ProtocolMessageTests, write_mouseMove_matchesWritef)
+{
+    LoopbackStream expected, actual;
+    ProtocolUtil::writef(&expected, kMsgDMouseMove, -1234, 5678);
+    MsgDMouseMove::write(&actual, -1234, 5678);
+
+    EXPECT_EQ(expected.take(), actual.take());
+}
+
+TEST(ProtocolMessageTests, write_mouseRelMove_matchesWritef)
+{
+    LoopbackStream expected, actual;
+    ProtocolUtil::writef(&expected, kMsgDMouseRelMove, -3, 7);
+    MsgDMouseRelMove::write(&actual, -3, 7);
+
+    EXPECT_EQ(expected.take(), actual.take());
+}
+
+TEST(ProtocolMessageTests, write_keyMessages_matchWritef)
+{
+    LoopbackStream expected, actual;
+    ProtocolUtil::writef(&expected, kMsgDKeyDown, 0xefb1, 0x2002, 0x26);
+    ProtocolUtil::writef(&expected, kMsgDKeyDown1_0, 0xefb1, 0x2002);
+    ProtocolUtil::writef(&expected, kMsgDKeyRepeat, 0x61, 0x0001, 3, 0x26);
+    ProtocolUtil::writef(&expected, kMsgDKeyRepeat1_0, 0x61, 0x0001, 3);
+    ProtocolUtil::writef(&expected, kMsgDKeyUp, 0xefb1, 0x2002, 0x26);
+    ProtocolUtil::writef(&expected, kMsgDKeyUp1_0, 0xefb1, 0x2002);
+    MsgDKeyDown::write(&actual, 0xefb1, 0x2002, 0x26);
+    MsgDKeyDown1_0::write(&actual, 0xefb1, 0x2002);
+    MsgDKeyRepeat::write(&actual, 0x61, 0x0001, 3, 0x26);
+    MsgDKeyRepeat1_0::write(&actual, 0x61, 0x0001, 3);
+    MsgDKeyUp::write(&actual, 0xefb1, 0x2002, 0x26);
+    MsgDKeyUp1_0::write(&actual, 0xefb1, 0x2002);
+
+    EXPECT_EQ(expected.take(), actual.take());
+}
+
+TEST(ProtocolMessageTests, write_keepAlive_matchesWritef)
+{
+    LoopbackStream expected, actual;
+    ProtocolUtil::writef(&expected, kMsgCKeepAlive);
+    MsgCKeepAlive::write(&actual);
+
+    EXPECT_EQ(expected.take(), actual.take());
+}
+
+TEST(ProtocolMessageTests, write_inputBatch_matchesWritef)
+{
+    LoopbackStream expected, actual;
+    ProtocolUtil::writef(&expected, kMsgDInputBatch, 2);
+    ProtocolUtil::writef(&expected, kMsgDMouseDown, 1);
+    ProtocolUtil::writef(&expected, kMsgDMouseWheel, 0, -120);
+
+    UInt8 batch[MsgDInputBatch::kSize + MsgDMouseDown::kSize + MsgDMouseWheel::kSize];
+    MsgDInputBatch::encode(batch, 2);
+    MsgDMouseDown::encode(batch + MsgDInputBatch::kSize, 1);
+    MsgDMouseWheel::encode(batch + MsgDInputBatch::kSize + MsgDMouseDown::kSize, 0, -120);
+    actual.write(batch, sizeof(batch));
+
+    EXPECT_EQ(expected.take(), actual.take());
+}
+
+TEST(ProtocolMessageTests, read_writefMouseMove_sameValues)
+{
+    LoopbackStream stream;
+    ProtocolUtil::writef(&stream, kMsgDMouseMove, -1234, 5678);
+
+    UInt8 code[4];
+    SInt16 x, y;
+    ASSERT_EQ(4, stream.read(code, 4));
+    ASSERT_TRUE(MsgDMouseMove::read(&stream, x, y));
+
+    EXPECT_EQ(-1234, x);
+    EXPECT_EQ(5678, y);
+}
+
+TEST(ProtocolMessageTests, read_truncated_false)
+{
+    LoopbackStream stream;
+    UInt8 partial[] = { 0x12, 0x34, 0x56 };
+    stream.write(partial, sizeof(partial));
+
+    SInt16 x, y;
+    EXPECT_FALSE(MsgDMouseMove::read(&stream, x, y));
+}
+
+TEST(ProtocolMessageTests, benchmark_mouseMove_againstWritefReadf)
+{
+    LoopbackStream stream;
+    UInt8 code[4];
+    SInt16 x = 0, y = 0;
+
+    // measure at the usual log level rather than the test's
+    int filter = CLOG->getFilter();
+    CLOG->setFilter(kINFO);
+
+    Stopwatch stopwatch;
+    for (int i = 0; i < kBenchmarkIterations; ++i) {
+        ProtocolUtil::writef(&stream, kMsgDMouseMove, i & 0x7fff, i >> 15);
+        stream.read(code, 4);
+        ProtocolUtil::readf(&stream, kMsgDMouseMove + 4, &x, &y);
+    }
+    double formatted = stopwatch.getTime();
+    EXPECT_EQ((kBenchmarkIterations - 1) & 0x7fff, x);
+
+    stopwatch.reset();
+    for (int i = 0; i < kBenchmarkIterations; ++i) {
+        MsgDMouseMove::write(&stream, i & 0x7fff, i >> 15);
+        stream.read(code, 4);
+        MsgDMouseMove::read(&stream, x, y);
+    }
+    double compiled = stopwatch.getTime();
+    EXPECT_EQ((kBenchmarkIterations - 1) & 0x7fff, x);
+
+    CLOG->setFilter(filter);
+
+    LOG((CLOG_INFO "mouse move encode+decode: writef/readf=%.0fns codec=%.0fns",
+        1.0e+9 * formatted / kBenchmarkIterations,
+        1.0e+9 * compiled / kBenchmarkIterations));
+}
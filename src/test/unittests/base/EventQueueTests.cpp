@@ -0,0 +1,223 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventQueue.h"
+#include "base/TMethodEventJob.h"
+#include "base/Log.h"
+#include "base/Stopwatch.h"
+
+#include "test/global/gtest.h"
+#include <vector>
+
+const int kBenchmarkEvents = 1000000;
+
+// events in the queue at once, about as many as a fast mouse produces
+// while the main thread is busy
+const int kBenchmarkDepth = 64;
+
+// heartbeat alarms, one per client, and how many times they're pushed back
+const int kBenchmarkTimers = 1000;
+const int kBenchmarkTimerResets = 1000000;
+
+class EventQueueTests : public ::testing::Test {
+public:
+    EventQueueTests() :
+        m_type(Event::kUnknown),
+        m_sent(0),
+        m_received(0),
+        m_total(0),
+        m_inOrder(true) { }
+
+    // dispatch total events through the queue, keeping depth pending
+    void                run(int total, int depth);
+
+    void                send();
+    void                handleEvent(const Event&, void*);
+    void                handleTimer(const Event&, void*);
+
+public:
+    EventQueue            m_events;
+    Event::Type            m_type;
+    int                    m_sent;
+    int                    m_received;
+    int                    m_total;
+    bool                m_inOrder;
+};
+
+void
+EventQueueTests::run(int total, int depth)
+{
+    m_events.registerTypeOnce(m_type, "EventQueueTests::event");
+    m_events.adoptHandler(m_type, this,
+        new TMethodEventJob<EventQueueTests>(this,
+            &EventQueueTests::handleEvent));
+
+    m_total = total;
+    for (int i = 0; i < depth && m_sent < m_total; ++i) {
+        send();
+    }
+    m_events.loop();
+
+    m_events.removeHandler(m_type, this);
+}
+
+void
+EventQueueTests::send()
+{
+    m_events.addEvent(Event(m_type, this,
+        reinterpret_cast<void*>(static_cast<intptr_t>(m_sent)),
+        Event::kDontFreeData));
+    ++m_sent;
+}
+
+void
+EventQueueTests::handleEvent(const Event& event, void*)
+{
+    if (reinterpret_cast<intptr_t>(event.getData()) != m_received) {
+        m_inOrder = false;
+    }
+    ++m_received;
+
+    // keep the queue at the same depth until everything is sent
+    if (m_sent < m_total) {
+        send();
+    }
+    else if (m_received == m_total) {
+        m_events.addEvent(Event(Event::kQuit));
+    }
+}
+
+void
+EventQueueTests::handleTimer(const Event& event, void*)
+{
+    IEventQueue::TimerEvent* timerEvent =
+        static_cast<IEventQueue::TimerEvent*>(event.getData());
+    m_received += timerEvent->m_count;
+    m_events.addEvent(Event(Event::kQuit));
+}
+
+TEST_F(EventQueueTests, addEvent_manyPending_dispatchedInOrder)
+{
+    run(10000, 1000);
+
+    EXPECT_EQ(10000, m_received);
+    EXPECT_TRUE(m_inOrder);
+}
+
+TEST_F(EventQueueTests, getHandler_afterAdoptAndRemove_matchesTable)
+{
+    // enough targets that the table grows several times
+    const int kTargets = 1000;
+    std::vector<int> targets(kTargets);
+    for (int i = 0; i < kTargets; ++i) {
+        m_events.adoptHandler(Event::kTimer, &targets[i],
+            new TMethodEventJob<EventQueueTests>(this,
+                &EventQueueTests::handleEvent));
+    }
+    IEventJob* job = new TMethodEventJob<EventQueueTests>(this,
+                                &EventQueueTests::handleEvent);
+    m_events.adoptHandler(Event::kQuit, &targets[0], job);
+
+    EXPECT_EQ(job, m_events.getHandler(Event::kQuit, &targets[0]));
+    EXPECT_TRUE(m_events.getHandler(Event::kQuit, &targets[1]) == NULL);
+    for (int i = 0; i < kTargets; ++i) {
+        EXPECT_TRUE(m_events.getHandler(Event::kTimer, &targets[i]) != NULL);
+    }
+
+    m_events.removeHandler(Event::kTimer, &targets[0]);
+    EXPECT_TRUE(m_events.getHandler(Event::kTimer, &targets[0]) == NULL);
+    EXPECT_EQ(job, m_events.getHandler(Event::kQuit, &targets[0]));
+
+    for (int i = 0; i < kTargets; ++i) {
+        m_events.removeHandlers(&targets[i]);
+    }
+    EXPECT_TRUE(m_events.getHandler(Event::kQuit, &targets[0]) == NULL);
+    EXPECT_TRUE(m_events.getHandler(Event::kTimer, &targets[kTargets - 1]) == NULL);
+}
+
+TEST_F(EventQueueTests, newOneShotTimer_reset_dispatchedOnce)
+{
+    EventQueueTimer* timer = m_events.newOneShotTimer(0.01, NULL);
+    m_events.adoptHandler(Event::kTimer, timer,
+        new TMethodEventJob<EventQueueTests>(this,
+            &EventQueueTests::handleTimer));
+    m_events.resetTimer(timer);
+
+    Stopwatch stopwatch;
+    m_events.loop();
+    EXPECT_EQ(1, m_received);
+    EXPECT_LE(0.01, stopwatch.getTime());
+
+    m_events.removeHandler(Event::kTimer, timer);
+    m_events.deleteTimer(timer);
+}
+
+TEST_F(EventQueueTests, benchmark_dispatchThroughput)
+{
+    // measure at the usual log level rather than the test's
+    int filter = CLOG->getFilter();
+    CLOG->setFilter(kINFO);
+
+    Stopwatch stopwatch;
+    run(kBenchmarkEvents, kBenchmarkDepth);
+    double time = stopwatch.getTime();
+
+    CLOG->setFilter(filter);
+
+    EXPECT_EQ(kBenchmarkEvents, m_received);
+    EXPECT_TRUE(m_inOrder);
+    LOG((CLOG_INFO "event queue dispatch: %.0f events/sec, depth %d",
+        kBenchmarkEvents / time, kBenchmarkDepth));
+}
+
+TEST_F(EventQueueTests, benchmark_timerChurn)
+{
+    std::vector<EventQueueTimer*> timers(kBenchmarkTimers);
+    for (int i = 0; i < kBenchmarkTimers; ++i) {
+        timers[i] = m_events.newOneShotTimer(30.0, NULL);
+    }
+
+    int filter = CLOG->getFilter();
+    CLOG->setFilter(kINFO);
+
+    // push back an alarm for every message by replacing the timer, as
+    // heartbeats used to, and then by restarting it
+    Stopwatch stopwatch;
+    for (int i = 0; i < kBenchmarkTimerResets; ++i) {
+        EventQueueTimer*& timer = timers[i % kBenchmarkTimers];
+        m_events.deleteTimer(timer);
+        timer = m_events.newOneShotTimer(30.0, NULL);
+    }
+    double replaced = stopwatch.getTime();
+
+    stopwatch.reset();
+    for (int i = 0; i < kBenchmarkTimerResets; ++i) {
+        m_events.resetTimer(timers[i % kBenchmarkTimers]);
+    }
+    double reset = stopwatch.getTime();
+
+    CLOG->setFilter(filter);
+
+    for (int i = 0; i < kBenchmarkTimers; ++i) {
+        m_events.deleteTimer(timers[i]);
+    }
+
+    LOG((CLOG_INFO "timer churn, %d timers: delete+new=%.0fns reset=%.0fns",
+        kBenchmarkTimers,
+        1.0e+9 * replaced / kBenchmarkTimerResets,
+        1.0e+9 * reset / kBenchmarkTimerResets));
+}
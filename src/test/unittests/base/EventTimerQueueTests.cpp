@@ -0,0 +1,153 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventTimerQueue.h"
+
+#include "test/global/gtest.h"
+#include <vector>
+
+// the queue only uses timers as keys so any distinct pointers will do
+static
+EventQueueTimer*
+getTimer(std::vector<char>& timers, int i)
+{
+    return reinterpret_cast<EventQueueTimer*>(&timers[i]);
+}
+
+TEST(EventTimerQueueTests, expire_beforeDeadline_false)
+{
+    std::vector<char> timers(1);
+    EventTimerQueue queue;
+    queue.add(getTimer(timers, 0), 1.0, 10.0, NULL, true);
+
+    IEventQueue::TimerEvent event;
+    void* target;
+    EXPECT_FALSE(queue.expire(10.5, event, target));
+    EXPECT_DOUBLE_EQ(0.5, queue.getTimeout(10.5));
+}
+
+TEST(EventTimerQueueTests, expire_oneShot_onceWithTarget)
+{
+    std::vector<char> timers(1);
+    int target;
+    EventTimerQueue queue;
+    queue.add(getTimer(timers, 0), 1.0, 10.0, &target, true);
+
+    IEventQueue::TimerEvent event;
+    void* expired = NULL;
+    ASSERT_TRUE(queue.expire(11.0, event, expired));
+    EXPECT_EQ(getTimer(timers, 0), event.m_timer);
+    EXPECT_EQ(1, event.m_count);
+    EXPECT_EQ(&target, expired);
+
+    EXPECT_FALSE(queue.expire(100.0, event, expired));
+    EXPECT_EQ(-1.0, queue.getTimeout(100.0));
+    EXPECT_EQ(1, queue.getSize());
+}
+
+TEST(EventTimerQueueTests, expire_repeatingLate_countsMissedPeriods)
+{
+    std::vector<char> timers(1);
+    EventTimerQueue queue;
+    queue.add(getTimer(timers, 0), 1.0, 0.0, NULL, false);
+
+    IEventQueue::TimerEvent event;
+    void* target;
+    ASSERT_TRUE(queue.expire(3.5, event, target));
+    EXPECT_EQ(3, event.m_count);
+
+    // counts down again from when it expired
+    EXPECT_FALSE(queue.expire(4.0, event, target));
+    ASSERT_TRUE(queue.expire(4.5, event, target));
+    EXPECT_EQ(1, event.m_count);
+}
+
+TEST(EventTimerQueueTests, expire_manyTimers_deadlineOrder)
+{
+    const int kTimers = 100;
+    std::vector<char> timers(kTimers);
+    EventTimerQueue queue;
+    for (int i = 0; i < kTimers; ++i) {
+        // spread the deadlines out of creation order
+        queue.add(getTimer(timers, i), 1.0 + (i * 37) % kTimers, 0.0,
+                            NULL, true);
+    }
+
+    IEventQueue::TimerEvent event;
+    void* target;
+    for (int i = 0; i < kTimers; ++i) {
+        ASSERT_TRUE(queue.expire(1000.0, event, target));
+        int index = static_cast<int>(
+            reinterpret_cast<char*>(event.m_timer) - &timers[0]);
+        EXPECT_EQ(i, (index * 37) % kTimers);
+    }
+    EXPECT_FALSE(queue.expire(1000.0, event, target));
+}
+
+TEST(EventTimerQueueTests, reset_beforeDeadline_postponesExpiry)
+{
+    std::vector<char> timers(2);
+    EventTimerQueue queue;
+    queue.add(getTimer(timers, 0), 1.0, 0.0, NULL, true);
+    queue.add(getTimer(timers, 1), 1.5, 0.0, NULL, true);
+
+    queue.reset(getTimer(timers, 0), 0.9);
+
+    IEventQueue::TimerEvent event;
+    void* target;
+    EXPECT_FALSE(queue.expire(1.2, event, target));
+    ASSERT_TRUE(queue.expire(1.6, event, target));
+    EXPECT_EQ(getTimer(timers, 1), event.m_timer);
+    ASSERT_TRUE(queue.expire(1.9, event, target));
+    EXPECT_EQ(getTimer(timers, 0), event.m_timer);
+}
+
+TEST(EventTimerQueueTests, reset_expiredOneShot_restarts)
+{
+    std::vector<char> timers(1);
+    EventTimerQueue queue;
+    queue.add(getTimer(timers, 0), 1.0, 0.0, NULL, true);
+
+    IEventQueue::TimerEvent event;
+    void* target;
+    ASSERT_TRUE(queue.expire(1.0, event, target));
+
+    queue.reset(getTimer(timers, 0), 5.0);
+    EXPECT_DOUBLE_EQ(1.0, queue.getTimeout(5.0));
+    EXPECT_TRUE(queue.expire(6.0, event, target));
+}
+
+TEST(EventTimerQueueTests, remove_queued_neverExpires)
+{
+    std::vector<char> timers(3);
+    EventTimerQueue queue;
+    for (int i = 0; i < 3; ++i) {
+        queue.add(getTimer(timers, i), 1.0 + i, 0.0, NULL, true);
+    }
+
+    queue.remove(getTimer(timers, 0));
+    queue.remove(getTimer(timers, 0));
+    EXPECT_EQ(2, queue.getSize());
+
+    IEventQueue::TimerEvent event;
+    void* target;
+    ASSERT_TRUE(queue.expire(10.0, event, target));
+    EXPECT_EQ(getTimer(timers, 1), event.m_timer);
+    ASSERT_TRUE(queue.expire(10.0, event, target));
+    EXPECT_EQ(getTimer(timers, 2), event.m_timer);
+    EXPECT_FALSE(queue.expire(10.0, event, target));
+}
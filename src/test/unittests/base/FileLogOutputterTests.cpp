@@ -0,0 +1,195 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/log_outputters.h"
+#include "base/Log.h"
+#include "base/Stopwatch.h"
+#include "base/String.h"
+
+#include "test/global/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#if !SYSAPI_WIN32
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
+#define TEST_LOG_FILE "FileLogOutputterTests.log"
+
+const int kBenchmarkMessages = 100000;
+
+class FileLogOutputterTests : public ::testing::Test {
+protected:
+    virtual void        SetUp() { removeFiles(); }
+    virtual void        TearDown() { removeFiles(); }
+
+    void                removeFiles();
+    std::string            readFile(const char* suffix = "");
+    bool                hasFile(const char* suffix);
+};
+
+void
+FileLogOutputterTests::removeFiles()
+{
+    remove(TEST_LOG_FILE);
+    remove(TEST_LOG_FILE ".1");
+    remove(TEST_LOG_FILE ".2");
+    remove(TEST_LOG_FILE ".3");
+}
+
+std::string
+FileLogOutputterTests::readFile(const char* suffix)
+{
+    std::ifstream file((std::string(TEST_LOG_FILE) + suffix).c_str());
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+bool
+FileLogOutputterTests::hasFile(const char* suffix)
+{
+    std::ifstream file((std::string(TEST_LOG_FILE) + suffix).c_str());
+    return file.is_open();
+}
+
+TEST_F(FileLogOutputterTests, write_messages_appendedAsLines)
+{
+    FileLogOutputter outputter(TEST_LOG_FILE);
+    outputter.write(kINFO, "first");
+    outputter.write(kDEBUG, "second");
+    outputter.flush();
+
+    EXPECT_EQ("first\nsecond\n", readFile());
+}
+
+TEST_F(FileLogOutputterTests, write_existingFile_appends)
+{
+    {
+        FileLogOutputter outputter(TEST_LOG_FILE);
+        outputter.write(kINFO, "first");
+    }
+    FileLogOutputter outputter(TEST_LOG_FILE);
+    outputter.write(kINFO, "second");
+    outputter.flush();
+
+    EXPECT_EQ("first\nsecond\n", readFile());
+}
+
+TEST_F(FileLogOutputterTests, write_pastSizeLimit_rotatesKeepingFiles)
+{
+    FileLogOutputter outputter(TEST_LOG_FILE);
+    outputter.setRotation(5, 2);
+    for (int i = 0; i < 4; ++i) {
+        // each message goes past the limit
+        outputter.write(kINFO, barrier::string::sprintf("message %d", i).c_str());
+        outputter.flush();
+    }
+
+    EXPECT_EQ("", readFile());
+    EXPECT_EQ("message 3\n", readFile(".1"));
+    EXPECT_EQ("message 2\n", readFile(".2"));
+    EXPECT_FALSE(hasFile(".3"));
+}
+
+TEST_F(FileLogOutputterTests, write_largerThanBuffer_droppedAndNoted)
+{
+    FileLogOutputter outputter(TEST_LOG_FILE);
+    std::string huge(4 * 1024 * 1024, 'x');
+    outputter.write(kINFO, huge.c_str());
+    outputter.write(kINFO, "after");
+    outputter.flush();
+
+    EXPECT_EQ(1, outputter.getDropped());
+    std::string contents = readFile();
+    EXPECT_NE(std::string::npos, contents.find("after\n"));
+    EXPECT_NE(std::string::npos, contents.find("1 log messages dropped\n"));
+}
+
+TEST_F(FileLogOutputterTests, setLogFilename_afterWrite_earlierMessagesInOldFile)
+{
+    FileLogOutputter outputter(TEST_LOG_FILE);
+    outputter.write(kINFO, "old");
+    outputter.setLogFilename(TEST_LOG_FILE ".1");
+    outputter.write(kINFO, "new");
+    outputter.flush();
+
+    EXPECT_EQ("old\n", readFile());
+    EXPECT_EQ("new\n", readFile(".1"));
+}
+
+#if !SYSAPI_WIN32
+TEST_F(FileLogOutputterTests, write_afterFork_childWrites)
+{
+    FileLogOutputter* outputter = new FileLogOutputter(TEST_LOG_FILE);
+    outputter->write(kINFO, "before");
+    outputter->flush();
+
+    pid_t child = fork();
+    ASSERT_NE(-1, child);
+    if (child == 0) {
+        // killed if the child hangs without a writer thread
+        alarm(10);
+        outputter->write(kINFO, "child");
+        outputter->flush();
+        delete outputter;
+        _exit(0);
+    }
+
+    int status;
+    ASSERT_EQ(child, waitpid(child, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    outputter->write(kINFO, "parent");
+    delete outputter;
+    EXPECT_EQ("before\nchild\nparent\n", readFile());
+}
+#endif
+
+TEST_F(FileLogOutputterTests, benchmark_write)
+{
+    std::string message = barrier::string::sprintf(
+        "[2018-01-01T00:00:00] DEBUG1: msg from \"client\": DMMV %d,%d", 1234, 567);
+
+    // opening the file for every message, as the outputter used to
+    Stopwatch stopwatch;
+    for (int i = 0; i < kBenchmarkMessages; ++i) {
+        std::ofstream file(TEST_LOG_FILE, std::fstream::app);
+        file << message << std::endl;
+    }
+    double reopened = stopwatch.getTime();
+    removeFiles();
+
+    // flush now and then so the buffer never fills and drops messages
+    FileLogOutputter outputter(TEST_LOG_FILE);
+    stopwatch.reset();
+    for (int i = 0; i < kBenchmarkMessages; ++i) {
+        outputter.write(kDEBUG1, message.c_str());
+        if ((i & 1023) == 1023) {
+            outputter.flush();
+        }
+    }
+    outputter.flush();
+    double buffered = stopwatch.getTime();
+
+    EXPECT_EQ(0, outputter.getDropped());
+    LOG((CLOG_INFO "file log: reopen=%.0fns/message buffered=%.0fns/message",
+        1.0e+9 * reopened / kBenchmarkMessages,
+        1.0e+9 * buffered / kBenchmarkMessages));
+}
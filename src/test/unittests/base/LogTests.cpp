@@ -0,0 +1,174 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BARRIER_TEST_ENV
+
+#include "test/mock/ipc/MockIpcServer.h"
+
+#include "base/Log.h"
+#include "base/ILogOutputter.h"
+#include "base/log_outputters.h"
+#include "base/Stopwatch.h"
+#include "ipc/IpcLogOutputter.h"
+
+#include "test/global/gtest.h"
+#include <cstdio>
+#include <regex>
+#include <string>
+
+#define TEST_LOG_FILE "LogTests.log"
+
+using ::testing::NiceMock;
+
+const int kBenchmarkMessages = 100000;
+
+// keeps the last message written
+class CaptureLogOutputter : public ILogOutputter {
+public:
+    CaptureLogOutputter() : m_count(0) { }
+
+    virtual void        open(const char*) { }
+    virtual void        close() { }
+    virtual void        show(bool) { }
+    virtual bool        write(ELevel, const char* message)
+    {
+        m_message = message;
+        ++m_count;
+        return true;
+    }
+
+public:
+    std::string            m_message;
+    int                    m_count;
+};
+
+class LogTests : public ::testing::Test {
+public:
+    // a log separate from the one the tests write their output to
+    LogTests() : m_log(CLOG), m_outputter(new CaptureLogOutputter)
+    {
+        m_log.insert(m_outputter);
+        m_log.setFilter(kINFO);
+    }
+
+protected:
+    bool                matches(const char* pattern) const
+    {
+        return std::regex_search(m_outputter->m_message, std::regex(pattern));
+    }
+
+protected:
+    Log                    m_log;
+    CaptureLogOutputter*    m_outputter;
+};
+
+TEST_F(LogTests, print_info_prefixedWithTimestampAndLevel)
+{
+    m_log.print(CLOG_INFO "hello %d", 42);
+
+    EXPECT_TRUE(matches(
+        "^\\[\\d{4}-\\d\\d-\\d\\dT\\d\\d:\\d\\d:\\d\\d\\] INFO: hello 42"));
+}
+
+TEST_F(LogTests, print_milliseconds_timestampHasMilliseconds)
+{
+    m_log.setTimestampPrecision(Log::kTimestampMilliseconds);
+    m_log.print(CLOG_WARN "hello");
+
+    EXPECT_TRUE(matches("^\\[[-0-9T:]{19}\\.\\d{3}\\] WARNING: hello"));
+}
+
+TEST_F(LogTests, print_microseconds_timestampHasMicroseconds)
+{
+    m_log.setTimestampPrecision(Log::kTimestampMicroseconds);
+    m_log.print(CLOG_NOTE "hello");
+
+    EXPECT_TRUE(matches("^\\[[-0-9T:]{19}\\.\\d{6}\\] NOTE: hello"));
+}
+
+TEST_F(LogTests, print_print_notPrefixed)
+{
+    m_log.print(CLOG_PRINT "hello %s", "there");
+
+    EXPECT_EQ("hello there", m_outputter->m_message);
+}
+
+TEST_F(LogTests, print_longerThanBuffer_notTruncated)
+{
+    std::string text(5000, 'x');
+    m_log.print(CLOG_PRINT "%s", text.c_str());
+    m_log.print(CLOG_INFO "%s", text.c_str());
+
+    EXPECT_TRUE(matches(("INFO: " + text).c_str()));
+}
+
+TEST_F(LogTests, print_belowFilter_notOutput)
+{
+    m_log.print(CLOG_DEBUG "hello");
+
+    EXPECT_EQ(0, m_outputter->m_count);
+}
+
+TEST_F(LogTests, setTimestampPrecision_name_recognized)
+{
+    EXPECT_TRUE(m_log.setTimestampPrecision("us"));
+    EXPECT_EQ(Log::kTimestampMicroseconds, m_log.getTimestampPrecision());
+    EXPECT_TRUE(m_log.setTimestampPrecision(NULL));
+    EXPECT_EQ(Log::kTimestampMicroseconds, m_log.getTimestampPrecision());
+    EXPECT_FALSE(m_log.setTimestampPrecision("ns"));
+}
+
+TEST_F(LogTests, benchmark_print)
+{
+    // with no outputter but the one keeping the last message, this is
+    // only the cost of formatting
+    Stopwatch stopwatch;
+    for (int i = 0; i < kBenchmarkMessages; ++i) {
+        m_log.print(CLOG_INFO "msg from \"client\": DMMV %d,%d", i, 567);
+    }
+    double formatted = stopwatch.getTime();
+
+    NiceMock<MockIpcServer> ipcServer;
+    IpcLogOutputter* ipcOutputter =
+        new IpcLogOutputter(ipcServer, kIpcClientUnknown, false);
+    // a zero length rate period never limits
+    ipcOutputter->bufferRateLimit(1, 0.0);
+    FileLogOutputter* fileOutputter = new FileLogOutputter(TEST_LOG_FILE);
+    m_log.insert(ipcOutputter);
+    m_log.insert(fileOutputter);
+
+    // flush now and then so the file buffer never fills and drops messages
+    stopwatch.reset();
+    for (int i = 0; i < kBenchmarkMessages; ++i) {
+        m_log.print(CLOG_INFO "msg from \"client\": DMMV %d,%d", i, 567);
+        if ((i & 1023) == 1023) {
+            fileOutputter->flush();
+        }
+    }
+    fileOutputter->flush();
+    double outputted = stopwatch.getTime();
+
+    EXPECT_EQ(0, fileOutputter->getDropped());
+    LOG((CLOG_INFO "log print: formatted=%.0f messages/sec "
+        "file+ipc=%.0f messages/sec",
+        kBenchmarkMessages / formatted, kBenchmarkMessages / outputted));
+
+    m_log.remove(fileOutputter);
+    delete fileOutputter;
+    remove(TEST_LOG_FILE);
+    remove(TEST_LOG_FILE ".1");
+}
@@ -0,0 +1,243 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/TraceLog.h"
+#include "base/TraceLogReader.h"
+#include "base/ILogOutputter.h"
+#include "base/log_outputters.h"
+#include "base/Stopwatch.h"
+
+#include "test/global/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TEST_TRACE_FILE "TraceLogTests.trace"
+#define TEST_LOG_FILE "TraceLogTests.log"
+
+const int kBenchmarkMessages = 100000;
+
+// keeps the last message written
+class TraceCaptureLogOutputter : public ILogOutputter {
+public:
+    virtual void        open(const char*) { }
+    virtual void        close() { }
+    virtual void        show(bool) { }
+    virtual bool        write(ELevel, const char* message)
+    {
+        m_message = message;
+        return true;
+    }
+
+public:
+    std::string            m_message;
+};
+
+static
+TraceLogReader::MessageList
+readTrace(const TraceLog& trace)
+{
+    TraceLogReader reader(trace.getData(), trace.getSize());
+    EXPECT_TRUE(reader.isValid());
+
+    TraceLogReader::MessageList messages;
+    reader.read(messages);
+    return messages;
+}
+
+static
+void
+writeNumbers(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        LOGT((CLOG_DEBUG2 "number %d", i));
+    }
+}
+
+static
+void
+expectNumbersInOrder(const TraceLogReader::MessageList& messages,
+                UInt32 thread, int last)
+{
+    int expected = -1;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        if (messages[i].m_thread != thread) {
+            continue;
+        }
+        int n;
+        ASSERT_EQ(1, sscanf(messages[i].m_text.c_str(), "number %d", &n));
+        if (expected >= 0) {
+            EXPECT_EQ(expected, n);
+        }
+        expected = n + 1;
+    }
+    EXPECT_EQ(last + 1, expected);
+}
+
+TEST(TraceLogTests, LOGT_traceLog_decodedWithArguments)
+{
+    TraceLog trace(NULL);
+    LOGT((CLOG_DEBUG2 "int %d hex 0x%x str %s dbl %.2f [%5d] [%*d] 100%%",
+        42, -1, "abc", 1.5, 7, 3, 9));
+
+    TraceLogReader::MessageList messages = readTrace(trace);
+    ASSERT_EQ(1, messages.size());
+    EXPECT_EQ("int 42 hex 0xffffffff str abc dbl 1.50 [    7] [  9] 100%",
+        messages[0].m_text);
+    EXPECT_EQ(kDEBUG2, messages[0].m_level);
+    EXPECT_EQ(1, messages[0].m_thread);
+#ifndef NDEBUG
+    EXPECT_NE(std::string::npos, messages[0].m_file.find("TraceLogTests.cpp"));
+    EXPECT_LT(0, messages[0].m_line);
+#endif
+}
+
+TEST(TraceLogTests, LOGT_noTraceLog_writesToLog)
+{
+    TraceCaptureLogOutputter* outputter = new TraceCaptureLogOutputter;
+    CLOG->insert(outputter);
+    LOGT((CLOG_DEBUG2 "number %d", 42));
+    CLOG->remove(outputter);
+
+    EXPECT_NE(std::string::npos, outputter->m_message.find("DEBUG2: number 42"));
+    delete outputter;
+}
+
+TEST(TraceLogTests, LOGT_missingArgument_marked)
+{
+    TraceLog trace(NULL);
+    std::string text(1000, 'x');
+    LOGT((CLOG_DEBUG2 "%s %d", text.c_str(), 1));
+
+    // the string fills the record so the number is dropped
+    TraceLogReader::MessageList messages = readTrace(trace);
+    ASSERT_EQ(1, messages.size());
+    EXPECT_GT(TraceLog::kMaxRecordSize, messages[0].m_text.size());
+    EXPECT_EQ(0, messages[0].m_text.find("xxxx"));
+    EXPECT_NE(std::string::npos, messages[0].m_text.find(" <missing>"));
+}
+
+TEST(TraceLogTests, write_ringFull_newestKeptInOrder)
+{
+    TraceLog trace(NULL, 1024, 1);
+    writeNumbers(1000);
+
+    TraceLogReader::MessageList messages = readTrace(trace);
+    EXPECT_LT(10, messages.size());
+    expectNumbersInOrder(messages, 1, 999);
+}
+
+TEST(TraceLogTests, write_manyThreads_ringPerThread)
+{
+    const int kThreads = 4;
+    TraceLog trace(NULL);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.push_back(std::thread(writeNumbers, 1000));
+    }
+    for (int i = 0; i < kThreads; ++i) {
+        threads[i].join();
+    }
+
+    TraceLogReader::MessageList messages = readTrace(trace);
+    EXPECT_EQ(kThreads * 1000, messages.size());
+    for (int i = 0; i < kThreads; ++i) {
+        expectNumbersInOrder(messages, i + 1, 999);
+    }
+    for (size_t i = 1; i < messages.size(); ++i) {
+        EXPECT_LE(messages[i - 1].m_time, messages[i].m_time);
+    }
+}
+
+TEST(TraceLogTests, write_noRingLeft_dropped)
+{
+    TraceLog trace(NULL, 1024, 1);
+    writeNumbers(1);
+    std::thread thread(writeNumbers, 1);
+    thread.join();
+
+    EXPECT_EQ(1, trace.getDropped());
+    EXPECT_EQ(1, readTrace(trace).size());
+}
+
+TEST(TraceLogTests, write_file_readableBeforeClose)
+{
+    {
+        TraceLog trace(TEST_TRACE_FILE, 4096, 2);
+        writeNumbers(3);
+
+        // as if the process had crashed here
+        std::ifstream file(TEST_TRACE_FILE, std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+        TraceLogReader reader(data.data(), data.size());
+        ASSERT_TRUE(reader.isValid());
+
+        TraceLogReader::MessageList messages;
+        reader.read(messages);
+        ASSERT_EQ(3, messages.size());
+        EXPECT_EQ("number 2", messages[2].m_text);
+    }
+    remove(TEST_TRACE_FILE);
+}
+
+TEST(TraceLogTests, read_notTraceLog_invalid)
+{
+    std::vector<char> data(100000, 'x');
+    TraceLogReader reader(data.data(), data.size());
+
+    EXPECT_FALSE(reader.isValid());
+}
+
+TEST(TraceLogTests, benchmark_LOGT)
+{
+    // the log as it would be with protocol logging on
+    Log log(CLOG);
+    log.setFilter(kDEBUG2);
+    FileLogOutputter* outputter = new FileLogOutputter(TEST_LOG_FILE);
+    log.insert(outputter);
+
+    Stopwatch stopwatch;
+    for (int i = 0; i < kBenchmarkMessages; ++i) {
+        log.print(CLOG_DEBUG2 "readf: read %d byte integer: %d (0x%x)", 4, i, i);
+        if ((i & 1023) == 1023) {
+            outputter->flush();
+        }
+    }
+    outputter->flush();
+    double logged = stopwatch.getTime();
+
+    TraceLog trace(NULL);
+    stopwatch.reset();
+    for (int i = 0; i < kBenchmarkMessages; ++i) {
+        LOGT((CLOG_DEBUG2 "readf: read %d byte integer: %d (0x%x)", 4, i, i));
+    }
+    double traced = stopwatch.getTime();
+
+    EXPECT_EQ(0, trace.getDropped());
+    LOG((CLOG_INFO "protocol logging: text=%.0fns/message trace=%.0fns/message",
+        1.0e+9 * logged / kBenchmarkMessages,
+        1.0e+9 * traced / kBenchmarkMessages));
+
+    log.remove(outputter);
+    delete outputter;
+    remove(TEST_LOG_FILE);
+    remove(TEST_LOG_FILE ".1");
+}
@@ -0,0 +1,161 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "io/StreamBuffer.h"
+#include "base/Log.h"
+#include "base/Stopwatch.h"
+
+#include "test/global/gtest.h"
+#include <cstring>
+#include <new>
+#include <vector>
+
+// a large clipboard, e.g. a screenshot
+const UInt32 kClipboardSize = 64 * 1024 * 1024;
+
+// what a socket read and a clipboard chunk typically carry
+const UInt32 kReadSize  = 16384;
+const UInt32 kChunkSize = 32 * 1024;
+
+TEST(StreamBufferTests, write_thenData_contiguous)
+{
+    StreamBuffer buffer;
+    std::vector<UInt8> expected;
+    for (UInt32 i = 0; i < 10000; ++i) {
+        UInt8 byte = static_cast<UInt8>(i * 31);
+        buffer.write(&byte, 1);
+        expected.push_back(byte);
+    }
+
+    ASSERT_EQ(expected.size(), buffer.getSize());
+    EXPECT_EQ(0, memcmp(&expected[0], buffer.data(), expected.size()));
+}
+
+TEST(StreamBufferTests, consume_partial_keepsRemainder)
+{
+    StreamBuffer buffer;
+    buffer.write("hello world", 11);
+
+    buffer.consume(6);
+
+    ASSERT_EQ(5, buffer.getSize());
+    EXPECT_EQ(0, memcmp("world", buffer.data(), 5));
+}
+
+TEST(StreamBufferTests, consume_all_empty)
+{
+    StreamBuffer buffer;
+    buffer.write("hello", 5);
+
+    buffer.consume(100);
+
+    EXPECT_EQ(0, buffer.getSize());
+    EXPECT_EQ(NULL, buffer.data());
+}
+
+TEST(StreamBufferTests, prepare_commitLess_appendsCommitted)
+{
+    StreamBuffer buffer;
+    buffer.write("ab", 2);
+
+    char* space = static_cast<char*>(buffer.prepare(100));
+    memcpy(space, "cdef", 4);
+    buffer.commit(2);
+
+    ASSERT_EQ(4, buffer.getSize());
+    EXPECT_EQ(0, memcmp("abcd", buffer.data(), 4));
+}
+
+TEST(StreamBufferTests, prepare_afterConsume_preservesData)
+{
+    StreamBuffer buffer;
+    std::vector<UInt8> data(kReadSize * 3);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<UInt8>(i);
+    }
+
+    // interleave reads and writes so the data moves around
+    UInt32 written = 0;
+    UInt32 read    = 0;
+    while (read < data.size()) {
+        if (written < data.size()) {
+            UInt32 n = (UInt32)data.size() - written;
+            if (n > 1000) {
+                n = 1000;
+            }
+            memcpy(buffer.prepare(kReadSize), &data[written], n);
+            buffer.commit(n);
+            written += n;
+        }
+
+        UInt32 n = buffer.getSize() < 700 ? buffer.getSize() : 700;
+        ASSERT_EQ(0, memcmp(&data[read], buffer.data(), n));
+        buffer.consume(n);
+        read += n;
+    }
+    EXPECT_EQ(0, buffer.getSize());
+}
+
+TEST(StreamBufferTests, prepare_pastMaxSize_throws)
+{
+    StreamBuffer buffer;
+    buffer.write("x", 1);
+
+    EXPECT_THROW(buffer.prepare(0xffffffffu), std::bad_alloc);
+
+    // the buffered data is untouched
+    ASSERT_EQ(1, buffer.getSize());
+    EXPECT_EQ('x', *static_cast<const char*>(buffer.data()));
+}
+
+// streams a clipboard through a buffer the way PacketStreamFilter does,
+// reading socket sized pieces in and taking chunk sized packets out
+TEST(StreamBufferTests, throughput_largeClipboard)
+{
+    std::vector<UInt8> source(kReadSize);
+    std::vector<UInt8> packet(kChunkSize);
+    for (size_t i = 0; i < source.size(); ++i) {
+        source[i] = static_cast<UInt8>(i);
+    }
+
+    StreamBuffer buffer;
+    UInt32 received = 0;
+    UInt32 delivered = 0;
+    Stopwatch stopwatch;
+    while (delivered < kClipboardSize) {
+        // the socket delivers a few reads per wakeup
+        for (int i = 0; i < 4 && received < kClipboardSize; ++i) {
+            memcpy(buffer.prepare(kReadSize), &source[0], kReadSize);
+            buffer.commit(kReadSize);
+            received += kReadSize;
+        }
+
+        // the reader takes out every whole packet
+        while (buffer.getSize() >= kChunkSize) {
+            memcpy(&packet[0], buffer.data(), kChunkSize);
+            buffer.consume(kChunkSize);
+            delivered += kChunkSize;
+        }
+    }
+    double elapsed = stopwatch.getTime();
+
+    EXPECT_EQ(kClipboardSize, delivered);
+    EXPECT_EQ(0, buffer.getSize());
+    LOG((CLOG_INFO "stream buffer: %d MB in %.1fms, %.0f MB/s",
+        kClipboardSize / (1024 * 1024), 1.0e+3 * elapsed,
+        kClipboardSize / (1024.0 * 1024.0) / elapsed));
+}
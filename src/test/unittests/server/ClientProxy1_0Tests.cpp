@@ -0,0 +1,179 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_2.h"
+#include "barrier/protocol_types.h"
+#include "base/EventQueue.h"
+#include "test/mock/io/MockStream.h"
+#include "common/stdvector.h"
+
+#include "test/global/gtest.h"
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+// keeps each message written
+class ProxyMessages {
+public:
+    void                write(const void* data, UInt32 size)
+    {
+        m_messages.push_back(String(static_cast<const char*>(data), size));
+    }
+
+    // the code of message \c i
+    String                getCode(size_t i) const { return m_messages[i].substr(0, 4); }
+
+    // the two 16-bit values that follow the code of motion message \c i
+    SInt16                getX(size_t i) const { return getValue(i, 4); }
+    SInt16                getY(size_t i) const { return getValue(i, 6); }
+
+private:
+    SInt16                getValue(size_t i, size_t offset) const
+    {
+        const UInt8* value =
+            reinterpret_cast<const UInt8*>(m_messages[i].data()) + offset;
+        return static_cast<SInt16>((value[0] << 8) | value[1]);
+    }
+
+public:
+    std::vector<String>    m_messages;
+};
+
+static String
+getCode(const char* message)
+{
+    return String(message, 4);
+}
+
+// drives the motion coalescing in ClientProxy1_0.  1.2 is the first
+// version that sends relative motion.
+class ClientProxy1_0Tests : public ::testing::Test {
+public:
+    ClientProxy1_0Tests()
+    {
+        m_stream = new NiceMock<MockStream>;
+        ON_CALL(*m_stream, getEventTarget()).WillByDefault(Return(m_stream));
+        ON_CALL(*m_stream, write(_, _))
+            .WillByDefault(Invoke(&m_messages, &ProxyMessages::write));
+
+        m_proxy = new ClientProxy1_2("stub", m_stream, &m_events);
+
+        // forget the info query
+        m_messages.m_messages.clear();
+    }
+
+    ~ClientProxy1_0Tests()
+    {
+        delete m_proxy;
+    }
+
+    // the socket caught up
+    void                flushed()
+    {
+        m_events.dispatchEvent(
+            Event(m_events.forIStream().outputFlushed(), m_stream));
+    }
+
+public:
+    EventQueue            m_events;
+    NiceMock<MockStream>*    m_stream;
+    ClientProxy1_2*        m_proxy;
+    ProxyMessages        m_messages;
+};
+
+TEST_F(ClientProxy1_0Tests, mouseMove_backedUp_latestPositionHeld)
+{
+    m_proxy->mouseMove(1, 2);
+    m_proxy->mouseMove(3, 4);
+    m_proxy->mouseMove(5, 6);
+    ASSERT_EQ(1u, m_messages.m_messages.size());
+    EXPECT_EQ(1, m_messages.getX(0));
+
+    flushed();
+    ASSERT_EQ(2u, m_messages.m_messages.size());
+    EXPECT_EQ(getCode(kMsgDMouseMove), m_messages.getCode(1));
+    EXPECT_EQ(5, m_messages.getX(1));
+    EXPECT_EQ(6, m_messages.getY(1));
+}
+
+TEST_F(ClientProxy1_0Tests, mouseRelativeMove_backedUp_deltasAccumulated)
+{
+    m_proxy->mouseRelativeMove(1, -1);
+    m_proxy->mouseRelativeMove(2, -2);
+    m_proxy->mouseRelativeMove(3, -3);
+    ASSERT_EQ(1u, m_messages.m_messages.size());
+
+    flushed();
+    ASSERT_EQ(2u, m_messages.m_messages.size());
+    EXPECT_EQ(getCode(kMsgDMouseRelMove), m_messages.getCode(1));
+    EXPECT_EQ(5, m_messages.getX(1));
+    EXPECT_EQ(-5, m_messages.getY(1));
+}
+
+TEST_F(ClientProxy1_0Tests, mouseMove_heldRelativeMotion_replaced)
+{
+    m_proxy->mouseRelativeMove(1, 1);
+    m_proxy->mouseRelativeMove(2, 2);
+    m_proxy->mouseMove(10, 20);
+
+    flushed();
+    ASSERT_EQ(2u, m_messages.m_messages.size());
+    EXPECT_EQ(getCode(kMsgDMouseMove), m_messages.getCode(1));
+    EXPECT_EQ(10, m_messages.getX(1));
+    EXPECT_EQ(20, m_messages.getY(1));
+}
+
+TEST_F(ClientProxy1_0Tests, keyDown_motionHeld_motionSentFirst)
+{
+    m_proxy->mouseMove(1, 2);
+    m_proxy->mouseMove(3, 4);
+    m_proxy->keyDown(65, 0, 1);
+
+    ASSERT_EQ(3u, m_messages.m_messages.size());
+    EXPECT_EQ(getCode(kMsgDMouseMove), m_messages.getCode(1));
+    EXPECT_EQ(3, m_messages.getX(1));
+    EXPECT_EQ(getCode(kMsgDKeyDown), m_messages.getCode(2));
+
+    // nothing is left to send
+    flushed();
+    EXPECT_EQ(3u, m_messages.m_messages.size());
+}
+
+TEST_F(ClientProxy1_0Tests, mouseDown_relativeMotionHeld_motionSentFirst)
+{
+    m_proxy->mouseRelativeMove(1, 1);
+    m_proxy->mouseRelativeMove(2, 2);
+    m_proxy->mouseDown(kButtonLeft);
+
+    ASSERT_EQ(3u, m_messages.m_messages.size());
+    EXPECT_EQ(getCode(kMsgDMouseRelMove), m_messages.getCode(1));
+    EXPECT_EQ(2, m_messages.getX(1));
+    EXPECT_EQ(getCode(kMsgDMouseDown), m_messages.getCode(2));
+}
+
+TEST_F(ClientProxy1_0Tests, outputFlushed_nothingHeld_nextMotionSentAtOnce)
+{
+    m_proxy->mouseMove(1, 2);
+    flushed();
+    EXPECT_EQ(1u, m_messages.m_messages.size());
+
+    m_proxy->mouseMove(3, 4);
+    ASSERT_EQ(2u, m_messages.m_messages.size());
+    EXPECT_EQ(3, m_messages.getX(1));
+}
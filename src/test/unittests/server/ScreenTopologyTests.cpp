@@ -0,0 +1,123 @@
+/*
+ * barrier -- mouse and keyboard sharing utility
+ * Copyright (C) 2018 Debauchee Open Source Group
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ScreenTopology.h"
+#include "server/Config.h"
+#include "test/mock/server/MockPrimaryClient.h"
+
+#include "test/global/gtest.h"
+
+class ScreenTopologyTests : public ::testing::Test {
+public:
+    ScreenTopologyTests() : m_config(NULL)
+    {
+        // a, b and c in a row with a second row d below b
+        m_config.addScreen("a");
+        m_config.addScreen("b");
+        m_config.addScreen("c");
+        m_config.addScreen("d");
+        m_config.connect("a", kRight, 0.0f, 1.0f, "b", 0.0f, 1.0f);
+        m_config.connect("b", kLeft, 0.0f, 1.0f, "a", 0.0f, 1.0f);
+        m_config.connect("b", kRight, 0.0f, 1.0f, "c", 0.0f, 1.0f);
+        m_config.connect("c", kLeft, 0.0f, 1.0f, "b", 0.0f, 1.0f);
+        m_config.connect("a", kBottom, 0.5f, 1.0f, "d", 0.0f, 0.5f);
+
+        m_clients["a"] = &m_a;
+        m_clients["c"] = &m_c;
+        m_clients["d"] = &m_d;
+    }
+
+    Config                        m_config;
+    ScreenTopology::ClientList    m_clients;
+    MockPrimaryClient            m_a;
+    MockPrimaryClient            m_b;
+    MockPrimaryClient            m_c;
+    MockPrimaryClient            m_d;
+};
+
+TEST_F(ScreenTopologyTests, getNeighbor_connected_returnsClient)
+{
+    m_clients["b"] = &m_b;
+    ScreenTopology topology;
+    topology.compile(m_config, m_clients);
+
+    float position = -1.0f;
+    EXPECT_EQ(&m_b, topology.getNeighbor(&m_a, kRight, 0.25f, position));
+    EXPECT_FLOAT_EQ(0.25f, position);
+    EXPECT_EQ(&m_a, topology.getNeighbor(&m_b, kLeft, 0.25f, position));
+    EXPECT_EQ(4, topology.getNumScreens());
+}
+
+TEST_F(ScreenTopologyTests, getNeighbor_unconnected_skipped)
+{
+    ScreenTopology topology;
+    topology.compile(m_config, m_clients);
+
+    float position = -1.0f;
+    EXPECT_EQ(&m_c, topology.getNeighbor(&m_a, kRight, 0.5f, position));
+    EXPECT_FLOAT_EQ(0.5f, position);
+    EXPECT_TRUE(topology.getNeighbor(&m_b, kRight, 0.5f, position) == NULL);
+}
+
+TEST_F(ScreenTopologyTests, getNeighbor_partialEdge_mapsPosition)
+{
+    ScreenTopology topology;
+    topology.compile(m_config, m_clients);
+
+    float position = -1.0f;
+    EXPECT_TRUE(topology.getNeighbor(&m_a, kBottom, 0.25f, position) == NULL);
+    EXPECT_EQ(&m_d, topology.getNeighbor(&m_a, kBottom, 0.75f, position));
+    EXPECT_FLOAT_EQ(0.25f, position);
+    EXPECT_TRUE(topology.getNeighbor(&m_a, kBottom, 1.0f, position) == NULL);
+    EXPECT_TRUE(topology.getNeighbor(&m_a, kTop, 0.5f, position) == NULL);
+}
+
+TEST_F(ScreenTopologyTests, getNeighbor_unconnectedLoop_returnsNull)
+{
+    m_config.connect("c", kRight, 0.0f, 1.0f, "b", 0.0f, 1.0f);
+    m_config.connect("b", kRight, 0.0f, 1.0f, "c", 0.0f, 1.0f);
+    m_clients.erase("c");
+    ScreenTopology topology;
+    topology.compile(m_config, m_clients);
+
+    float position;
+    EXPECT_TRUE(topology.getNeighbor(&m_a, kRight, 0.5f, position) == NULL);
+}
+
+TEST_F(ScreenTopologyTests, hasNeighbor_unconnected_true)
+{
+    ScreenTopology topology;
+    topology.compile(m_config, m_clients);
+
+    EXPECT_TRUE(topology.hasNeighbor(&m_a, kRight, 0.5f));
+    EXPECT_TRUE(topology.hasNeighbor(&m_a, kBottom));
+    EXPECT_FALSE(topology.hasNeighbor(&m_a, kBottom, 0.25f));
+    EXPECT_FALSE(topology.hasNeighbor(&m_a, kLeft));
+    EXPECT_FALSE(topology.hasNeighbor(&m_b, kLeft));
+}
+
+TEST_F(ScreenTopologyTests, compile_clientDisconnected_replacesLayout)
+{
+    ScreenTopology topology;
+    topology.compile(m_config, m_clients);
+    m_clients.erase("c");
+    topology.compile(m_config, m_clients);
+
+    float position;
+    EXPECT_TRUE(topology.getNeighbor(&m_a, kRight, 0.5f, position) == NULL);
+    EXPECT_FALSE(topology.hasNeighbor(&m_c, kLeft));
+}